@@ -0,0 +1,188 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <sstream>
+
+namespace degate
+{
+    namespace benchmark
+    {
+        namespace
+        {
+            std::string escape(std::string const& str)
+            {
+                std::ostringstream os;
+
+                for (char c : str)
+                {
+                    switch (c)
+                    {
+                        case '"': os << "\\\""; break;
+                        case '\\': os << "\\\\"; break;
+                        case '\n': os << "\\n"; break;
+                        case '\r': os << "\\r"; break;
+                        case '\t': os << "\\t"; break;
+                        default:
+                            if (static_cast<unsigned char>(c) < 0x20)
+                                os << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                                   << static_cast<int>(c) << std::dec;
+                            else
+                                os << c;
+                    }
+                }
+
+                return os.str();
+            }
+
+            std::string number(double value)
+            {
+                // JSON has no infinity or NaN.
+                if (!std::isfinite(value))
+                    return "null";
+
+                std::ostringstream os;
+                os << std::setprecision(std::numeric_limits<double>::max_digits10) << value;
+                return os.str();
+            }
+        }
+
+        State::State(unsigned int iterations, double scale) : iterations(iterations), scale(scale), items(0)
+        {
+        }
+
+        unsigned int State::scaled(unsigned int n, unsigned int minimum) const
+        {
+            const double value = std::round(n * scale);
+            return value < minimum ? minimum : static_cast<unsigned int>(value);
+        }
+
+        void State::run(std::function<void()> const& function)
+        {
+            run([]() {}, function);
+        }
+
+        void State::run(std::function<void()> const& setup, std::function<void()> const& function)
+        {
+            times.clear();
+
+            for (unsigned int i = 0; i < iterations; i++)
+            {
+                setup();
+
+                auto start = std::chrono::steady_clock::now();
+                function();
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+                times.push_back(elapsed.count());
+            }
+        }
+
+        std::vector<Benchmark>& get_benchmarks()
+        {
+            static std::vector<Benchmark> benchmarks;
+            return benchmarks;
+        }
+
+        Registrar::Registrar(std::string const& name, unsigned int iterations, benchmark_function function)
+        {
+            get_benchmarks().push_back(Benchmark{name, iterations, function});
+        }
+
+        void write_json(std::ostream& os,
+                        std::map<std::string, std::string> const& context,
+                        std::vector<Result> const& results)
+        {
+            os << "{\n  \"context\": {";
+
+            bool first = true;
+            for (auto const& value : context)
+            {
+                os << (first ? "\n" : ",\n") << "    \"" << escape(value.first) << "\": \"" << escape(value.second)
+                   << "\"";
+                first = false;
+            }
+
+            os << "\n  },\n  \"benchmarks\": [";
+
+            first = true;
+            for (auto const& result : results)
+            {
+                os << (first ? "\n" : ",\n") << "    {\n      \"name\": \"" << escape(result.name) << "\"";
+                first = false;
+
+                if (!result.error.empty())
+                    os << ",\n      \"error\": \"" << escape(result.error) << "\"";
+
+                std::vector<double> times = result.state.get_times();
+                os << ",\n      \"iterations\": " << times.size();
+
+                if (!times.empty())
+                {
+                    std::sort(times.begin(), times.end());
+
+                    const double n = static_cast<double>(times.size());
+                    const double mean = std::accumulate(times.begin(), times.end(), 0.0) / n;
+                    const double median = times.size() % 2 == 1
+                                              ? times[times.size() / 2]
+                                              : (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2;
+
+                    double variance = 0;
+                    for (double t : times)
+                        variance += (t - mean) * (t - mean);
+
+                    os << ",\n      \"min_s\": " << number(times.front())
+                       << ",\n      \"median_s\": " << number(median)
+                       << ",\n      \"mean_s\": " << number(mean)
+                       << ",\n      \"max_s\": " << number(times.back())
+                       << ",\n      \"stddev_s\": " << number(times.size() > 1 ? std::sqrt(variance / (n - 1)) : 0);
+
+                    if (result.state.get_items_processed() > 0)
+                        os << ",\n      \"items\": " << result.state.get_items_processed()
+                           << ",\n      \"items_per_second\": "
+                           << number(static_cast<double>(result.state.get_items_processed()) / median);
+                }
+
+                os << ",\n      \"counters\": {";
+
+                bool first_counter = true;
+                for (auto const& counter : result.state.get_counters())
+                {
+                    os << (first_counter ? "\n" : ",\n") << "        \"" << escape(counter.first)
+                       << "\": " << number(counter.second);
+                    first_counter = false;
+                }
+
+                os << (first_counter ? "}" : "\n      }") << "\n    }";
+            }
+
+            os << (first ? "]" : "\n  ]") << "\n}\n";
+        }
+    }
+}
@@ -0,0 +1,162 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace degate
+{
+    namespace benchmark
+    {
+        /**
+         * The state of a running benchmark.
+         *
+         * A benchmark prepares its workload, then calls run() with the code to
+         * measure. Only the code passed to run() is timed.
+         */
+        class State
+        {
+        private:
+
+            unsigned int iterations;
+            double scale;
+
+            std::vector<double> times;
+            std::map<std::string, double> counters;
+            std::uint64_t items;
+
+        public:
+
+            State(unsigned int iterations, double scale);
+
+            /**
+             * Get the workload scale factor (1 for the default workload size).
+             */
+            double get_scale() const
+            {
+                return scale;
+            }
+
+            /**
+             * Scale a workload size, never less than \p minimum.
+             */
+            unsigned int scaled(unsigned int n, unsigned int minimum = 1) const;
+
+            /**
+             * Time \p function, once per iteration.
+             */
+            void run(std::function<void()> const& function);
+
+            /**
+             * Time \p function, once per iteration. \p setup is called before
+             * each iteration, and is not timed.
+             */
+            void run(std::function<void()> const& setup, std::function<void()> const& function);
+
+            /**
+             * Set the number of items processed by each iteration. The throughput
+             * (items_per_second) is then reported.
+             */
+            void set_items_processed(std::uint64_t items)
+            {
+                this->items = items;
+            }
+
+            /**
+             * Report a value with the results (e.g. a workload size or a number of hits).
+             */
+            void set_counter(std::string const& name, double value)
+            {
+                counters[name] = value;
+            }
+
+            std::vector<double> const& get_times() const
+            {
+                return times;
+            }
+
+            std::map<std::string, double> const& get_counters() const
+            {
+                return counters;
+            }
+
+            std::uint64_t get_items_processed() const
+            {
+                return items;
+            }
+        };
+
+        typedef std::function<void(State&)> benchmark_function;
+
+        /**
+         * A registered benchmark.
+         */
+        struct Benchmark
+        {
+            std::string name;
+            unsigned int iterations;
+            benchmark_function function;
+        };
+
+        /**
+         * Get all the registered benchmarks, in registration order.
+         */
+        std::vector<Benchmark>& get_benchmarks();
+
+        /**
+         * Register a benchmark from a static object:
+         *
+         *   static Registrar registrar("QuadTree/insert", 3, &insert);
+         */
+        struct Registrar
+        {
+            Registrar(std::string const& name, unsigned int iterations, benchmark_function function);
+        };
+
+        /**
+         * The result of a benchmark.
+         */
+        struct Result
+        {
+            std::string name;
+            State state;
+            std::string error;
+        };
+
+        /**
+         * Write the results as JSON.
+         * @param context The values describing the run (version, scale...).
+         */
+        void write_json(std::ostream& os,
+                        std::map<std::string, std::string> const& context,
+                        std::vector<Result> const& results);
+    }
+}
+
+#endif
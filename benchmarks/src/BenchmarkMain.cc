@@ -0,0 +1,160 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Benchmark.h"
+#include "Core/Version.h"
+
+#include <cstdlib>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QThreadPool>
+
+using namespace degate::benchmark;
+
+namespace
+{
+    void print_usage(char const* name)
+    {
+        std::cerr << "Usage: " << name << " [options]\n"
+                  << "  --list              List the benchmarks.\n"
+                  << "  --filter <text>     Run the benchmarks whose name contains <text>.\n"
+                  << "  --scale <factor>    Scale the workloads (default: 1).\n"
+                  << "  --iterations <n>    Run each benchmark <n> times (default: per benchmark).\n"
+                  << "  --output <file>     Write the JSON results to <file> (default: benchmarks.json).\n";
+    }
+
+    std::string get_date()
+    {
+        char buffer[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+        return buffer;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    // Not the standard output by default, the core writes its debug messages there.
+    std::string filter, output = "benchmarks.json";
+    double scale = 1;
+    unsigned int iterations = 0;
+    bool list = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (arg == "--list")
+            list = true;
+        else if (arg == "--filter" && has_value)
+            filter = argv[++i];
+        else if (arg == "--scale" && has_value)
+            scale = std::atof(argv[++i]);
+        else if (arg == "--iterations" && has_value)
+            iterations = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (arg == "--output" && has_value)
+            output = argv[++i];
+        else
+        {
+            print_usage(argv[0]);
+            return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if (scale <= 0)
+    {
+        std::cerr << "The scale must be positive." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Degate always runs several threads. Until a thread is started, libstdc++ updates the
+    // shared pointer reference counts without atomic operations, which would favor the code
+    // copying shared pointers (e.g. for each pixel) over the code used from several threads.
+    std::thread([] {}).join();
+
+    std::vector<Result> results;
+    bool failed = false;
+
+    for (auto const& benchmark : get_benchmarks())
+    {
+        if (benchmark.name.find(filter) == std::string::npos)
+            continue;
+
+        if (list)
+        {
+            std::cout << benchmark.name << std::endl;
+            continue;
+        }
+
+        std::cerr << benchmark.name << "..." << std::flush;
+
+        Result result{benchmark.name, State(iterations > 0 ? iterations : benchmark.iterations, scale), ""};
+
+        try
+        {
+            benchmark.function(result.state);
+        }
+        catch (std::exception const& ex)
+        {
+            result.error = ex.what();
+            failed = true;
+        }
+
+        if (result.error.empty())
+            std::cerr << " done" << std::endl;
+        else
+            std::cerr << " failed: " << result.error << std::endl;
+
+        results.push_back(result);
+    }
+
+    if (list)
+        return EXIT_SUCCESS;
+
+    std::map<std::string, std::string> context = {{"version", DEGATE_VERSION},
+                                                  {"date", get_date()},
+                                                  {"scale", std::to_string(scale)},
+                                                  {"threads", std::to_string(QThreadPool::globalInstance()->maxThreadCount())}};
+
+    std::ofstream file(output);
+    write_json(file, context, results);
+
+    if (!file)
+    {
+        std::cerr << "Can't write the results to " << output << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cerr << "Results written to " << output << std::endl;
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Benchmark.h"
+#include "Workloads.h"
+#include "Core/Image/BackgroundImageImporter.h"
+#include "Core/Image/ImageStatistics.h"
+#include "Core/Image/Manipulation/ImageManipulation.h"
+#include "Core/Image/Manipulation/MedianFilter.h"
+#include "Core/Image/Processor/IPConvolve.h"
+#include "Core/Image/Processor/IPCopy.h"
+#include "Core/Image/Processor/IPMedianFilter.h"
+#include "Core/Image/Processor/IPNormalize.h"
+#include "Core/Image/Processor/IPPipe.h"
+#include "Core/Image/Processor/IPThresholding.h"
+#include "Core/Utils/FileSystem.h"
+
+using namespace degate;
+using namespace degate::benchmark;
+
+namespace
+{
+    BackgroundImage_shptr create_image(State& state)
+    {
+        const unsigned int size = state.scaled(4096, 256);
+
+        return create_background_image(size, size, [](unsigned int x, unsigned int y)
+        {
+            return MERGE_CHANNELS(x & 0xff, y & 0xff, (x ^ y) & 0xff, 255);
+        });
+    }
+
+    /**
+     * A gray scale image of pseudo random noise.
+     */
+    template<typename ImageType>
+    std::shared_ptr<ImageType> create_noise_image(unsigned int size)
+    {
+        auto img = std::make_shared<ImageType>(size, size);
+
+        for (unsigned int y = 0; y < size; y++)
+            for (unsigned int x = 0; x < size; x++)
+                img->set_pixel(x, y, static_cast<typename ImageType::pixel_type>(noise(1, x, y) % 256));
+
+        return img;
+    }
+
+    void copy(State& state)
+    {
+        BackgroundImage_shptr src = create_image(state);
+        auto dst = std::make_shared<TileImage_GS_BYTE>(src->get_width(), src->get_height());
+
+        state.run([&]() { copy_image(dst, src); });
+
+        state.set_items_processed(static_cast<std::uint64_t>(src->get_width()) * src->get_height());
+    }
+
+    void statistics(State& state)
+    {
+        BackgroundImage_shptr src = create_image(state);
+
+        double average = 0, stddev = 0;
+        state.run([&]()
+        {
+            average_and_stddev(src, 0, 0, src->get_width(), src->get_height(), &average, &stddev);
+        });
+
+        state.set_items_processed(static_cast<std::uint64_t>(src->get_width()) * src->get_height());
+        state.set_counter("average", average);
+    }
+
+    void background_import(State& state)
+    {
+        const unsigned int size = state.scaled(8192, 1024);
+
+        // A synthetic source, the decoding cost is negligible.
+        auto decoder = [size](unsigned int min_y, unsigned int rows, std::vector<rgba_pixel_t>& pixels)
+        {
+            pixels.resize(static_cast<std::size_t>(size) * rows);
+            for (unsigned int y = 0; y < rows; y++)
+                for (unsigned int x = 0; x < size; x++)
+                    pixels[static_cast<std::size_t>(y) * size + x] = MERGE_CHANNELS(x & 0xff, (min_y + y) & 0xff, 0, 255);
+            return true;
+        };
+
+        std::string directory;
+        BackgroundImageImporter::statistics result;
+        state.run([&]()
+        {
+            // The tiles of the previous iteration are removed.
+            if (!directory.empty())
+                remove_directory(directory);
+            directory = create_temp_directory();
+        }, [&]()
+        {
+            BackgroundImageImporter importer(directory, size, size, 1024, decoder);
+            result = importer.run();
+        });
+
+        remove_directory(directory);
+
+        state.set_items_processed(static_cast<std::uint64_t>(size) * size);
+        state.set_counter("tiles", result.tiles);
+        state.set_counter("levels", result.levels);
+    }
+
+    void separable_convolution(State& state)
+    {
+        auto src = create_noise_image<TileImage_GS_DOUBLE>(state.scaled(2048, 256));
+        auto dst = std::make_shared<TileImage_GS_DOUBLE>(src->get_width(), src->get_height());
+
+        auto kernel = std::make_shared<GaussianBlur>(13, 13, 2.0);
+
+        state.run([&]() { convolve(dst, src, kernel); });
+
+        state.set_items_processed(static_cast<std::uint64_t>(src->get_width()) * src->get_height());
+    }
+
+    void median(State& state)
+    {
+        const unsigned int kernel_width = 9;
+
+        auto src = create_noise_image<TileImage_GS_BYTE>(state.scaled(2048, 256));
+        auto dst = std::make_shared<TileImage_GS_BYTE>(src->get_width(), src->get_height());
+
+        state.run([&]() { median_filter(dst, src, kernel_width); });
+
+        state.set_items_processed(static_cast<std::uint64_t>(src->get_width()) * src->get_height());
+        state.set_counter("kernel_width", kernel_width);
+    }
+
+    /**
+     * Run the line detection pipe (like BinaryLineDetection) on the whole image,
+     * or tile by tile.
+     */
+    void line_detection_pipe(State& state, bool tiled)
+    {
+        const unsigned int size = state.scaled(2048, 256);
+
+        BackgroundImage_shptr img = create_background_image(size, size, [](unsigned int x, unsigned int y)
+        {
+            unsigned int v = ((x / 7 + y / 5) % 3 == 0 ? 180 : 60) + noise(1, x, y) % 40;
+            return MERGE_CHANNELS(v, v, v, 255);
+        });
+
+        IPPipe pipe;
+        pipe.add(std::make_shared<IPCopy<TileImage_RGBA, TileImage_GS_DOUBLE>>(0, size, 0, size));
+        pipe.add(std::make_shared<IPMedianFilter<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>>(3));
+        pipe.add(std::make_shared<IPNormalize<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>>(0, 255));
+        pipe.add(std::make_shared<IPConvolve<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>>(
+            std::make_shared<GaussianBlur>(10, 10, 0.5)));
+        pipe.add(std::make_shared<IPConvolve<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>>(
+            std::make_shared<SobelXOperator>()));
+        pipe.add(std::make_shared<IPThresholding<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>>(0.5));
+
+        state.run([&]()
+        {
+            if (tiled)
+                pipe.run_tiled(img);
+            else
+                pipe.run(img);
+        });
+
+        state.set_items_processed(static_cast<std::uint64_t>(size) * size);
+    }
+
+    void line_detection_pipe_whole(State& state)
+    {
+        line_detection_pipe(state, false);
+    }
+
+    void line_detection_pipe_tiled(State& state)
+    {
+        line_detection_pipe(state, true);
+    }
+
+    Registrar copy_registrar("Image/copy_image", 3, &copy);
+    Registrar statistics_registrar("Image/average_and_stddev", 3, &statistics);
+    Registrar background_import_registrar("Image/background_import", 3, &background_import);
+    Registrar convolution_registrar("ImageProcessing/separable_convolution", 3, &separable_convolution);
+    Registrar median_registrar("ImageProcessing/median_filter", 3, &median);
+    Registrar pipe_registrar("ImageProcessing/line_detection_pipe", 3, &line_detection_pipe_whole);
+    Registrar tiled_pipe_registrar("ImageProcessing/line_detection_pipe_tiled", 3, &line_detection_pipe_tiled);
+}
@@ -0,0 +1,309 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Benchmark.h"
+#include "Workloads.h"
+#include "Core/LogicModel/Gate/GateLibraryExporter.h"
+#include "Core/LogicModel/Gate/GateLibraryImporter.h"
+#include "Core/LogicModel/LogicModelBinaryExporter.h"
+#include "Core/LogicModel/LogicModelBinaryImporter.h"
+#include "Core/LogicModel/LogicModelExporter.h"
+#include "Core/LogicModel/LogicModelHelper.h"
+#include "Core/LogicModel/LogicModelImporter.h"
+#include "Core/Utils/FileSystem.h"
+
+#include <iterator>
+
+#include <boost/filesystem/operations.hpp>
+
+using namespace degate;
+using namespace degate::benchmark;
+
+namespace
+{
+    const unsigned int size = 50000;
+
+    /**
+     * A logic model with a gate library of hundreds of templates, gates on
+     * the first layer, wires and vias on the second layer.
+     */
+    LogicModel_shptr create_logic_model(State& state)
+    {
+        LogicModel_shptr lmodel = std::make_shared<LogicModel>(size, size, ProjectType::Normal, 2);
+
+        auto templates = create_gate_library(lmodel, 300, 1);
+        place_gates(lmodel, templates, state.scaled(20000), 2);
+
+        lmodel->add_objects(1, create_wires(state.scaled(500000), size, size, 3));
+        lmodel->add_objects(1, create_vias(state.scaled(200000), size, size, 4));
+
+        return lmodel;
+    }
+
+    void xml_export(State& state)
+    {
+        LogicModel_shptr lmodel = create_logic_model(state);
+
+        const std::string directory = create_temp_directory();
+        const std::string filename = join_pathes(directory, "lmodel.xml");
+
+        state.run([&]()
+        {
+            LogicModelExporter exporter(std::make_shared<ObjectIDRewriter>(false));
+            exporter.export_data(filename, lmodel);
+        });
+
+        state.set_items_processed(std::distance(lmodel->objects_begin(), lmodel->objects_end()));
+        state.set_counter("file_size", static_cast<double>(boost::filesystem::file_size(filename)));
+
+        remove_directory(directory);
+    }
+
+    void xml_import(State& state)
+    {
+        LogicModel_shptr lmodel = create_logic_model(state);
+
+        const std::string directory = create_temp_directory();
+        const std::string filename = join_pathes(directory, "lmodel.xml");
+
+        LogicModelExporter exporter(std::make_shared<ObjectIDRewriter>(false));
+        exporter.export_data(filename, lmodel);
+
+        LogicModel_shptr imported;
+        state.run([&]() { imported.reset(); }, [&]()
+        {
+            LogicModelImporter importer(size, size, lmodel->get_gate_library());
+            imported = importer.import(filename, ProjectType::Normal);
+        });
+
+        state.set_items_processed(std::distance(imported->objects_begin(), imported->objects_end()));
+
+        remove_directory(directory);
+    }
+
+    void binary_export(State& state)
+    {
+        LogicModel_shptr lmodel = create_logic_model(state);
+
+        const std::string directory = create_temp_directory();
+        const std::string filename = join_pathes(directory, "lmodel.bin");
+
+        state.run([&]()
+        {
+            LogicModelBinaryExporter exporter(std::make_shared<ObjectIDRewriter>(false));
+            exporter.export_data(filename, lmodel);
+        });
+
+        state.set_items_processed(std::distance(lmodel->objects_begin(), lmodel->objects_end()));
+        state.set_counter("file_size", static_cast<double>(boost::filesystem::file_size(filename)));
+
+        remove_directory(directory);
+    }
+
+    void binary_import(State& state)
+    {
+        LogicModel_shptr lmodel = create_logic_model(state);
+
+        const std::string directory = create_temp_directory();
+        const std::string filename = join_pathes(directory, "lmodel.bin");
+
+        LogicModelBinaryExporter exporter(std::make_shared<ObjectIDRewriter>(false));
+        exporter.export_data(filename, lmodel);
+
+        LogicModel_shptr imported;
+        state.run([&]() { imported.reset(); }, [&]()
+        {
+            LogicModelBinaryImporter importer(size, size, lmodel->get_gate_library());
+            imported = importer.import(filename, ProjectType::Normal);
+        });
+
+        state.set_items_processed(std::distance(imported->objects_begin(), imported->objects_end()));
+
+        remove_directory(directory);
+    }
+
+    /**
+     * Import the logic model of the test project (a few objects), many times.
+     */
+    void xml_import_test_project(State& state)
+    {
+        const std::string directory = DEGATE_BENCHMARK_TEST_PROJECT;
+        const unsigned int imports = 1000;
+
+        GateLibraryImporter gate_library_importer;
+        GateLibrary_shptr gate_library = gate_library_importer.import(join_pathes(directory, "gate_library.xml"));
+
+        LogicModel_shptr imported;
+        state.run([&]()
+        {
+            for (unsigned int i = 0; i < imports; i++)
+            {
+                LogicModelImporter importer(500, 500, gate_library);
+                imported = importer.import(join_pathes(directory, "lmodel.xml"), ProjectType::Normal);
+            }
+        });
+
+        state.set_items_processed(imports);
+        state.set_counter("objects", static_cast<double>(std::distance(imported->objects_begin(),
+                                                                       imported->objects_end())));
+    }
+
+    /**
+     * Export a logic model of 1M wires.
+     */
+    void xml_export_wires(State& state)
+    {
+        const unsigned int wires_size = 100000;
+
+        LogicModel_shptr lmodel = std::make_shared<LogicModel>(wires_size, wires_size, ProjectType::Normal, 1);
+        lmodel->add_objects(0, create_wires(state.scaled(1000000), wires_size, wires_size, 1));
+
+        const std::string directory = create_temp_directory();
+        const std::string filename = join_pathes(directory, "lmodel.xml");
+
+        state.run([&]()
+        {
+            LogicModelExporter exporter(std::make_shared<ObjectIDRewriter>(false));
+            exporter.export_data(filename, lmodel);
+        });
+
+        state.set_items_processed(std::distance(lmodel->objects_begin(), lmodel->objects_end()));
+        state.set_counter("file_size", static_cast<double>(boost::filesystem::file_size(filename)));
+
+        remove_directory(directory);
+    }
+
+    /**
+     * Import a logic model of 1M wires.
+     */
+    void xml_import_wires(State& state)
+    {
+        const unsigned int wires_size = 100000;
+
+        LogicModel_shptr lmodel = std::make_shared<LogicModel>(wires_size, wires_size, ProjectType::Normal, 1);
+        lmodel->add_objects(0, create_wires(state.scaled(1000000), wires_size, wires_size, 1));
+
+        const std::string directory = create_temp_directory();
+        const std::string filename = join_pathes(directory, "lmodel.xml");
+
+        LogicModelExporter exporter(std::make_shared<ObjectIDRewriter>(false));
+        exporter.export_data(filename, lmodel);
+
+        LogicModel_shptr imported;
+        state.run([&]() { imported.reset(); }, [&]()
+        {
+            LogicModelImporter importer(wires_size, wires_size, std::make_shared<GateLibrary>());
+            imported = importer.import(filename, ProjectType::Normal);
+        });
+
+        state.set_items_processed(std::distance(imported->objects_begin(), imported->objects_end()));
+        state.set_counter("file_size", static_cast<double>(boost::filesystem::file_size(filename)));
+
+        remove_directory(directory);
+    }
+
+    void gate_library_xml_round_trip(State& state)
+    {
+        LogicModel_shptr lmodel = std::make_shared<LogicModel>(size, size, ProjectType::Normal, 1);
+        create_gate_library(lmodel, state.scaled(300), 1);
+
+        const std::string directory = create_temp_directory();
+        const std::string filename = join_pathes(directory, "gate_library.xml");
+
+        GateLibrary_shptr imported;
+        state.run([&]()
+        {
+            GateLibraryExporter exporter(std::make_shared<ObjectIDRewriter>(false));
+            exporter.export_data(filename, lmodel->get_gate_library());
+
+            GateLibraryImporter importer;
+            imported = importer.import(filename);
+        });
+
+        state.set_items_processed(std::distance(imported->begin(), imported->end()));
+
+        remove_directory(directory);
+    }
+
+    void autoconnect(State& state)
+    {
+        const unsigned int autoconnect_size = 20000;
+
+        LogicModel_shptr lmodel;
+        state.run([&]()
+        {
+            // The connections are made by the previous iteration, the logic model is recreated.
+            lmodel = std::make_shared<LogicModel>(autoconnect_size, autoconnect_size, ProjectType::Normal, 1);
+            lmodel->add_objects(0, create_wires(state.scaled(200000), autoconnect_size, autoconnect_size, 1));
+            lmodel->add_objects(0, create_vias(state.scaled(100000), autoconnect_size, autoconnect_size, 2));
+        }, [&]()
+        {
+            autoconnect_objects(lmodel, lmodel->get_layer(0), BoundingBox(autoconnect_size, autoconnect_size));
+        });
+
+        state.set_items_processed(std::distance(lmodel->objects_begin(), lmodel->objects_end()));
+        state.set_counter("nets", static_cast<double>(std::distance(lmodel->nets_begin(), lmodel->nets_end())));
+    }
+
+    void template_port_edit(State& state)
+    {
+        // Few templates, so a template has thousands of instances.
+        LogicModel_shptr lmodel = std::make_shared<LogicModel>(size, size, ProjectType::Normal, 1);
+
+        auto templates = create_gate_library(lmodel, 10, 1);
+        place_gates(lmodel, templates, state.scaled(200000), 2);
+
+        GateTemplate_shptr tmpl = templates.front();
+        GateTemplatePort_shptr port = *tmpl->ports_begin();
+
+        // Move a port of the template back and forth, then add and remove a port.
+        bool moved = false;
+        state.run([&]()
+        {
+            Point position = port->get_point();
+            position.set_y(moved ? position.get_y() - 1 : position.get_y() + 1);
+            port->set_point(position);
+            moved = !moved;
+
+            lmodel->update_ports(tmpl);
+
+            auto new_port = std::make_shared<GateTemplatePort>(1.f, 1.f, GateTemplatePort::PORT_TYPE_IN);
+            new_port->set_object_id(lmodel->get_new_object_id());
+            lmodel->add_template_port_to_gate_template(tmpl, new_port);
+            lmodel->remove_template_port_from_gate_template(tmpl, new_port);
+        });
+
+        state.set_items_processed(lmodel->get_template_instances(tmpl).size());
+        state.set_counter("gates", lmodel->get_gates_count());
+    }
+
+    Registrar xml_export_registrar("LogicModel/xml_export", 3, &xml_export);
+    Registrar xml_import_registrar("LogicModel/xml_import", 3, &xml_import);
+    Registrar xml_import_test_project_registrar("LogicModel/xml_import_test_project", 3, &xml_import_test_project);
+    Registrar xml_export_wires_registrar("LogicModel/xml_export_wires", 3, &xml_export_wires);
+    Registrar xml_import_wires_registrar("LogicModel/xml_import_wires", 3, &xml_import_wires);
+    Registrar binary_export_registrar("LogicModel/binary_export", 3, &binary_export);
+    Registrar binary_import_registrar("LogicModel/binary_import", 3, &binary_import);
+    Registrar gate_library_registrar("GateLibrary/xml_round_trip", 3, &gate_library_xml_round_trip);
+    Registrar template_port_edit_registrar("LogicModel/template_port_edit", 3, &template_port_edit);
+    Registrar autoconnect_registrar("LogicModel/autoconnect_objects", 3, &autoconnect);
+}
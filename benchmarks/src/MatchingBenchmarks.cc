@@ -0,0 +1,287 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Benchmark.h"
+#include "Workloads.h"
+#include "Core/LogicModel/Gate/Gate.h"
+#include "Core/LogicModel/Via/Via.h"
+#include "Core/LogicModel/Wire/Wire.h"
+#include "Core/Matching/LineSegmentExtraction.h"
+#include "Core/Matching/TemplateMatching.h"
+#include "Core/Matching/ViaMatching.h"
+#include "Core/Matching/WireMatching.h"
+
+#include <random>
+#include <set>
+
+using namespace degate;
+using namespace degate::benchmark;
+
+namespace
+{
+    /**
+     * Remove the objects of a type, added by a previous run of a matching.
+     */
+    template<typename T>
+    void remove_objects(LogicModel_shptr lmodel, std::set<PlacedLogicModelObject_shptr> const& keep = {})
+    {
+        std::vector<PlacedLogicModelObject_shptr> objects;
+
+        for (auto iter = lmodel->objects_begin(); iter != lmodel->objects_end(); ++iter)
+        {
+            if (std::dynamic_pointer_cast<T>(iter->second) != nullptr && keep.count(iter->second) == 0)
+                objects.push_back(iter->second);
+        }
+
+        for (auto const& o : objects)
+            lmodel->remove_object(o);
+    }
+
+    /**
+     * Gate templates placed on a grid of 64x64 pixel cells, the template of
+     * a cell is chosen from the cell position.
+     */
+    void template_matching(State& state)
+    {
+        const unsigned int size = state.scaled(1024, 128);
+        const unsigned int cell_size = 64;
+        const unsigned int templates_count = 8;
+
+        std::vector<GateTemplate_shptr> templates;
+        std::vector<unsigned int> seeds;
+        for (unsigned int i = 0; i < templates_count; i++)
+        {
+            seeds.push_back(i + 1);
+            templates.push_back(create_template("T" + std::to_string(i), 24 + 2 * i, 40 - 2 * i, i + 1));
+        }
+
+        // One cell out of three is empty.
+        auto get_template = [&](unsigned int cell_x, unsigned int cell_y) -> int
+        {
+            unsigned int n = noise(7, cell_x, cell_y);
+            return n % 3 == 0 ? -1 : static_cast<int>((n / 3) % templates_count);
+        };
+
+        Project_shptr project = create_project(size, size, Layer::TRANSISTOR, [&](unsigned int x, unsigned int y)
+        {
+            unsigned int v = 30 + noise(3, x, y) % 8;
+
+            const int i = get_template(x / cell_size, y / cell_size);
+            const unsigned int cx = x % cell_size, cy = y % cell_size;
+
+            if (i >= 0 && cx < templates[i]->get_width() && cy < templates[i]->get_height())
+                v = cell_pattern(seeds[i], cx, cy);
+
+            return MERGE_CHANNELS(v, v, v, 255);
+        });
+
+        LogicModel_shptr lmodel = project->get_logic_model();
+        Layer_shptr layer = lmodel->get_layer(0);
+
+        for (auto const& tmpl : templates)
+            lmodel->add_gate_template(tmpl);
+
+        unsigned int hits = 0;
+        state.run([&]() { remove_objects<Gate>(lmodel); }, [&]()
+        {
+            TemplateMatchingNormal matching;
+            matching.set_templates(std::list<GateTemplate_shptr>(templates.begin(), templates.end()));
+            matching.set_orientations({Gate::ORIENTATION_NORMAL});
+            matching.set_layers(layer, layer);
+            matching.init(project->get_bounding_box(), project);
+            matching.run();
+
+            hits = matching.get_number_of_hits();
+        });
+
+        state.set_items_processed(static_cast<std::uint64_t>(size) * size);
+        state.set_counter("templates", templates_count);
+        state.set_counter("hits", hits);
+    }
+
+    /**
+     * Vias on a grid of 40x40 pixel cells, with a random offset and direction.
+     */
+    void via_matching(State& state)
+    {
+        const unsigned int size = state.scaled(2048, 128);
+        const unsigned int cell_size = 40, diameter = 11;
+
+        auto get_via = [&](unsigned int cell_x, unsigned int cell_y, unsigned int& x, unsigned int& y)
+        {
+            unsigned int n = noise(5, cell_x, cell_y);
+            x = cell_x * cell_size + 12 + n % 16;
+            y = cell_y * cell_size + 12 + (n >> 8) % 16;
+            return (n >> 16) % 2 == 0 ? Via::DIRECTION_UP : Via::DIRECTION_DOWN;
+        };
+
+        Project_shptr project = create_project(size, size, Layer::METAL, [&](unsigned int x, unsigned int y)
+        {
+            unsigned int v = 60 + noise(1, x, y) % 40;
+            unsigned int vx, vy;
+            Via::DIRECTION direction = get_via(x / cell_size, y / cell_size, vx, vy);
+
+            const int dx = static_cast<int>(x) - static_cast<int>(vx), dy = static_cast<int>(y) - static_cast<int>(vy);
+            const int d2 = dx * dx + dy * dy;
+
+            if (direction == Via::DIRECTION_UP && d2 <= 16)
+                v = 200 + noise(2, x, y) % 30;
+            else if (direction == Via::DIRECTION_DOWN && d2 <= 25)
+                v = d2 <= 6 ? 20 + noise(2, x, y) % 10 : 170 + noise(2, x, y) % 20;
+
+            return MERGE_CHANNELS(v, v, v, 255);
+        });
+
+        LogicModel_shptr lmodel = project->get_logic_model();
+        Layer_shptr layer = lmodel->get_layer(0);
+
+        // The via matching learns from the vias in the logic model, one per direction.
+        std::set<PlacedLogicModelObject_shptr> known_vias;
+        const unsigned int cells = size / cell_size;
+        for (unsigned int cell = 0; known_vias.size() < 2 && cell < cells * cells; cell++)
+        {
+            unsigned int x, y;
+            Via::DIRECTION direction = get_via(cell % cells, cell / cells, x, y);
+
+            bool known = false;
+            for (auto const& via : known_vias)
+                known |= std::dynamic_pointer_cast<Via>(via)->get_direction() == direction;
+
+            if (!known)
+            {
+                Via_shptr via = std::make_shared<Via>(x, y, diameter, direction);
+                lmodel->add_object(layer, via);
+                known_vias.insert(via);
+            }
+        }
+
+        state.run([&]() { remove_objects<Via>(lmodel, known_vias); }, [&]()
+        {
+            ViaMatching matching;
+            matching.set_diameter(diameter);
+            matching.set_threshold_match(0.7);
+            matching.set_merge_n_vias(0);
+            matching.init(project->get_bounding_box(), project);
+            matching.run();
+        });
+
+        state.set_items_processed(static_cast<std::uint64_t>(size) * size);
+        state.set_counter("vias", static_cast<double>(std::distance(lmodel->vias_begin(), lmodel->vias_end())));
+    }
+
+    /**
+     * Horizontal and vertical wire segments on a 32 pixel grid.
+     */
+    void wire_matching(State& state)
+    {
+        const unsigned int size = state.scaled(2048, 128);
+        const unsigned int grid = 32, length = 128;
+
+        Project_shptr project = create_project(size, size, Layer::METAL, [&](unsigned int x, unsigned int y)
+        {
+            unsigned int v = 40 + noise(1, x, y) % 20;
+
+            const bool horizontal = y % grid >= 10 && y % grid < 15 && noise(2, x / length, y / grid) % 2 == 0;
+            const bool vertical = x % grid >= 10 && x % grid < 15 && noise(3, x / grid, y / length) % 3 == 0;
+
+            if (horizontal || vertical)
+                v = 180 + noise(4, x, y) % 40;
+
+            return MERGE_CHANNELS(v, v, v, 255);
+        });
+
+        LogicModel_shptr lmodel = project->get_logic_model();
+
+        state.run([&]() { remove_objects<Wire>(lmodel); }, [&]()
+        {
+            WireMatching matching;
+            matching.set_wire_diameter(5);
+            matching.init(project->get_bounding_box(), project);
+            matching.run();
+        });
+
+        std::size_t wires = 0;
+        for (auto iter = lmodel->objects_begin(); iter != lmodel->objects_end(); ++iter)
+            wires += std::dynamic_pointer_cast<Wire>(iter->second) != nullptr ? 1 : 0;
+
+        state.set_items_processed(static_cast<std::uint64_t>(size) * size);
+        state.set_counter("wires", static_cast<double>(wires));
+    }
+
+    /**
+     * Wires broken into pieces with small gaps and jitter across the wire, like
+     * the line segments extracted by the wire matching (about 13 pieces per wire).
+     */
+    std::vector<LineSegment> create_wire_pieces(unsigned int wires, unsigned int size, unsigned int seed)
+    {
+        std::mt19937 random(seed);
+        std::vector<LineSegment> pieces;
+
+        for (unsigned int i = 0; i < wires; i++)
+        {
+            const bool horizontal = random() % 2 == 0;
+            const int across = static_cast<int>(random() % size);
+            int along = static_cast<int>(random() % size);
+            const int end = along + 20 + static_cast<int>(random() % 200);
+
+            while (along < end)
+            {
+                const int length = 2 + static_cast<int>(random() % 12);
+                const int jitter = static_cast<int>(random() % 3) - 1;
+
+                if (horizontal)
+                    pieces.emplace_back(along, across + jitter, along + length, across + jitter);
+                else
+                    pieces.emplace_back(across + jitter, along, across + jitter, along + length);
+
+                along += length + static_cast<int>(random() % 4);
+            }
+        }
+
+        return pieces;
+    }
+
+    void line_segment_merge(State& state)
+    {
+        // About 1M pieces.
+        const std::vector<LineSegment> pieces = create_wire_pieces(state.scaled(75000), 20000, 1);
+
+        LineSegmentMap map;
+        state.run([&]()
+        {
+            map = LineSegmentMap();
+            for (auto const& piece : pieces)
+                map.add(piece);
+        }, [&]()
+        {
+            map.merge(3, 2);
+        });
+
+        state.set_items_processed(pieces.size());
+        state.set_counter("segments", static_cast<double>(map.size()));
+    }
+
+    Registrar template_matching_registrar("TemplateMatching/run", 3, &template_matching);
+    Registrar via_matching_registrar("ViaMatching/run", 3, &via_matching);
+    Registrar wire_matching_registrar("WireMatching/run", 3, &wire_matching);
+    Registrar line_segment_merge_registrar("WireMatching/line_segment_merge", 3, &line_segment_merge);
+}
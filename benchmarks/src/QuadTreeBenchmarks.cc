@@ -0,0 +1,104 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Benchmark.h"
+#include "Workloads.h"
+#include "Core/Primitive/QuadTree.h"
+#include "Core/Primitive/QuadTreeRegionIterator.h"
+
+#include <memory>
+#include <random>
+
+using namespace degate;
+using namespace degate::benchmark;
+
+namespace
+{
+    const unsigned int size = 100000;
+
+    typedef QuadTree<PlacedLogicModelObject_shptr> quadtree_type;
+
+    void insert(State& state)
+    {
+        auto wires = create_wires(state.scaled(1000000), size, size, 1);
+
+        std::unique_ptr<quadtree_type> qt;
+        state.run([&]() { qt.reset(new quadtree_type(BoundingBox(size, size), 100)); }, [&]()
+        {
+            for (auto const& w : wires)
+                qt->insert(w);
+        });
+
+        state.set_items_processed(wires.size());
+        state.set_counter("depth", qt->depth());
+    }
+
+    void bulk_insert(State& state)
+    {
+        auto wires = create_wires(state.scaled(1000000), size, size, 1);
+
+        std::unique_ptr<quadtree_type> qt;
+        state.run([&]() { qt.reset(new quadtree_type(BoundingBox(size, size), 100)); }, [&]()
+        {
+            qt->bulk_insert(wires.begin(), wires.end());
+        });
+
+        state.set_items_processed(wires.size());
+        state.set_counter("depth", qt->depth());
+    }
+
+    void region_query(State& state)
+    {
+        auto wires = create_wires(state.scaled(1000000), size, size, 1);
+
+        quadtree_type qt(BoundingBox(size, size), 100);
+        qt.bulk_insert(wires.begin(), wires.end());
+
+        // Windows of the size of a screen.
+        const unsigned int queries = 10000, window = 1000;
+
+        std::mt19937 random(2);
+        std::vector<BoundingBox> regions;
+        for (unsigned int i = 0; i < queries; i++)
+        {
+            const int x = static_cast<int>(random() % (size - window));
+            const int y = static_cast<int>(random() % (size - window));
+            regions.emplace_back(x, x + window, y, y + window);
+        }
+
+        std::uint64_t found = 0;
+        state.run([&]()
+        {
+            found = 0;
+            for (auto const& region : regions)
+                for (auto iter = qt.region_iter_begin(region); iter != qt.region_iter_end(); ++iter)
+                    found++;
+        });
+
+        state.set_items_processed(queries);
+        state.set_counter("objects_found", static_cast<double>(found));
+    }
+
+    Registrar insert_registrar("QuadTree/insert", 3, &insert);
+    Registrar bulk_insert_registrar("QuadTree/bulk_insert", 3, &bulk_insert);
+    Registrar region_query_registrar("QuadTree/region_query", 3, &region_query);
+}
@@ -0,0 +1,194 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Benchmark.h"
+#include "Workloads.h"
+
+#include "Core/Image/TileCache.h"
+
+using namespace degate;
+using namespace degate::benchmark;
+
+namespace
+{
+    BackgroundImage_shptr create_image(State& state)
+    {
+        const unsigned int size = state.scaled(4096, 256);
+
+        return create_background_image(size, size, [](unsigned int x, unsigned int y)
+        {
+            unsigned int v = noise(1, x, y) & 0xff;
+            return MERGE_CHANNELS(v, v, v, 255);
+        });
+    }
+
+    /**
+     * Read all the pixels in row order: the tile of the pixel is almost always
+     * the last tile used.
+     */
+    void hit(State& state)
+    {
+        BackgroundImage_shptr img = create_image(state);
+        const unsigned int width = img->get_width(), height = img->get_height();
+
+        // Load all the tiles.
+        for (unsigned int y = 0; y < height; y += img->get_tile_size())
+            for (unsigned int x = 0; x < width; x += img->get_tile_size())
+                img->get_pixel(x, y);
+
+        std::uint64_t sum = 0;
+        state.run([&]()
+        {
+            for (unsigned int y = 0; y < height; y++)
+                for (unsigned int x = 0; x < width; x++)
+                    sum += img->get_pixel(x, y) & 0xff;
+        });
+
+        state.set_items_processed(static_cast<std::uint64_t>(width) * height);
+        state.set_counter("checksum", static_cast<double>(sum & 0xffffffff));
+    }
+
+    /**
+     * Read all the pixels in row order, with a tile lookup per pixel on a tile
+     * cache of the image.
+     */
+    template<typename TileAccess>
+    void hit_tile_cache(State& state, TileAccess access)
+    {
+        BackgroundImage_shptr img = create_image(state);
+        const unsigned int width = img->get_width(), height = img->get_height();
+        const unsigned int offset_bitmask = img->get_tile_size() - 1;
+
+        // A second cache on the tiles of the image
+        TileCache<PixelPolicy_RGBA> cache(img->get_path(), img->get_tile_width_exp(), 1, TileLoadingType::Sync, {});
+
+        for (unsigned int y = 0; y < height; y += img->get_tile_size())
+            for (unsigned int x = 0; x < width; x += img->get_tile_size())
+                cache.load_tile(x / img->get_tile_size(), y / img->get_tile_size());
+
+        std::uint64_t sum = 0;
+        state.run([&]()
+        {
+            for (unsigned int y = 0; y < height; y++)
+                for (unsigned int x = 0; x < width; x++)
+                    sum += access(cache, x, y)->get(x & offset_bitmask, y & offset_bitmask) & 0xff;
+        });
+
+        cache.release_memory();
+
+        state.set_items_processed(static_cast<std::uint64_t>(width) * height);
+        state.set_counter("checksum", static_cast<double>(sum & 0xffffffff));
+    }
+
+    /**
+     * Tile lookup through TileCache::get_tile(), which returns a shared pointer
+     * for each pixel. This is how get_pixel() read pixels before the thread tile
+     * handles, it is the reference for hit_handle.
+     */
+    void hit_shared(State& state)
+    {
+        hit_tile_cache(state, [](TileCache<PixelPolicy_RGBA>& cache, unsigned int x, unsigned int y)
+        {
+            return cache.get_tile(x, y);
+        });
+    }
+
+    /**
+     * Tile lookup through the thread tile handle, as get_pixel() does.
+     */
+    void hit_handle(State& state)
+    {
+        hit_tile_cache(state, [](TileCache<PixelPolicy_RGBA>& cache, unsigned int x, unsigned int y)
+        {
+            return cache.get_tile_fast(x, y);
+        });
+    }
+
+    /**
+     * Read all the pixels in column order: each pixel is in another tile than
+     * the previous one, but all the tiles are in memory.
+     */
+    void tile_switch(State& state)
+    {
+        BackgroundImage_shptr img = create_image(state);
+        const unsigned int width = img->get_width(), height = img->get_height();
+        const unsigned int tile_size = img->get_tile_size();
+
+        for (unsigned int y = 0; y < height; y += tile_size)
+            for (unsigned int x = 0; x < width; x += tile_size)
+                img->get_pixel(x, y);
+
+        // Visit the pixels so that consecutive reads are in different tiles.
+        const unsigned int tiles_x = (width + tile_size - 1) / tile_size;
+
+        std::uint64_t sum = 0, reads = 0;
+        state.run([&]()
+        {
+            reads = 0;
+            for (unsigned int y = 0; y < height; y++)
+                for (unsigned int x = 0; x < tile_size; x++)
+                    for (unsigned int tile = 0; tile < tiles_x; tile++)
+                    {
+                        const unsigned int px = tile * tile_size + x;
+                        if (px < width)
+                        {
+                            sum += img->get_pixel(px, y) & 0xff;
+                            reads++;
+                        }
+                    }
+        });
+
+        state.set_items_processed(reads);
+        state.set_counter("checksum", static_cast<double>(sum & 0xffffffff));
+    }
+
+    /**
+     * Read one pixel per tile, after the release of the tiles: each read loads a tile.
+     */
+    void miss(State& state)
+    {
+        BackgroundImage_shptr img = create_image(state);
+        const unsigned int width = img->get_width(), height = img->get_height();
+        const unsigned int tile_size = img->get_tile_size();
+
+        std::uint64_t sum = 0, tiles = 0;
+        state.run([&]() { img->release_memory(); }, [&]()
+        {
+            tiles = 0;
+            for (unsigned int y = 0; y < height; y += tile_size)
+                for (unsigned int x = 0; x < width; x += tile_size)
+                {
+                    sum += img->get_pixel(x, y) & 0xff;
+                    tiles++;
+                }
+        });
+
+        state.set_items_processed(tiles);
+        state.set_counter("checksum", static_cast<double>(sum & 0xffffffff));
+    }
+
+    Registrar hit_registrar("TileCache/hit", 5, &hit);
+    Registrar hit_shared_registrar("TileCache/hit_shared", 5, &hit_shared);
+    Registrar hit_handle_registrar("TileCache/hit_handle", 5, &hit_handle);
+    Registrar tile_switch_registrar("TileCache/tile_switch", 5, &tile_switch);
+    Registrar miss_registrar("TileCache/miss", 5, &miss);
+}
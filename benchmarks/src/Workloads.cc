@@ -0,0 +1,225 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Workloads.h"
+#include "Core/LogicModel/Gate/Gate.h"
+#include "Core/LogicModel/Via/Via.h"
+#include "Core/LogicModel/Wire/Wire.h"
+#include "Core/Utils/FileSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace degate
+{
+    namespace benchmark
+    {
+        unsigned int noise(unsigned int seed, unsigned int x, unsigned int y)
+        {
+            unsigned int h = seed * 2654435761u ^ x * 40503u ^ y * 2246822519u;
+            h ^= h >> 13;
+            h *= 0x5bd1e995;
+            h ^= h >> 15;
+            return h;
+        }
+
+        unsigned int cell_pattern(unsigned int seed, unsigned int x, unsigned int y)
+        {
+            return 64 + noise(seed, x / 8, y / 8) % 160;
+        }
+
+        BackgroundImage_shptr create_background_image(unsigned int width, unsigned int height, pixel_function pixel)
+        {
+            BackgroundImage_shptr img = std::make_shared<BackgroundImage>(width, height, create_temp_directory());
+
+            const unsigned int tile_size = img->get_tile_size();
+
+            for (unsigned int tile_y = 0; tile_y < height; tile_y += tile_size)
+                for (unsigned int tile_x = 0; tile_x < width; tile_x += tile_size)
+                {
+                    auto block = img->get_block(tile_x, tile_y, width - tile_x, height - tile_y);
+
+                    for (unsigned int y = 0; y < block.get_height(); y++)
+                    {
+                        rgba_pixel_t* row = block.get_row(y);
+
+                        for (unsigned int x = 0; x < block.get_width(); x++)
+                            row[x] = pixel(tile_x + x, tile_y + y);
+                    }
+                }
+
+            return img;
+        }
+
+        Project_shptr create_project(unsigned int width, unsigned int height,
+                                     Layer::LAYER_TYPE layer_type, pixel_function pixel)
+        {
+            Project_shptr project = std::make_shared<Project>(width, height, create_temp_directory(),
+                                                              ProjectType::Normal, 1);
+
+            LogicModel_shptr lmodel = project->get_logic_model();
+            lmodel->set_current_layer(0);
+
+            Layer_shptr layer = lmodel->get_layer(0);
+            layer->set_layer_type(layer_type);
+            layer->set_image(create_background_image(width, height, pixel));
+
+            return project;
+        }
+
+        std::vector<PlacedLogicModelObject_shptr> create_wires(unsigned int count,
+                                                               unsigned int width,
+                                                               unsigned int height,
+                                                               unsigned int seed)
+        {
+            std::mt19937 random(seed);
+            std::vector<PlacedLogicModelObject_shptr> wires;
+            wires.reserve(count);
+
+            for (unsigned int i = 0; i < count; i++)
+            {
+                const float x = static_cast<float>(random() % width);
+                const float y = static_cast<float>(random() % height);
+                const float length = static_cast<float>(10 + random() % 200);
+
+                if (i % 2 == 0)
+                    wires.push_back(std::make_shared<Wire>(x, y, std::min(x + length, width - 1.f), y, 5));
+                else
+                    wires.push_back(std::make_shared<Wire>(x, y, x, std::min(y + length, height - 1.f), 5));
+            }
+
+            return wires;
+        }
+
+        std::vector<PlacedLogicModelObject_shptr> create_vias(unsigned int count,
+                                                              unsigned int width,
+                                                              unsigned int height,
+                                                              unsigned int seed)
+        {
+            std::mt19937 random(seed);
+            std::vector<PlacedLogicModelObject_shptr> vias;
+            vias.reserve(count);
+
+            for (unsigned int i = 0; i < count; i++)
+            {
+                const float x = static_cast<float>(5 + random() % (width - 10));
+                const float y = static_cast<float>(5 + random() % (height - 10));
+
+                vias.push_back(std::make_shared<Via>(x, y, 7, i % 2 == 0 ? Via::DIRECTION_UP : Via::DIRECTION_DOWN));
+            }
+
+            return vias;
+        }
+
+        GateTemplate_shptr create_template(std::string const& name,
+                                           unsigned int width,
+                                           unsigned int height,
+                                           unsigned int seed)
+        {
+            GateTemplate_shptr tmpl = std::make_shared<GateTemplate>(width, height);
+            tmpl->set_name(name);
+
+            GateTemplateImage_shptr tmpl_img = std::make_shared<GateTemplateImage>(width, height);
+            for (unsigned int y = 0; y < height; y++)
+                for (unsigned int x = 0; x < width; x++)
+                {
+                    unsigned int v = cell_pattern(seed, x, y);
+                    tmpl_img->set_pixel(x, y, MERGE_CHANNELS(v, v, v, 255));
+                }
+
+            tmpl->set_image(Layer::TRANSISTOR, tmpl_img);
+
+            return tmpl;
+        }
+
+        std::vector<GateTemplate_shptr> create_gate_library(LogicModel_shptr lmodel,
+                                                            unsigned int templates,
+                                                            unsigned int seed)
+        {
+            std::mt19937 random(seed);
+            std::vector<GateTemplate_shptr> tmpls;
+
+            for (unsigned int i = 0; i < templates; i++)
+            {
+                const unsigned int width = 16 + random() % 32;
+                const unsigned int height = 16 + random() % 32;
+
+                GateTemplate_shptr tmpl = create_template("T" + std::to_string(i), width, height,
+                                                          static_cast<unsigned int>(random()));
+
+                // Inputs, then an output.
+                const unsigned int ports = 2 + i % 4;
+                for (unsigned int p = 0; p < ports; p++)
+                {
+                    auto port = std::make_shared<GateTemplatePort>(static_cast<float>((p + 1) * width / (ports + 1)),
+                                                                   static_cast<float>(height / 2),
+                                                                   p + 1 == ports ? GateTemplatePort::PORT_TYPE_OUT
+                                                                                  : GateTemplatePort::PORT_TYPE_IN);
+                    port->set_name(std::string(1, static_cast<char>('A' + p)));
+                    port->set_object_id(lmodel->get_new_object_id());
+                    tmpl->add_template_port(port);
+                }
+
+                lmodel->add_gate_template(tmpl);
+                tmpls.push_back(tmpl);
+            }
+
+            return tmpls;
+        }
+
+        void place_gates(LogicModel_shptr lmodel,
+                         std::vector<GateTemplate_shptr> const& templates,
+                         unsigned int count,
+                         unsigned int seed)
+        {
+            std::mt19937 random(seed);
+
+            // The templates are at most 48x48 pixels.
+            const unsigned int cell_size = 50;
+            const unsigned int columns = std::max(1u, lmodel->get_width() / cell_size);
+
+            std::vector<Gate_shptr> gates;
+            std::vector<PlacedLogicModelObject_shptr> objects;
+
+            for (unsigned int i = 0; i < count; i++)
+            {
+                GateTemplate_shptr tmpl = templates[random() % templates.size()];
+
+                const float x = static_cast<float>((i % columns) * cell_size);
+                const float y = static_cast<float>((i / columns) * cell_size);
+
+                Gate_shptr gate = std::make_shared<Gate>(x, x + tmpl->get_width() - 1, y, y + tmpl->get_height() - 1,
+                                                         Gate::ORIENTATION_NORMAL);
+                gate->set_gate_template(tmpl);
+
+                gates.push_back(gate);
+                objects.push_back(gate);
+            }
+
+            lmodel->add_objects(0, objects);
+
+            for (auto const& gate : gates)
+                lmodel->update_ports(gate);
+        }
+    }
+}
@@ -0,0 +1,109 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef __WORKLOADS_H__
+#define __WORKLOADS_H__
+
+#include "Core/Image/Image.h"
+#include "Core/LogicModel/Gate/GateLibrary.h"
+#include "Core/LogicModel/Gate/GateTemplate.h"
+#include "Core/LogicModel/Layer.h"
+#include "Core/LogicModel/LogicModel.h"
+#include "Core/Project/Project.h"
+
+#include <functional>
+#include <vector>
+
+/**
+ * Synthetic workloads for the benchmarks. They only depend on their
+ * parameters (and seeds), so that runs on different commits can be compared.
+ */
+namespace degate
+{
+    namespace benchmark
+    {
+        typedef std::function<rgba_pixel_t(unsigned int x, unsigned int y)> pixel_function;
+
+        /**
+         * Pseudo random noise.
+         */
+        unsigned int noise(unsigned int seed, unsigned int x, unsigned int y);
+
+        /**
+         * A smooth (8x8 pixel blocks) pseudo random gray cell pattern.
+         */
+        unsigned int cell_pattern(unsigned int seed, unsigned int x, unsigned int y);
+
+        /**
+         * Create a background image, pixels are set tile by tile.
+         */
+        BackgroundImage_shptr create_background_image(unsigned int width, unsigned int height, pixel_function pixel);
+
+        /**
+         * Create a project with a single layer showing a background image.
+         * The layer is the current layer.
+         */
+        Project_shptr create_project(unsigned int width, unsigned int height,
+                                     Layer::LAYER_TYPE layer_type, pixel_function pixel);
+
+        /**
+         * Create horizontal and vertical wires, randomly placed.
+         */
+        std::vector<PlacedLogicModelObject_shptr> create_wires(unsigned int count,
+                                                               unsigned int width,
+                                                               unsigned int height,
+                                                               unsigned int seed);
+
+        /**
+         * Create vias, randomly placed.
+         */
+        std::vector<PlacedLogicModelObject_shptr> create_vias(unsigned int count,
+                                                              unsigned int width,
+                                                              unsigned int height,
+                                                              unsigned int seed);
+
+        /**
+         * Create a gate template, with an image (see cell_pattern()) on the transistor layer.
+         */
+        GateTemplate_shptr create_template(std::string const& name,
+                                           unsigned int width,
+                                           unsigned int height,
+                                           unsigned int seed);
+
+        /**
+         * Create the gate templates, with ports, of a gate library in a logic model.
+         */
+        std::vector<GateTemplate_shptr> create_gate_library(LogicModel_shptr lmodel,
+                                                            unsigned int templates,
+                                                            unsigned int seed);
+
+        /**
+         * Place gates of the templates, on a grid, with their ports.
+         */
+        void place_gates(LogicModel_shptr lmodel,
+                         std::vector<GateTemplate_shptr> const& templates,
+                         unsigned int count,
+                         unsigned int seed);
+    }
+}
+
+#endif
@@ -33,6 +33,11 @@ uint_fast64_t Configuration::get_max_tile_cache_size()
     return static_cast<uint_fast64_t>(PREFERENCES_HANDLER.get_preferences().cache_size);
 }
 
+uint_fast64_t Configuration::get_max_matching_cache_size()
+{
+    return static_cast<uint_fast64_t>(PREFERENCES_HANDLER.get_preferences().matching_cache_size);
+}
+
 unsigned int Configuration::get_max_concurrent_thread_count()
 {
     const auto& pref = PREFERENCES_HANDLER.get_preferences();
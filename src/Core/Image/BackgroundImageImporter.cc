@@ -0,0 +1,491 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Image/BackgroundImageImporter.h"
+#include "Core/Image/Image.h"
+#include "Core/Utils/BoundedQueue.h"
+#include "Core/Utils/DegateExceptions.h"
+#include "Core/Utils/FileSystem.h"
+
+#include <boost/format.hpp>
+#include <boost/range/counting_range.hpp>
+
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace degate;
+
+namespace
+{
+    /**
+     * A tile waiting to be written.
+     */
+    struct tile_job
+    {
+        std::string path;
+        std::vector<rgba_pixel_t> pixels;
+    };
+
+    /**
+     * A level of the image pyramid (0 is the source image).
+     */
+    struct level
+    {
+        std::string directory;
+        unsigned int width, height;
+
+        // Rows of the current tile row, when they are received in several parts
+        std::vector<rgba_pixel_t> band;
+        unsigned int band_rows = 0;
+        unsigned int band_y = 0;
+    };
+
+    /**
+     * Decoded strips, handed over in order to the consumer. Decode threads can run
+     * ahead of the consumer by a fixed number of strips only.
+     */
+    class ordered_strips
+    {
+    private:
+
+        std::map<unsigned int, std::vector<rgba_pixel_t>> decoded;
+        unsigned int next_strip = 0, consumed = 0;
+        unsigned int strip_count, max_ahead;
+        bool aborted = false;
+
+        std::mutex mtx;
+        std::condition_variable cv;
+
+    public:
+
+        ordered_strips(unsigned int strip_count, unsigned int max_ahead)
+            : strip_count(strip_count), max_ahead(max_ahead)
+        {
+        }
+
+        /**
+         * Get the next strip to decode.
+         * @return Returns false if there is no strip left.
+         */
+        bool claim(unsigned int& strip)
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this] { return aborted || next_strip >= strip_count || next_strip < consumed + max_ahead; });
+
+            if (aborted || next_strip >= strip_count)
+                return false;
+
+            strip = next_strip++;
+            return true;
+        }
+
+        void add(unsigned int strip, std::vector<rgba_pixel_t>&& pixels)
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            decoded[strip] = std::move(pixels);
+            cv.notify_all();
+        }
+
+        /**
+         * Wait for a strip, strips must be taken in order.
+         * @return Returns false if the import was aborted.
+         */
+        bool take(unsigned int strip, std::vector<rgba_pixel_t>& pixels)
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [&] { return aborted || decoded.count(strip) > 0; });
+
+            if (aborted)
+                return false;
+
+            auto found = decoded.find(strip);
+            pixels = std::move(found->second);
+            decoded.erase(found);
+
+            consumed = strip + 1;
+            cv.notify_all();
+
+            return true;
+        }
+
+        void abort()
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            aborted = true;
+            cv.notify_all();
+        }
+    };
+
+    /**
+     * Tile split and downsample stages.
+     */
+    class pyramid_builder
+    {
+    private:
+
+        std::vector<level>& levels;
+        unsigned int tile_size;
+        BoundedQueue<tile_job>& tiles;
+
+    public:
+
+        pyramid_builder(std::vector<level>& levels, unsigned int tile_size, BoundedQueue<tile_job>& tiles)
+            : levels(levels), tile_size(tile_size), tiles(tiles)
+        {
+        }
+
+        /**
+         * Add the next rows of a level.
+         */
+        void push_rows(std::size_t index, const rgba_pixel_t* data, unsigned int rows)
+        {
+            level& l = levels[index];
+
+            while (rows > 0 && l.band_y * tile_size + l.band_rows < l.height)
+            {
+                const unsigned int band_height = std::min(tile_size, l.height - l.band_y * tile_size);
+
+                // Whole tile rows are processed without copy
+                if (l.band_rows == 0 && rows >= band_height)
+                {
+                    process_band(index, data, band_height);
+
+                    data += static_cast<std::size_t>(band_height) * l.width;
+                    rows -= band_height;
+                    continue;
+                }
+
+                if (l.band.empty())
+                    l.band.resize(static_cast<std::size_t>(tile_size) * l.width);
+
+                const unsigned int count = std::min(rows, band_height - l.band_rows);
+                std::copy(data, data + static_cast<std::size_t>(count) * l.width,
+                          l.band.begin() + static_cast<std::size_t>(l.band_rows) * l.width);
+
+                l.band_rows += count;
+                data += static_cast<std::size_t>(count) * l.width;
+                rows -= count;
+
+                if (l.band_rows == band_height)
+                {
+                    l.band_rows = 0;
+                    process_band(index, l.band.data(), band_height);
+                }
+            }
+        }
+
+    private:
+
+        /**
+         * Split a tile row in tiles and downsample it into the next level.
+         */
+        void process_band(std::size_t index, const rgba_pixel_t* data, unsigned int rows)
+        {
+            level& l = levels[index];
+            const unsigned int band_y = l.band_y++;
+
+            for (unsigned int tile_x = 0; tile_x * tile_size < l.width; tile_x++)
+            {
+                tile_job job;
+                job.path = join_pathes(l.directory, (boost::format("%1%_%2%.dat") % tile_x % band_y).str());
+                job.pixels.assign(static_cast<std::size_t>(tile_size) * tile_size, 0);
+
+                const unsigned int
+                    min_x = tile_x * tile_size,
+                    columns = std::min(tile_size, l.width - min_x);
+
+                for (unsigned int y = 0; y < rows; y++)
+                {
+                    const rgba_pixel_t* src = data + static_cast<std::size_t>(y) * l.width + min_x;
+                    std::copy(src, src + columns, job.pixels.begin() + static_cast<std::size_t>(y) * tile_size);
+                }
+
+                // Closed if a tile can't be written
+                if (!tiles.push(std::move(job)))
+                    return;
+            }
+
+            if (index + 1 >= levels.size())
+                return;
+
+            // Tile rows are even, except the last one: its last row is dropped, like the
+            // last column of an odd width.
+            const unsigned int
+                dst_width = levels[index + 1].width,
+                dst_rows = rows / 2,
+                src_width = l.width;
+
+            std::vector<rgba_pixel_t> scaled(static_cast<std::size_t>(dst_width) * dst_rows);
+
+            std::function<void(const unsigned int&)> downsample = [&](const unsigned int& dst_y)
+            {
+                const rgba_pixel_t* src_0 = data + static_cast<std::size_t>(2 * dst_y) * src_width;
+                const rgba_pixel_t* src_1 = src_0 + src_width;
+                rgba_pixel_t* dst = &scaled[static_cast<std::size_t>(dst_y) * dst_width];
+
+                for (unsigned int x = 0; x < dst_width; x++)
+                {
+                    // 1 2
+                    // 3 4
+                    const rgba_pixel_t p1 = src_0[2 * x], p2 = src_0[2 * x + 1], p3 = src_1[2 * x], p4 = src_1[2 * x + 1];
+
+                    const unsigned int
+                        r = (MASK_R(p1) + MASK_R(p2) + MASK_R(p3) + MASK_R(p4)) / 4,
+                        g = (MASK_G(p1) + MASK_G(p2) + MASK_G(p3) + MASK_G(p4)) / 4,
+                        b = (MASK_B(p1) + MASK_B(p2) + MASK_B(p3) + MASK_B(p4)) / 4,
+                        a = (MASK_A(p1) + MASK_A(p2) + MASK_A(p3) + MASK_A(p4)) / 4;
+
+                    dst[x] = MERGE_CHANNELS(r, g, b, a);
+                }
+            };
+
+            const auto& it = boost::counting_range<unsigned int>(0, dst_rows);
+            QtConcurrent::blockingMap(it, downsample);
+
+            push_rows(index + 1, scaled.data(), dst_rows);
+        }
+    };
+
+    void write_tile(tile_job const& job)
+    {
+        std::ofstream file(job.path, std::ios::out | std::ios::binary | std::ios::trunc);
+
+        file.write(reinterpret_cast<const char*>(job.pixels.data()),
+                   static_cast<std::streamsize>(job.pixels.size() * sizeof(rgba_pixel_t)));
+
+        if (!file)
+            throw DegateRuntimeException("Can't write the background image tile " + job.path + ".");
+    }
+}
+
+double BackgroundImageImporter::statistics::get_throughput() const
+{
+    if (seconds <= 0)
+        return 0;
+
+    return static_cast<double>(decoded_bytes) / (1024.0 * 1024.0) / seconds;
+}
+
+BackgroundImageImporter::BackgroundImageImporter(std::string const& directory,
+                                                 unsigned int width,
+                                                 unsigned int height,
+                                                 unsigned int tile_size,
+                                                 strip_decoder decoder)
+    : directory(directory),
+      width(width),
+      height(height),
+      tile_size(tile_size),
+      decoder(std::move(decoder)),
+      memory_budget(uint_fast64_t(256) * 1024 * 1024),
+      decode_threads(1)
+{
+    assert(tile_size >= 2 && (tile_size & (tile_size - 1)) == 0);
+}
+
+void BackgroundImageImporter::set_memory_budget(uint_fast64_t bytes)
+{
+    memory_budget = bytes;
+}
+
+void BackgroundImageImporter::set_decode_threads(unsigned int threads)
+{
+    decode_threads = std::max(1u, threads);
+}
+
+unsigned int BackgroundImageImporter::get_strip_height() const
+{
+    // Strips being decoded, waiting in order and being processed
+    const uint_fast64_t
+        strips = decode_threads + 2,
+        row_size = std::max<uint_fast64_t>(1, static_cast<uint_fast64_t>(width) * sizeof(rgba_pixel_t));
+
+    uint_fast64_t rows = memory_budget / (strips * row_size);
+    rows = (rows / tile_size) * tile_size;
+
+    const uint_fast64_t max_rows = ((static_cast<uint_fast64_t>(height) + tile_size - 1) / tile_size) * tile_size;
+
+    return static_cast<unsigned int>(std::max<uint_fast64_t>(tile_size, std::min(rows, max_rows)));
+}
+
+BackgroundImageImporter::statistics BackgroundImageImporter::run()
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    statistics stats;
+
+    // Same scaling levels as ScalingManager
+    std::vector<level> levels;
+    levels.push_back({directory, width, height});
+
+    unsigned int w = width, h = height;
+    for (unsigned int i = 2; (h > tile_size || w > tile_size) && i < (1u << 24u); i *= 2) // max 24 scaling levels
+    {
+        w >>= 1u;
+        h >>= 1u;
+
+        levels.push_back({join_pathes(directory, (boost::format("scaling_%1%.dimg") % i).str()), w, h});
+    }
+
+    for (auto const& l : levels)
+    {
+        if (!file_exists(l.directory))
+            create_directory(l.directory);
+    }
+
+    const unsigned int
+        strip_height = get_strip_height(),
+        strip_count = (height + strip_height - 1) / strip_height,
+        writer_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    ordered_strips strips(strip_count, decode_threads + 1);
+    BoundedQueue<tile_job> tiles(4 * writer_threads);
+
+    std::mutex error_mtx;
+    std::string error;
+
+    auto fail = [&](std::string const& message)
+    {
+        {
+            std::lock_guard<std::mutex> lock(error_mtx);
+            if (error.empty())
+                error = message;
+        }
+
+        strips.abort();
+        tiles.close();
+    };
+
+    std::atomic<uint_fast64_t> written_bytes(0);
+    std::atomic<unsigned int> written_tiles(0);
+
+    // Decode stage
+    std::vector<std::thread> decoders;
+    for (unsigned int t = 0; t < std::min(decode_threads, std::max(1u, strip_count)); t++)
+    {
+        decoders.emplace_back([&]
+        {
+            unsigned int strip;
+            while (strips.claim(strip))
+            {
+                const unsigned int
+                    min_y = strip * strip_height,
+                    rows = std::min(strip_height, height - min_y);
+
+                std::vector<rgba_pixel_t> pixels;
+
+                bool decoded = false;
+                try
+                {
+                    decoded = decoder(min_y, rows, pixels) &&
+                              pixels.size() == static_cast<std::size_t>(width) * rows;
+                }
+                catch (std::exception const& e)
+                {
+                    fail(e.what());
+                    return;
+                }
+
+                if (!decoded)
+                {
+                    fail((boost::format("Can't decode the rows %1% to %2% of the background image.") %
+                          min_y % (min_y + rows - 1)).str());
+                    return;
+                }
+
+                strips.add(strip, std::move(pixels));
+            }
+        });
+    }
+
+    // Write stage
+    std::vector<std::thread> writers;
+    for (unsigned int t = 0; t < writer_threads; t++)
+    {
+        writers.emplace_back([&]
+        {
+            tile_job job;
+            while (tiles.pop(job))
+            {
+                try
+                {
+                    write_tile(job);
+                }
+                catch (std::exception const& e)
+                {
+                    fail(e.what());
+                    return;
+                }
+
+                written_bytes += job.pixels.size() * sizeof(rgba_pixel_t);
+                written_tiles++;
+            }
+        });
+    }
+
+    // Tile split and downsample stages
+    pyramid_builder builder(levels, tile_size, tiles);
+
+    try
+    {
+        std::vector<rgba_pixel_t> pixels;
+        for (unsigned int strip = 0; strip < strip_count && strips.take(strip, pixels); strip++)
+        {
+            const unsigned int rows = std::min(strip_height, height - strip * strip_height);
+            builder.push_rows(0, pixels.data(), rows);
+
+            stats.decoded_bytes += static_cast<uint_fast64_t>(width) * rows * sizeof(rgba_pixel_t);
+            stats.strips++;
+        }
+    }
+    catch (std::exception const& e)
+    {
+        fail(e.what());
+    }
+
+    tiles.close();
+
+    for (auto& thread : writers)
+        thread.join();
+
+    strips.abort();
+
+    for (auto& thread : decoders)
+        thread.join();
+
+    if (!error.empty())
+        throw DegateRuntimeException(error);
+
+    stats.written_bytes = written_bytes;
+    stats.tiles = written_tiles;
+    stats.levels = static_cast<unsigned int>(levels.size());
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return stats;
+}
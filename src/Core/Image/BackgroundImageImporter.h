@@ -0,0 +1,134 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __BACKGROUNDIMAGEIMPORTER_H__
+#define __BACKGROUNDIMAGEIMPORTER_H__
+
+#include "Core/Image/PixelPolicies.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace degate
+{
+    /**
+     * @class BackgroundImageImporter
+     * @brief Convert a source image to the Degate tile format, with all its scaling levels.
+     *
+     * The source image is decoded once, in horizontal strips from top to bottom. Strips
+     * go through a pipeline of stages connected with bounded queues:
+     * - decode: strips are decoded (possibly by several threads) and reordered;
+     * - tile split: rows are cut into tiles of the current level;
+     * - downsample: rows are scaled down by 2 into the next level (like scale_down_by_2()),
+     *   which is then split and downsampled the same way;
+     * - write: tiles are written to \p directory ("scaling_N.dimg" sub-directories for
+     *   the scaling levels) by writer threads.
+     *
+     * The memory in use is bounded by the memory budget, whatever the image size, plus
+     * the memory held by the decoder (e.g. a decoder that can't decode a strip alone
+     * holds the whole decoded image).
+     */
+    class BackgroundImageImporter
+    {
+    public:
+
+        /**
+         * Decode rows [min_y, min_y + height) of the source image, row by row.
+         * It can be called concurrently if more than one decode thread is used.
+         *
+         * @param pixels The decoded pixels (width * height values).
+         * @return Returns false if the rows can't be decoded.
+         */
+        typedef std::function<bool(unsigned int min_y, unsigned int height, std::vector<rgba_pixel_t>& pixels)>
+            strip_decoder;
+
+        /**
+         * Import statistics.
+         */
+        struct statistics
+        {
+            uint_fast64_t decoded_bytes = 0;
+            uint_fast64_t written_bytes = 0;
+            unsigned int strips = 0;
+            unsigned int tiles = 0;
+            unsigned int levels = 0;
+            double seconds = 0;
+
+            /**
+             * Get the import throughput, in MB of decoded source pixels per second.
+             */
+            double get_throughput() const;
+        };
+
+        /**
+         * Create an importer.
+         *
+         * @param directory The directory of the background image (created if needed).
+         * @param width The width of the source image.
+         * @param height The height of the source image.
+         * @param tile_size The tile size of the background image (a power of 2).
+         * @param decoder The source image decoder.
+         */
+        BackgroundImageImporter(std::string const& directory,
+                                unsigned int width,
+                                unsigned int height,
+                                unsigned int tile_size,
+                                strip_decoder decoder);
+
+        /**
+         * Set the memory budget for the decoded strips (in bytes, 256 MB by default).
+         */
+        void set_memory_budget(uint_fast64_t bytes);
+
+        /**
+         * Set the number of decode threads (1 by default). Use more than one thread
+         * only if the decoder can decode a strip without decoding the whole image.
+         */
+        void set_decode_threads(unsigned int threads);
+
+        /**
+         * Get the height of the decoded strips (a multiple of the tile size).
+         */
+        unsigned int get_strip_height() const;
+
+        /**
+         * Run the import.
+         *
+         * @exception DegateRuntimeException This exception is thrown if a strip can't be
+         *   decoded or a tile can't be written.
+         * @return Returns the import statistics.
+         */
+        statistics run();
+
+    private:
+
+        std::string directory;
+        unsigned int width, height, tile_size;
+        strip_decoder decoder;
+
+        uint_fast64_t memory_budget;
+        unsigned int decode_threads;
+    };
+}
+
+#endif
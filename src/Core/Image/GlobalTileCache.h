@@ -25,8 +25,14 @@
 #include "Core/Image/TileCacheBase.h"
 #include "Core/Primitive/SingletonBase.h"
 
+#include <QThreadPool>
+
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 #include <utility>
 
 namespace degate
@@ -37,6 +43,11 @@ namespace degate
      * 
      * This can ask for every single tile cache to release memory if needed.
      * 
+     * All the methods are thread safe, tile caches can be used from several threads.
+     * If no cache can release memory because all the tiles are in use by other
+     * threads, the limit is exceeded by at most one request per thread of the
+     * global thread pool. Beyond that, requests are refused.
+     * 
      * @warning This is a singleton, only one instance can exists.
      */
     template<class PixelPolicy>
@@ -48,11 +59,25 @@ namespace degate
         uint_fast64_t max_cache_memory;
         uint_fast64_t allocated_memory;
 
-        typedef std::pair<struct timespec, uint_fast64_t> cache_entry_t;
-        typedef std::map<TileCacheBase*, cache_entry_t> cache_t;
+        typedef std::list<TileCacheBase*> lru_t;
+
+        struct cache_entry_t
+        {
+            struct timespec last_access;
+            uint_fast64_t amount;
+            lru_t::iterator lru_position;
+        };
+
+        typedef std::unordered_map<TileCacheBase*, cache_entry_t> cache_t;
 
         cache_t cache;
 
+        // Holders ordered from the most recently to the least recently requesting one.
+        lru_t lru;
+
+        // Recursive, since a cleanup releases memory from within a request.
+        mutable std::recursive_mutex mtx;
+
     private:
         /**
          * Create a new global tile cache object (singleton).
@@ -66,43 +91,44 @@ namespace degate
         }
 
         /**
-         * Search for the oldest cache that requested memory and make it release memory.
+         * Make the least recently requesting cache release memory.
+         * The mutex must be held by the caller.
+         *
+         * If the oldest cache can't release anything (e.g. a tile still loading, or
+         * the cache is in use by another thread), the next oldest one is tried.
+         *
+         * @return Returns true if some memory was released, false otherwise.
          */
-        void remove_oldest()
+        bool remove_oldest()
         {
-            struct timespec now;
-            GET_CLOCK(now);
-
-            TileCacheBase* oldest = nullptr;
-
-            // Search for oldest cache
-            for (auto iter = cache.begin(); iter != cache.end(); ++iter)
+            for (std::size_t tries = lru.size(); tries > 0 && !lru.empty(); tries--)
             {
-                cache_entry_t& entry = iter->second;
-                if (entry.first < now)
-                {
-                    now.tv_sec = entry.first.tv_sec;
-                    now.tv_nsec = entry.first.tv_nsec;
-                    oldest = iter->first;
-                }
-            }
+                TileCacheBase* oldest = lru.back();
 
-            if (oldest != nullptr)
-            {
 #ifdef TILECACHE_DEBUG
                 debug(TM, "Will call cleanup on %p", oldest);
 #endif
 
-                // If found, make the oldest release memory
+                const uint_fast64_t previously_allocated = allocated_memory;
+
+                // Make the oldest release memory
                 oldest->cleanup_cache();
+
+                if (allocated_memory < previously_allocated)
+                    return true;
+
+                // Nothing released, move it to the front to give a chance to the next one
+                auto found = cache.find(oldest);
+                if (found != cache.end())
+                    lru.splice(lru.begin(), lru, found->second.lru_position);
             }
-            else
-            {
+
 #ifdef TILECACHE_DEBUG
-                debug(TM, "there is nothing to free.");
-                print_table();
+            debug(TM, "there is nothing to free.");
+            print_table();
 #endif
-            }
+
+            return false;
         }
 
     public:
@@ -111,24 +137,27 @@ namespace degate
          */
         void print_table() const
         {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+
             std::cout << "Global Image Tile Cache:\n"
                       << "Used memory : " << allocated_memory << " bytes\n"
                       << "Max memory  : " << max_cache_memory << " bytes\n\n"
                       << "Holder           | Last access (sec,nsec)    | Amount of memory\n"
                       << "-----------------+---------------------------+------------------------------------\n";
 
-            for (auto iter = cache.begin(); iter != cache.end(); ++iter)
+            // Most recently used first
+            for (auto holder : lru)
             {
-                cache_entry_t const& entry = iter->second;
-                std::cout << std::setw(16) << std::hex << static_cast<void*>(iter->first);
+                cache_entry_t const& entry = cache.at(holder);
+                std::cout << std::setw(16) << std::hex << static_cast<void*>(holder);
                 std::cout << " | ";
-                std::cout << std::setw(12) << entry.first.tv_sec;
+                std::cout << std::setw(12) << entry.last_access.tv_sec;
                 std::cout << ".";
-                std::cout << std::setw(12) << entry.first.tv_nsec;
+                std::cout << std::setw(12) << entry.last_access.tv_nsec;
                 std::cout << " | ";
-                std::cout << entry.second / static_cast<unsigned long>(1024 * 1024) << " M (" << entry.second
+                std::cout << entry.amount / static_cast<unsigned long>(1024 * 1024) << " M (" << entry.amount
                           << " bytes)\n";
-                iter->first->print();
+                holder->print();
             }
             std::cout << "\n";
         }
@@ -137,9 +166,14 @@ namespace degate
          * Request memory from the cache (this is virtual).
          * 
          * If too less memory remaining, then will call remove_oldest().
+         *
+         * @return Returns false if the memory can't be allocated, even over the
+         *      limit (see get_over_commit_limit()).
          */
         bool request_cache_memory(TileCacheBase* requestor, uint_fast64_t amount)
         {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+
 #ifdef TILECACHE_DEBUG
             debug(TM, "Local cache %p requests %d bytes.", requestor, amount);
 #endif
@@ -148,10 +182,13 @@ namespace degate
 #ifdef TILECACHE_DEBUG
                 debug(TM, "Try to free memory");
 #endif
-                remove_oldest();
+                if (!remove_oldest())
+                    break;
             }
 
-            if (allocated_memory + amount <= max_cache_memory)
+            // If the memory is held by tiles in use by other threads, go over the limit
+            // for now (bounded), the memory will be released by the next requests.
+            if (allocated_memory + amount <= max_cache_memory + get_over_commit_limit(amount))
             {
                 struct timespec now
                 {
@@ -161,14 +198,16 @@ namespace degate
                 auto found = cache.find(requestor);
                 if (found == cache.end())
                 {
-                    cache[requestor] = std::make_pair(now, amount);
+                    lru.push_front(requestor);
+                    cache[requestor] = cache_entry_t{now, amount, lru.begin()};
                 }
                 else
                 {
                     cache_entry_t& entry = found->second;
-                    entry.first.tv_sec = now.tv_sec;
-                    entry.first.tv_nsec = now.tv_nsec;
-                    entry.second += amount;
+                    entry.last_access.tv_sec = now.tv_sec;
+                    entry.last_access.tv_nsec = now.tv_nsec;
+                    entry.amount += amount;
+                    lru.splice(lru.begin(), lru, entry.lru_position);
                 }
 
                 allocated_memory += amount;
@@ -180,7 +219,9 @@ namespace degate
 
             debug(TM, "Can't free memory.");
 
+#ifdef TILECACHE_DEBUG
             print_table();
+#endif
             return false;
         }
 
@@ -189,6 +230,8 @@ namespace degate
          */
         void release_cache_memory(TileCacheBase* requestor, uint_fast64_t amount)
         {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+
 #ifdef TILECACHE_DEBUG
             debug(TM, "Local cache %p releases %d bytes.", requestor, amount);
 #endif
@@ -205,9 +248,9 @@ namespace degate
             {
                 cache_entry_t& entry = found->second;
 
-                if (entry.second >= amount)
+                if (entry.amount >= amount)
                 {
-                    entry.second -= amount;
+                    entry.amount -= amount;
                     assert(allocated_memory >= amount);
                     if (allocated_memory >= amount)
                         allocated_memory -= amount;
@@ -221,14 +264,15 @@ namespace degate
                 else
                 {
                     print_table();
-                    assert(entry.second >= amount); // will break
+                    assert(entry.amount >= amount); // will break
                 }
 
-                if (entry.second == 0)
+                if (entry.amount == 0)
                 {
 #ifdef TILECACHE_DEBUG
                     debug(TM, "Memory completely released. Remove entry from global cache.");
 #endif
+                    lru.erase(entry.lru_position);
                     cache.erase(found);
                 }
             }
@@ -239,13 +283,24 @@ namespace degate
             return max_cache_memory;
         }
 
+        /**
+         * Get how much memory can be allocated over the limit, when no cache can
+         * release memory: one request of \p amount per thread of the global thread pool.
+         */
+        inline uint_fast64_t get_over_commit_limit(uint_fast64_t amount) const
+        {
+            return amount * static_cast<uint_fast64_t>(std::max(1, QThreadPool::globalInstance()->maxThreadCount()));
+        }
+
         inline uint_fast64_t get_allocated_memory() const
         {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
             return allocated_memory;
         }
 
         inline bool is_full(uint_fast64_t amount) const
         {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
             return allocated_memory + amount > max_cache_memory;
         }
     };
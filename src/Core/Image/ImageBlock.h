@@ -0,0 +1,332 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __IMAGEBLOCK_H__
+#define __IMAGEBLOCK_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace degate
+{
+    /**
+     * @class ImageBlock
+     * @brief A rectangular block of pixels with direct access to the image storage.
+     *
+     * Rows of a block are contiguous in memory and are separated by a stride. A block
+     * never crosses a tile border, so it can be obtained from every storage policy
+     * (memory, file and tile based). For tile based images, the block keeps a reference
+     * on its tile, so the pixel data stays valid as long as the block exists.
+     *
+     * Use a block of const pixels for a read-only view.
+     *
+     * @see StoragePolicy_Base::get_block()
+     */
+    template <typename PixelType>
+    class ImageBlock
+    {
+    public:
+        typedef PixelType pixel_type;
+
+        /**
+         * Create an empty block.
+         */
+        ImageBlock() = default;
+
+        /**
+         * Create a new block.
+         *
+         * @param data : pointer to the first pixel of the block.
+         * @param min_x : the x coordinate of the block in the image.
+         * @param min_y : the y coordinate of the block in the image.
+         * @param width : the width of the block.
+         * @param height : the height of the block.
+         * @param stride : the distance (in pixels) between two rows.
+         * @param owner : keep alive reference on the storage (can be null).
+         */
+        ImageBlock(PixelType* data,
+                   unsigned int min_x,
+                   unsigned int min_y,
+                   unsigned int width,
+                   unsigned int height,
+                   std::size_t stride,
+                   std::shared_ptr<const void> owner = nullptr)
+            : data(data),
+              min_x(min_x),
+              min_y(min_y),
+              width(width),
+              height(height),
+              stride(stride),
+              owner(std::move(owner))
+        {
+        }
+
+        /**
+         * Get the x coordinate of the block in the image.
+         */
+        inline unsigned int get_min_x() const
+        {
+            return min_x;
+        }
+
+        /**
+         * Get the y coordinate of the block in the image.
+         */
+        inline unsigned int get_min_y() const
+        {
+            return min_y;
+        }
+
+        inline unsigned int get_width() const
+        {
+            return width;
+        }
+
+        inline unsigned int get_height() const
+        {
+            return height;
+        }
+
+        /**
+         * Get the distance (in pixels) between two rows.
+         */
+        inline std::size_t get_stride() const
+        {
+            return stride;
+        }
+
+        inline bool is_empty() const
+        {
+            return width == 0 || height == 0;
+        }
+
+        /**
+         * Get a pointer on the first pixel of a row.
+         *
+         * @param row : the row, relative to the block (0 is the first row of the block).
+         */
+        inline PixelType* get_row(unsigned int row) const
+        {
+            return data + row * stride;
+        }
+
+        /**
+         * Get a pixel, coordinates are relative to the block.
+         */
+        inline PixelType& at(unsigned int x, unsigned int y) const
+        {
+            return data[y * stride + x];
+        }
+
+    private:
+        PixelType* data = nullptr;
+        unsigned int min_x = 0;
+        unsigned int min_y = 0;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        std::size_t stride = 0;
+        std::shared_ptr<const void> owner;
+    };
+
+    /**
+     * @class ImageRegionBlocks
+     * @brief Walk all the blocks (tiles) of an image region, row of tiles by row of tiles.
+     *
+     * Use a const image type to get read-only blocks:
+     *
+     * @code
+     * for (auto const& block : ImageRegionBlocks<const TileImage_RGBA>(img, 0, 0, 512, 512))
+     *     for (unsigned int y = 0; y < block.get_height(); y++)
+     *         process(block.get_row(y), block.get_width());
+     * @endcode
+     */
+    template <typename ImageType>
+    class ImageRegionBlocks
+    {
+    public:
+        typedef decltype(std::declval<ImageType&>().get_block(0, 0, 0, 0)) block_type;
+
+        /**
+         * @class iterator
+         * @brief Forward iterator over the blocks of the region.
+         */
+        class iterator
+        {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef block_type value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const block_type* pointer;
+            typedef const block_type& reference;
+
+            iterator() = default;
+
+            iterator(ImageRegionBlocks const* region, unsigned int x, unsigned int y)
+                : region(region), x(x), y(y)
+            {
+                load();
+            }
+
+            inline reference operator*() const
+            {
+                return block;
+            }
+
+            inline pointer operator->() const
+            {
+                return &block;
+            }
+
+            inline iterator& operator++()
+            {
+                // All the blocks of a row of tiles have the same height (tiles are aligned)
+                if (x == region->min_x)
+                    band_height = block.get_height();
+
+                x += block.get_width();
+                if (x >= region->max_x)
+                {
+                    x = region->min_x;
+                    y += band_height;
+                }
+
+                load();
+                return *this;
+            }
+
+            inline bool operator==(iterator const& other) const
+            {
+                return x == other.x && y == other.y;
+            }
+
+            inline bool operator!=(iterator const& other) const
+            {
+                return !(*this == other);
+            }
+
+        private:
+            inline void load()
+            {
+                if (region == nullptr || y >= region->max_y)
+                {
+                    x = region != nullptr ? region->min_x : 0;
+                    block = block_type();
+                    return;
+                }
+
+                block = region->img->get_block(x, y, region->max_x - x, region->max_y - y);
+
+                // Storage bounds reached (region bigger than the image)
+                if (block.is_empty())
+                {
+                    x = region->min_x;
+                    y = region->max_y;
+                }
+            }
+
+            ImageRegionBlocks const* region = nullptr;
+            unsigned int x = 0;
+            unsigned int y = 0;
+            unsigned int band_height = 0;
+            block_type block;
+        };
+
+        /**
+         * Create a new block walker, the region is clipped to the image size.
+         *
+         * @param img : the image.
+         * @param min_x : the x coordinate of the upper left corner of the region.
+         * @param min_y : the y coordinate of the upper left corner of the region.
+         * @param width : the width of the region.
+         * @param height : the height of the region.
+         */
+        ImageRegionBlocks(std::shared_ptr<ImageType> img,
+                          unsigned int min_x,
+                          unsigned int min_y,
+                          unsigned int width,
+                          unsigned int height)
+            : img(std::move(img)),
+              min_x(min_x),
+              min_y(min_y),
+              max_x(std::min(min_x + width, this->img->get_width())),
+              max_y(std::min(min_y + height, this->img->get_height()))
+        {
+        }
+
+        inline iterator begin() const
+        {
+            if (min_x >= max_x || min_y >= max_y)
+                return end();
+
+            return iterator(this, min_x, min_y);
+        }
+
+        inline iterator end() const
+        {
+            return iterator(this, min_x, std::max(min_y, max_y));
+        }
+
+    private:
+        std::shared_ptr<ImageType> img;
+        unsigned int min_x;
+        unsigned int min_y;
+        unsigned int max_x;
+        unsigned int max_y;
+    };
+
+    /**
+     * Call a function on each contiguous segment of an image row.
+     *
+     * Rows are visited from left to right, so the pixel order is the same as with
+     * a classic get_pixel() loop.
+     *
+     * @param img : the image.
+     * @param min_x : the x coordinate of the first pixel.
+     * @param y : the row.
+     * @param width : the number of pixels to visit (clipped to the image width).
+     * @param func : the function, called with the x coordinate of the segment, a pointer
+     *      on its first pixel and its length.
+     */
+    template <typename ImageType, typename Function>
+    void for_each_row_segment(std::shared_ptr<ImageType> const& img,
+                              unsigned int min_x,
+                              unsigned int y,
+                              unsigned int width,
+                              Function&& func)
+    {
+        const unsigned int max_x = std::min(min_x + width, img->get_width());
+
+        for (unsigned int x = min_x; x < max_x;)
+        {
+            auto segment = img->get_block(x, y, max_x - x, 1);
+            if (segment.is_empty())
+                return;
+
+            func(x, segment.get_row(0), segment.get_width());
+            x += segment.get_width();
+        }
+    }
+} // namespace degate
+
+#endif //__IMAGEBLOCK_H__
@@ -23,6 +23,7 @@
 #define __IMAGESTATISTICS_H__
 
 #include "Core/Primitive/BoundingBox.h"
+#include "Core/Image/ImageBlock.h"
 #include "Core/Image/Manipulation/ImageManipulation.h"
 
 namespace degate
@@ -32,6 +33,9 @@ namespace degate
     inline PixelTypeDst get_pixel_as(typename std::shared_ptr<ImageTypeSrc> img,
                                      unsigned int x, unsigned int y);
 
+    template <typename PixelTypeDst, typename PixelTypeSrc>
+    inline PixelTypeDst convert_pixel(PixelTypeSrc p);
+
     /**
      * Get the minimum pixel value of a single channel image.
      */
@@ -118,21 +122,28 @@ namespace degate
         if (height == 0 || width == 0)
             throw DegateRuntimeException("Can't calculate average for an image.");
 
+        // Rows are read segment by segment, directly from the image storage
+        std::shared_ptr<const ImageType> view = img;
+
         for (unsigned int y = start_y; y < start_y + height; y++)
-            for (unsigned int x = start_x; x < start_x + width; x++)
-            {
-                sum += img->template get_pixel_as<gs_double_pixel_t>(x, y);
-            }
+            for_each_row_segment(view, start_x, y, width,
+                                 [&](unsigned int, const typename ImageType::pixel_type* row, unsigned int length)
+                                 {
+                                     for (unsigned int i = 0; i < length; i++)
+                                         sum += convert_pixel<gs_double_pixel_t, typename ImageType::pixel_type>(row[i]);
+                                 });
 
         *avg = sum / (double)(height * width);
 
         sum = 0;
 
         for (unsigned int y = start_y; y < start_y + height; y++)
-            for (unsigned int x = start_x; x < start_x + width; x++)
-            {
-                sum += pow(*avg - img->template get_pixel_as<gs_double_pixel_t>(x, y), 2);
-            }
+            for_each_row_segment(view, start_x, y, width,
+                                 [&](unsigned int, const typename ImageType::pixel_type* row, unsigned int length)
+                                 {
+                                     for (unsigned int i = 0; i < length; i++)
+                                         sum += pow(*avg - convert_pixel<gs_double_pixel_t, typename ImageType::pixel_type>(row[i]), 2);
+                                 });
 
         *stddev = sqrt(sum / (double)(height * width));
     }
@@ -0,0 +1,155 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Image/Manipulation/ConvolutionKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CONVOLUTION_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang need the target of functions using intrinsics, MSVC does not.
+#if defined(CONVOLUTION_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CONVOLUTION_KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define CONVOLUTION_KERNEL_TARGET(isa)
+#endif
+
+using namespace degate;
+
+namespace
+{
+    ConvolutionInstructionSet detect_instruction_set()
+    {
+#if !defined(CONVOLUTION_KERNEL_X86)
+        return ConvolutionInstructionSet::Scalar;
+#elif defined(_MSC_VER)
+        int info[4];
+
+        __cpuid(info, 1);
+        const bool sse2 = (info[3] & (1 << 26)) != 0;
+        const bool os_avx = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0 &&
+                            (_xgetbv(0) & 6) == 6; // xmm and ymm states saved by the OS
+
+        if (os_avx)
+            return ConvolutionInstructionSet::AVX;
+
+        return sse2 ? ConvolutionInstructionSet::SSE2 : ConvolutionInstructionSet::Scalar;
+#else
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx"))
+            return ConvolutionInstructionSet::AVX;
+
+        return __builtin_cpu_supports("sse2") ? ConvolutionInstructionSet::SSE2 : ConvolutionInstructionSet::Scalar;
+#endif
+    }
+
+
+    /* -------------------------------------------------------------------------- *
+     * scalar kernel (reference)
+     * -------------------------------------------------------------------------- */
+
+    void accumulate_row_scalar(double* out, const double* in, double weight, unsigned int length)
+    {
+        for (unsigned int i = 0; i < length; i++)
+            out[i] += weight * in[i];
+    }
+
+#ifdef CONVOLUTION_KERNEL_X86
+
+    /* -------------------------------------------------------------------------- *
+     * SSE2 kernel (2 values per step)
+     * -------------------------------------------------------------------------- */
+
+    CONVOLUTION_KERNEL_TARGET("sse2")
+    void accumulate_row_sse2(double* out, const double* in, double weight, unsigned int length)
+    {
+        const __m128d w = _mm_set1_pd(weight);
+
+        unsigned int i = 0;
+        for (; i + 4 <= length; i += 4)
+        {
+            _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(out + i), _mm_mul_pd(w, _mm_loadu_pd(in + i))));
+            _mm_storeu_pd(out + i + 2, _mm_add_pd(_mm_loadu_pd(out + i + 2), _mm_mul_pd(w, _mm_loadu_pd(in + i + 2))));
+        }
+
+        accumulate_row_scalar(out + i, in + i, weight, length - i);
+    }
+
+
+    /* -------------------------------------------------------------------------- *
+     * AVX kernel (4 values per step)
+     * -------------------------------------------------------------------------- */
+
+    CONVOLUTION_KERNEL_TARGET("avx")
+    void accumulate_row_avx(double* out, const double* in, double weight, unsigned int length)
+    {
+        const __m256d w = _mm256_set1_pd(weight);
+
+        unsigned int i = 0;
+        for (; i + 8 <= length; i += 8)
+        {
+            _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(out + i), _mm256_mul_pd(w, _mm256_loadu_pd(in + i))));
+            _mm256_storeu_pd(out + i + 4, _mm256_add_pd(_mm256_loadu_pd(out + i + 4), _mm256_mul_pd(w, _mm256_loadu_pd(in + i + 4))));
+        }
+
+        accumulate_row_scalar(out + i, in + i, weight, length - i);
+    }
+
+#endif
+}
+
+ConvolutionInstructionSet degate::get_convolution_instruction_set()
+{
+    static const ConvolutionInstructionSet instruction_set = detect_instruction_set();
+    return instruction_set;
+}
+
+bool degate::is_convolution_instruction_set_supported(ConvolutionInstructionSet instruction_set)
+{
+    return static_cast<int>(instruction_set) <= static_cast<int>(get_convolution_instruction_set());
+}
+
+void degate::convolution_accumulate_row(double* out,
+                                        const double* in,
+                                        double weight,
+                                        unsigned int length,
+                                        ConvolutionInstructionSet instruction_set)
+{
+    switch (instruction_set)
+    {
+#ifdef CONVOLUTION_KERNEL_X86
+    case ConvolutionInstructionSet::AVX:
+        accumulate_row_avx(out, in, weight, length);
+        break;
+    case ConvolutionInstructionSet::SSE2:
+        accumulate_row_sse2(out, in, weight, length);
+        break;
+#endif
+    default:
+        accumulate_row_scalar(out, in, weight, length);
+        break;
+    }
+}
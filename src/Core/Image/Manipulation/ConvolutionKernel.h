@@ -0,0 +1,63 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __CONVOLUTIONKERNEL_H__
+#define __CONVOLUTIONKERNEL_H__
+
+namespace degate
+{
+    /**
+     * Instruction sets supported by the convolution kernels.
+     */
+    enum class ConvolutionInstructionSet
+    {
+        Scalar,
+        SSE2,
+        AVX
+    };
+
+    /**
+     * Get the best instruction set supported by the running CPU (detected once).
+     */
+    ConvolutionInstructionSet get_convolution_instruction_set();
+
+    /**
+     * Check if an instruction set is supported by the running CPU.
+     */
+    bool is_convolution_instruction_set_supported(ConvolutionInstructionSet instruction_set);
+
+    /**
+     * Add a weighted row to a row: out[i] += weight * in[i].
+     *
+     * @param out The accumulated row.
+     * @param in The added row.
+     * @param weight The weight of the added row.
+     * @param length The number of values.
+     * @param instruction_set The instruction set to use, it must be supported.
+     */
+    void convolution_accumulate_row(double* out,
+                                    const double* in,
+                                    double weight,
+                                    unsigned int length,
+                                    ConvolutionInstructionSet instruction_set = get_convolution_instruction_set());
+}
+
+#endif
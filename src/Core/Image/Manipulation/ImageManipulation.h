@@ -24,9 +24,11 @@
 
 #include "Core/Primitive/BoundingBox.h"
 #include "Core/Image/Image.h"
+#include "Core/Image/ImageBlock.h"
 #include "Core/Utils/FilterKernel.h"
 #include "Core/Utils/Statistics.h"
 #include "Core/Image/ImageStatistics.h"
+#include "Core/Image/Manipulation/ConvolutionKernel.h"
 
 #include <boost/format.hpp>
 
@@ -204,6 +206,53 @@ namespace degate
     }
 
 
+    /**
+     * Transform a region of a source image into a destination image, pixel by pixel.
+     * The source region is walked block by block (tile by tile), and rows are
+     * accessed directly in the image storage. The source and the destination can be
+     * the same image, if the source and destination regions are the same.
+     *
+     * @param dst : the destination image.
+     * @param dst_x : the x coordinate of the region in the destination image.
+     * @param dst_y : the y coordinate of the region in the destination image.
+     * @param src : the source image.
+     * @param src_x : the x coordinate of the region in the source image.
+     * @param src_y : the y coordinate of the region in the source image.
+     * @param width : the width of the region.
+     * @param height : the height of the region.
+     * @param op : the operation, takes a source pixel and returns a destination pixel.
+     */
+    template <typename ImageTypeDst, typename ImageTypeSrc, typename Operation>
+    void transform_region(std::shared_ptr<ImageTypeDst> dst,
+                          unsigned int dst_x, unsigned int dst_y,
+                          std::shared_ptr<ImageTypeSrc> src,
+                          unsigned int src_x, unsigned int src_y,
+                          unsigned int width, unsigned int height,
+                          Operation op)
+    {
+        for (auto const& src_block : ImageRegionBlocks<const ImageTypeSrc>(src, src_x, src_y, width, height))
+        {
+            const unsigned int block_dst_x = dst_x + (src_block.get_min_x() - src_x);
+            const unsigned int block_dst_y = dst_y + (src_block.get_min_y() - src_y);
+
+            for (unsigned int row = 0; row < src_block.get_height(); row++)
+            {
+                const typename ImageTypeSrc::pixel_type* src_row = src_block.get_row(row);
+
+                // The destination can have another tiling, so it is split in row segments
+                for_each_row_segment(dst, block_dst_x, block_dst_y + row, src_block.get_width(),
+                                     [&](unsigned int x, typename ImageTypeDst::pixel_type* dst_row, unsigned int length)
+                                     {
+                                         const typename ImageTypeSrc::pixel_type* src_pixels = src_row + (x - block_dst_x);
+
+                                         for (unsigned int i = 0; i < length; i++)
+                                             dst_row[i] = op(src_pixels[i]);
+                                     });
+            }
+        }
+    }
+
+
     /**
      * Copy an image.
      * Copy the source image into the destination image. If the images differ in
@@ -219,9 +268,8 @@ namespace degate
         unsigned int h = std::min(src->get_height(), dst->get_height());
         unsigned int w = std::min(src->get_width(), dst->get_width());
 
-        for (unsigned int y = 0; y < h; y++)
-            for (unsigned int x = 0; x < w; x++)
-                dst->set_pixel(x, y, src->template get_pixel_as<typename ImageTypeDst::pixel_type>(x, y));
+        transform_region(dst, 0, 0, src, 0, 0, w, h,
+                         convert_pixel<typename ImageTypeDst::pixel_type, typename ImageTypeSrc::pixel_type>);
     }
 
 
@@ -242,14 +290,8 @@ namespace degate
         unsigned int h = std::min(std::min(std::min(src->get_height(), max_y), dst->get_height()), max_y - min_y);
         unsigned int w = std::min(std::min(std::min(src->get_width(), max_x), dst->get_width()), max_x - min_x);
 
-        unsigned int dst_x = 0, dst_y = 0, x, y;
-
-        for (y = min_y; y < min_y + h; y++, dst_y++)
-        {
-            for (x = min_x, dst_x = 0; x < min_x + w; x++, dst_x++)
-                dst->set_pixel(dst_x, dst_y,
-                               src->template get_pixel_as<typename ImageTypeDst::pixel_type>(x, y));
-        }
+        transform_region(dst, 0, 0, src, min_x, min_y, w, h,
+                         convert_pixel<typename ImageTypeDst::pixel_type, typename ImageTypeSrc::pixel_type>);
     }
 
     /**
@@ -288,12 +330,12 @@ namespace degate
         unsigned int h = std::min(src->get_height(), dst->get_height());
         unsigned int w = std::min(src->get_width(), dst->get_width());
 
-        for (unsigned int y = 0; y < h; y++)
-            for (unsigned int x = 0; x < w; x++)
-            {
-                gs_byte_pixel_t p = src->template get_pixel_as<gs_byte_pixel_t>(x, y);
-                dst->template set_pixel_as<gs_byte_pixel_t>(x, y, p);
-            }
+        transform_region(dst, 0, 0, src, 0, 0, w, h,
+                         [](typename ImageTypeSrc::pixel_type p)
+                         {
+                             gs_byte_pixel_t grey = convert_pixel<gs_byte_pixel_t, typename ImageTypeSrc::pixel_type>(p);
+                             return convert_pixel<typename ImageTypeDst::pixel_type, gs_byte_pixel_t>(grey);
+                         });
     }
 
     /**
@@ -453,6 +495,34 @@ namespace degate
     }
 
 
+    /**
+     * Normalize a pixel value.
+     * @see normalize()
+     */
+    inline double normalize_value(double p,
+                                  double shift, double factor,
+                                  double lower_bound, double upper_bound)
+    {
+        double d = (p + shift) * factor + lower_bound;
+        if (d < lower_bound)
+        {
+            if (abs(lower_bound - d) < 0.001)
+                d = lower_bound;
+            std::cout << "transformed value " << p << " beyond lower bound: " << d << std::endl;
+            //d = lower_bound;
+        }
+        else if (d > upper_bound)
+        {
+            if (abs(d - upper_bound) < 0.001)
+                d = upper_bound;
+            std::cout << "transformed value " << p << " beyond upper bound: " << d << std::endl;
+        }
+        assert(d >= lower_bound);
+        assert(d <= upper_bound);
+
+        return d;
+    }
+
     /**
      * Normalize a single channel image.
      * Source and destination image can be the same image.
@@ -495,22 +565,7 @@ namespace degate
                 typename ImageTypeDst::pixel_type p =
                     src->template get_pixel_as<typename ImageTypeDst::pixel_type>(x, y);
 
-                double d = ((double)p + shift) * factor + lower_bound;
-                if (d < lower_bound)
-                {
-                    if (abs(lower_bound - d) < 0.001)
-                        d = lower_bound;
-                    std::cout << "transformed value " << p << " beyond lower bound: " << d << std::endl;
-                    //d = lower_bound;
-                }
-                else if (d > upper_bound)
-                {
-                    if (abs(d - upper_bound) < 0.001)
-                        d = upper_bound;
-                    std::cout << "transformed value " << p << " beyond upper bound: " << d << std::endl;
-                }
-                assert(d >= lower_bound);
-                assert(d <= upper_bound);
+                double d = normalize_value((double)p, shift, factor, lower_bound, upper_bound);
                 dst->template set_pixel_as<double>(x, y, d);
             }
         }
@@ -554,6 +609,75 @@ namespace degate
         }
     }
 
+    /**
+     * Convolve a region with a separable filter kernel, a row pass then a column pass.
+     * Rows are processed as contiguous buffers with the vectorized convolution kernels.
+     *
+     * The destination pixel (dst_x + x, dst_y + y) is computed from the source pixels
+     * (src_x + x, src_y + y) to (src_x + x + columns - 1, src_y + y + rows - 1), which
+     * must be in the source image.
+     *
+     * @param horizontal The row vector of the kernel.
+     * @param vertical The column vector of the kernel.
+     * @see FilterKernel::get_separable_factors()
+     */
+    template <typename ImageTypeDst, typename ImageTypeSrc>
+    void convolve_separable(std::shared_ptr<ImageTypeDst> dst,
+                            unsigned int dst_x, unsigned int dst_y,
+                            std::shared_ptr<ImageTypeSrc> src,
+                            unsigned int src_x, unsigned int src_y,
+                            unsigned int width, unsigned int height,
+                            std::vector<double> const& horizontal,
+                            std::vector<double> const& vertical)
+    {
+        if (width == 0 || height == 0)
+            return;
+
+        const unsigned int columns = static_cast<unsigned int>(horizontal.size());
+        const unsigned int rows = static_cast<unsigned int>(vertical.size());
+        const unsigned int src_width = width + columns - 1;
+
+        std::vector<double> src_row(src_width);
+        std::vector<double> out_row(width);
+
+        // Rows after the row pass, for the last 'rows' source rows
+        std::vector<std::vector<double>> row_pass(rows, std::vector<double>(width));
+
+        for (unsigned int y = 0; y < height + rows - 1; y++)
+        {
+            for_each_row_segment(src, src_x, src_y + y, src_width,
+                                 [&](unsigned int x, const typename ImageTypeSrc::pixel_type* pixels, unsigned int length)
+                                 {
+                                     for (unsigned int i = 0; i < length; i++)
+                                         src_row[x - src_x + i] = static_cast<double>(pixels[i]);
+                                 });
+
+            // The kernel is mirrored, like in convolve()
+            std::vector<double>& filtered = row_pass[y % rows];
+            std::fill(filtered.begin(), filtered.end(), 0.0);
+
+            for (unsigned int i = 0; i < columns; i++)
+                convolution_accumulate_row(filtered.data(), src_row.data() + i, horizontal[columns - 1 - i], width);
+
+            if (y + 1 < rows)
+                continue;
+
+            const unsigned int out_y = y + 1 - rows;
+
+            std::fill(out_row.begin(), out_row.end(), 0.0);
+
+            for (unsigned int j = 0; j < rows; j++)
+                convolution_accumulate_row(out_row.data(), row_pass[(out_y + j) % rows].data(), vertical[rows - 1 - j], width);
+
+            for_each_row_segment(dst, dst_x, dst_y + out_y, width,
+                                 [&](unsigned int x, typename ImageTypeDst::pixel_type* pixels, unsigned int length)
+                                 {
+                                     for (unsigned int i = 0; i < length; i++)
+                                         pixels[i] = convert_pixel<typename ImageTypeDst::pixel_type, double>(out_row[x - dst_x + i]);
+                                 });
+        }
+    }
+
     /**
      * Convolve a single channel source image with a filter kernel
      * and write it into a destination image.
@@ -572,6 +696,21 @@ namespace degate
         unsigned int h = std::min(src->get_height(), dst->get_height());
         unsigned int w = std::min(src->get_width(), dst->get_width());
 
+        // Separable kernels (e.g. Gaussian, Sobel) are applied as a row and a column pass
+        std::vector<double> horizontal, vertical;
+        if (kernel->get_separable_factors(horizontal, vertical))
+        {
+            const unsigned int border_x = 2 * kernel->get_center_column();
+            const unsigned int border_y = 2 * kernel->get_center_row();
+
+            if (w > border_x && h > border_y)
+                convolve_separable(dst, kernel->get_center_column(), kernel->get_center_row(),
+                                   src, 0, 0,
+                                   w - border_x, h - border_y,
+                                   horizontal, vertical);
+            return;
+        }
+
         unsigned int x, y, i, j;
 
         for (y = kernel->get_center_row(); y < h - kernel->get_center_row(); y++)
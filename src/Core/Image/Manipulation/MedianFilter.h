@@ -25,7 +25,15 @@
 #include "Core/Image/PixelPolicies.h"
 #include "Core/Image/Image.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <vector>
+
+#include <boost/range/counting_range.hpp>
+
+#include <QtConcurrent/QtConcurrent>
 
 namespace degate
 {
@@ -111,17 +119,349 @@ namespace degate
         }
     };
 
+    /**
+     * Sliding histograms of 8-bit values for the median filter (Perreault and Hebert):
+     * a histogram per source column (over the rows of the filter window) and a histogram
+     * for the filter window, which slides by adding a column histogram and removing
+     * another one. The cost per pixel doesn't depend on the filter width.
+     *
+     * Histograms have 16 coarse bins and 256 fine bins, so a value of a given rank is
+     * found in at most 32 steps.
+     */
+    class MedianHistograms
+    {
+    public:
+
+        /**
+         * Create empty histograms.
+         *
+         * @param columns The number of source columns.
+         */
+        explicit MedianHistograms(unsigned int columns) :
+            column_fine(static_cast<std::size_t>(columns) * 256),
+            column_coarse(static_cast<std::size_t>(columns) * 16)
+        {
+        }
+
+        /**
+         * Add a value to a column histogram.
+         */
+        inline void add(unsigned int column, std::uint8_t value)
+        {
+            column_fine[static_cast<std::size_t>(column) * 256 + value]++;
+            column_coarse[static_cast<std::size_t>(column) * 16 + (value >> 4)]++;
+        }
+
+        /**
+         * Remove a value from a column histogram.
+         */
+        inline void remove(unsigned int column, std::uint8_t value)
+        {
+            column_fine[static_cast<std::size_t>(column) * 256 + value]--;
+            column_coarse[static_cast<std::size_t>(column) * 16 + (value >> 4)]--;
+        }
+
+        /**
+         * Set the window histogram to the sum of the columns [first, first + count).
+         */
+        void set_window(unsigned int first, unsigned int count)
+        {
+            std::fill(window_fine, window_fine + 256, 0);
+            std::fill(window_coarse, window_coarse + 16, 0);
+
+            for (unsigned int column = first; column < first + count; column++)
+            {
+                const std::uint16_t* fine = &column_fine[static_cast<std::size_t>(column) * 256];
+                const std::uint16_t* coarse = &column_coarse[static_cast<std::size_t>(column) * 16];
+
+                for (unsigned int i = 0; i < 256; i++)
+                    window_fine[i] += fine[i];
+                for (unsigned int i = 0; i < 16; i++)
+                    window_coarse[i] += coarse[i];
+            }
+        }
+
+        /**
+         * Slide the window histogram by one column.
+         *
+         * @param removed The column leaving the window.
+         * @param added The column entering the window.
+         */
+        inline void slide_window(unsigned int removed, unsigned int added)
+        {
+            const std::uint16_t* removed_fine = &column_fine[static_cast<std::size_t>(removed) * 256];
+            const std::uint16_t* removed_coarse = &column_coarse[static_cast<std::size_t>(removed) * 16];
+            const std::uint16_t* added_fine = &column_fine[static_cast<std::size_t>(added) * 256];
+            const std::uint16_t* added_coarse = &column_coarse[static_cast<std::size_t>(added) * 16];
+
+            for (unsigned int i = 0; i < 256; i++)
+                window_fine[i] += added_fine[i] - removed_fine[i];
+            for (unsigned int i = 0; i < 16; i++)
+                window_coarse[i] += added_coarse[i] - removed_coarse[i];
+        }
+
+        /**
+         * Get the value of a rank (from 0) in the window.
+         */
+        inline unsigned int get_value(unsigned int rank) const
+        {
+            unsigned int bin = 0, count = 0;
+
+            while (count + window_coarse[bin] <= rank)
+                count += window_coarse[bin++];
+
+            bin *= 16;
+
+            while (count + window_fine[bin] <= rank)
+                count += window_fine[bin++];
+
+            return bin;
+        }
+
+    private:
+
+        std::vector<std::uint16_t> column_fine, column_coarse;
+        std::uint16_t window_fine[256], window_coarse[16];
+    };
+
+
+    /**
+     * Policy class for the histogram median filter: pixels are split in 8-bit channels.
+     * The median is the same as the one of median().
+     */
+    template <typename PixelType>
+    struct HistogramMedianPolicy
+    {
+        static const unsigned int channels = 1;
+
+        /**
+         * Check if a pixel value fits into a histogram (an integer in [0, 255]).
+         */
+        static inline bool is_supported(PixelType p)
+        {
+            return p >= 0 && p <= 255 && static_cast<PixelType>(static_cast<unsigned int>(p)) == p;
+        }
+
+        static inline std::uint8_t get_channel(PixelType p, unsigned int channel)
+        {
+            return static_cast<std::uint8_t>(p);
+        }
+
+        static inline PixelType get_median(std::vector<MedianHistograms> const& histograms, unsigned int size)
+        {
+            if (size % 2 == 0)
+                return (static_cast<PixelType>(histograms[0].get_value(size / 2 - 1)) +
+                        static_cast<PixelType>(histograms[0].get_value(size / 2 + 1))) / 2;
+
+            return static_cast<PixelType>(histograms[0].get_value(size / 2));
+        }
+    };
+
+    /**
+     * Policy class for the histogram median filter for RGB(A) images (see
+     * CalculateImageMedianPolicy).
+     */
+    template <>
+    struct HistogramMedianPolicy<rgba_pixel_t>
+    {
+        static const unsigned int channels = 3;
+
+        static inline bool is_supported(rgba_pixel_t p)
+        {
+            return true;
+        }
+
+        static inline std::uint8_t get_channel(rgba_pixel_t p, unsigned int channel)
+        {
+            return static_cast<std::uint8_t>(channel == 0 ? MASK_R(p) : channel == 1 ? MASK_G(p) : MASK_B(p));
+        }
+
+        static inline rgba_pixel_t get_median(std::vector<MedianHistograms> const& histograms, unsigned int size)
+        {
+            unsigned int v[3];
+
+            for (unsigned int channel = 0; channel < 3; channel++)
+            {
+                if (size % 2 == 0)
+                    v[channel] = (histograms[channel].get_value(size / 2 - 1) +
+                                  histograms[channel].get_value(size / 2 + 1)) / 2;
+                else
+                    v[channel] = histograms[channel].get_value(size / 2);
+            }
+
+            return MERGE_CHANNELS(v[0], v[1], v[2], 255);
+        }
+    };
+
+    /**
+     * Check if the histogram median filter can be used for an image region, i.e. if
+     * all the pixel values are 8-bit values.
+     */
+    template <typename ImageType>
+    bool is_histogram_median_supported(std::shared_ptr<ImageType> img,
+                                       unsigned int min_x, unsigned int min_y,
+                                       unsigned int width, unsigned int height)
+    {
+        typedef HistogramMedianPolicy<typename ImageType::pixel_type> policy;
+
+        for (unsigned int y = min_y; y < min_y + height; y++)
+        {
+            bool supported = true;
+
+            for_each_row_segment(img, min_x, y, width,
+                                 [&](unsigned int x, const typename ImageType::pixel_type* pixels, unsigned int length)
+                                 {
+                                     for (unsigned int i = 0; i < length && supported; i++)
+                                         supported = policy::is_supported(pixels[i]);
+                                 });
+
+            if (!supported)
+                return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Median filter a region with sliding histograms (see MedianHistograms).
+     *
+     * The destination pixel (dst_x + x, dst_y + y) is the median of the source pixels
+     * (src_x + x, src_y + y) to (src_x + x + kernel_width - 1, src_y + y + kernel_width - 1),
+     * which must be in the source image and supported (see is_histogram_median_supported()).
+     *
+     * @param kernel_width The width of the filter window, at most 255.
+     */
+    template <typename ImageTypeDst, typename ImageTypeSrc>
+    void histogram_median_filter(std::shared_ptr<ImageTypeDst> dst,
+                                 unsigned int dst_x, unsigned int dst_y,
+                                 std::shared_ptr<ImageTypeSrc> src,
+                                 unsigned int src_x, unsigned int src_y,
+                                 unsigned int width, unsigned int height,
+                                 unsigned int kernel_width)
+    {
+        typedef typename ImageTypeSrc::pixel_type pixel_type;
+        typedef HistogramMedianPolicy<pixel_type> policy;
+
+        assert(kernel_width > 0 && kernel_width <= 255);
+
+        if (width == 0 || height == 0)
+            return;
+
+        const unsigned int channels = policy::channels;
+        const unsigned int src_width = width + kernel_width - 1;
+        const unsigned int size = kernel_width * kernel_width;
+
+        std::vector<MedianHistograms> histograms(channels, MedianHistograms(src_width));
+
+        // The channel values of the window rows, to remove them from the column histograms
+        std::vector<std::uint8_t> window_rows(static_cast<std::size_t>(kernel_width) * channels * src_width);
+
+        // Replace a window row with a source row
+        auto load_row = [&](unsigned int row, bool remove)
+        {
+            std::uint8_t* values = &window_rows[static_cast<std::size_t>(row % kernel_width) * channels * src_width];
+
+            for_each_row_segment(src, src_x, src_y + row, src_width,
+                                 [&](unsigned int x, const pixel_type* pixels, unsigned int length)
+                                 {
+                                     for (unsigned int i = 0; i < length; i++)
+                                     {
+                                         const unsigned int column = x - src_x + i;
+
+                                         for (unsigned int channel = 0; channel < channels; channel++)
+                                         {
+                                             std::uint8_t& value = values[channel * src_width + column];
+
+                                             if (remove)
+                                                 histograms[channel].remove(column, value);
+
+                                             value = policy::get_channel(pixels[i], channel);
+                                             histograms[channel].add(column, value);
+                                         }
+                                     }
+                                 });
+        };
+
+        for (unsigned int row = 0; row < kernel_width; row++)
+            load_row(row, false);
+
+        std::vector<pixel_type> out_row(width);
+
+        for (unsigned int y = 0; y < height; y++)
+        {
+            if (y > 0)
+                load_row(y + kernel_width - 1, true);
+
+            for (auto& h : histograms)
+                h.set_window(0, kernel_width);
+
+            out_row[0] = policy::get_median(histograms, size);
+
+            for (unsigned int x = 1; x < width; x++)
+            {
+                for (auto& h : histograms)
+                    h.slide_window(x - 1, x + kernel_width - 1);
+
+                out_row[x] = policy::get_median(histograms, size);
+            }
+
+            for_each_row_segment(dst, dst_x, dst_y + y, width,
+                                 [&](unsigned int x, typename ImageTypeDst::pixel_type* pixels, unsigned int length)
+                                 {
+                                     for (unsigned int i = 0; i < length; i++)
+                                         pixels[i] = convert_pixel<typename ImageTypeDst::pixel_type, pixel_type>(
+                                             out_row[x - dst_x + i]);
+                                 });
+        }
+    }
+
     /**
      * Filter an image with a median filter.
+     *
+     * Images with 8-bit values (per channel) are filtered with sliding histograms, in
+     * parallel row bands. Other images are filtered pixel by pixel with filter_image().
+     * Both give the same result.
      */
     template <typename ImageTypeDst, typename ImageTypeSrc>
     void median_filter(std::shared_ptr<ImageTypeDst> dst,
                        std::shared_ptr<ImageTypeSrc> src,
                        unsigned int kernel_width = 3)
     {
-        filter_image<ImageTypeDst, ImageTypeSrc,
-                     CalculateImageMedianPolicy<ImageTypeSrc, typename ImageTypeSrc::pixel_type>>(
-            dst, src, kernel_width);
+        const unsigned int width = std::min(src->get_width(), dst->get_width());
+        const unsigned int height = std::min(src->get_height(), dst->get_height());
+
+        if (kernel_width <= 1 || kernel_width > 255 || width < kernel_width || height < kernel_width ||
+            !is_histogram_median_supported(src, 0, 0, width, height))
+        {
+            filter_image<ImageTypeDst, ImageTypeSrc,
+                         CalculateImageMedianPolicy<ImageTypeSrc, typename ImageTypeSrc::pixel_type>>(
+                dst, src, kernel_width);
+            return;
+        }
+
+        // Same filtered area as filter_image(), the last row and column are never in a window
+        const unsigned int kernel_center = kernel_width / 2;
+        const unsigned int filtered_width = width - kernel_width;
+        const unsigned int filtered_height = height - kernel_width;
+
+        const unsigned int
+            band_height = std::max(64u, 4 * kernel_width),
+            bands = (filtered_height + band_height - 1) / band_height;
+
+        std::function<void(const unsigned int&)> filter_band = [&](const unsigned int& band)
+        {
+            const unsigned int
+                min_y = band * band_height,
+                max_y = std::min(min_y + band_height, filtered_height);
+
+            histogram_median_filter(dst, kernel_center, kernel_center + min_y,
+                                    src, 0, min_y,
+                                    filtered_width, max_y - min_y,
+                                    kernel_width);
+        };
+
+        const auto& it = boost::counting_range<unsigned int>(0, bands);
+        QtConcurrent::blockingMap(it, filter_band);
     }
 }
 #endif
@@ -23,7 +23,8 @@
 #define __IPCONVOLVE_H__
 
 #include <string>
-#include "Core/Image/Processor/ImageProcessorBase.h"
+#include <vector>
+#include "Core/Image/Processor/TiledImageProcessor.h"
 #include "Core/Utils/FilterKernel.h"
 
 namespace degate
@@ -32,24 +33,27 @@ namespace degate
      * Processor: Convolve an image.
      */
     template <typename ImageTypeIn, typename ImageTypeOut>
-    class IPConvolve : public ImageProcessorBase
+    class IPConvolve : public TiledImageProcessor<ImageTypeIn, ImageTypeOut>
     {
     private:
         FilterKernel_shptr kernel;
 
+        // The kernel factors, if the kernel is separable
+        bool separable;
+        std::vector<double> horizontal, vertical;
+
     public:
 
         /**
          * The constructor.
          */
         IPConvolve(FilterKernel_shptr kernel) :
-            ImageProcessorBase("IPConvolve",
-                               "Convolve an image.",
-                               false,
-                               typeid(typename ImageTypeIn::pixel_type),
-                               typeid(typename ImageTypeOut::pixel_type)),
+            TiledImageProcessor<ImageTypeIn, ImageTypeOut>("IPConvolve",
+                                                           "Convolve an image.",
+                                                           false),
             kernel(kernel)
         {
+            separable = kernel->get_separable_factors(horizontal, vertical);
         }
 
         /**
@@ -75,6 +79,66 @@ namespace degate
 
             return img_out;
         }
+
+        virtual unsigned int get_halo() const
+        {
+            return std::max(std::max(kernel->get_center_column(), kernel->get_columns() - 1 - kernel->get_center_column()),
+                            std::max(kernel->get_center_row(), kernel->get_rows() - 1 - kernel->get_center_row()));
+        }
+
+    protected:
+
+        typedef typename TiledImageProcessor<ImageTypeIn, ImageTypeOut>::tile_in_type tile_in_type;
+        typedef typename TiledImageProcessor<ImageTypeIn, ImageTypeOut>::tile_out_type tile_out_type;
+
+        virtual void process_tile(std::shared_ptr<tile_in_type> in,
+                                  ImageRegion const& in_region,
+                                  std::shared_ptr<tile_out_type> out,
+                                  ImageRegion const& out_region)
+        {
+            // Same convolved area as convolve(), the image border stays 0
+            const unsigned int min_x = std::max(out_region.min_x, kernel->get_center_column());
+            const unsigned int min_y = std::max(out_region.min_y, kernel->get_center_row());
+            const unsigned int max_x = std::min(out_region.max_x, in_region.image_width - kernel->get_center_column());
+            const unsigned int max_y = std::min(out_region.max_y, in_region.image_height - kernel->get_center_row());
+
+            if (separable)
+            {
+                if (min_x < max_x && min_y < max_y)
+                    convolve_separable(out, min_x - out_region.min_x, min_y - out_region.min_y,
+                                       in,
+                                       min_x - kernel->get_center_column() - in_region.min_x,
+                                       min_y - kernel->get_center_row() - in_region.min_y,
+                                       max_x - min_x, max_y - min_y,
+                                       horizontal, vertical);
+                return;
+            }
+
+            unsigned int x, y, i, j;
+
+            for (y = min_y; y < max_y; y++)
+            {
+                for (x = min_x; x < max_x; x++)
+                {
+                    double accu = 0;
+
+                    for (i = 0; i < kernel->get_columns(); i++)
+                    {
+                        for (j = 0; j < kernel->get_rows(); j++)
+                        {
+                            typename ImageTypeIn::pixel_type p =
+                                in->get_pixel(x - kernel->get_center_column() + i - in_region.min_x,
+                                              y - kernel->get_center_row() + j - in_region.min_y);
+
+                            double k = kernel->get(kernel->get_columns() - 1 - i,
+                                                   kernel->get_rows() - 1 - j);
+                            accu += k * p;
+                        }
+                    }
+                    out->template set_pixel_as<double>(x - out_region.min_x, y - out_region.min_y, accu);
+                }
+            }
+        }
     };
 }
 
@@ -23,7 +23,7 @@
 #define __IPCOPY_H__
 
 #include <string>
-#include "Core/Image/Processor/ImageProcessorBase.h"
+#include "Core/Image/Processor/TiledImageProcessor.h"
 
 namespace degate
 {
@@ -31,7 +31,7 @@ namespace degate
      * Processor: Copy an image with auto conversion.
      */
     template <typename ImageTypeIn, typename ImageTypeOut>
-    class IPCopy : public ImageProcessorBase
+    class IPCopy : public TiledImageProcessor<ImageTypeIn, ImageTypeOut>
     {
     private:
 
@@ -44,11 +44,9 @@ namespace degate
          * The constructor for processing the whole image.
          */
         IPCopy() :
-            ImageProcessorBase("IPCopy",
-                               "Copy an image with pixel type auto conversion",
-                               false,
-                               typeid(typename ImageTypeIn::pixel_type),
-                               typeid(typename ImageTypeOut::pixel_type)),
+            TiledImageProcessor<ImageTypeIn, ImageTypeOut>("IPCopy",
+                                                           "Copy an image with pixel type auto conversion",
+                                                           false),
             work_on_region(false)
         {
         }
@@ -57,11 +55,9 @@ namespace degate
          * The constructor for working on an image region.
          */
         IPCopy(unsigned int min_x, unsigned int max_x, unsigned int min_y, unsigned int max_y) :
-            ImageProcessorBase("IPCopy",
-                               "Copy an image with pixel type auto conversion",
-                               false,
-                               typeid(typename ImageTypeIn::pixel_type),
-                               typeid(typename ImageTypeOut::pixel_type)),
+            TiledImageProcessor<ImageTypeIn, ImageTypeOut>("IPCopy",
+                                                           "Copy an image with pixel type auto conversion",
+                                                           false),
             min_x(min_x),
             max_x(max_x),
             min_y(min_y),
@@ -108,6 +104,46 @@ namespace degate
 
             return img_out;
         }
+
+        virtual void get_output_size(unsigned int in_width, unsigned int in_height,
+                                     unsigned int& out_width, unsigned int& out_height) const
+        {
+            out_width = work_on_region ? max_x - min_x : in_width;
+            out_height = work_on_region ? max_y - min_y : in_height;
+        }
+
+        virtual ImageRegion get_input_region(ImageRegion const& out_region,
+                                             unsigned int in_width, unsigned int in_height) const
+        {
+            const unsigned int offset_x = work_on_region ? min_x : 0;
+            const unsigned int offset_y = work_on_region ? min_y : 0;
+
+            // The part of the input image copied into the output region (can be empty)
+            return {std::min(out_region.min_x + offset_x, in_width),
+                    std::min(out_region.min_y + offset_y, in_height),
+                    std::min(out_region.max_x + offset_x, in_width),
+                    std::min(out_region.max_y + offset_y, in_height),
+                    in_width,
+                    in_height};
+        }
+
+    protected:
+
+        typedef typename TiledImageProcessor<ImageTypeIn, ImageTypeOut>::tile_in_type tile_in_type;
+        typedef typename TiledImageProcessor<ImageTypeIn, ImageTypeOut>::tile_out_type tile_out_type;
+
+        virtual void process_tile(std::shared_ptr<tile_in_type> in,
+                                  ImageRegion const& in_region,
+                                  std::shared_ptr<tile_out_type> out,
+                                  ImageRegion const& out_region)
+        {
+            // Pixels outside of the input image stay 0
+            if (in_region.is_empty())
+                return;
+
+            transform_region(out, 0, 0, in, 0, 0, in_region.get_width(), in_region.get_height(),
+                             convert_pixel<typename ImageTypeOut::pixel_type, typename ImageTypeIn::pixel_type>);
+        }
     };
 }
 
@@ -23,7 +23,7 @@
 #define __IPMEDIANFILTER_H__
 
 #include <string>
-#include "Core/Image/Processor/ImageProcessorBase.h"
+#include "Core/Image/Processor/TiledImageProcessor.h"
 #include "Core/Image/Manipulation/MedianFilter.h"
 
 namespace degate
@@ -32,7 +32,7 @@ namespace degate
      * Processor: Median filter a single channel image.
      */
     template <typename ImageTypeIn, typename ImageTypeOut>
-    class IPMedianFilter : public ImageProcessorBase
+    class IPMedianFilter : public TiledImageProcessor<ImageTypeIn, ImageTypeOut>
     {
     private:
 
@@ -44,11 +44,9 @@ namespace degate
          * The constructor.
          */
         IPMedianFilter(unsigned int median_filter_width = 3) :
-            ImageProcessorBase("IPNormalize",
-                               "Normalize an image.",
-                               false,
-                               typeid(typename ImageTypeIn::pixel_type),
-                               typeid(typename ImageTypeOut::pixel_type)),
+            TiledImageProcessor<ImageTypeIn, ImageTypeOut>("IPNormalize",
+                                                           "Normalize an image.",
+                                                           false),
             median_filter_width(median_filter_width)
         {
         }
@@ -69,6 +67,76 @@ namespace degate
 
             return img_out;
         }
+
+        virtual unsigned int get_halo() const
+        {
+            // The filter window must end before the image border, see filter_image()
+            return median_filter_width - median_filter_width / 2;
+        }
+
+    protected:
+
+        typedef typename TiledImageProcessor<ImageTypeIn, ImageTypeOut>::tile_in_type tile_in_type;
+        typedef typename TiledImageProcessor<ImageTypeIn, ImageTypeOut>::tile_out_type tile_out_type;
+
+        virtual void process_tile(std::shared_ptr<tile_in_type> in,
+                                  ImageRegion const& in_region,
+                                  std::shared_ptr<tile_out_type> out,
+                                  ImageRegion const& out_region)
+        {
+            if (median_filter_width <= 1)
+                throw DegateRuntimeException("Error in filter_image(). Kernel width is to small.");
+
+            if (in_region.image_width < median_filter_width || in_region.image_height < median_filter_width)
+                throw DegateRuntimeException("Error in filter_image(). One of the images is to small.");
+
+            // Same filtered area as filter_image(), the image border stays 0
+            const unsigned int kernel_center = median_filter_width / 2;
+            const unsigned int max_x = in_region.image_width - (median_filter_width - kernel_center);
+            const unsigned int max_y = in_region.image_height - (median_filter_width - kernel_center);
+
+            const unsigned int filtered_min_x = std::max(out_region.min_x, kernel_center);
+            const unsigned int filtered_min_y = std::max(out_region.min_y, kernel_center);
+            const unsigned int filtered_max_x = std::min(out_region.max_x, max_x);
+            const unsigned int filtered_max_y = std::min(out_region.max_y, max_y);
+
+            if (filtered_min_x >= filtered_max_x || filtered_min_y >= filtered_max_y)
+                return;
+
+            if (median_filter_width <= 255 &&
+                is_histogram_median_supported(in, 0, 0, in_region.get_width(), in_region.get_height()))
+            {
+                histogram_median_filter(out, filtered_min_x - out_region.min_x, filtered_min_y - out_region.min_y,
+                                        in,
+                                        filtered_min_x - kernel_center - in_region.min_x,
+                                        filtered_min_y - kernel_center - in_region.min_y,
+                                        filtered_max_x - filtered_min_x, filtered_max_y - filtered_min_y,
+                                        median_filter_width);
+                return;
+            }
+
+            for (unsigned int y = filtered_min_y; y < filtered_max_y; y++)
+            {
+                for (unsigned int x = filtered_min_x; x < filtered_max_x; x++)
+                {
+                    const unsigned int in_x = x - in_region.min_x;
+                    const unsigned int in_y = y - in_region.min_y;
+
+                    typename ImageTypeIn::pixel_type p =
+                        CalculateImageMedianPolicy<tile_in_type, typename ImageTypeIn::pixel_type>::calculate(
+                            in,
+                            in_x, in_y,
+                            in_x - kernel_center,
+                            in_x - kernel_center + median_filter_width,
+                            in_y - kernel_center,
+                            in_y - kernel_center + median_filter_width,
+                            3);
+
+                    out->template set_pixel_as<typename ImageTypeIn::pixel_type>(x - out_region.min_x,
+                                                                                 y - out_region.min_y, p);
+                }
+            }
+        }
     };
 }
 
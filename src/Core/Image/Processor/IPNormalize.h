@@ -23,7 +23,7 @@
 #define __IPNORMALIZE_H__
 
 #include <string>
-#include "Core/Image/Processor/ImageProcessorBase.h"
+#include "Core/Image/Processor/TiledImageProcessor.h"
 #include "Core/Utils/FilterKernel.h"
 
 namespace degate
@@ -32,23 +32,25 @@ namespace degate
      * Processor: Normalize a single channel image.
      */
     template <typename ImageTypeIn, typename ImageTypeOut>
-    class IPNormalize : public ImageProcessorBase
+    class IPNormalize : public TiledImageProcessor<ImageTypeIn, ImageTypeOut>
     {
     private:
         double lower_bound;
         double upper_bound;
 
+        // Input image range, for the tiled processing
+        double src_min = 0;
+        double src_max = 0;
+
     public:
 
         /**
          * The constructor.
          */
         IPNormalize(double lower_bound = 0, double upper_bound = 1) :
-            ImageProcessorBase("IPNormalize",
-                               "Normalize an image.",
-                               false,
-                               typeid(typename ImageTypeIn::pixel_type),
-                               typeid(typename ImageTypeOut::pixel_type)),
+            TiledImageProcessor<ImageTypeIn, ImageTypeOut>("IPNormalize",
+                                                           "Normalize an image.",
+                                                           false),
             lower_bound(lower_bound),
             upper_bound(upper_bound)
         {
@@ -77,6 +79,49 @@ namespace degate
 
             return img_out;
         }
+
+        virtual bool needs_whole_input() const
+        {
+            return true;
+        }
+
+        virtual void prepare(ImageBase_shptr in)
+        {
+            std::shared_ptr<ImageTypeIn> img_in = std::dynamic_pointer_cast<ImageTypeIn>(in);
+            assert(img_in != nullptr);
+
+            src_min = get_minimum<ImageTypeIn>(img_in);
+            src_max = get_maximum<ImageTypeIn>(img_in);
+        }
+
+    protected:
+
+        typedef typename TiledImageProcessor<ImageTypeIn, ImageTypeOut>::tile_in_type tile_in_type;
+        typedef typename TiledImageProcessor<ImageTypeIn, ImageTypeOut>::tile_out_type tile_out_type;
+
+        virtual void process_tile(std::shared_ptr<tile_in_type> in,
+                                  ImageRegion const& in_region,
+                                  std::shared_ptr<tile_out_type> out,
+                                  ImageRegion const& out_region)
+        {
+            // Like normalize(), the output stays 0 for a constant image
+            if (src_max - src_min == 0) return;
+
+            double shift = -src_min;
+            double factor = (double)(upper_bound - lower_bound) / (double)(src_max - src_min);
+
+            for (unsigned int y = 0; y < out_region.get_height(); y++)
+            {
+                for (unsigned int x = 0; x < out_region.get_width(); x++)
+                {
+                    typename ImageTypeOut::pixel_type p =
+                        in->template get_pixel_as<typename ImageTypeOut::pixel_type>(x, y);
+
+                    double d = normalize_value((double)p, shift, factor, lower_bound, upper_bound);
+                    out->template set_pixel_as<double>(x, y, d);
+                }
+            }
+        }
     };
 }
 
@@ -22,10 +22,20 @@
 #ifndef __IPPIPE_H__
 #define __IPPIPE_H__
 
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 #include "Core/Image/Processor/ImageProcessorBase.h"
 #include "Core/Utils/ProgressControl.h"
 
+#include <boost/range/counting_range.hpp>
+
+#include <QtConcurrent/QtConcurrent>
+
 namespace degate
 {
     /**
@@ -38,6 +48,83 @@ namespace degate
         typedef std::list<std::shared_ptr<ImageProcessorBase>> processor_list_type;
         processor_list_type processor_list;
 
+        typedef std::vector<ImageProcessorBase_shptr> stage_list_type;
+        typedef std::vector<std::pair<unsigned int, unsigned int>> size_list_type;
+
+        /**
+         * Run the tileable stages [first, last) tile by tile, in parallel.
+         *
+         * @param img_in The whole input image of the first stage.
+         * @param sizes The image sizes, before each stage.
+         * @return Returns the whole output image of the last stage, null if canceled.
+         */
+        ImageBase_shptr run_tiled_stages(ImageBase_shptr img_in,
+                                         stage_list_type const& stages,
+                                         size_list_type const& sizes,
+                                         std::size_t first, std::size_t last,
+                                         unsigned int tile_size)
+        {
+            if (stages[first]->needs_whole_input())
+                stages[first]->prepare(img_in);
+
+            const unsigned int width = sizes[last].first;
+            const unsigned int height = sizes[last].second;
+            const unsigned int tiles_x = (width + tile_size - 1) / tile_size;
+            const unsigned int tiles_y = (height + tile_size - 1) / tile_size;
+
+            ImageBase_shptr img_out = stages[last - 1]->create_image(width, height);
+
+            std::mutex error_mutex;
+            std::exception_ptr error;
+            std::atomic<bool> failed(false);
+
+            std::function<void(const unsigned int&)> run_tile = [&](const unsigned int& tile)
+            {
+                if (failed || is_canceled())
+                    return;
+
+                try
+                {
+                    const unsigned int min_x = (tile % tiles_x) * tile_size;
+                    const unsigned int min_y = (tile / tiles_x) * tile_size;
+
+                    // Regions between the stages, from the output back to the input
+                    std::vector<ImageRegion> regions(last - first + 1);
+                    regions.back() = {min_x, min_y,
+                                      std::min(min_x + tile_size, width), std::min(min_y + tile_size, height),
+                                      width, height};
+
+                    for (std::size_t i = last; i-- > first;)
+                        regions[i - first] = stages[i]->get_input_region(regions[i - first + 1],
+                                                                         sizes[i].first, sizes[i].second);
+
+                    // Intermediate images only exist for the tile
+                    ImageBase_shptr img = img_in;
+                    for (std::size_t i = first; i < last; i++)
+                        img = stages[i]->run_tile(img, regions[i - first], regions[i - first + 1]);
+
+                    stages[last - 1]->write_tile(img, regions.back(), img_out);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!failed)
+                        error = std::current_exception();
+                    failed = true;
+                }
+
+                progress_step_done();
+            };
+
+            const auto& it = boost::counting_range<unsigned int>(0, tiles_x * tiles_y);
+            QtConcurrent::blockingMap(it, run_tile);
+
+            if (error)
+                std::rethrow_exception(error);
+
+            return is_canceled() ? ImageBase_shptr() : img_out;
+        }
+
     public:
 
         /**
@@ -104,6 +191,74 @@ namespace degate
 
             return last_img;
         }
+
+        /**
+         * Start processing, tile by tile.
+         *
+         * Consecutive tileable processors are run tile by tile: each tile (with the halo
+         * each processor needs) goes through all of them, and tiles are processed in
+         * parallel. Intermediate images only exist for a tile. Whole images are only
+         * created before a processor that needs its whole input (e.g. a normalization)
+         * or that isn't tileable, and for the result.
+         *
+         * The result is the same as the one of run().
+         *
+         * @param img_in The input image.
+         * @param tile_size The size of the tiles (in output pixels).
+         * @return Returns the output image, null if the processing was canceled.
+         */
+        ImageBase_shptr run_tiled(ImageBase_shptr img_in, unsigned int tile_size = 256)
+        {
+            assert(img_in != nullptr);
+            assert(tile_size > 0);
+
+            const stage_list_type stages(processor_list.begin(), processor_list.end());
+
+            size_list_type sizes(stages.size() + 1);
+            sizes[0] = std::make_pair(img_in->get_width(), img_in->get_height());
+
+            for (std::size_t i = 0; i < stages.size(); i++)
+                stages[i]->get_output_size(sizes[i].first, sizes[i].second, sizes[i + 1].first, sizes[i + 1].second);
+
+            // Split the pipe into runs of tileable processors
+            std::vector<std::pair<std::size_t, std::size_t>> runs;
+            unsigned int tiles = 0;
+
+            for (std::size_t first = 0; first < stages.size();)
+            {
+                std::size_t last = first + 1;
+
+                if (stages[first]->is_tileable())
+                {
+                    while (last < stages.size() && stages[last]->is_tileable() && !stages[last]->needs_whole_input())
+                        last++;
+
+                    tiles += ((sizes[last].first + tile_size - 1) / tile_size) *
+                             ((sizes[last].second + tile_size - 1) / tile_size);
+                }
+
+                runs.emplace_back(first, last);
+                first = last;
+            }
+
+            reset_progress();
+            set_progress_step_size(tiles > 0 ? 1.0 / tiles : 0);
+
+            ImageBase_shptr last_img = img_in;
+
+            for (auto const& run : runs)
+            {
+                if (stages[run.first]->is_tileable())
+                    last_img = run_tiled_stages(last_img, stages, sizes, run.first, run.second, tile_size);
+                else
+                    last_img = stages[run.first]->run(last_img);
+
+                if (last_img == nullptr)
+                    return last_img;
+            }
+
+            return last_img;
+        }
     };
 }
 
@@ -23,7 +23,7 @@
 #define __IPTHRESHOLDING_H__
 
 #include <string>
-#include "Core/Image/Processor/ImageProcessorBase.h"
+#include "Core/Image/Processor/TiledImageProcessor.h"
 #include "Core/Utils/FilterKernel.h"
 
 namespace degate
@@ -32,7 +32,7 @@ namespace degate
      * Processor: Create a binary image from a single channel image.
      */
     template <typename ImageTypeIn, typename ImageTypeOut>
-    class IPThresholding : public ImageProcessorBase
+    class IPThresholding : public TiledImageProcessor<ImageTypeIn, ImageTypeOut>
     {
     private:
         double threshold;
@@ -43,11 +43,9 @@ namespace degate
          * The constructor.
          */
         IPThresholding(double threshold = 0.5) :
-            ImageProcessorBase("IPThresholding",
-                               "Binarize an image.",
-                               false,
-                               typeid(typename ImageTypeIn::pixel_type),
-                               typeid(typename ImageTypeOut::pixel_type)),
+            TiledImageProcessor<ImageTypeIn, ImageTypeOut>("IPThresholding",
+                                                           "Binarize an image.",
+                                                           false),
             threshold(threshold)
         {
         }
@@ -75,6 +73,19 @@ namespace degate
 
             return img_out;
         }
+
+    protected:
+
+        typedef typename TiledImageProcessor<ImageTypeIn, ImageTypeOut>::tile_in_type tile_in_type;
+        typedef typename TiledImageProcessor<ImageTypeIn, ImageTypeOut>::tile_out_type tile_out_type;
+
+        virtual void process_tile(std::shared_ptr<tile_in_type> in,
+                                  ImageRegion const& in_region,
+                                  std::shared_ptr<tile_out_type> out,
+                                  ImageRegion const& out_region)
+        {
+            thresholding_image<tile_out_type, tile_in_type>(out, in, threshold);
+        }
     };
 }
 
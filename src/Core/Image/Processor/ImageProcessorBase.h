@@ -22,11 +22,59 @@
 #ifndef __IMAGEPROCESSORBASE_H__
 #define __IMAGEPROCESSORBASE_H__
 
+#include <algorithm>
 #include <string>
+#include "Core/Image/Image.h"
+#include "Core/Utils/DegateExceptions.h"
 #include "Core/Utils/ProgressControl.h"
 
 namespace degate
 {
+    /**
+     * A rectangular region of an image, for the tiled execution of image processors.
+     * @see IPPipe::run_tiled()
+     */
+    struct ImageRegion
+    {
+        /**
+         * The region, from min (included) to max (excluded).
+         */
+        unsigned int min_x, min_y, max_x, max_y;
+
+        /**
+         * The size of the whole image.
+         */
+        unsigned int image_width, image_height;
+
+        unsigned int get_width() const
+        {
+            return max_x - min_x;
+        }
+
+        unsigned int get_height() const
+        {
+            return max_y - min_y;
+        }
+
+        bool is_empty() const
+        {
+            return min_x >= max_x || min_y >= max_y;
+        }
+
+        /**
+         * Get the region grown by a margin on each side, clipped to the image.
+         */
+        ImageRegion grow(unsigned int margin) const
+        {
+            return {min_x > margin ? min_x - margin : 0,
+                    min_y > margin ? min_y - margin : 0,
+                    std::min(max_x + margin, image_width),
+                    std::min(max_y + margin, image_height),
+                    image_width,
+                    image_height};
+        }
+    };
+
     /**
      * Abstract base class for an image processor.
      */
@@ -107,6 +155,96 @@ namespace degate
         virtual ImageBase_shptr run(ImageBase_shptr in) = 0;
 
 
+        /**
+         * Check if the processor can work on separate regions of an image (see run_tile()).
+         */
+        virtual bool is_tileable() const
+        {
+            return false;
+        }
+
+        /**
+         * Check if the processor needs its whole input image before processing tiles
+         * (e.g. for global statistics). It is then passed to prepare().
+         */
+        virtual bool needs_whole_input() const
+        {
+            return false;
+        }
+
+        /**
+         * Prepare the tiled processing of an image.
+         * @see needs_whole_input()
+         */
+        virtual void prepare(ImageBase_shptr in)
+        {
+        }
+
+        /**
+         * Get the number of pixels around an output pixel, in each direction, that the
+         * processor reads from its input image.
+         */
+        virtual unsigned int get_halo() const
+        {
+            return 0;
+        }
+
+        /**
+         * Get the size of the output image for an input image size.
+         */
+        virtual void get_output_size(unsigned int in_width, unsigned int in_height,
+                                     unsigned int& out_width, unsigned int& out_height) const
+        {
+            out_width = in_width;
+            out_height = in_height;
+        }
+
+        /**
+         * Get the input region needed to process an output region.
+         * By default, this is the output region grown by the halo.
+         */
+        virtual ImageRegion get_input_region(ImageRegion const& out_region,
+                                             unsigned int in_width, unsigned int in_height) const
+        {
+            ImageRegion in_region = out_region;
+            in_region.image_width = in_width;
+            in_region.image_height = in_height;
+
+            return in_region.grow(get_halo());
+        }
+
+        /**
+         * Create an output image (for the whole image).
+         */
+        virtual ImageBase_shptr create_image(unsigned int width, unsigned int height) const
+        {
+            throw DegateRuntimeException("The image processor " + name + " can't process tiles.");
+        }
+
+        /**
+         * Process a region of an image. This can be called concurrently.
+         *
+         * @param in Either the whole input image or an image holding exactly \p in_region.
+         * @param in_region The input region, as returned by get_input_region().
+         * @param out_region The output region to process.
+         * @return Returns an image holding the output region.
+         */
+        virtual ImageBase_shptr run_tile(ImageBase_shptr in,
+                                         ImageRegion const& in_region,
+                                         ImageRegion const& out_region)
+        {
+            throw DegateRuntimeException("The image processor " + name + " can't process tiles.");
+        }
+
+        /**
+         * Write a processed region (as returned by run_tile()) into the whole output image.
+         */
+        virtual void write_tile(ImageBase_shptr tile, ImageRegion const& region, ImageBase_shptr out) const
+        {
+            throw DegateRuntimeException("The image processor " + name + " can't process tiles.");
+        }
+
+
         /**
          * Check if the processor can be configured.
          */
@@ -0,0 +1,149 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __TILEDIMAGEPROCESSOR_H__
+#define __TILEDIMAGEPROCESSOR_H__
+
+#include <string>
+#include "Core/Image/Processor/ImageProcessorBase.h"
+
+namespace degate
+{
+    /**
+     * Base class for an image processor that can work on separate regions of an image.
+     *
+     * Regions are processed in memory images of the processor pixel types (tiles).
+     * A derived processor only implements process_tile().
+     */
+    template <typename ImageTypeIn, typename ImageTypeOut>
+    class TiledImageProcessor : public ImageProcessorBase
+    {
+    public:
+
+        typedef Image<typename ImageTypeIn::pixel_policy, StoragePolicy_Memory> tile_in_type;
+        typedef Image<typename ImageTypeOut::pixel_policy, StoragePolicy_Memory> tile_out_type;
+
+        /**
+         * The constructor.
+         */
+        TiledImageProcessor(std::string const& name,
+                            std::string const& description,
+                            bool has_properties) :
+            ImageProcessorBase(name,
+                               description,
+                               has_properties,
+                               typeid(typename ImageTypeIn::pixel_type),
+                               typeid(typename ImageTypeOut::pixel_type))
+        {
+        }
+
+        /**
+         * The destructor.
+         */
+        virtual ~TiledImageProcessor()
+        {
+        }
+
+        virtual bool is_tileable() const
+        {
+            return true;
+        }
+
+        virtual ImageBase_shptr create_image(unsigned int width, unsigned int height) const
+        {
+            return std::make_shared<ImageTypeOut>(width, height);
+        }
+
+        virtual ImageBase_shptr run_tile(ImageBase_shptr in,
+                                         ImageRegion const& in_region,
+                                         ImageRegion const& out_region)
+        {
+            assert(in != nullptr);
+
+            if (out_region.is_empty())
+                return ImageBase_shptr();
+
+            std::shared_ptr<tile_in_type> tile_in;
+
+            if (!in_region.is_empty())
+            {
+                tile_in = std::dynamic_pointer_cast<tile_in_type>(in);
+
+                // The whole input image, extract the input region
+                if (tile_in == nullptr ||
+                    tile_in->get_width() != in_region.get_width() ||
+                    tile_in->get_height() != in_region.get_height())
+                {
+                    std::shared_ptr<ImageTypeIn> img_in = std::dynamic_pointer_cast<ImageTypeIn>(in);
+                    assert(img_in != nullptr);
+
+                    tile_in = std::make_shared<tile_in_type>(in_region.get_width(), in_region.get_height());
+                    transform_region(tile_in, 0, 0, img_in, in_region.min_x, in_region.min_y,
+                                     in_region.get_width(), in_region.get_height(),
+                                     [](typename ImageTypeIn::pixel_type p) { return p; });
+                }
+            }
+
+            auto tile_out = std::make_shared<tile_out_type>(out_region.get_width(), out_region.get_height());
+
+            process_tile(tile_in, in_region, tile_out, out_region);
+
+            return tile_out;
+        }
+
+        virtual void write_tile(ImageBase_shptr tile, ImageRegion const& region, ImageBase_shptr out) const
+        {
+            if (region.is_empty())
+                return;
+
+            std::shared_ptr<tile_out_type> tile_out = std::dynamic_pointer_cast<tile_out_type>(tile);
+            std::shared_ptr<ImageTypeOut> img_out = std::dynamic_pointer_cast<ImageTypeOut>(out);
+
+            assert(tile_out != nullptr);
+            assert(img_out != nullptr);
+
+            transform_region(img_out, region.min_x, region.min_y, tile_out, 0, 0,
+                             region.get_width(), region.get_height(),
+                             [](typename ImageTypeOut::pixel_type p) { return p; });
+        }
+
+    protected:
+
+        /**
+         * Process a region of an image. This can be called concurrently.
+         *
+         * Pixel (0, 0) of \p in is the pixel (in_region.min_x, in_region.min_y) of
+         * the input image, and the same for \p out with \p out_region. The result must
+         * be the same as the one of run() for the region.
+         *
+         * @param in The input region, null if \p in_region is empty.
+         * @param in_region The input region, as returned by get_input_region().
+         * @param out The output region, initialized with 0.
+         * @param out_region The output region.
+         */
+        virtual void process_tile(std::shared_ptr<tile_in_type> in,
+                                  ImageRegion const& in_region,
+                                  std::shared_ptr<tile_out_type> out,
+                                  ImageRegion const& out_region) = 0;
+    };
+}
+
+#endif
@@ -26,6 +26,7 @@
 #include "Core/Utils/MemoryMap.h"
 #include "Core/Configuration.h"
 #include "Core/Utils/FileSystem.h"
+#include "Core/Image/ImageBlock.h"
 
 namespace degate
 {
@@ -67,6 +68,59 @@ namespace degate
          * implement it for a concrete StoragePolicy.
          */
         virtual void set_pixel(unsigned int x, unsigned int y, pixel_type new_val) = 0;
+
+        /**
+         * Get direct access to a block of pixels, with its upper left corner at x,y.
+         * The block is clipped to the image and to the storage unit (e.g. a tile),
+         * so it can be smaller than requested. Iterate with ImageRegionBlocks to
+         * cover a whole region.
+         *
+         * @param x : the x coordinate of the first pixel.
+         * @param y : the y coordinate of the first pixel.
+         * @param max_width : the maximum width of the block.
+         * @param max_height : the maximum height of the block.
+         *
+         * @return Returns the block, empty if x,y is outside of the image.
+         */
+        virtual ImageBlock<pixel_type> get_block(unsigned int x,
+                                                 unsigned int y,
+                                                 unsigned int max_width,
+                                                 unsigned int max_height) = 0;
+
+        /**
+         * Get a read-only block of pixels.
+         * @see get_block()
+         */
+        virtual ImageBlock<const pixel_type> get_block(unsigned int x,
+                                                       unsigned int y,
+                                                       unsigned int max_width,
+                                                       unsigned int max_height) const = 0;
+
+    protected:
+
+        /**
+         * Get a block from a single contiguous memory map.
+         */
+        template <typename BlockPixelType, typename MemoryMapType>
+        static inline ImageBlock<BlockPixelType> get_memory_map_block(MemoryMapType& memory_map,
+                                                                      unsigned int x,
+                                                                      unsigned int y,
+                                                                      unsigned int max_width,
+                                                                      unsigned int max_height)
+        {
+            const auto map_width = static_cast<unsigned int>(memory_map.get_width());
+            const auto map_height = static_cast<unsigned int>(memory_map.get_height());
+
+            if (x >= map_width || y >= map_height)
+                return ImageBlock<BlockPixelType>();
+
+            return ImageBlock<BlockPixelType>(memory_map.data() + static_cast<std::size_t>(y) * map_width + x,
+                                              x,
+                                              y,
+                                              std::min(max_width, map_width - x),
+                                              std::min(max_height, map_height - y),
+                                              map_width);
+        }
     };
 
 
@@ -103,6 +157,22 @@ namespace degate
             memory_map.set(x, y, new_val);
         }
 
+        inline ImageBlock<typename PixelPolicy::pixel_type> get_block(unsigned int x,
+                                                                      unsigned int y,
+                                                                      unsigned int max_width,
+                                                                      unsigned int max_height)
+        {
+            return this->template get_memory_map_block<typename PixelPolicy::pixel_type>(memory_map, x, y, max_width, max_height);
+        }
+
+        inline ImageBlock<const typename PixelPolicy::pixel_type> get_block(unsigned int x,
+                                                                            unsigned int y,
+                                                                            unsigned int max_width,
+                                                                            unsigned int max_height) const
+        {
+            return this->template get_memory_map_block<const typename PixelPolicy::pixel_type>(memory_map, x, y, max_width, max_height);
+        }
+
         /**
          * Copy the raw data into a buffer.
          */
@@ -151,6 +221,22 @@ namespace degate
             memory_map.set(x, y, new_val);
         }
 
+        inline ImageBlock<typename PixelPolicy::pixel_type> get_block(unsigned int x,
+                                                                      unsigned int y,
+                                                                      unsigned int max_width,
+                                                                      unsigned int max_height)
+        {
+            return this->template get_memory_map_block<typename PixelPolicy::pixel_type>(memory_map, x, y, max_width, max_height);
+        }
+
+        inline ImageBlock<const typename PixelPolicy::pixel_type> get_block(unsigned int x,
+                                                                            unsigned int y,
+                                                                            unsigned int max_width,
+                                                                            unsigned int max_height) const
+        {
+            return this->template get_memory_map_block<const typename PixelPolicy::pixel_type>(memory_map, x, y, max_width, max_height);
+        }
+
         /**
          * Copy the raw data into a buffer.
          */
@@ -26,6 +26,7 @@
 #include "Core/Image/Image.h"
 #include "Core/Image/TileCacheBase.h"
 #include "Core/Utils/FileSystem.h"
+#include "Core/Utils/Instrumentation.h"
 #include "Core/Utils/MemoryMap.h"
 #include "Core/Utils/Utils.h"
 #include "GUI/Workspace/WorkspaceNotifier.h"
@@ -34,7 +35,11 @@
 #include <QImageReader>
 #include <QtConcurrent/QtConcurrent>
 #include <cmath>
+#include <atomic>
 #include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 #include <qmessagebox.h>
 #include <qnamespace.h>
 #include <qrunnable.h>
@@ -69,6 +74,82 @@ namespace degate
     {
         friend class GlobalTileCache<PixelPolicy>;
 
+    private:
+        // Cache types.
+        typedef std::shared_ptr<MemoryMap<typename PixelPolicy::pixel_type>> MemoryMap_shptr;
+        typedef uint_fast64_t tile_key_type;
+        typedef std::list<tile_key_type> lru_type;
+
+        struct cache_entry
+        {
+            MemoryMap_shptr tile;
+            typename lru_type::iterator lru_position;
+        };
+
+        typedef std::unordered_map<tile_key_type, cache_entry> cache_type;
+
+        /**
+         * Per-thread handle on the last tile used by a thread.
+         * The reference on the tile is held separately (see get_thread_tile_reference()),
+         * so the handle is trivial and is accessed without any thread local initialization check.
+         * @see get_tile_fast().
+         */
+        struct TileHandle
+        {
+            uint_fast64_t cache_id = 0;
+            uint_fast64_t generation = 0;
+            unsigned int tile_num_x = 0;
+            unsigned int tile_num_y = 0;
+            MemoryMap<typename PixelPolicy::pixel_type>* tile = nullptr;
+        };
+
+        // Generation value that never matches, to force a rebind.
+        static constexpr uint_fast64_t invalid_generation = ~uint_fast64_t(0);
+
+        // Number of tile handles per thread (power of 2), so a thread can work on
+        // several images at once (e.g. a source and a destination) without thrashing.
+        static constexpr unsigned int thread_tile_handles = 4;
+
+        /**
+         * Get the calling thread's tile handle slot for a cache.
+         */
+        static inline TileHandle& get_thread_tile_handle(uint_fast64_t cache_id)
+        {
+            static thread_local TileHandle handles[thread_tile_handles];
+            return handles[cache_id & (thread_tile_handles - 1)];
+        }
+
+        /**
+         * Get the reference on the tile of the calling thread's tile handle slot for a cache.
+         */
+        static inline MemoryMap_shptr& get_thread_tile_reference(uint_fast64_t cache_id)
+        {
+            static thread_local MemoryMap_shptr references[thread_tile_handles];
+            return references[cache_id & (thread_tile_handles - 1)];
+        }
+
+        /**
+         * Drop the calling thread's tile handle, if it is bound to this cache.
+         */
+        inline void drop_thread_tile_handle()
+        {
+            TileHandle& handle = get_thread_tile_handle(cache_id);
+            if (handle.cache_id == cache_id)
+            {
+                handle = TileHandle();
+                get_thread_tile_reference(cache_id).reset();
+            }
+        }
+
+        /**
+         * Get a new unique tile cache id (never 0).
+         */
+        static inline uint_fast64_t get_new_cache_id()
+        {
+            static std::atomic<uint_fast64_t> next_cache_id{1};
+            return next_cache_id.fetch_add(1, std::memory_order_relaxed);
+        }
+
     public:
         /**
          * Create a new tile cache.
@@ -101,7 +182,8 @@ namespace degate
               scale(scale),
               loading_type(loading_type),
               notification_list(notification_list),
-              tile_size(1 << tile_width_exp)
+              tile_size(1 << tile_width_exp),
+              cache_id(get_new_cache_id())
         {
             // Check if Degate's image format
             QImageReader reader(this->path.c_str());
@@ -175,7 +257,7 @@ namespace degate
          */
         inline ~TileCache()
         {
-            std::lock_guard<std::mutex> lock(mtx);
+            std::lock_guard<std::recursive_mutex> lock(mtx);
 
             // Delete and clear watchers
             for (auto* watcher : watchers)
@@ -187,40 +269,51 @@ namespace degate
         }
 
         /**
-         * Cleanup the cache by removing the oldest entry.
+         * Cleanup the cache by removing the least recently used entry.
+         *
+         * If the cache is in use by another thread, nothing is released (the global
+         * tile cache then asks the next cache). Blocking here could deadlock, since
+         * the other thread may be waiting for the global tile cache.
+         *
+         * A tile that is still referenced outside of the cache (by a thread tile
+         * handle or by the current tile) is skipped: removing it from the cache
+         * would not free its memory.
          */
         inline void cleanup_cache() override
         {
-            if (cache.size() == 0)
+            std::unique_lock<std::recursive_mutex> lock(mtx, std::try_to_lock);
+
+            if (!lock.owns_lock() || lru.empty())
                 return;
 
-            std::lock_guard<std::mutex> lock(mtx);
+            // The least recently used tile is always at the back of the list
+            auto position = lru.end();
+            auto oldest = cache.end();
+            do
+            {
+                --position;
+                oldest = cache.find(*position);
+                assert(oldest != cache.end());
 
-            // Initialize a clock to store the oldest
-            struct timespec oldest_clock_val;
-            GET_CLOCK(oldest_clock_val);
+                // A new reference is only taken with the lock held, so a use count of 1 can't change
+                if (oldest->second.tile == loading_tile || oldest->second.tile.use_count() == 1)
+                    break;
 
-            auto oldest = cache.begin();
+                oldest = cache.end();
+            } while (position != lru.begin());
 
-            // Search for oldest entry
-            for (auto iter = cache.begin(); iter != cache.end(); ++iter)
-            {
-                struct timespec clock_val = (*iter).second.second;
-                if (clock_val < oldest_clock_val)
-                {
-                    oldest_clock_val.tv_sec = clock_val.tv_sec;
-                    oldest_clock_val.tv_nsec = clock_val.tv_nsec;
-                    oldest = iter;
-                }
-            }
+            if (oldest == cache.end())
+                return;
 
-            assert(oldest != cache.end());
+            static Counter& evictions = Instrumentation::get_instance().get_counter("tile_cache.evictions");
+            evictions.add();
 
             // Release memory
-            (*oldest).second.first.reset(); // explicit reset of smart pointer
+            oldest->second.tile.reset(); // explicit reset of smart pointer
 
-            // Clean the cache entry
+            // Clean the cache entry. No tile handle holds the tile, so the handles stay valid.
             cache.erase(oldest);
+            lru.erase(position);
 
 #ifdef TILECACHE_DEBUG
             debug(TM, "local cache: %d entries after remove\n", cache.size());
@@ -233,13 +326,19 @@ namespace degate
 
         /**
          * Release all the memory.
+         *
+         * The tile handle of the calling thread is dropped. A tile still held by the
+         * handle of another thread is freed on the next access of this thread to a
+         * cache using the same handle slot.
          */
         inline void release_memory()
         {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+
+            drop_thread_tile_handle();
+
             if (cache.size() > 0)
             {
-                std::lock_guard<std::mutex> lock(mtx);
-
                 // Release the global tile cache (by removing all the used virtual memory by this)
                 GlobalTileCache<PixelPolicy>& gtc = GlobalTileCache<PixelPolicy>::get_instance();
                 gtc.release_cache_memory(this, cache.size() * get_image_size());
@@ -247,18 +346,35 @@ namespace degate
                 // Release the memory
                 current_tile.reset();
                 cache.clear();
+                lru.clear();
+                generation.fetch_add(1, std::memory_order_release);
             }
         }
 
+        /**
+         * Check if a tile is in the cache.
+         *
+         * @param tile_x : the x index of the tile (not the real coordinate).
+         * @param tile_y : the y index of the tile (not the real coordinate).
+         */
+        inline bool contains_tile(unsigned int tile_x, unsigned int tile_y)
+        {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+
+            return cache.find(make_tile_key(tile_x, tile_y)) != cache.end();
+        }
+
         /**
          * Print this cache info.
          */
         inline void print() const override
         {
-            for (typename cache_type::const_iterator iter = cache.begin(); iter != cache.end(); ++iter)
+            // Most recently used first
+            unsigned int rank = 0;
+            for (auto iter = lru.begin(); iter != lru.end(); ++iter, ++rank)
             {
-                std::cout << "\t+ " << path << "/" << (*iter).first << " " << (*iter).second.second.tv_sec << "/"
-                          << (*iter).second.second.tv_nsec << std::endl;
+                std::cout << "\t+ " << path << "/" << get_tile_filename(*iter) << " (lru rank " << rank << ")"
+                          << std::endl;
             }
         }
 
@@ -341,107 +457,69 @@ namespace degate
         }
 
         /**
-         * Load a new tile and update the cache.
-         * 
-         * @param x : the x index of the tile (not the real coordinate).
-         * @param y : the y index of the tile (not the real coordinate).
-         * @param update_current : if true, will update the current_tile pointer, otherwise not.
+         * Get the tile containing the pixel (x, y) through the calling thread's tile handle.
+         *
+         * As long as the accesses of a thread stay in the same tile, no lock is taken
+         * and no reference count is touched: the handle is only revalidated against the
+         * cache generation, which changes each time a tile of this cache is replaced or
+         * the cache is cleared. The handle keeps a reference on its tile, so the returned
+         * tile stays valid until the next access of the same thread to this cache, and
+         * the tile is not evicted meanwhile (see cleanup_cache()).
+         *
+         * @param x : absolute pixel coordinate.
+         * @param y : absolute pixel coordinate.
+         *
+         * @return Returns the tile, never null.
          */
-        inline void load_tile(unsigned int x, unsigned int y, bool update_current = false)
+        inline MemoryMap<typename PixelPolicy::pixel_type>* get_tile_fast(unsigned int x, unsigned int y)
         {
-            std::lock_guard<std::mutex> lock(mtx);
-
-            // Check if tile is included in the base image
-            // Otherwise return loading tile
-            if (!is_included(x, y))
-            {
-                if (update_current)
-                {
-                    current_tile = loading_tile;
-                    curr_tile_num_x = x;
-                    curr_tile_num_y = y;
-                    current_tile_is_loading = false;
-                }
+            const unsigned int tile_num_x = x >> tile_width_exp;
+            const unsigned int tile_num_y = y >> tile_width_exp;
 
-                return;
-            }
-
-            // Get time
-            struct timespec now
-            {
-            };
-            GET_CLOCK(now);
+            TileHandle& handle = get_thread_tile_handle(cache_id);
 
-            // Create a file name from tile number
-            auto filename = QString("%1_%2.dat").arg(x).arg(y).toStdString();
-
-            // If filename/object is not in cache, load the tile
-            typename cache_type::const_iterator iter = cache.find(filename);
-
-            // If the tile was not found in the cache, then load it
-            if (iter == cache.end())
+            if (handle.cache_id == cache_id && handle.tile_num_x == tile_num_x && handle.tile_num_y == tile_num_y &&
+                handle.generation == generation.load(std::memory_order_acquire))
             {
-                GlobalTileCache<PixelPolicy>& gtc = GlobalTileCache<PixelPolicy>::get_instance();
-
-                // Allocate memory (global tile cache)
-                bool ok = gtc.request_cache_memory(this, get_image_size());
-                assert(ok == true);
-
-                if (degate_image_format == false)
-                {
-                    // Check loading type
-                    if (loading_type == TileLoadingType::Async)
-                    {
-                        // If update_current, then update and set a black loading tile
-                        if (update_current)
-                        {
-                            cache[filename] = std::make_pair(loading_tile, now);
-                            current_tile = loading_tile;
-                            curr_tile_num_x = x;
-                            curr_tile_num_y = y;
-                            current_tile_is_loading = true;
-                        }
-
-                        // Run in another thread the loading phase of the new tile
-                        load_async(x, y, now, filename);
-
-                        // Show the loading tile while waiting for the next update to try to load the real tile image
-                        return;
-                    }
-                    else
-                    {
-                        // If sync
-                        auto temp = load(x, y, tile_size, scaled_size, path, best_image_number);
+                return handle.tile;
+            }
 
-                        // Prevent overflow
-                        if (temp == nullptr)
-                            temp = loading_tile;
+            return bind_thread_tile_handle(handle, tile_num_x, tile_num_y);
+        }
 
-                        // Update cache
-                        cache[filename] = std::make_pair(temp, now);
-                    }
-                }
-                else
-                {
-                    // Async loading not supported for degate image format (memory map)
-                    cache[filename] = std::make_pair(load_degate_image_format(filename), now);
-                }
+        /**
+         * Get a shared reference on the tile containing the pixel (x, y).
+         * Same as get_tile_fast(), but the tile stays valid as long as the reference exists.
+         *
+         * @param x : absolute pixel coordinate.
+         * @param y : absolute pixel coordinate.
+         */
+        inline MemoryMap_shptr get_tile_shared(unsigned int x, unsigned int y)
+        {
+            get_tile_fast(x, y);
+            return get_thread_tile_reference(cache_id);
+        }
 
-#ifdef TILECACHE_DEBUG
-                gtc.print_table();
-#endif
-            }
+        /**
+         * Load a new tile and update the cache.
+         * 
+         * @param x : the x index of the tile (not the real coordinate).
+         * @param y : the y index of the tile (not the real coordinate).
+         * @param update_current : if true, will update the current_tile pointer, otherwise not.
+         */
+        inline void load_tile(unsigned int x, unsigned int y, bool update_current = false)
+        {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
 
-            // Update entry
-            auto entry = cache[filename];
-            entry.second = now;
+            bool pending = false;
+            MemoryMap_shptr tile = fetch_tile(x, y, update_current, &pending);
 
             if (update_current)
             {
-                current_tile = entry.first;
+                current_tile = tile;
                 curr_tile_num_x = x;
                 curr_tile_num_y = y;
-                current_tile_is_loading = false;
+                current_tile_is_loading = pending;
             }
         }
 
@@ -460,6 +538,9 @@ namespace degate
                                                                                         std::string path,
                                                                                         int best_image_number)
         {
+            static Histogram& load_timer = Instrumentation::get_instance().get_timer("tile_cache.load");
+            ScopedTimer timer(load_timer);
+
             // Prepare sizes
             QSize reading_size{static_cast<int>(tile_size), static_cast<int>(tile_size)};
             const QSize read_size{static_cast<int>(tile_x) * static_cast<int>(tile_size),
@@ -574,6 +655,200 @@ namespace degate
                 WorkspaceNotifier::get_instance().notify(notification.first, notification.second);
         }
 
+        /**
+         * Get a tile from the cache, loading it if needed.
+         * The mutex must be held by the caller.
+         *
+         * If the global tile cache refuses the memory for a new tile, the tile is
+         * loaded but not cached: it is released with its last reference.
+         *
+         * @param x : the x index of the tile (not the real coordinate).
+         * @param y : the y index of the tile (not the real coordinate).
+         * @param store_placeholder : if true and the tile is loaded asynchronously,
+         *      the loading tile is stored (and returned) until the real tile is loaded.
+         * @param pending : if not null, set to true if the tile is loaded asynchronously
+         *      (an async loading was started, or must be tried again).
+         *
+         * @return Returns the tile, or null if the tile is loaded asynchronously and
+         *      no placeholder was requested.
+         */
+        inline MemoryMap_shptr fetch_tile(unsigned int x,
+                                          unsigned int y,
+                                          bool store_placeholder,
+                                          bool* pending = nullptr)
+        {
+            // Check if tile is included in the base image
+            // Otherwise return loading tile
+            if (!is_included(x, y))
+                return loading_tile;
+
+            // Pack the tile coordinates into a single key
+            const tile_key_type key = make_tile_key(x, y);
+
+            // If object is not in cache, load the tile
+            auto iter = cache.find(key);
+
+            static Counter& hits = Instrumentation::get_instance().get_counter("tile_cache.hits");
+            static Counter& misses = Instrumentation::get_instance().get_counter("tile_cache.misses");
+
+            // If the tile was found in the cache, update entry (mark as most recently used)
+            if (iter != cache.end())
+            {
+                hits.add();
+                touch(iter->second);
+                return iter->second.tile;
+            }
+
+            misses.add();
+
+            GlobalTileCache<PixelPolicy>& gtc = GlobalTileCache<PixelPolicy>::get_instance();
+
+            // Allocate memory (global tile cache). This fails only if the global tile cache is
+            // full of tiles in use by other threads, the tile is then used without being cached.
+            const bool cached = gtc.request_cache_memory(this, get_image_size());
+
+            MemoryMap_shptr tile;
+
+            if (degate_image_format == false)
+            {
+                // Check loading type
+                if (loading_type == TileLoadingType::Async)
+                {
+                    // If not cached, there is nothing to wait for: just try again on the next update
+                    if (cached)
+                    {
+                        // If requested, set a black loading tile
+                        if (store_placeholder)
+                            store_tile(key, loading_tile);
+
+                        // Run in another thread the loading phase of the new tile
+                        load_async(x, y, key);
+                    }
+
+                    if (pending != nullptr)
+                        *pending = true;
+
+                    // Show the loading tile while waiting for the next update to try to load the real tile image
+                    return store_placeholder ? loading_tile : nullptr;
+                }
+
+                // If sync
+                tile = load(x, y, tile_size, scaled_size, path, best_image_number);
+
+                // Prevent overflow
+                if (tile == nullptr)
+                    tile = loading_tile;
+            }
+            else
+            {
+                // Async loading not supported for degate image format (memory map)
+                tile = load_degate_image_format(get_tile_filename(key));
+            }
+
+            if (!cached)
+            {
+                static Counter& uncached_loads = Instrumentation::get_instance().get_counter("tile_cache.uncached_loads");
+                uncached_loads.add();
+
+                return tile;
+            }
+
+            // Update cache
+            iter = store_tile(key, std::move(tile));
+
+#ifdef TILECACHE_DEBUG
+            gtc.print_table();
+#endif
+
+            return iter->second.tile;
+        }
+
+        /**
+         * Bind the calling thread's tile handle to a tile (slow path of get_tile_fast()).
+         * Kept out of get_tile_fast(), so that the handle check is inlined in the callers.
+         *
+         * @return Returns the tile, never null.
+         */
+        MemoryMap<typename PixelPolicy::pixel_type>* bind_thread_tile_handle(TileHandle& handle,
+                                                                              unsigned int tile_num_x,
+                                                                              unsigned int tile_num_y)
+        {
+            std::lock_guard<std::recursive_mutex> lock(mtx);
+
+            MemoryMap_shptr& reference = get_thread_tile_reference(cache_id);
+            reference = fetch_tile(tile_num_x, tile_num_y, true);
+
+            handle.cache_id = cache_id;
+            handle.tile_num_x = tile_num_x;
+            handle.tile_num_y = tile_num_y;
+            handle.tile = reference.get();
+
+            // The loading tile is a placeholder, so always check again for the real one
+            if (reference == loading_tile)
+                handle.generation = invalid_generation;
+            else
+                handle.generation = generation.load(std::memory_order_relaxed);
+
+            return handle.tile;
+        }
+
+        /**
+         * Pack tile indices into a single cache key.
+         *
+         * @param tile_x : the tile first coordinate (first index).
+         * @param tile_y : the tile second coordinate (second index).
+         */
+        static inline tile_key_type make_tile_key(unsigned int tile_x, unsigned int tile_y)
+        {
+            return (static_cast<tile_key_type>(tile_x) << 32) | static_cast<tile_key_type>(tile_y);
+        }
+
+        /**
+         * Get the file name of a tile (degate image format), from its cache key.
+         */
+        static inline std::string get_tile_filename(tile_key_type key)
+        {
+            return QString("%1_%2.dat")
+                    .arg(static_cast<unsigned int>(key >> 32))
+                    .arg(static_cast<unsigned int>(key & 0xffffffff))
+                    .toStdString();
+        }
+
+        /**
+         * Mark a cache entry as the most recently used one.
+         * The mutex must be held by the caller.
+         */
+        inline void touch(cache_entry& entry)
+        {
+            lru.splice(lru.begin(), lru, entry.lru_position);
+        }
+
+        /**
+         * Insert (or replace) a tile in the cache and mark it as the most recently used one.
+         * The mutex must be held by the caller.
+         *
+         * @return Returns an iterator to the cache entry.
+         */
+        inline typename cache_type::iterator store_tile(tile_key_type key, MemoryMap_shptr tile)
+        {
+            auto iter = cache.find(key);
+            if (iter == cache.end())
+            {
+                lru.push_front(key);
+                iter = cache.emplace(key, cache_entry{std::move(tile), lru.begin()}).first;
+            }
+            else
+            {
+                iter->second.tile = std::move(tile);
+                touch(iter->second);
+
+                // Threads may still use the replaced tile
+                generation.fetch_add(1, std::memory_order_release);
+            }
+
+            return iter;
+        }
+
         /**
          * Load image in degate internal format.
          * 
@@ -585,6 +860,9 @@ namespace degate
         inline std::shared_ptr<MemoryMap<typename PixelPolicy::pixel_type>> load_degate_image_format(
                 std::string const& filename)
         {
+            static Histogram& load_timer = Instrumentation::get_instance().get_timer("tile_cache.load");
+            ScopedTimer timer(load_timer);
+
             std::shared_ptr<MemoryMap<typename PixelPolicy::pixel_type>> mem(
                     new MemoryMap<typename PixelPolicy::pixel_type>(uint_fast64_t(1) << tile_width_exp,
                                                                     uint_fast64_t(1) << tile_width_exp,
@@ -623,7 +901,7 @@ namespace degate
         /**
          * Run load() async, take into account this Tile Cache possible destruction before getting the result.
          */
-        inline void load_async(unsigned int x, unsigned int y, struct timespec now, std::string filename)
+        inline void load_async(unsigned int x, unsigned int y, tile_key_type key)
         {
             // QRunnable will delete the object when task finished
             auto* loader = new TileLoader<PixelPolicy>(x,
@@ -637,12 +915,9 @@ namespace degate
                                                            if (result == nullptr)
                                                                result = loading_tile;
 
-                                                           // Convert to cache type
-                                                           auto data = std::make_pair(result, now);
-
                                                            // Register the new entry and send notifications (if this lambda was called, then this is valid/not destroyed)
-                                                           std::lock_guard<std::mutex> lock(mtx);
-                                                           cache[filename] = data;
+                                                           std::lock_guard<std::recursive_mutex> lock(mtx);
+                                                           store_tile(key, result);
                                                            notify();
                                                        });
 
@@ -654,13 +929,10 @@ namespace degate
         const std::string path;
         const unsigned int tile_width_exp;
 
-        // Cache types.
-        typedef std::shared_ptr<MemoryMap<typename PixelPolicy::pixel_type>> MemoryMap_shptr;
-        typedef std::map<std::string, // filename
-                         std::pair<MemoryMap_shptr, struct timespec>>
-                cache_type;
-
+        // Cache content, indexed by packed tile coordinates. The LRU list
+        // holds the keys from the most recently used to the least recently used.
         cache_type cache;
+        lru_type lru;
 
         // Used for caching the working tile.
         MemoryMap_shptr current_tile;
@@ -670,7 +942,9 @@ namespace degate
 
         unsigned int scale;
 
-        std::mutex mtx;
+        // Recursive, since the global tile cache can ask this cache to release
+        // memory while a tile is being loaded (and so while the lock is held).
+        std::recursive_mutex mtx;
 
         TileLoadingType loading_type;
         WorkspaceNotificationVector notification_list;
@@ -683,6 +957,12 @@ namespace degate
 
         std::shared_ptr<MemoryMap<typename PixelPolicy::pixel_type>> loading_tile;
 
+        // Identifies this cache in the per-thread tile handles.
+        const uint_fast64_t cache_id;
+
+        // Changed each time a tile is replaced or the cache is cleared (invalidates tile handles).
+        std::atomic<uint_fast64_t> generation{0};
+
         std::vector<QFutureWatcher<std::shared_ptr<MemoryMap<typename PixelPolicy::pixel_type>>>*> watchers;
     };
 
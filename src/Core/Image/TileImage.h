@@ -86,6 +86,35 @@ namespace degate
             else return requested_size - remainder + tile_size;
         }
 
+        /**
+         * Get a block from the tile containing x,y.
+         */
+        template <typename BlockPixelType>
+        inline ImageBlock<BlockPixelType> get_tile_block(unsigned int x,
+                                                         unsigned int y,
+                                                         unsigned int max_width,
+                                                         unsigned int max_height) const
+        {
+            if (x >= width || y >= height)
+                return ImageBlock<BlockPixelType>();
+
+            MemoryMap_shptr tile = tile_cache->get_tile_shared(x, y);
+
+            const unsigned int tile_size = get_tile_size();
+            const unsigned int offset_x = x & offset_bitmask;
+            const unsigned int offset_y = y & offset_bitmask;
+
+            BlockPixelType* data = tile->data() + static_cast<std::size_t>(offset_y) * tile_size + offset_x;
+
+            return ImageBlock<BlockPixelType>(data,
+                                              x,
+                                              y,
+                                              std::min(max_width, std::min(tile_size - offset_x, width - x)),
+                                              std::min(max_height, std::min(tile_size - offset_y, height - y)),
+                                              tile_size,
+                                              std::move(tile));
+        }
+
     public:
 
         /**
@@ -178,6 +207,30 @@ namespace degate
 
         inline void set_pixel(unsigned int x, unsigned int y, typename PixelPolicy::pixel_type new_val);
 
+        /**
+         * Get direct access to a block of pixels, clipped to the tile containing x,y.
+         * @see StoragePolicy_Base::get_block()
+         */
+        inline ImageBlock<typename PixelPolicy::pixel_type> get_block(unsigned int x,
+                                                                      unsigned int y,
+                                                                      unsigned int max_width,
+                                                                      unsigned int max_height)
+        {
+            return get_tile_block<typename PixelPolicy::pixel_type>(x, y, max_width, max_height);
+        }
+
+        /**
+         * Get a read-only block of pixels, clipped to the tile containing x,y.
+         * @see StoragePolicy_Base::get_block()
+         */
+        inline ImageBlock<const typename PixelPolicy::pixel_type> get_block(unsigned int x,
+                                                                            unsigned int y,
+                                                                            unsigned int max_width,
+                                                                            unsigned int max_height) const
+        {
+            return get_tile_block<const typename PixelPolicy::pixel_type>(x, y, max_width, max_height);
+        }
+
         /**
          * Copy the raw data from an image tile that has its upper left corner at x,y into a buffer.
          */
@@ -229,8 +282,7 @@ namespace degate
     StoragePolicy_Tile<PixelPolicy>::get_pixel(unsigned int x,
                                                unsigned int y) const
     {
-        MemoryMap_shptr mem = tile_cache->get_tile(x, y);
-        return mem->get(x & offset_bitmask, y & offset_bitmask);
+        return tile_cache->get_tile_fast(x, y)->get(x & offset_bitmask, y & offset_bitmask);
     }
 
     template <class PixelPolicy>
@@ -238,8 +290,7 @@ namespace degate
     StoragePolicy_Tile<PixelPolicy>::set_pixel(unsigned int x, unsigned int y,
                                                typename PixelPolicy::pixel_type new_val)
     {
-        MemoryMap_shptr mem = tile_cache->get_tile(x, y);
-        mem->set(x & offset_bitmask, y & offset_bitmask, new_val);
+        tile_cache->get_tile_fast(x, y)->set(x & offset_bitmask, y & offset_bitmask, new_val);
     }
 }
 
@@ -0,0 +1,82 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/LogicModel/BulkInsert.h"
+#include "Core/Utils/DegateExceptions.h"
+
+using namespace degate;
+
+BulkInsert::BulkInsert(LogicModel_shptr lmodel, Layer_shptr layer) :
+    lmodel(lmodel),
+    layer(layer),
+    indexed(0)
+{
+    if (lmodel == nullptr || layer == nullptr)
+        throw InvalidPointerException("Invalid parameter for BulkInsert()");
+}
+
+void BulkInsert::add(PlacedLogicModelObject_shptr o)
+{
+    if (o == nullptr)
+        throw InvalidPointerException();
+
+    objects.push_back(o);
+}
+
+std::vector<PlacedLogicModelObject_shptr> BulkInsert::commit()
+{
+    // The staged objects are kept if the logic model rejects them
+    if (!objects.empty())
+        lmodel->add_new_objects(layer, objects);
+
+    std::vector<PlacedLogicModelObject_shptr> committed;
+    committed.swap(objects);
+    rollback();
+
+    return committed;
+}
+
+void BulkInsert::rollback()
+{
+    objects.clear();
+    staged.reset();
+    indexed = 0;
+}
+
+void BulkInsert::index_staged_objects()
+{
+    if (staged == nullptr)
+        staged.reset(new QuadTree<PlacedLogicModelObject_shptr>(layer->get_bounding_box(), 100));
+
+    if (indexed == objects.size())
+        return;
+
+    // Region checks usually follow each new object, bulk loading is for larger sets
+    if (objects.size() - indexed > 1)
+    {
+        if (RET_IS_NOT_OK(staged->bulk_insert(objects.begin() + indexed, objects.end())))
+            throw DegateRuntimeException("Failed to insert objects into quadtree.");
+    }
+    else if (RET_IS_NOT_OK(staged->insert(objects.back())))
+        throw DegateRuntimeException("Failed to insert object into quadtree.");
+
+    indexed = objects.size();
+}
@@ -0,0 +1,129 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __BULKINSERT_H__
+#define __BULKINSERT_H__
+
+#include "Core/LogicModel/LogicModel.h"
+#include "Core/Primitive/QuadTree.h"
+
+#include <memory>
+#include <vector>
+
+namespace degate
+{
+    /**
+     * @class BulkInsert
+     * @brief Collect new objects of a layer and add them into the logic model at once.
+     *
+     * The objects added to a bulk insert are only staged: the logic model and the
+     * layer are changed by commit(), see LogicModel::add_new_objects(). A bulk insert
+     * that is not committed changes nothing.
+     *
+     * The region checks see the objects of the layer and the staged objects, so
+     * overlapping objects can be rejected before the commit.
+     */
+    class BulkInsert
+    {
+    public:
+
+        /**
+         * Create an empty bulk insert into a layer.
+         */
+        BulkInsert(LogicModel_shptr lmodel, Layer_shptr layer);
+
+        BulkInsert(BulkInsert const&) = delete;
+        BulkInsert& operator=(BulkInsert const&) = delete;
+
+        /**
+         * Stage a new object.
+         */
+        void add(PlacedLogicModelObject_shptr o);
+
+        /**
+         * Get the number of staged objects.
+         */
+        std::size_t size() const
+        {
+            return objects.size();
+        }
+
+        /**
+         * Check for placed or staged objects in a region of type given by template param.
+         * @see Layer::exists_type_in_region()
+         */
+        template <typename LogicModelObjectType>
+        bool exists_type_in_region(unsigned int min_x, unsigned int max_x,
+                                   unsigned int min_y, unsigned int max_y)
+        {
+            if (layer->exists_type_in_region<LogicModelObjectType>(min_x, max_x, min_y, max_y))
+                return true;
+
+            if (objects.empty())
+                return false;
+
+            index_staged_objects();
+
+            for (auto iter = staged->region_iter_begin(min_x, max_x, min_y, max_y);
+                 iter != staged->region_iter_end(); ++iter)
+            {
+                if (std::dynamic_pointer_cast<LogicModelObjectType>(*iter) != nullptr)
+                    return true;
+            }
+            return false;
+        }
+
+        /**
+         * Add the staged objects into the logic model, then empty the bulk insert.
+         * If the logic model rejects the objects, an exception is thrown, the logic
+         * model is not changed and the objects stay staged.
+         * @return Returns the added objects (the new gate ports are not included).
+         * @see LogicModel::add_new_objects()
+         */
+        std::vector<PlacedLogicModelObject_shptr> commit();
+
+        /**
+         * Drop the staged objects.
+         */
+        void rollback();
+
+    private:
+
+        /**
+         * Insert the objects staged since the last region check into the staged quadtree.
+         */
+        void index_staged_objects();
+
+        LogicModel_shptr lmodel;
+        Layer_shptr layer;
+
+        std::vector<PlacedLogicModelObject_shptr> objects;
+
+        /**
+         * Quadtree of the staged objects, created on the first region check,
+         * with the first 'indexed' objects.
+         */
+        std::unique_ptr<QuadTree<PlacedLogicModelObject_shptr>> staged;
+        std::size_t indexed;
+    };
+}
+
+#endif
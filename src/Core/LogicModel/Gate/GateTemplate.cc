@@ -22,8 +22,19 @@
 
 #include "Core/LogicModel/Gate/GateTemplate.h"
 
+#include <atomic>
+
 using namespace degate;
 
+namespace
+{
+    uint_fast64_t next_image_revision()
+    {
+        static std::atomic<uint_fast64_t> revision(0);
+        return ++revision;
+    }
+}
+
 void GateTemplate::increment_reference_counter()
 {
     reference_counter++;
@@ -81,6 +92,7 @@ void GateTemplate::clone_deep_into(DeepCopyable_shptr dest, oldnew_t* oldnew) co
 
     // images
     clone->images = images;
+    clone->image_revision = image_revision;
 
     ColoredObject::clone_deep_into(dest, oldnew);
     LogicModelObjectBase::clone_deep_into(dest, oldnew);
@@ -117,6 +129,7 @@ void GateTemplate::set_image(Layer::LAYER_TYPE layer_type, GateTemplateImage_shp
     if (img == nullptr) throw InvalidPointerException("Invalid pointer for image.");
     debug(TM, "set image for template.");
     images[layer_type] = img;
+    image_revision = next_image_revision();
 }
 
 
@@ -133,6 +146,11 @@ bool GateTemplate::has_image(Layer::LAYER_TYPE layer_type) const
     return images.find(layer_type) != images.end();
 }
 
+uint_fast64_t GateTemplate::get_image_revision() const
+{
+    return image_revision;
+}
+
 void GateTemplate::add_template_port(GateTemplatePort_shptr template_port)
 {
     if (!template_port->has_valid_object_id())
@@ -70,6 +70,7 @@ namespace degate
 
         implementation_collection implementations;
         image_collection images;
+        uint_fast64_t image_revision = 0;
 
         std::string logic_class = "undefined"; // e.g. nand, xor, flipflop, buffer, oai
 
@@ -174,6 +175,13 @@ namespace degate
          */
         virtual bool has_image(Layer::LAYER_TYPE layer_type) const;
 
+        /**
+         * Get the revision of the reference images. It changes every time an
+         * image is set, and it is unique among all templates.
+         * Use it to detect that data computed from the images is outdated.
+         */
+        virtual uint_fast64_t get_image_revision() const;
+
         /**
          * Add a template port to a gate template.
          * This is an isolated function. The port is just added to the gate template.
@@ -24,20 +24,36 @@
 #include "Core/LogicModel/Gate/Gate.h"
 #include "Core/LogicModel/Via/Via.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 
 using namespace degate;
 
-void Layer::add_object(std::shared_ptr<PlacedLogicModelObject> o)
+namespace
 {
-    if (o->get_bounding_box() == BoundingBox(0, 0, 0, 0))
+    uint_fast64_t next_image_revision()
     {
-        boost::format fmter("Error in add_object(): Object %1% with ID %2% has an "
-            "undefined bounding box. Can't insert it into the quadtree");
-        fmter % o->get_object_type_name() % o->get_object_id();
-        throw DegateLogicException(fmter.str());
+        static std::atomic<uint_fast64_t> revision(0);
+        return ++revision;
     }
 
+    void check_bounding_box(std::shared_ptr<PlacedLogicModelObject> const& o)
+    {
+        if (o->get_bounding_box() == BoundingBox(0, 0, 0, 0))
+        {
+            boost::format fmter("Error in add_object(): Object %1% with ID %2% has an "
+                "undefined bounding box. Can't insert it into the quadtree");
+            fmter % o->get_object_type_name() % o->get_object_id();
+            throw DegateLogicException(fmter.str());
+        }
+    }
+}
+
+void Layer::add_object(std::shared_ptr<PlacedLogicModelObject> o)
+{
+    check_bounding_box(o);
+
     if (RET_IS_NOT_OK(quadtree.insert(o)))
     {
         debug(TM, "Failed to insert object into quadtree.");
@@ -46,9 +62,35 @@ void Layer::add_object(std::shared_ptr<PlacedLogicModelObject> o)
     objects[o->get_object_id()] = o;
 }
 
+void Layer::add_objects(std::vector<std::shared_ptr<PlacedLogicModelObject>> const& objects)
+{
+    std::for_each(objects.begin(), objects.end(), check_bounding_box);
+
+    if (RET_IS_NOT_OK(quadtree.bulk_insert(objects.begin(), objects.end())))
+    {
+        debug(TM, "Failed to insert objects into quadtree.");
+        throw DegateRuntimeException("Failed to insert objects into quadtree.");
+    }
+
+    for (auto const& o : objects)
+        this->objects[o->get_object_id()] = o;
+}
+
 void Layer::remove_object(std::shared_ptr<PlacedLogicModelObject> o)
 {
-    if (RET_IS_NOT_OK(quadtree.remove(o)))
+    ret_t ret;
+
+    // A moved object is still stored with its old bounding box
+    auto pending = pending_shape_changes.find(o->get_object_id());
+    if (pending != pending_shape_changes.end())
+    {
+        ret = quadtree.remove(o, pending->second.second);
+        pending_shape_changes.erase(pending);
+    }
+    else
+        ret = quadtree.remove(o);
+
+    if (RET_IS_NOT_OK(ret))
     {
         debug(TM, "Failed to remove object from quadtree.");
         throw std::runtime_error("Failed to remove object from quadtree.");
@@ -107,6 +149,7 @@ DeepCopyable_shptr Layer::clone_shallow() const
     clone->description = description;
     clone->layer_id = layer_id;
     clone->scaling_manager = scaling_manager;
+    clone->image_revision = image_revision;
     return clone;
 }
 
@@ -117,10 +160,11 @@ void Layer::clone_deep_into(DeepCopyable_shptr dest, oldnew_t* oldnew) const
     // quadtree
     std::vector<quadtree_element_type> quadtree_elems;
     quadtree.get_all_elements(quadtree_elems);
-    std::for_each(quadtree_elems.begin(), quadtree_elems.end(), [=,&clone](const quadtree_element_type& t)
+    std::for_each(quadtree_elems.begin(), quadtree_elems.end(), [=](quadtree_element_type& t)
     {
-        clone->quadtree.insert(std::dynamic_pointer_cast<PlacedLogicModelObject>(t->clone_deep(oldnew)));
+        t = std::dynamic_pointer_cast<PlacedLogicModelObject>(t->clone_deep(oldnew));
     });
+    clone->quadtree.bulk_insert(quadtree_elems.begin(), quadtree_elems.end());
 
     // objects
     std::for_each(objects.begin(), objects.end(), [&](object_collection::value_type v)
@@ -227,6 +271,8 @@ void Layer::set_image(BackgroundImage_shptr img)
     scaling_manager = std::make_shared<ScalingManager<BackgroundImage>>(img, img->get_path(), project_type);
 
     scaling_manager->create_scalings();
+
+    image_revision = next_image_revision();
 }
 
 BackgroundImage_shptr Layer::get_image()
@@ -273,6 +319,7 @@ void Layer::unset_image()
 
     std::string img_dir = get_image_filename();
     scaling_manager.reset();
+    image_revision = next_image_revision();
 
     debug(TM, "remove directory: %s", img_dir.c_str());
     remove_directory(img_dir);
@@ -299,7 +346,61 @@ void Layer::print(std::ostream& os)
 
 void Layer::notify_shape_change(object_id_t object_id, const BoundingBox& old_bb)
 {
-    quadtree.notify_shape_change(get_object(object_id), old_bb);
+    std::shared_ptr<PlacedLogicModelObject> o = get_object(object_id);
+
+    if (shape_changes_depth == 0)
+    {
+        quadtree.notify_shape_change(o, old_bb);
+        return;
+    }
+
+    // Keep the first bounding box, the object is stored with it in the quadtree
+    pending_shape_changes.insert(std::make_pair(object_id, std::make_pair(o, old_bb)));
+}
+
+void Layer::begin_shape_changes()
+{
+    shape_changes_depth++;
+}
+
+void Layer::end_shape_changes()
+{
+    assert(shape_changes_depth > 0);
+
+    if (--shape_changes_depth > 0)
+        return;
+
+    std::vector<std::pair<quadtree_element_type, BoundingBox>> removed;
+    std::vector<quadtree_element_type> moved;
+
+    removed.reserve(pending_shape_changes.size());
+    moved.reserve(pending_shape_changes.size());
+
+    for (auto const& change : pending_shape_changes)
+    {
+        if (change.second.first->get_bounding_box() == change.second.second)
+            continue;
+
+        removed.push_back(change.second);
+        moved.push_back(change.second.first);
+    }
+
+    pending_shape_changes.clear();
+
+    if (moved.empty())
+        return;
+
+    if (RET_IS_NOT_OK(quadtree.bulk_remove(removed)))
+    {
+        debug(TM, "Failed to remove objects from quadtree.");
+        throw DegateRuntimeException("Failed to remove objects from quadtree.");
+    }
+
+    if (RET_IS_NOT_OK(quadtree.bulk_insert(moved.begin(), moved.end())))
+    {
+        debug(TM, "Failed to insert objects into quadtree.");
+        throw DegateRuntimeException("Failed to insert objects into quadtree.");
+    }
 }
 
 
@@ -34,6 +34,7 @@
 
 #include <set>
 #include <stdexcept>
+#include <vector>
 
 namespace degate
 {
@@ -71,6 +72,7 @@ namespace degate
         layer_position_t layer_pos;
 
         std::shared_ptr<ScalingManager<BackgroundImage>> scaling_manager;
+        uint_fast64_t image_revision = 0;
 
         // store shared pointers to objects, that belong to the layer
         typedef std::map<object_id_t, PlacedLogicModelObject_shptr> object_collection;
@@ -83,6 +85,13 @@ namespace degate
 
         ProjectType project_type;
 
+        /**
+         * Shape changes deferred by begin_shape_changes(): the object and the bounding
+         * box it is stored with in the quadtree, by object ID.
+         */
+        unsigned int shape_changes_depth = 0;
+        std::map<object_id_t, std::pair<PlacedLogicModelObject_shptr, BoundingBox>> pending_shape_changes;
+
     protected:
 
         /**
@@ -93,6 +102,15 @@ namespace degate
          */
         void add_object(std::shared_ptr<PlacedLogicModelObject> o);
 
+        /**
+         * Add many logic model objects into this layer at once.
+         * The quadtree is built in one pass (see QuadTree::bulk_insert()).
+         * @throw DegateRuntimeException Is thrown if the objects
+         *   cannot be inserted into the quadtree.
+         * @throw DegateLogicException Is thrown if an object has an undefined
+         *   bounding box. In this case, no object is added.
+         */
+        void add_objects(std::vector<std::shared_ptr<PlacedLogicModelObject>> const& objects);
 
         /**
          * Remove object from layer.
@@ -260,6 +278,13 @@ namespace degate
          */
         void unset_image();
 
+        /**
+         * Get the revision of the background image. It changes every time the
+         * background image is set or unset, and it is unique among all layers.
+         * Use it to detect that data computed from the background image is outdated.
+         */
+        uint_fast64_t get_image_revision() const { return image_revision; }
+
         /**
          * Get the scaling manager.
          * If you want to access the background image of a layer, that is the
@@ -293,6 +318,24 @@ namespace degate
          */
         void notify_shape_change(object_id_t object_id, const BoundingBox& old_bb);
 
+        /**
+         * Defer the quadtree updates of notify_shape_change() until end_shape_changes(),
+         * to move many objects at once. Calls can be nested.
+         *
+         * Until then, moved objects are found in the quadtree at their old position.
+         */
+        void begin_shape_changes();
+
+        /**
+         * Apply the quadtree updates deferred since begin_shape_changes(). The moved
+         * objects are removed from the quadtree and inserted back in one pass
+         * (see QuadTree::bulk_insert()).
+         *
+         * @throw DegateRuntimeException Is thrown if the objects
+         *   cannot be moved in the quadtree.
+         */
+        void end_shape_changes();
+
         /**
          * Get an object at a specific position.
          * If multiple objects are placed at coordinate \p x, \p y, then if
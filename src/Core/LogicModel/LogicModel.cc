@@ -30,6 +30,7 @@
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <set>
 
 
 using namespace std;
@@ -83,35 +84,28 @@ void LogicModel::print(std::ostream& os)
     }
 }
 
-bool LogicModel::exists_layer_id(layer_collection const& layers, layer_id_t lid) const
+object_id_t LogicModel::get_new_object_id()
 {
-    for (auto l : layers)
-    {
-        if (l != nullptr && l->has_valid_layer_id() && l->get_layer_id() == lid)
-            return true;
-    }
-    return false;
+    return object_ids.allocate();
 }
 
-object_id_t LogicModel::get_new_object_id()
+object_id_t LogicModel::reserve_object_ids(object_id_t count)
 {
-    object_id_t new_id = ++object_id_counter;
-    while (objects.find(new_id) != objects.end() ||
-        (gate_library != nullptr && (gate_library->exists_template(new_id) || gate_library->exists_template_port(new_id)))
-        ||
-        nets.find(new_id) != nets.end() ||
-        exists_layer_id(layers, new_id))
-    {
-        new_id = ++object_id_counter;
-    }
-    return new_id;
+    return object_ids.allocate_block(count);
+}
+
+void LogicModel::reserve_template_ids(GateTemplate_shptr tmpl)
+{
+    object_ids.reserve(tmpl->get_object_id());
+
+    for (GateTemplate::port_iterator iter = tmpl->ports_begin(); iter != tmpl->ports_end(); ++iter)
+        object_ids.reserve((*iter)->get_object_id());
 }
 
 
 LogicModel::LogicModel(unsigned int width, unsigned int height, ProjectType project_type, unsigned int layers) :
     bounding_box(static_cast<float>(width), static_cast<float>(height)),
     main_module(new Module("main_module", "", true)),
-    object_id_counter(0),
     project_type(project_type)
 {
     gate_library = std::make_shared<GateLibrary>();
@@ -268,17 +262,11 @@ void LogicModel::add_gate(int layer_pos, Gate_shptr o)
     if (!o->has_valid_object_id()) o->set_object_id(get_new_object_id());
     gates[o->get_object_id()] = o;
 
+    if (o->get_template_type_id() != 0)
+        template_instances[o->get_template_type_id()].insert(o->get_object_id());
+
     assert(main_module != nullptr);
     main_module->add_gate(o);
-
-    // iterate over ports and add them into the lookup table
-    for (Gate::port_iterator iter = o->ports_begin(); iter != o->ports_end(); ++iter)
-    {
-        assert(*iter != nullptr);
-        assert((*iter)->has_valid_object_id() == true);
-
-        add_object(layer_pos, std::dynamic_pointer_cast<PlacedLogicModelObject>(*iter));
-    }
 }
 
 void LogicModel::remove_gate_ports(Gate_shptr o)
@@ -299,6 +287,14 @@ void LogicModel::remove_gate(Gate_shptr o)
     debug(TM, "remove gate");
     gates.erase(o->get_object_id());
 
+    auto instances = template_instances.find(o->get_template_type_id());
+    if (instances != template_instances.end())
+    {
+        instances->second.erase(o->get_object_id());
+        if (instances->second.empty())
+            template_instances.erase(instances);
+    }
+
     main_module->remove_gate(o);
 }
 
@@ -328,14 +324,27 @@ void LogicModel::remove_annotation(Annotation_shptr o)
 }
 
 
-void LogicModel::add_object(int layer_pos, PlacedLogicModelObject_shptr o)
+void LogicModel::register_object(Layer_shptr layer, PlacedLogicModelObject_shptr o,
+                                 std::vector<PlacedLogicModelObject_shptr>& placed)
 {
     if (o == nullptr) throw InvalidPointerException();
     if (!o->has_valid_object_id()) o->set_object_id(get_new_object_id());
     object_id_t object_id = o->get_object_id();
+    int layer_pos = layer->get_layer_pos();
 
     if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(o))
+    {
         add_gate(layer_pos, gate);
+
+        // iterate over ports and add them into the lookup table
+        for (Gate::port_iterator iter = gate->ports_begin(); iter != gate->ports_end(); ++iter)
+        {
+            assert(*iter != nullptr);
+            assert((*iter)->has_valid_object_id() == true);
+
+            register_object(layer, std::dynamic_pointer_cast<PlacedLogicModelObject>(*iter), placed);
+        }
+    }
     else if (Wire_shptr wire = std::dynamic_pointer_cast<Wire>(o))
         add_wire(layer_pos, wire);
     else if (Via_shptr via = std::dynamic_pointer_cast<Via>(o))
@@ -362,14 +371,107 @@ void LogicModel::add_object(int layer_pos, PlacedLogicModelObject_shptr o)
     else
     {
         objects[object_id] = o;
-        Layer_shptr layer = get_create_layer(layer_pos);
-        assert(layer != nullptr);
+        object_ids.reserve(object_id);
         o->set_layer(layer);
-        layer->add_object(o);
+        placed.push_back(o);
     }
     assert(objects.find(object_id) != objects.end());
 }
 
+void LogicModel::add_object(int layer_pos, PlacedLogicModelObject_shptr o)
+{
+    if (o == nullptr) throw InvalidPointerException();
+
+    Layer_shptr layer = get_create_layer(layer_pos);
+    assert(layer != nullptr);
+
+    std::vector<PlacedLogicModelObject_shptr> placed;
+    register_object(layer, o, placed);
+
+    for (auto const& p : placed)
+        layer->add_object(p);
+}
+
+void LogicModel::add_objects(int layer_pos, std::vector<PlacedLogicModelObject_shptr> const& objects)
+{
+    Layer_shptr layer = get_create_layer(layer_pos);
+    assert(layer != nullptr);
+
+    std::vector<PlacedLogicModelObject_shptr> placed;
+    placed.reserve(objects.size());
+
+    for (auto const& o : objects)
+        register_object(layer, o, placed);
+
+    layer->add_objects(placed);
+}
+
+
+void LogicModel::add_new_objects(Layer_shptr layer, std::vector<PlacedLogicModelObject_shptr> const& objects)
+{
+    if (layer == nullptr) throw InvalidPointerException();
+
+    // Check all the objects first, nothing is registered if one of them is rejected
+    std::set<object_id_t> ids;
+    auto check_object = [this, &ids](PlacedLogicModelObject_shptr const& o)
+    {
+        if (o->get_bounding_box() == BoundingBox(0, 0, 0, 0))
+        {
+            std::ostringstream stm;
+            stm << "Logic model object " << o->get_object_type_name() << " with id "
+                << o->get_object_id() << " has an undefined bounding box.";
+            throw DegateLogicException(stm.str());
+        }
+
+        if (o->has_valid_object_id() &&
+            (this->objects.find(o->get_object_id()) != this->objects.end() || !ids.insert(o->get_object_id()).second))
+        {
+            std::ostringstream stm;
+            stm << "Logic model object with id " << o->get_object_id() << " is already stored in the logic model.";
+            throw DegateLogicException(stm.str());
+        }
+    };
+
+    object_id_t count = 0;
+    for (auto const& o : objects)
+    {
+        if (o == nullptr) throw InvalidPointerException();
+        check_object(o);
+        if (!o->has_valid_object_id()) count++;
+
+        if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(o))
+        {
+            for (Gate::port_iterator iter = gate->ports_begin(); iter != gate->ports_end(); ++iter)
+            {
+                if (!(*iter)->has_valid_object_id())
+                    throw InvalidObjectIDException("A port of a new gate has no valid object ID.");
+                check_object(*iter);
+            }
+
+            count += count_missing_gate_ports(gate);
+        }
+    }
+
+    // One block for the new objects and the new gate ports
+    object_id_t id = count > 0 ? reserve_object_ids(count) : 0;
+
+    for (auto const& o : objects)
+        if (!o->has_valid_object_id()) o->set_object_id(id++);
+
+    std::vector<PlacedLogicModelObject_shptr> placed;
+    placed.reserve(objects.size());
+
+    for (auto const& o : objects)
+    {
+        register_object(layer, o, placed);
+
+        if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(o))
+            add_gate_ports(gate, placed, id);
+    }
+
+    layer->add_objects(placed);
+}
+
 
 void LogicModel::remove_remote_object(object_id_t remote_id)
 {
@@ -446,7 +548,9 @@ void LogicModel::remove_object(PlacedLogicModelObject_shptr o, bool add_to_remov
 
         layer->remove_object(o);
     }
-    objects.erase(o->get_object_id());
+
+    if (objects.erase(o->get_object_id()) > 0)
+        object_ids.release(o->get_object_id());
 }
 
 void LogicModel::remove_object(PlacedLogicModelObject_shptr o)
@@ -461,6 +565,7 @@ void LogicModel::add_gate_template(GateTemplate_shptr tmpl)
     {
         if (!tmpl->has_valid_object_id()) tmpl->set_object_id(get_new_object_id());
         gate_library->add_template(tmpl);
+        reserve_template_ids(tmpl);
         //update_gate_ports(tmpl);
 
         // XXX iterate over gates and check tmpl-id -> update
@@ -480,6 +585,10 @@ void LogicModel::remove_gate_template(GateTemplate_shptr tmpl)
     {
         remove_gates_by_template_type(tmpl);
         gate_library->remove_template(tmpl);
+
+        object_ids.release(tmpl->get_object_id());
+        for (GateTemplate::port_iterator iter = tmpl->ports_begin(); iter != tmpl->ports_end(); ++iter)
+            object_ids.release((*iter)->get_object_id());
     }
 }
 
@@ -487,16 +596,15 @@ void LogicModel::remove_template_references(GateTemplate_shptr tmpl)
 {
     if (gate_library == nullptr)
         throw DegateLogicException("You can't remove a gate template, if there is no gate library.");
-    for (gate_collection::iterator iter = gates_begin();
-         iter != gates.end(); ++iter)
+
+    for (auto const& gate : get_template_instances(tmpl))
     {
-        Gate_shptr gate = (*iter).second;
-        if (gate->get_gate_template() == tmpl)
-        {
-            remove_gate_ports(gate);
-            gate->remove_template();
-        }
+        remove_gate_ports(gate);
+        gate->remove_template();
     }
+
+    // The gates have no template anymore
+    template_instances.erase(tmpl->get_object_id());
 }
 
 
@@ -504,28 +612,15 @@ void LogicModel::remove_gates_by_template_type(GateTemplate_shptr tmpl)
 {
     if (tmpl == nullptr) throw InvalidPointerException("The gate template pointer is invalid.");
 
-    std::list<Gate_shptr> gates_to_remove;
-
-    for (gate_collection::iterator iter = gates_begin();
-         iter != gates_end(); ++iter)
-    {
-        Gate_shptr gate = (*iter).second;
-
-        if (gate->get_gate_template() == tmpl)
-            gates_to_remove.push_back(gate);
-    }
-
-    while (!gates_to_remove.empty())
-    {
-        remove_object(gates_to_remove.front());
-        gates_to_remove.pop_front();
-    }
+    for (auto const& gate : get_template_instances(tmpl))
+        remove_object(gate);
 }
 
 void LogicModel::add_template_port_to_gate_template(GateTemplate_shptr gate_template,
                                                     GateTemplatePort_shptr template_port)
 {
     gate_template->add_template_port(template_port);
+    object_ids.reserve(template_port->get_object_id());
     update_ports(gate_template);
 }
 
@@ -541,47 +636,47 @@ void LogicModel::update_ports(Gate_shptr gate)
     if (gate == nullptr)
         throw InvalidPointerException("Invalid parameter for update_ports()");
 
-    GateTemplate_shptr gate_template = gate->get_gate_template();
-
     debug(TM, "update ports on gate %llu", gate->get_object_id());
 
-    // in a first iteration over all template ports from the corresponding template
-    // we check if there are gate ports to add
     if (gate->has_template())
-    {
-        // iterate over template ports from the corresponding template
-
         debug(TM, "compare ports for gate with oid=%llu with corresponding template (oid=%llu)", gate->get_object_id(),
-              gate_template->get_object_id());
+              gate->get_gate_template()->get_object_id());
 
-        for (GateTemplate::port_iterator tmpl_port_iter = gate_template->ports_begin();
-             tmpl_port_iter != gate_template->ports_end(); ++tmpl_port_iter)
-        {
-            GateTemplatePort_shptr tmpl_port = *tmpl_port_iter;
-            assert(tmpl_port != nullptr);
+    Layer_shptr layer = gate->get_layer();
+    std::vector<PlacedLogicModelObject_shptr> new_ports;
 
-            if (!gate->has_template_port(tmpl_port) && gate->has_orientation())
-            {
-                debug(TM, "adding a new port to gate, because the gate has no reference to the gate port template %llu.",
-                      tmpl_port->get_object_id());
-                GatePort_shptr new_gate_port(new GatePort(gate, tmpl_port, port_diameter));
-                new_gate_port->set_object_id(get_new_object_id());
-                gate->add_port(new_gate_port); // will set coordinates, too
+    if (layer == nullptr)
+    {
+        update_gate_ports(gate, new_ports);
+        return;
+    }
 
-                assert(gate->get_layer() != nullptr);
-                add_object(gate->get_layer()->get_layer_pos(), new_gate_port);
-            }
-        }
+    layer->begin_shape_changes();
+
+    try
+    {
+        update_gate_ports(gate, new_ports);
+    }
+    catch (...)
+    {
+        layer->end_shape_changes();
+        throw;
     }
 
-    std::list<GatePort_shptr> ports_to_remove;
+    layer->end_shape_changes();
 
+    if (!new_ports.empty())
+        layer->add_objects(new_ports);
+}
 
-    // iterate over gate ports
+void LogicModel::update_gate_ports(Gate_shptr gate, std::vector<PlacedLogicModelObject_shptr>& new_ports)
+{
+    std::list<GatePort_shptr> ports_to_remove;
+
+    // iterate over gate ports: reset their coordinates or remove them
     for (Gate::port_iterator port_iter = gate->ports_begin();
          port_iter != gate->ports_end(); ++port_iter)
     {
-        //debug(TM, "iterating over ports");
         GatePort_shptr gate_port = *port_iter;
         assert(gate_port != nullptr);
 
@@ -593,11 +688,8 @@ void LogicModel::update_ports(Gate_shptr gate)
             GateTemplatePort_shptr tmpl_port = gate_port->get_template_port();
             assert(tmpl_port != nullptr);
 
-            bool has_template_port = tmpl->has_template_port(tmpl_port->get_object_id());
-
-            if (has_template_port)
+            if (tmpl->has_template_port(tmpl_port->get_object_id()))
             {
-                GateTemplatePort_shptr tmpl_port = gate_port->get_template_port();
                 // reset port coordinates
                 if (gate->has_orientation())
                 {
@@ -609,30 +701,76 @@ void LogicModel::update_ports(Gate_shptr gate)
                     gate_port->set_name(tmpl_port->get_name());
                 }
             }
-                // unset port coordinates
             else
-            {
-                debug(TM, "should remove port with oid=%llu from gate with oid %llu", gate_port->get_object_id(),
-                      gate->get_object_id());
                 ports_to_remove.push_back(gate_port);
-            }
         }
         else
-        {
-            debug(TM, "should remove port with oid=%llu from gate with oid=%llu, because gate has no template",
-                  gate_port->get_object_id(), gate->get_object_id());
             ports_to_remove.push_back(gate_port);
+    }
+
+    for (auto const& gate_port : ports_to_remove)
+    {
+        gate->remove_port(gate_port);
+        remove_object(gate_port);
+    }
+
+    add_gate_ports(gate, new_ports);
+}
+
+void LogicModel::add_gate_ports(Gate_shptr gate, std::vector<PlacedLogicModelObject_shptr>& new_ports)
+{
+    object_id_t count = count_missing_gate_ports(gate);
+    if (count == 0)
+        return;
+
+    object_id_t next_id = reserve_object_ids(count);
+    add_gate_ports(gate, new_ports, next_id);
+}
+
+void LogicModel::add_gate_ports(Gate_shptr gate, std::vector<PlacedLogicModelObject_shptr>& new_ports,
+                                object_id_t& next_id)
+{
+    // add a port for each template port the gate has no reference to
+    if (gate->has_template() && gate->has_orientation())
+    {
+        GateTemplate_shptr gate_template = gate->get_gate_template();
+
+        for (GateTemplate::port_iterator tmpl_port_iter = gate_template->ports_begin();
+             tmpl_port_iter != gate_template->ports_end(); ++tmpl_port_iter)
+        {
+            GateTemplatePort_shptr tmpl_port = *tmpl_port_iter;
+            assert(tmpl_port != nullptr);
+
+            if (!gate->has_template_port(tmpl_port))
+            {
+                GatePort_shptr new_gate_port(new GatePort(gate, tmpl_port, port_diameter));
+                new_gate_port->set_object_id(next_id++);
+                gate->add_port(new_gate_port); // will set coordinates, too
+
+                assert(gate->get_layer() != nullptr);
+                register_object(gate->get_layer(), new_gate_port, new_ports);
+            }
         }
     }
+}
 
-    for (std::list<GatePort_shptr>::iterator iter = ports_to_remove.begin();
-         iter != ports_to_remove.end(); ++iter)
+object_id_t LogicModel::count_missing_gate_ports(Gate_shptr gate) const
+{
+    object_id_t count = 0;
+
+    if (gate->has_template() && gate->has_orientation())
     {
-        debug(TM, "remove real port:");
-        (*iter)->print();
-        gate->remove_port(*iter);
-        remove_object(*iter);
+        GateTemplate_shptr gate_template = gate->get_gate_template();
+
+        for (GateTemplate::port_iterator tmpl_port_iter = gate_template->ports_begin();
+             tmpl_port_iter != gate_template->ports_end(); ++tmpl_port_iter)
+        {
+            if (!gate->has_template_port(*tmpl_port_iter))
+                count++;
+        }
     }
+
+    return count;
 }
 
 void LogicModel::update_ports(GateTemplate_shptr gate_template)
@@ -640,17 +778,65 @@ void LogicModel::update_ports(GateTemplate_shptr gate_template)
     if (gate_template == nullptr)
         throw InvalidPointerException("Invalid parameter for update_ports()");
 
-    // iterate over all gates ...
-    for (gate_collection::iterator g_iter = gates.begin();
-         g_iter != gates.end(); ++g_iter)
+    std::vector<Gate_shptr> instances = get_template_instances(gate_template);
+
+    debug(TM, "update ports on %lu gates of template %llu", instances.size(), gate_template->get_object_id());
+
+    // The port moves are applied to the quadtrees at once
+    std::map<Layer_shptr, std::vector<PlacedLogicModelObject_shptr>> new_ports;
+
+    for (auto const& layer : layers)
+        if (layer != nullptr)
+            layer->begin_shape_changes();
+
+    auto end_shape_changes = [this]()
     {
-        Gate_shptr gate = (*g_iter).second;
-        if (gate->get_gate_template() == gate_template)
-        {
-            debug(TM, "update ports on gate with id %llu", gate->get_object_id());
-            update_ports(gate);
-        }
+        for (auto const& layer : layers)
+            if (layer != nullptr)
+                layer->end_shape_changes();
+    };
+
+    try
+    {
+        for (auto const& gate : instances)
+            update_gate_ports(gate, new_ports[gate->get_layer()]);
     }
+    catch (...)
+    {
+        end_shape_changes();
+        throw;
+    }
+
+    end_shape_changes();
+
+    for (auto const& ports : new_ports)
+    {
+        if (ports.first != nullptr && !ports.second.empty())
+            ports.first->add_objects(ports.second);
+    }
+}
+
+std::vector<Gate_shptr> LogicModel::get_template_instances(GateTemplate_shptr gate_template) const
+{
+    if (gate_template == nullptr)
+        throw InvalidPointerException("Invalid parameter for get_template_instances()");
+
+    std::vector<Gate_shptr> instances;
+
+    auto found = template_instances.find(gate_template->get_object_id());
+    if (found == template_instances.end())
+        return instances;
+
+    instances.reserve(found->second.size());
+
+    for (object_id_t gate_id : found->second)
+    {
+        auto gate = gates.find(gate_id);
+        if (gate != gates.end() && gate->second->get_gate_template() == gate_template)
+            instances.push_back(gate->second);
+    }
+
+    return instances;
 }
 
 
@@ -669,6 +855,7 @@ void LogicModel::add_layer(layer_position_t pos, Layer_shptr new_layer)
     {
         if (!new_layer->is_empty()) throw DegateLogicException("You must add an empty layer.");
         if (!new_layer->has_valid_layer_id()) new_layer->set_layer_id(get_new_layer_id());
+        object_ids.reserve(new_layer->get_layer_id());
         layers[pos] = new_layer;
         new_layer->set_layer_pos(pos);
     }
@@ -732,6 +919,9 @@ void LogicModel::set_layers(layer_collection layers)
 
     // set new layers
     this->layers = layers;
+
+    for (auto const& l : this->layers)
+        if (l != nullptr && l->has_valid_layer_id()) object_ids.reserve(l->get_layer_id());
 }
 
 void LogicModel::remove_layer(layer_position_t pos)
@@ -760,6 +950,8 @@ void LogicModel::remove_layer(Layer_shptr layer)
     // Remove layer container.
     layers.erase(remove(layers.begin(), layers.end(), layer),
                  layers.end());
+
+    if (layer->has_valid_layer_id()) object_ids.release(layer->get_layer_id());
 }
 
 void LogicModel::set_current_layer(layer_position_t pos)
@@ -784,6 +976,12 @@ void LogicModel::set_gate_library(GateLibrary_shptr new_gate_lib)
         // XXX
     }
     gate_library = new_gate_lib;
+
+    if (gate_library != nullptr)
+    {
+        for (GateLibrary::template_iterator iter = gate_library->begin(); iter != gate_library->end(); ++iter)
+            reserve_template_ids(iter->second);
+    }
 }
 
 void LogicModel::add_net(Net_shptr net)
@@ -798,6 +996,7 @@ void LogicModel::add_net(Net_shptr net)
         throw DegateRuntimeException(f.str());
     }
     nets[net->get_object_id()] = net;
+    object_ids.reserve(net->get_object_id());
 }
 
 
@@ -850,6 +1049,7 @@ void LogicModel::remove_net(Net_shptr net)
         //nets[net->get_object_id()].reset();
         size_t n = nets.erase(net->get_object_id());
         assert(n == 1);
+        object_ids.release(net->get_object_id());
     }
 }
 
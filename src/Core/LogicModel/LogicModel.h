@@ -40,12 +40,14 @@
 #include "Core/LogicModel/Gate/GateLibrary.h"
 #include "Core/LogicModel/Annotation/Annotation.h"
 #include "Core/LogicModel/Module.h"
+#include "Core/Utils/ObjectIDAllocator.h"
 
 #include <memory>
 #include <set>
 #include <map>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
 namespace degate
 {
@@ -91,11 +93,20 @@ namespace degate
          */
         object_collection objects;
 
+        typedef std::map<object_id_t, std::set<object_id_t>> template_instance_collection;
 
         /**
-         * Counter to generate new object IDs.
+         * IDs of the placed gates by gate template ID, to not iterate over
+         * all gates to find the instances of a template.
          */
-        object_id_t object_id_counter;
+        template_instance_collection template_instances;
+
+
+        /**
+         * The object IDs in use by the objects, nets, layers, gate templates
+         * and template ports, to generate new object IDs.
+         */
+        ObjectIDAllocator object_ids;
 
 
         /**
@@ -159,12 +170,55 @@ namespace degate
          * Add a gate into the logic model. If the layer doesn't exists, the layer is
          * created implicitly.
          * If the gate has no object ID, a new object ID for the gate is generated.
-         * Port are implicitly added, too.
+         * The ports are added by register_object().
          * @param layer_pos The layer position (starting at 0).
          * @param o A shared pointer to the object.
          */
         void add_gate(int layer_pos, Gate_shptr o);
 
+        /**
+         * Register an object, and the ports of a gate, into the logic model without
+         * inserting it into the layer quadtree.
+         * @param layer The layer of the object.
+         * @param o A shared pointer to the object.
+         * @param placed The registered objects, in order, that have to be inserted into the layer.
+         * @exception DegateLogicException This exception is thrown, if an object with the
+         *            same object ID is already in the logic model.
+         */
+        void register_object(Layer_shptr layer, PlacedLogicModelObject_shptr o,
+                             std::vector<PlacedLogicModelObject_shptr>& placed);
+
+        /**
+         * Compare ports of a gate with template ports of its associated template and update them.
+         * Port moves are notified to the layer (see Layer::begin_shape_changes()).
+         * @param gate The gate, it must be in a layer.
+         * @param new_ports The new ports, registered into the logic model but not yet
+         *   inserted into their layer, are added to this list.
+         */
+        void update_gate_ports(Gate_shptr gate, std::vector<PlacedLogicModelObject_shptr>& new_ports);
+
+        /**
+         * Create a port for each template port the gate has no port for.
+         * @param gate The gate, it must be registered into the logic model.
+         * @param new_ports The new ports, registered into the logic model but not yet
+         *   inserted into their layer, are added to this list.
+         */
+        void add_gate_ports(Gate_shptr gate, std::vector<PlacedLogicModelObject_shptr>& new_ports);
+
+        /**
+         * Create a port for each template port the gate has no port for, like
+         * add_gate_ports(), with the object IDs of a reserved block.
+         * @param next_id The next free ID of the block, it is advanced for each new port.
+         * @see count_missing_gate_ports()
+         */
+        void add_gate_ports(Gate_shptr gate, std::vector<PlacedLogicModelObject_shptr>& new_ports,
+                            object_id_t& next_id);
+
+        /**
+         * Get the number of template ports a gate has no port for.
+         */
+        object_id_t count_missing_gate_ports(Gate_shptr gate) const;
+
 
         /**
          * Remove all ports from the logic model for a given gate.
@@ -210,7 +264,10 @@ namespace degate
          */
         void remove_object(PlacedLogicModelObject_shptr o, bool add_to_remove_list);
 
-        bool exists_layer_id(layer_collection const& layers, layer_id_t lid) const;
+        /**
+         * Mark the IDs of a gate template and of its ports as used.
+         */
+        void reserve_template_ids(GateTemplate_shptr tmpl);
 
     public:
 
@@ -246,6 +303,15 @@ namespace degate
          */
         object_id_t get_new_object_id();
 
+        /**
+         * Reserve a block of consecutive unique object IDs for a bulk insert.
+         * The IDs can then be set on the new objects without calling
+         * get_new_object_id() for each object (e.g. from several threads).
+         * @param count : the number of IDs, must be greater than 0.
+         * @return Returns the first ID of the block [first, first + count - 1].
+         */
+        object_id_t reserve_object_ids(object_id_t count);
+
 
         /**
          * Lookup an object from the logic model for a given object ID.
@@ -277,6 +343,44 @@ namespace degate
             add_object(layer->get_layer_pos(), o);
         }
 
+        /**
+         * Add many logic model objects into a layer of the logic model at once.
+         * This is the same as calling add_object() for each object, but the layer
+         * quadtree is built in one pass. Use it to add large sets of objects, like
+         * when loading a project or for the matching results.
+         *
+         * @param layer_pos The layer position (starting at 0).
+         * @param objects The objects to add.
+         * @exception DegateLogicException This exception is thrown, if an object with the
+         *            same object ID is already in the logic model.
+         * @see add_object()
+         */
+        void add_objects(int layer_pos, std::vector<PlacedLogicModelObject_shptr> const& objects);
+
+        void add_objects(Layer_shptr layer, std::vector<PlacedLogicModelObject_shptr> const& objects)
+        {
+            add_objects(layer->get_layer_pos(), objects);
+        }
+
+        /**
+         * Add new logic model objects into a layer at once, like add_objects(), and
+         * create the missing ports of the new gates from their template. The objects
+         * without a valid object ID and the new gate ports get their IDs from one block
+         * (see reserve_object_ids()). The objects and the gate ports are inserted into
+         * the layer quadtree in one pass.
+         *
+         * The objects are checked before any of them is added: if an exception is
+         * thrown, the logic model is not changed.
+         *
+         * @param layer The layer.
+         * @param objects The new objects.
+         * @exception DegateLogicException This exception is thrown, if an object with the
+         *            same object ID is already in the logic model (or twice in the objects),
+         *            or if an object has an undefined bounding box.
+         * @see BulkInsert
+         */
+        void add_new_objects(Layer_shptr layer, std::vector<PlacedLogicModelObject_shptr> const& objects);
+
 
         /**
          * Remove a generic logic model object from the logic model.
@@ -567,10 +671,18 @@ namespace degate
 
         /**
          * Compare ports of all gates that reference a given template
-         * and update them.
+         * and update them. The quadtree updates of all ports are made at once.
          */
         void update_ports(GateTemplate_shptr gate_template);
 
+        /**
+         * Get the placed gates that reference a gate template, ordered by object ID.
+         *
+         * Gates are indexed by the template they have when they are added to the
+         * logic model, the template of a placed gate should not be replaced.
+         */
+        std::vector<Gate_shptr> get_template_instances(GateTemplate_shptr gate_template) const;
+
 
         /**
          * Get the main module.
@@ -0,0 +1,375 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "LogicModelBinaryExporter.h"
+#include "Prerequisites.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+using namespace degate;
+using namespace degate::binary_lmodel;
+
+namespace
+{
+    template<typename T>
+    section add_section(std::uint64_t& offset, std::vector<T> const& records)
+    {
+        section s = {offset, records.size()};
+        offset += records.size() * sizeof(T);
+        return s;
+    }
+
+    template<typename T>
+    void write_records(std::ofstream& file, std::vector<T> const& records)
+    {
+        if (!records.empty())
+            file.write(reinterpret_cast<char const*>(records.data()),
+                       static_cast<std::streamsize>(records.size() * sizeof(T)));
+    }
+}
+
+void LogicModelBinaryExporter::export_data(std::string const& filename, LogicModel_shptr lmodel)
+{
+    if (lmodel == nullptr)
+        throw InvalidPointerException("Logic model pointer is nullptr.");
+
+    try
+    {
+        clear();
+
+        std::vector<layer_records> layers;
+
+        for (auto layer_iter = lmodel->layers_begin(); layer_iter != lmodel->layers_end(); ++layer_iter)
+        {
+            if ((*layer_iter) == nullptr || (*layer_iter)->is_empty())
+                continue;
+
+            Layer_shptr layer = *layer_iter;
+
+            layers.emplace_back();
+            layers.back().position = layer->get_layer_pos();
+
+            for (Layer::object_iterator iter = layer->objects_begin(); iter != layer->objects_end(); ++iter)
+                add_object(layers.back(), *iter);
+        }
+
+        add_nets(lmodel);
+
+        // Update the module ports, as for the XML export.
+        determine_module_ports_for_root(lmodel);
+        lmodel->get_main_module()->determine_module_ports_recursive();
+
+        add_module(lmodel->get_main_module(), no_index);
+
+        if (strings.size() > std::numeric_limits<std::uint32_t>::max())
+            throw std::runtime_error("The string table of the binary logic model is too large.");
+
+        // Layout of the file: the header, the layer records, then all the other sections.
+        std::vector<layer_record> layer_headers(layers.size());
+
+        std::uint64_t offset = sizeof(file_header);
+
+        file_header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.header_size = sizeof(file_header);
+        header.layers = add_section(offset, layer_headers);
+
+        for (std::size_t i = 0; i < layers.size(); i++)
+        {
+            layer_record& layer_header = layer_headers[i];
+            std::memset(&layer_header, 0, sizeof(layer_header));
+
+            layer_header.position = layers[i].position;
+            layer_header.gates = add_section(offset, layers[i].gates);
+            layer_header.ports = add_section(offset, layers[i].ports);
+            layer_header.vias = add_section(offset, layers[i].vias);
+            layer_header.emarkers = add_section(offset, layers[i].emarkers);
+            layer_header.wires = add_section(offset, layers[i].wires);
+            layer_header.annotations = add_section(offset, layers[i].annotations);
+        }
+
+        header.parameters = add_section(offset, parameters);
+        header.nets = add_section(offset, nets);
+        header.connections = add_section(offset, connections);
+        header.modules = add_section(offset, modules);
+        header.cells = add_section(offset, cells);
+        header.module_ports = add_section(offset, module_ports);
+        header.strings.offset = offset;
+        header.strings.count = strings.size();
+
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            throw InvalidPathException("Can't create export file.");
+        }
+
+        file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        write_records(file, layer_headers);
+
+        for (auto const& layer : layers)
+        {
+            write_records(file, layer.gates);
+            write_records(file, layer.ports);
+            write_records(file, layer.vias);
+            write_records(file, layer.emarkers);
+            write_records(file, layer.wires);
+            write_records(file, layer.annotations);
+        }
+
+        write_records(file, parameters);
+        write_records(file, nets);
+        write_records(file, connections);
+        write_records(file, modules);
+        write_records(file, cells);
+        write_records(file, module_ports);
+        file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+
+        file.close();
+
+        if (!file)
+            throw std::runtime_error("Failed to write the export file.");
+
+        clear();
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << "Exception caught: " << ex.what() << std::endl;
+        clear();
+        throw;
+    }
+}
+
+void LogicModelBinaryExporter::clear()
+{
+    parameters.clear();
+    nets.clear();
+    connections.clear();
+    modules.clear();
+    cells.clear();
+    module_ports.clear();
+
+    strings.clear();
+    string_refs.clear();
+}
+
+string_ref LogicModelBinaryExporter::add_string(std::string const& str)
+{
+    string_ref ref = {0, 0};
+
+    if (str.empty())
+        return ref;
+
+    // Names are often repeated (e.g. gate names), they are stored once.
+    auto found = string_refs.find(str);
+    if (found != string_refs.end())
+        return found->second;
+
+    ref.offset = static_cast<std::uint32_t>(strings.size());
+    ref.size = static_cast<std::uint32_t>(str.size());
+
+    strings.append(str);
+    string_refs.insert(std::make_pair(str, ref));
+
+    return ref;
+}
+
+object_record LogicModelBinaryExporter::get_object_record(PlacedLogicModelObject_shptr o)
+{
+    object_record record;
+
+    record.id = oid_rewriter->get_new_object_id(o->get_object_id());
+    record.name = add_string(o->get_name());
+    record.description = add_string(o->get_description());
+    record.fill_color = o->get_fill_color();
+    record.frame_color = o->get_frame_color();
+
+    return record;
+}
+
+void LogicModelBinaryExporter::add_object(layer_records& layer, PlacedLogicModelObject_shptr o)
+{
+    // The object IDs are rewritten in the same order as for the XML export.
+    object_record object = get_object_record(o);
+
+    if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(o))
+    {
+        gate_record record;
+        std::memset(&record, 0, sizeof(record));
+
+        record.object = object;
+        record.min_x = gate->get_min_x();
+        record.min_y = gate->get_min_y();
+        record.max_x = gate->get_max_x();
+        record.max_y = gate->get_max_y();
+        record.template_id = oid_rewriter->get_new_object_id(gate->get_template_type_id());
+        record.orientation = static_cast<std::uint32_t>(gate->get_orientation());
+        record.first_port = layer.ports.size();
+
+        for (Gate::port_iterator iter = gate->ports_begin(); iter != gate->ports_end(); ++iter)
+        {
+            GatePort_shptr port = *iter;
+
+            port_record port_rec;
+            std::memset(&port_rec, 0, sizeof(port_rec));
+
+            port_rec.id = oid_rewriter->get_new_object_id(port->get_object_id());
+            port_rec.name = add_string(port->get_name());
+            port_rec.description = add_string(port->get_description());
+            port_rec.template_port_id = oid_rewriter->get_new_object_id(port->get_template_port_type_id());
+            port_rec.diameter = port->get_diameter();
+
+            layer.ports.push_back(port_rec);
+        }
+
+        record.port_count = static_cast<std::uint32_t>(layer.ports.size() - record.first_port);
+
+        layer.gates.push_back(record);
+    }
+    else if (Via_shptr via = std::dynamic_pointer_cast<Via>(o))
+    {
+        via_record record;
+        std::memset(&record, 0, sizeof(record));
+
+        record.object = object;
+        record.x = via->get_x();
+        record.y = via->get_y();
+        record.diameter = via->get_diameter();
+        record.direction = static_cast<std::uint32_t>(via->get_direction());
+        record.remote_id = via->get_remote_object_id();
+
+        layer.vias.push_back(record);
+    }
+    else if (EMarker_shptr emarker = std::dynamic_pointer_cast<EMarker>(o))
+    {
+        emarker_record record;
+        std::memset(&record, 0, sizeof(record));
+
+        record.object = object;
+        record.x = emarker->get_x();
+        record.y = emarker->get_y();
+        record.diameter = emarker->get_diameter();
+        record.is_module_port = emarker->is_module_port() ? 1 : 0;
+        record.remote_id = emarker->get_remote_object_id();
+
+        layer.emarkers.push_back(record);
+    }
+    else if (Wire_shptr wire = std::dynamic_pointer_cast<Wire>(o))
+    {
+        wire_record record;
+        std::memset(&record, 0, sizeof(record));
+
+        record.object = object;
+        record.from_x = wire->get_from_x();
+        record.from_y = wire->get_from_y();
+        record.to_x = wire->get_to_x();
+        record.to_y = wire->get_to_y();
+        record.diameter = wire->get_diameter();
+        record.remote_id = wire->get_remote_object_id();
+
+        layer.wires.push_back(record);
+    }
+    else if (Annotation_shptr annotation = std::dynamic_pointer_cast<Annotation>(o))
+    {
+        annotation_record record;
+        std::memset(&record, 0, sizeof(record));
+
+        record.object = object;
+        record.min_x = annotation->get_min_x();
+        record.min_y = annotation->get_min_y();
+        record.max_x = annotation->get_max_x();
+        record.max_y = annotation->get_max_y();
+        record.class_id = annotation->get_class_id();
+        record.first_parameter = parameters.size();
+
+        for (auto iter = annotation->parameters_begin(); iter != annotation->parameters_end(); ++iter)
+        {
+            parameter_record parameter = {add_string(iter->first), add_string(iter->second)};
+            parameters.push_back(parameter);
+        }
+
+        record.parameter_count = static_cast<std::uint32_t>(parameters.size() - record.first_parameter);
+
+        layer.annotations.push_back(record);
+    }
+}
+
+void LogicModelBinaryExporter::add_nets(LogicModel_shptr lmodel)
+{
+    for (LogicModel::net_collection::iterator net_iter = lmodel->nets_begin(); net_iter != lmodel->nets_end();
+         ++net_iter)
+    {
+        Net_shptr net = net_iter->second;
+        assert(net != nullptr);
+
+        net_record record;
+        record.id = oid_rewriter->get_new_object_id(net->get_object_id());
+        record.first_connection = connections.size();
+
+        for (Net::connection_iterator conn_iter = net->begin(); conn_iter != net->end(); ++conn_iter)
+            connections.push_back(oid_rewriter->get_new_object_id(*conn_iter));
+
+        record.connection_count = connections.size() - record.first_connection;
+
+        nets.push_back(record);
+    }
+}
+
+void LogicModelBinaryExporter::add_module(Module_shptr module, std::uint64_t parent)
+{
+    const std::uint64_t index = modules.size();
+
+    module_record record;
+    std::memset(&record, 0, sizeof(record));
+
+    // Same ID rewriting order as the XML export: module, module ports, cells, sub-modules.
+    record.id = oid_rewriter->get_new_object_id(module->get_object_id());
+    record.name = add_string(module->get_name());
+    record.entity = add_string(module->get_entity_name());
+    record.parent = parent;
+
+    record.first_port = module_ports.size();
+    for (Module::port_collection::const_iterator p_iter = module->ports_begin(); p_iter != module->ports_end();
+         ++p_iter)
+    {
+        module_port_record port = {add_string(p_iter->first),
+                                   oid_rewriter->get_new_object_id(p_iter->second->get_object_id())};
+        module_ports.push_back(port);
+    }
+    record.port_count = module_ports.size() - record.first_port;
+
+    record.first_cell = cells.size();
+    for (Module::gate_collection::const_iterator g_iter = module->gates_begin(); g_iter != module->gates_end();
+         ++g_iter)
+        cells.push_back(oid_rewriter->get_new_object_id((*g_iter)->get_object_id()));
+    record.cell_count = cells.size() - record.first_cell;
+
+    modules.push_back(record);
+
+    for (Module::module_collection::const_iterator m_iter = module->modules_begin(); m_iter != module->modules_end();
+         ++m_iter)
+        add_module(*m_iter, index);
+}
@@ -0,0 +1,99 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __LOGICMODELBINARYEXPORTER_H__
+#define __LOGICMODELBINARYEXPORTER_H__
+
+#include "Globals.h"
+#include "LogicModel.h"
+#include "LogicModelBinaryFile.h"
+#include "Core/Utils/Exporter.h"
+#include "Core/Utils/ObjectIDRewriter.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace degate
+{
+    /**
+     * The LogicModelBinaryExporter exports a logic model as a binary logic model file
+     * (see LogicModelBinaryFile), the binary counterpart of lmodel.xml.
+     */
+    class LogicModelBinaryExporter : public Exporter
+    {
+    private:
+
+        /**
+         * The records of a layer, before their offsets in the file are known.
+         */
+        struct layer_records
+        {
+            layer_position_t position;
+
+            std::vector<binary_lmodel::gate_record> gates;
+            std::vector<binary_lmodel::port_record> ports;
+            std::vector<binary_lmodel::via_record> vias;
+            std::vector<binary_lmodel::emarker_record> emarkers;
+            std::vector<binary_lmodel::wire_record> wires;
+            std::vector<binary_lmodel::annotation_record> annotations;
+        };
+
+        ObjectIDRewriter_shptr oid_rewriter;
+
+        std::vector<binary_lmodel::parameter_record> parameters;
+        std::vector<binary_lmodel::net_record> nets;
+        std::vector<std::uint64_t> connections;
+        std::vector<binary_lmodel::module_record> modules;
+        std::vector<std::uint64_t> cells;
+        std::vector<binary_lmodel::module_port_record> module_ports;
+
+        std::string strings;
+        std::unordered_map<std::string, binary_lmodel::string_ref> string_refs;
+
+        binary_lmodel::string_ref add_string(std::string const& str);
+        binary_lmodel::object_record get_object_record(PlacedLogicModelObject_shptr o);
+
+        void add_object(layer_records& layer, PlacedLogicModelObject_shptr o);
+        void add_nets(LogicModel_shptr lmodel);
+        void add_module(Module_shptr module, std::uint64_t parent);
+
+        void clear();
+
+    public:
+        LogicModelBinaryExporter(ObjectIDRewriter_shptr oid_rewriter) : oid_rewriter(oid_rewriter)
+        {
+        }
+
+        ~LogicModelBinaryExporter()
+        {
+        }
+
+        /**
+         * @exception InvalidPathException
+         * @exception InvalidPointerException
+         * @exception std::runtime_error
+         */
+        void export_data(std::string const& filename, LogicModel_shptr lmodel);
+    };
+}
+
+#endif
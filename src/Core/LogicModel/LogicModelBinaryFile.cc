@@ -0,0 +1,128 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/LogicModel/LogicModelBinaryFile.h"
+#include "Core/Utils/FileSystem.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include <boost/filesystem/operations.hpp>
+
+using namespace degate;
+using namespace degate::binary_lmodel;
+
+// The records are read in place from the mapped file, without padding between them.
+static_assert(sizeof(file_header) % 8 == 0, "file_header must be 8 bytes aligned.");
+static_assert(sizeof(layer_record) % 8 == 0, "layer_record must be 8 bytes aligned.");
+static_assert(sizeof(gate_record) % 8 == 0, "gate_record must be 8 bytes aligned.");
+static_assert(sizeof(port_record) % 8 == 0, "port_record must be 8 bytes aligned.");
+static_assert(sizeof(via_record) % 8 == 0, "via_record must be 8 bytes aligned.");
+static_assert(sizeof(emarker_record) % 8 == 0, "emarker_record must be 8 bytes aligned.");
+static_assert(sizeof(wire_record) % 8 == 0, "wire_record must be 8 bytes aligned.");
+static_assert(sizeof(annotation_record) % 8 == 0, "annotation_record must be 8 bytes aligned.");
+static_assert(sizeof(parameter_record) % 8 == 0, "parameter_record must be 8 bytes aligned.");
+static_assert(sizeof(net_record) % 8 == 0, "net_record must be 8 bytes aligned.");
+static_assert(sizeof(module_record) % 8 == 0, "module_record must be 8 bytes aligned.");
+static_assert(sizeof(module_port_record) % 8 == 0, "module_port_record must be 8 bytes aligned.");
+
+LogicModelBinaryFile::LogicModelBinaryFile(std::string const& filename) : data(nullptr), size(0), header(nullptr)
+{
+    if (!is_file(filename))
+        throw InvalidPathException("Can't load the binary logic model, the file doesn't exist.");
+
+    const std::uint64_t file_size = boost::filesystem::file_size(filename);
+
+    if (file_size < sizeof(file_header))
+        throw InvalidFileFormatException("The binary logic model file is truncated.");
+
+    // The whole file is mapped as a single row
+    if (file_size > std::numeric_limits<unsigned int>::max())
+        throw InvalidFileFormatException("The binary logic model file is too large.");
+
+    size = static_cast<std::size_t>(file_size);
+
+    // Read-only, the file can be write protected and is never resized.
+    file = std::make_unique<MemoryMap<std::uint8_t>>(static_cast<unsigned int>(size), 1,
+                                                     MAP_STORAGE_TYPE_READ_ONLY_FILE, filename);
+    data = file->data();
+    if (data == nullptr)
+        throw InvalidPathException("Can't map the binary logic model file.");
+
+    header = reinterpret_cast<file_header const*>(data);
+
+    if (std::memcmp(header->magic, magic, sizeof(magic)) != 0)
+        throw InvalidFileFormatException("The file is not a binary logic model file.");
+
+    if (header->version != version || header->header_size != sizeof(file_header))
+        throw InvalidFileFormatException("Unsupported binary logic model file version.");
+
+    check_section(header->layers, sizeof(layer_record));
+    check_section(header->parameters, sizeof(parameter_record));
+    check_section(header->nets, sizeof(net_record));
+    check_section(header->connections, sizeof(std::uint64_t));
+    check_section(header->modules, sizeof(module_record));
+    check_section(header->cells, sizeof(std::uint64_t));
+    check_section(header->module_ports, sizeof(module_port_record));
+    check_section(header->strings, 1);
+
+    for (auto const& layer : get_layers())
+    {
+        check_section(layer.gates, sizeof(gate_record));
+        check_section(layer.ports, sizeof(port_record));
+        check_section(layer.vias, sizeof(via_record));
+        check_section(layer.emarkers, sizeof(emarker_record));
+        check_section(layer.wires, sizeof(wire_record));
+        check_section(layer.annotations, sizeof(annotation_record));
+    }
+}
+
+LogicModelBinaryFile::~LogicModelBinaryFile() = default;
+
+bool LogicModelBinaryFile::is_binary_file(std::string const& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+
+    char buffer[sizeof(magic)];
+    if (!file.read(buffer, sizeof(buffer)))
+        return false;
+
+    return std::memcmp(buffer, magic, sizeof(magic)) == 0;
+}
+
+void LogicModelBinaryFile::check_section(section const& s, std::size_t record_size) const
+{
+    // Records are read in place, they must be aligned.
+    const std::size_t alignment = record_size < 8 ? record_size : 8;
+
+    if (s.offset > size || s.offset % alignment != 0 || s.count > (size - s.offset) / record_size)
+        throw InvalidFileFormatException("The binary logic model file is truncated.");
+}
+
+std::string LogicModelBinaryFile::get_string(string_ref const& ref) const
+{
+    if (ref.offset > header->strings.count || ref.size > header->strings.count - ref.offset)
+        throw InvalidFileFormatException("A string is out of the string table.");
+
+    char const* strings = reinterpret_cast<char const*>(data + header->strings.offset);
+    return std::string(strings + ref.offset, ref.size);
+}
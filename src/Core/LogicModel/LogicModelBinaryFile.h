@@ -0,0 +1,399 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __LOGICMODELBINARYFILE_H__
+#define __LOGICMODELBINARYFILE_H__
+
+#include "Globals.h"
+#include "Core/Utils/MemoryMap.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace degate
+{
+    /**
+     * The records of the binary logic model file (see LogicModelBinaryFile).
+     *
+     * All the records have a fixed size, a multiple of 8 bytes, and are stored
+     * in the byte order of the machine that wrote the file (little endian in practice).
+     */
+    namespace binary_lmodel
+    {
+        static const char magic[8] = {'D', 'G', 'T', 'L', 'M', 'O', 'D', 'L'};
+        static const std::uint32_t version = 1;
+
+        /**
+         * The parent index of the main module.
+         */
+        static const std::uint64_t no_index = ~static_cast<std::uint64_t>(0);
+
+        /**
+         * A range of records of the file, \p offset is in bytes from the start of the file.
+         */
+        struct section
+        {
+            std::uint64_t offset;
+            std::uint64_t count;
+        };
+
+        /**
+         * A string of the string table, \p offset is in bytes from the start of the string table.
+         * Strings are UTF-8 and not null terminated. The offsets are 32 bits, so the
+         * string table is limited to 4 GiB (the records sections are not limited).
+         */
+        struct string_ref
+        {
+            std::uint32_t offset;
+            std::uint32_t size;
+        };
+
+        /**
+         * The attributes common to all placed objects.
+         */
+        struct object_record
+        {
+            std::uint64_t id;
+            string_ref name;
+            string_ref description;
+            std::uint32_t fill_color;
+            std::uint32_t frame_color;
+        };
+
+        /**
+         * A gate, its ports are \p port_count port records from \p first_port in the layer ports.
+         */
+        struct gate_record
+        {
+            object_record object;
+            float min_x, min_y, max_x, max_y;
+            std::uint64_t template_id;
+            std::uint32_t orientation;
+            std::uint32_t port_count;
+            std::uint64_t first_port;
+        };
+
+        struct port_record
+        {
+            std::uint64_t id;
+            string_ref name;
+            string_ref description;
+            std::uint64_t template_port_id;
+            std::uint32_t diameter;
+            std::uint32_t reserved;
+        };
+
+        struct via_record
+        {
+            object_record object;
+            float x, y;
+            std::uint32_t diameter;
+            std::uint32_t direction;
+            std::uint64_t remote_id;
+        };
+
+        struct emarker_record
+        {
+            object_record object;
+            float x, y;
+            std::uint32_t diameter;
+            std::uint32_t is_module_port;
+            std::uint64_t remote_id;
+        };
+
+        struct wire_record
+        {
+            object_record object;
+            float from_x, from_y, to_x, to_y;
+            std::uint32_t diameter;
+            std::uint32_t reserved;
+            std::uint64_t remote_id;
+        };
+
+        /**
+         * An annotation, its parameters are \p parameter_count parameter records
+         * from \p first_parameter in the file parameters.
+         */
+        struct annotation_record
+        {
+            object_record object;
+            float min_x, min_y, max_x, max_y;
+            std::uint32_t class_id;
+            std::uint32_t parameter_count;
+            std::uint64_t first_parameter;
+        };
+
+        struct parameter_record
+        {
+            string_ref name;
+            string_ref value;
+        };
+
+        /**
+         * A net, its connections are \p connection_count object IDs from
+         * \p first_connection in the file connections.
+         */
+        struct net_record
+        {
+            std::uint64_t id;
+            std::uint64_t first_connection;
+            std::uint64_t connection_count;
+        };
+
+        /**
+         * A module. Modules are stored in depth-first order, the main module first.
+         * The cells are object IDs in the file cells, the ports are module port records.
+         */
+        struct module_record
+        {
+            std::uint64_t id;
+            string_ref name;
+            string_ref entity;
+            std::uint64_t parent;
+            std::uint64_t first_cell;
+            std::uint64_t cell_count;
+            std::uint64_t first_port;
+            std::uint64_t port_count;
+        };
+
+        struct module_port_record
+        {
+            string_ref name;
+            std::uint64_t object_id;
+        };
+
+        /**
+         * The placed objects of a layer.
+         */
+        struct layer_record
+        {
+            std::uint32_t position;
+            std::uint32_t reserved;
+
+            section gates;
+            section ports;
+            section vias;
+            section emarkers;
+            section wires;
+            section annotations;
+        };
+
+        struct file_header
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t header_size;
+
+            section layers;
+            section parameters;
+            section nets;
+            section connections;
+            section modules;
+            section cells;
+            section module_ports;
+            section strings;
+        };
+
+        /**
+         * Records of a section, mapped in memory.
+         */
+        template<typename T>
+        class record_range
+        {
+        private:
+            T const* first;
+            std::size_t count;
+
+        public:
+            record_range(T const* first = nullptr, std::size_t count = 0) : first(first), count(count)
+            {
+            }
+
+            T const* begin() const
+            {
+                return first;
+            }
+
+            T const* end() const
+            {
+                return first + count;
+            }
+
+            std::size_t size() const
+            {
+                return count;
+            }
+
+            T const& operator[](std::size_t i) const
+            {
+                return first[i];
+            }
+        };
+    }
+
+    /**
+     * A binary logic model file, mapped in memory.
+     *
+     * The file is a header followed by fixed size records: the placed objects sectioned
+     * per layer, the annotation parameters, the nets and their connections, the modules
+     * with their cells and ports, and a string table for the names and descriptions.
+     *
+     * Opening a file maps it read-only and checks that the sections are within
+     * the file, nothing else is read. The file is never modified. The records can
+     * be inspected without creating any logic model object, see
+     * LogicModelBinaryImporter to load a logic model.
+     */
+    class LogicModelBinaryFile
+    {
+    private:
+
+        std::unique_ptr<MemoryMap<std::uint8_t>> file;
+        std::uint8_t const* data;
+        std::size_t size;
+
+        binary_lmodel::file_header const* header;
+
+        /**
+         * Check that a section is within the file.
+         * @exception InvalidFileFormatException This exception is thrown if it isn't.
+         */
+        void check_section(binary_lmodel::section const& s, std::size_t record_size) const;
+
+        template<typename T>
+        binary_lmodel::record_range<T> get_records(binary_lmodel::section const& s) const
+        {
+            return binary_lmodel::record_range<T>(reinterpret_cast<T const*>(data + s.offset),
+                                                  static_cast<std::size_t>(s.count));
+        }
+
+    public:
+
+        /**
+         * Map a binary logic model file.
+         * @exception InvalidPathException This exception is thrown if the file can't be opened
+         *   or mapped.
+         * @exception InvalidFileFormatException This exception is thrown if the file is not a
+         *   binary logic model file, or if it is truncated.
+         */
+        explicit LogicModelBinaryFile(std::string const& filename);
+
+        ~LogicModelBinaryFile();
+
+        /**
+         * Check if a file is a binary logic model file (from its first bytes).
+         */
+        static bool is_binary_file(std::string const& filename);
+
+        binary_lmodel::record_range<binary_lmodel::layer_record> get_layers() const
+        {
+            return get_records<binary_lmodel::layer_record>(header->layers);
+        }
+
+        binary_lmodel::record_range<binary_lmodel::gate_record> get_gates(binary_lmodel::layer_record const& layer) const
+        {
+            return get_records<binary_lmodel::gate_record>(layer.gates);
+        }
+
+        binary_lmodel::record_range<binary_lmodel::port_record> get_ports(binary_lmodel::layer_record const& layer) const
+        {
+            return get_records<binary_lmodel::port_record>(layer.ports);
+        }
+
+        binary_lmodel::record_range<binary_lmodel::via_record> get_vias(binary_lmodel::layer_record const& layer) const
+        {
+            return get_records<binary_lmodel::via_record>(layer.vias);
+        }
+
+        binary_lmodel::record_range<binary_lmodel::emarker_record>
+        get_emarkers(binary_lmodel::layer_record const& layer) const
+        {
+            return get_records<binary_lmodel::emarker_record>(layer.emarkers);
+        }
+
+        binary_lmodel::record_range<binary_lmodel::wire_record> get_wires(binary_lmodel::layer_record const& layer) const
+        {
+            return get_records<binary_lmodel::wire_record>(layer.wires);
+        }
+
+        binary_lmodel::record_range<binary_lmodel::annotation_record>
+        get_annotations(binary_lmodel::layer_record const& layer) const
+        {
+            return get_records<binary_lmodel::annotation_record>(layer.annotations);
+        }
+
+        binary_lmodel::record_range<binary_lmodel::parameter_record> get_parameters() const
+        {
+            return get_records<binary_lmodel::parameter_record>(header->parameters);
+        }
+
+        binary_lmodel::record_range<binary_lmodel::net_record> get_nets() const
+        {
+            return get_records<binary_lmodel::net_record>(header->nets);
+        }
+
+        binary_lmodel::record_range<std::uint64_t> get_connections() const
+        {
+            return get_records<std::uint64_t>(header->connections);
+        }
+
+        binary_lmodel::record_range<binary_lmodel::module_record> get_modules() const
+        {
+            return get_records<binary_lmodel::module_record>(header->modules);
+        }
+
+        binary_lmodel::record_range<std::uint64_t> get_cells() const
+        {
+            return get_records<std::uint64_t>(header->cells);
+        }
+
+        binary_lmodel::record_range<binary_lmodel::module_port_record> get_module_ports() const
+        {
+            return get_records<binary_lmodel::module_port_record>(header->module_ports);
+        }
+
+        /**
+         * Get a subrange of records, e.g. the ports of a gate.
+         * @exception InvalidFileFormatException This exception is thrown if the subrange is
+         *   not within the range.
+         */
+        template<typename T>
+        binary_lmodel::record_range<T> get_subrange(binary_lmodel::record_range<T> const& range,
+                                                    std::uint64_t first,
+                                                    std::uint64_t count) const
+        {
+            if (first > range.size() || count > range.size() - first)
+                throw InvalidFileFormatException("A record references records out of its section.");
+
+            return binary_lmodel::record_range<T>(range.begin() + first, static_cast<std::size_t>(count));
+        }
+
+        /**
+         * Get a string from the string table.
+         * @exception InvalidFileFormatException This exception is thrown if the string is
+         *   not within the string table.
+         */
+        std::string get_string(binary_lmodel::string_ref const& ref) const;
+    };
+}
+
+#endif
@@ -0,0 +1,334 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/LogicModel/LogicModelBinaryImporter.h"
+#include "Core/LogicModel/Annotation/SubProjectAnnotation.h"
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/format.hpp>
+
+using namespace degate;
+using namespace degate::binary_lmodel;
+
+void LogicModelBinaryImporter::import_into(LogicModel_shptr lmodel, std::string const& filename)
+{
+    if (lmodel == nullptr)
+        throw InvalidPointerException("Got a nullptr pointer in LogicModelBinaryImporter::import_into()");
+
+    if (RET_IS_NOT_OK(check_file(filename)))
+    {
+        debug(TM, "Problem: file %s not found.", filename.c_str());
+        throw InvalidPathException("Can't load logic model from file.");
+    }
+
+    try
+    {
+        LogicModelBinaryFile file(filename);
+
+        lmodel->set_gate_library(gate_library);
+
+        // Template ports by ID, to not search the gate library for each gate port.
+        template_ports.clear();
+        if (gate_library != nullptr)
+        {
+            for (GateLibrary::template_iterator iter = gate_library->begin(); iter != gate_library->end(); ++iter)
+            {
+                GateTemplate_shptr tmpl = iter->second;
+
+                for (GateTemplate::port_iterator piter = tmpl->ports_begin(); piter != tmpl->ports_end(); ++piter)
+                    template_ports.insert(std::make_pair((*piter)->get_object_id(), *piter));
+            }
+        }
+
+        auto layers = file.get_layers();
+
+        // The objects are created by type, in the same order as from lmodel.xml,
+        // then added layer by layer to build the layer quadtrees in one pass.
+        std::list<Gate_shptr> gates;
+        std::vector<std::vector<PlacedLogicModelObject_shptr>> layer_objects(layers.size());
+
+        for (std::size_t i = 0; i < layers.size(); i++)
+        {
+            for (auto const& record : file.get_gates(layers[i]))
+            {
+                Gate_shptr gate = create_gate(file, layers[i], record);
+                layer_objects[i].push_back(gate);
+                gates.push_back(gate);
+            }
+        }
+
+        for (std::size_t i = 0; i < layers.size(); i++)
+        {
+            for (auto const& record : file.get_vias(layers[i]))
+                layer_objects[i].push_back(create_via(file, record));
+        }
+
+        for (std::size_t i = 0; i < layers.size(); i++)
+        {
+            for (auto const& record : file.get_emarkers(layers[i]))
+                layer_objects[i].push_back(create_emarker(file, record));
+        }
+
+        for (std::size_t i = 0; i < layers.size(); i++)
+        {
+            for (auto const& record : file.get_wires(layers[i]))
+                layer_objects[i].push_back(create_wire(file, record));
+        }
+
+        for (std::size_t i = 0; i < layers.size(); i++)
+        {
+            for (auto const& record : file.get_annotations(layers[i]))
+                layer_objects[i].push_back(create_annotation(file, record));
+        }
+
+        for (std::size_t i = 0; i < layers.size(); i++)
+        {
+            if (!layer_objects[i].empty())
+                lmodel->add_objects(layers[i].position, layer_objects[i]);
+        }
+
+        add_nets(file, lmodel);
+        add_modules(file, lmodel);
+
+        // check if the ports of placed standard cell are available and create them if necessary
+        for (auto g : gates)
+        {
+            lmodel->update_ports(g);
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << "Exception caught: " << ex.what() << std::endl;
+        throw;
+    }
+}
+
+LogicModel_shptr LogicModelBinaryImporter::import(std::string const& filename, ProjectType project_type)
+{
+    LogicModel_shptr lmodel(new LogicModel(width, height, project_type));
+    assert(lmodel != nullptr);
+
+    import_into(lmodel, filename);
+
+    return lmodel;
+}
+
+void LogicModelBinaryImporter::set_object_attributes(LogicModelBinaryFile const& file,
+                                                     object_record const& record,
+                                                     PlacedLogicModelObject_shptr o) const
+{
+    o->set_object_id(record.id);
+    o->set_name(file.get_string(record.name));
+    o->set_description(file.get_string(record.description));
+    o->set_fill_color(record.fill_color);
+    o->set_frame_color(record.frame_color);
+}
+
+Gate_shptr LogicModelBinaryImporter::create_gate(LogicModelBinaryFile const& file,
+                                                 layer_record const& layer,
+                                                 gate_record const& record) const
+{
+    if (record.orientation > Gate::ORIENTATION_FLIPPED_BOTH)
+        throw InvalidFileFormatException("Can't parse orientation type.");
+
+    Gate_shptr gate(new Gate(record.min_x, record.max_x, record.min_y, record.max_y,
+                             static_cast<Gate::ORIENTATION>(record.orientation)));
+    set_object_attributes(file, record.object, gate);
+    gate->set_template_type_id(record.template_id);
+
+    if (gate_library != nullptr && record.template_id != 0)
+    {
+        GateTemplate_shptr tmpl = gate_library->get_template(record.template_id);
+        assert(tmpl != nullptr);
+        gate->set_gate_template(tmpl);
+    }
+
+    for (auto const& port_rec : file.get_subrange(file.get_ports(layer), record.first_port, record.port_count))
+    {
+        GatePort_shptr gate_port = std::make_shared<GatePort>(gate);
+        gate_port->set_object_id(port_rec.id);
+        gate_port->set_name(file.get_string(port_rec.name));
+        gate_port->set_description(file.get_string(port_rec.description));
+        gate_port->set_template_port_type_id(port_rec.template_port_id);
+        gate_port->set_diameter(port_rec.diameter);
+
+        if (gate_library != nullptr)
+        {
+            auto found = template_ports.find(port_rec.template_port_id);
+            if (found == template_ports.end())
+            {
+                std::ostringstream stm;
+                stm << "There is no template port with ID. " << port_rec.template_port_id << " in the gate library.";
+                throw CollectionLookupException(stm.str());
+            }
+
+            gate_port->set_template_port(found->second);
+        }
+
+        gate->add_port(gate_port);
+    }
+
+    return gate;
+}
+
+Via_shptr LogicModelBinaryImporter::create_via(LogicModelBinaryFile const& file, via_record const& record) const
+{
+    if (record.direction > Via::DIRECTION_DOWN)
+        throw InvalidFileFormatException("Can't parse via direction type.");
+
+    Via_shptr via(new Via(record.x, record.y, record.diameter, static_cast<Via::DIRECTION>(record.direction)));
+    set_object_attributes(file, record.object, via);
+    via->set_remote_object_id(record.remote_id);
+
+    return via;
+}
+
+EMarker_shptr LogicModelBinaryImporter::create_emarker(LogicModelBinaryFile const& file,
+                                                       emarker_record const& record) const
+{
+    EMarker_shptr emarker(new EMarker(record.x, record.y, record.diameter, record.is_module_port != 0));
+    set_object_attributes(file, record.object, emarker);
+    emarker->set_remote_object_id(record.remote_id);
+
+    return emarker;
+}
+
+Wire_shptr LogicModelBinaryImporter::create_wire(LogicModelBinaryFile const& file, wire_record const& record) const
+{
+    Wire_shptr wire(new Wire(record.from_x, record.from_y, record.to_x, record.to_y, record.diameter));
+    set_object_attributes(file, record.object, wire);
+    wire->set_remote_object_id(record.remote_id);
+
+    return wire;
+}
+
+Annotation_shptr LogicModelBinaryImporter::create_annotation(LogicModelBinaryFile const& file,
+                                                             annotation_record const& record) const
+{
+    Annotation_shptr annotation;
+
+    if (record.class_id == Annotation::SUBPROJECT)
+    {
+        std::string path;
+
+        for (auto const& parameter : file.get_subrange(file.get_parameters(), record.first_parameter,
+                                                       record.parameter_count))
+        {
+            if (file.get_string(parameter.name) == "subproject-directory")
+                path = file.get_string(parameter.value);
+        }
+
+        annotation = std::make_shared<SubProjectAnnotation>(record.min_x, record.max_x, record.min_y, record.max_y,
+                                                            path);
+    }
+    else
+        annotation = std::make_shared<Annotation>(record.min_x, record.max_x, record.min_y, record.max_y,
+                                                  record.class_id);
+
+    set_object_attributes(file, record.object, annotation);
+
+    return annotation;
+}
+
+void LogicModelBinaryImporter::add_nets(LogicModelBinaryFile const& file, LogicModel_shptr lmodel) const
+{
+    auto connections = file.get_connections();
+
+    for (auto const& record : file.get_nets())
+    {
+        Net_shptr net(new Net());
+        net->set_object_id(record.id);
+
+        for (object_id_t object_id : file.get_subrange(connections, record.first_connection, record.connection_count))
+        {
+            // Lookup will throw an exception, if the object is not in the logic model.
+            PlacedLogicModelObject_shptr placed_object = lmodel->get_object(object_id);
+
+            ConnectedLogicModelObject_shptr o = std::dynamic_pointer_cast<ConnectedLogicModelObject>(placed_object);
+            if (o != nullptr)
+                o->set_net(net);
+            else
+                debug(TM, "Failed to dynamic_cast<> a logic model object with ID %llu", object_id);
+        }
+
+        if (record.connection_count < 2)
+        {
+            boost::format f("Net with ID %1% has only a single object. This should not occur.");
+            f % record.id;
+            std::cout << "WARNING: " << f.str() << std::endl;
+        }
+
+        lmodel->add_net(net);
+    }
+}
+
+void LogicModelBinaryImporter::add_modules(LogicModelBinaryFile const& file, LogicModel_shptr lmodel) const
+{
+    auto records = file.get_modules();
+    auto cells = file.get_cells();
+    auto ports = file.get_module_ports();
+
+    if (records.size() == 0)
+        return;
+
+    if (records[0].parent != no_index)
+        throw InvalidFileFormatException("The first module is not the main module.");
+
+    std::vector<Module_shptr> modules;
+    modules.reserve(records.size());
+
+    for (auto const& record : records)
+    {
+        const bool is_root = modules.empty();
+
+        if (!is_root && record.parent >= modules.size())
+            throw InvalidFileFormatException("A module references a parent module out of the modules.");
+
+        Module_shptr module(new Module(file.get_string(record.name), file.get_string(record.entity)));
+        module->set_object_id(record.id);
+
+        for (object_id_t cell_id : file.get_subrange(cells, record.first_cell, record.cell_count))
+        {
+            // Lookup will throw an exception, if cell is not in the logic model. This is intended behaviour.
+            if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(lmodel->get_object(cell_id)))
+                module->add_gate(gate, /* autodetect module ports = */ false);
+        }
+
+        for (auto const& port : file.get_subrange(ports, record.first_port, record.port_count))
+        {
+            // Lookup will throw an exception, if cell is not in the logic model. This is intended behaviour.
+            if (GatePort_shptr gport = std::dynamic_pointer_cast<GatePort>(lmodel->get_object(port.object_id)))
+                module->add_module_port(file.get_string(port.name), gport);
+        }
+
+        if (!is_root)
+            modules[static_cast<std::size_t>(record.parent)]->add_module(module);
+
+        modules.push_back(module);
+    }
+
+    lmodel->set_main_module(modules.front());
+}
@@ -0,0 +1,104 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __LOGICMODELBINARYIMPORTER_H__
+#define __LOGICMODELBINARYIMPORTER_H__
+
+#include "LogicModel.h"
+#include "LogicModelBinaryFile.h"
+#include "Core/Utils/Importer.h"
+
+#include <list>
+#include <map>
+#include <stdexcept>
+
+namespace degate
+{
+    /**
+     * This class implements a loader for binary logic model files (see LogicModelBinaryFile).
+     */
+    class LogicModelBinaryImporter : public Importer
+    {
+    private:
+
+        unsigned int width, height;
+        GateLibrary_shptr gate_library;
+
+        std::map<object_id_t, GateTemplatePort_shptr> template_ports;
+
+        void set_object_attributes(LogicModelBinaryFile const& file,
+                                   binary_lmodel::object_record const& record,
+                                   PlacedLogicModelObject_shptr o) const;
+
+        Gate_shptr create_gate(LogicModelBinaryFile const& file,
+                               binary_lmodel::layer_record const& layer,
+                               binary_lmodel::gate_record const& record) const;
+
+        Via_shptr create_via(LogicModelBinaryFile const& file, binary_lmodel::via_record const& record) const;
+
+        EMarker_shptr create_emarker(LogicModelBinaryFile const& file,
+                                     binary_lmodel::emarker_record const& record) const;
+
+        Wire_shptr create_wire(LogicModelBinaryFile const& file, binary_lmodel::wire_record const& record) const;
+
+        Annotation_shptr create_annotation(LogicModelBinaryFile const& file,
+                                           binary_lmodel::annotation_record const& record) const;
+
+        void add_nets(LogicModelBinaryFile const& file, LogicModel_shptr lmodel) const;
+
+        void add_modules(LogicModelBinaryFile const& file, LogicModel_shptr lmodel) const;
+
+    public:
+
+        /**
+         * Create a binary logic model importer.
+         * @param width The width of the logic model.
+         * @param height The height of the logic model.
+         * @param gate_library The gate library, needed to resolve the gate templates.
+         */
+        LogicModelBinaryImporter(unsigned int width, unsigned int height, GateLibrary_shptr gate_library = nullptr) :
+            width(width), height(height), gate_library(gate_library)
+        {
+        }
+
+        ~LogicModelBinaryImporter()
+        {
+        }
+
+        /**
+         * Import a binary logic model file.
+         * @exception InvalidPathException This exception is thrown if the file can't be opened.
+         * @exception InvalidFileFormatException This exception is thrown if the file is not a
+         *   valid binary logic model file.
+         * @exception CollectionLookupException This exception is thrown if a gate template
+         *   or an object referenced by a net or a module doesn't exist.
+         */
+        LogicModel_shptr import(std::string const& filename, ProjectType project_type);
+
+        /**
+         * Import a binary logic model file into an existing logic model.
+         * @see import()
+         */
+        void import_into(LogicModel_shptr lmodel, std::string const& filename);
+    };
+}
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Core/LogicModel/LogicModelConverter.h"
+#include "Core/LogicModel/LogicModelBinaryExporter.h"
+#include "Core/LogicModel/LogicModelBinaryImporter.h"
+#include "Core/LogicModel/LogicModelExporter.h"
+#include "Core/LogicModel/LogicModelImporter.h"
+
+#include <memory>
+
+using namespace degate;
+
+void degate::convert_logic_model_to_binary(std::string const& xml_filename,
+                                           std::string const& binary_filename,
+                                           unsigned int width,
+                                           unsigned int height,
+                                           GateLibrary_shptr gate_library)
+{
+    LogicModelImporter importer(width, height, gate_library);
+    LogicModel_shptr lmodel = importer.import(xml_filename, ProjectType::Normal);
+
+    LogicModelBinaryExporter exporter(std::make_shared<ObjectIDRewriter>(false));
+    exporter.export_data(binary_filename, lmodel);
+}
+
+void degate::convert_logic_model_to_xml(std::string const& binary_filename,
+                                        std::string const& xml_filename,
+                                        unsigned int width,
+                                        unsigned int height,
+                                        GateLibrary_shptr gate_library)
+{
+    LogicModelBinaryImporter importer(width, height, gate_library);
+    LogicModel_shptr lmodel = importer.import(binary_filename, ProjectType::Normal);
+
+    LogicModelExporter exporter(std::make_shared<ObjectIDRewriter>(false));
+    exporter.export_data(xml_filename, lmodel);
+}
+
+bool degate::convert_logic_model(std::string const& filename,
+                                 std::string const& converted_filename,
+                                 unsigned int width,
+                                 unsigned int height,
+                                 GateLibrary_shptr gate_library)
+{
+    if (LogicModelBinaryFile::is_binary_file(filename))
+    {
+        convert_logic_model_to_xml(filename, converted_filename, width, height, gate_library);
+        return true;
+    }
+
+    convert_logic_model_to_binary(filename, converted_filename, width, height, gate_library);
+    return false;
+}
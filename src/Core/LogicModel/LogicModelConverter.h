@@ -0,0 +1,71 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef __LOGICMODELCONVERTER_H__
+#define __LOGICMODELCONVERTER_H__
+
+#include "Globals.h"
+#include "Core/LogicModel/Gate/GateLibrary.h"
+
+#include <string>
+
+namespace degate
+{
+    /**
+     * Convert a logic model file (lmodel.xml) into a binary logic model file (see LogicModelBinaryFile).
+     * The object IDs are kept, so that the other project files still reference the same objects.
+     * @param width The width of the logic model (the project width).
+     * @param height The height of the logic model (the project height).
+     * @param gate_library The gate library of the project.
+     * @exception InvalidPathException This exception is thrown if a file can't be read or written.
+     * @exception InvalidXMLException This exception is thrown if the logic model file can't be parsed.
+     */
+    void convert_logic_model_to_binary(std::string const& xml_filename,
+                                       std::string const& binary_filename,
+                                       unsigned int width,
+                                       unsigned int height,
+                                       GateLibrary_shptr gate_library);
+
+    /**
+     * Convert a binary logic model file into a logic model file (lmodel.xml).
+     * The object IDs are kept.
+     * @see convert_logic_model_to_binary()
+     * @exception InvalidFileFormatException This exception is thrown if the binary file is invalid.
+     */
+    void convert_logic_model_to_xml(std::string const& binary_filename,
+                                    std::string const& xml_filename,
+                                    unsigned int width,
+                                    unsigned int height,
+                                    GateLibrary_shptr gate_library);
+
+    /**
+     * Convert a logic model file of any format to the other format, depending on its content.
+     * @return Returns true if \p filename was a binary logic model file (and was converted to XML).
+     */
+    bool convert_logic_model(std::string const& filename,
+                             std::string const& converted_filename,
+                             unsigned int width,
+                             unsigned int height,
+                             GateLibrary_shptr gate_library);
+}
+
+#endif
@@ -40,117 +40,138 @@ void LogicModelExporter::export_data(std::string const& filename, LogicModel_shp
 
     try
     {
-        QDomDocument doc;
+        placed_objects<Gate> gates;
+        placed_objects<Via> vias;
+        placed_objects<EMarker> emarkers;
+        placed_objects<Wire> wires;
+        placed_objects<Annotation> annotations;
 
-        QDomProcessingInstruction head = doc.createProcessingInstruction("xml", XML_ENCODING);
-        doc.appendChild(head);
+        collect_objects(lmodel, gates, vias, emarkers, wires, annotations);
 
-        QDomElement root_elem = doc.createElement("logic-model");
-        assert(!root_elem.isNull());
+        // actually we have only one main module
 
-        QDomElement gates_elem = doc.createElement("gates");
-        if (gates_elem.isNull())
-            throw(std::runtime_error("Failed to create node."));
+        // First update the module ports.
+        determine_module_ports_for_root(lmodel);                       // Update main module itself.
+        lmodel->get_main_module()->determine_module_ports_recursive(); // Update all of main module's children.
 
-        QDomElement vias_elem = doc.createElement("vias");
-        if (vias_elem.isNull())
-            throw(std::runtime_error("Failed to create node."));
+        QFile file(QString::fromStdString(filename));
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            throw InvalidPathException("Can't create export file.");
+        }
 
-        QDomElement emarkers_elem = doc.createElement("emarkers");
-        if (emarkers_elem.isNull())
-            throw(std::runtime_error("Failed to create node."));
+        QXmlStreamWriter stream(&file);
+        stream.setAutoFormatting(true);
+        stream.setAutoFormattingIndent(1);
 
-        QDomElement wires_elem = doc.createElement("wires");
-        if (wires_elem.isNull())
-            throw(std::runtime_error("Failed to create node."));
+        stream.writeStartDocument();
+        stream.writeStartElement("logic-model");
 
-        QDomElement nets_elem = doc.createElement("nets");
-        if (nets_elem.isNull())
-            throw(std::runtime_error("Failed to create node."));
+        stream.writeStartElement("gates");
+        for (auto const& gate : gates)
+            add_gate(stream, gate.first, gate.second);
+        stream.writeEndElement();
 
-        QDomElement annotations_elem = doc.createElement("annotations");
-        if (annotations_elem.isNull())
-            throw(std::runtime_error("Failed to create node."));
+        stream.writeStartElement("vias");
+        for (auto const& via : vias)
+            add_via(stream, via.first, via.second);
+        stream.writeEndElement();
 
-        for (auto layer_iter = lmodel->layers_begin(); layer_iter != lmodel->layers_end(); ++layer_iter)
-        {
-            if ((*layer_iter) == nullptr || (*layer_iter)->is_empty())
-                continue;
+        stream.writeStartElement("emarkers");
+        for (auto const& emarker : emarkers)
+            add_emarker(stream, emarker.first, emarker.second);
+        stream.writeEndElement();
 
-            Layer_shptr layer = *layer_iter;
+        stream.writeStartElement("wires");
+        for (auto const& wire : wires)
+            add_wire(stream, wire.first, wire.second);
+        stream.writeEndElement();
 
-            for (Layer::object_iterator iter = layer->objects_begin(); iter != layer->objects_end(); ++iter)
-            {
-                layer_position_t layer_pos = layer->get_layer_pos();
+        stream.writeStartElement("annotations");
+        for (auto const& annotation : annotations)
+            add_annotation(stream, annotation.first, annotation.second);
+        stream.writeEndElement();
 
-                PlacedLogicModelObject_shptr o = (*iter);
+        stream.writeStartElement("nets");
+        add_nets(stream, lmodel);
+        stream.writeEndElement();
 
-                if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(o))
-                    add_gate(doc, gates_elem, gate, layer_pos);
+        stream.writeStartElement("modules");
+        add_module(stream, lmodel, lmodel->get_main_module());
+        stream.writeEndElement();
 
-                else if (Via_shptr via = std::dynamic_pointer_cast<Via>(o))
-                    add_via(doc, vias_elem, via, layer_pos);
+        stream.writeEndElement();
+        stream.writeEndDocument();
 
-                else if (EMarker_shptr emarker = std::dynamic_pointer_cast<EMarker>(o))
-                    add_emarker(doc, emarkers_elem, emarker, layer_pos);
+        if (stream.hasError())
+            throw std::runtime_error("Failed to write the export file.");
 
-                else if (Wire_shptr wire = std::dynamic_pointer_cast<Wire>(o))
-                    add_wire(doc, wires_elem, wire, layer_pos);
+        file.close();
+    }
+    catch (const std::exception& ex)
+    {
+        std::cout << "Exception caught: " << ex.what() << std::endl;
+        throw;
+    }
+}
 
-                else if (Annotation_shptr annotation = std::dynamic_pointer_cast<Annotation>(o))
-                    add_annotation(doc, annotations_elem, annotation, layer_pos);
-            }
-        }
+void LogicModelExporter::collect_objects(LogicModel_shptr lmodel,
+                                         placed_objects<Gate>& gates,
+                                         placed_objects<Via>& vias,
+                                         placed_objects<EMarker>& emarkers,
+                                         placed_objects<Wire>& wires,
+                                         placed_objects<Annotation>& annotations)
+{
+    for (auto layer_iter = lmodel->layers_begin(); layer_iter != lmodel->layers_end(); ++layer_iter)
+    {
+        if ((*layer_iter) == nullptr || (*layer_iter)->is_empty())
+            continue;
 
-        add_nets(doc, nets_elem, lmodel);
+        Layer_shptr layer = *layer_iter;
+        layer_position_t layer_pos = layer->get_layer_pos();
 
-        // actually we have only one main module
+        for (Layer::object_iterator iter = layer->objects_begin(); iter != layer->objects_end(); ++iter)
+        {
+            PlacedLogicModelObject_shptr o = (*iter);
 
-        // First update the module ports.
-        determine_module_ports_for_root(lmodel);                       // Update main module itself.
-        lmodel->get_main_module()->determine_module_ports_recursive(); // Update all of main module's children.
+            // The objects of all types get their new object ID in the layer order, so that
+            // the ID rewriting doesn't depend on the order of the elements in the file.
+            oid_rewriter->get_new_object_id(o->get_object_id());
 
-        QDomElement modules_elem = doc.createElement("modules");
-        if (modules_elem.isNull())
-            throw(std::runtime_error("Failed to create node."));
+            if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(o))
+            {
+                oid_rewriter->get_new_object_id(gate->get_template_type_id());
 
-        add_module(doc, modules_elem, lmodel, lmodel->get_main_module());
+                for (Gate::port_iterator port_iter = gate->ports_begin(); port_iter != gate->ports_end(); ++port_iter)
+                {
+                    oid_rewriter->get_new_object_id((*port_iter)->get_object_id());
+                    oid_rewriter->get_new_object_id((*port_iter)->get_template_port_type_id());
+                }
 
-        root_elem.appendChild(gates_elem);
-        root_elem.appendChild(vias_elem);
-        root_elem.appendChild(emarkers_elem);
-        root_elem.appendChild(wires_elem);
-        root_elem.appendChild(annotations_elem);
-        root_elem.appendChild(nets_elem);
-        root_elem.appendChild(modules_elem);
+                gates.emplace_back(gate, layer_pos);
+            }
 
-        doc.appendChild(root_elem);
+            else if (Via_shptr via = std::dynamic_pointer_cast<Via>(o))
+                vias.emplace_back(via, layer_pos);
 
-        QFile file(QString::fromStdString(filename));
-        if (!file.open(QIODevice::WriteOnly))
-        {
-            throw InvalidPathException("Can't create export file.");
-        }
+            else if (EMarker_shptr emarker = std::dynamic_pointer_cast<EMarker>(o))
+                emarkers.emplace_back(emarker, layer_pos);
 
-        QTextStream stream(&file);
-        stream.setEncoding(QStringConverter::Utf8);
-        stream << doc.toString();
+            else if (Wire_shptr wire = std::dynamic_pointer_cast<Wire>(o))
+                wires.emplace_back(wire, layer_pos);
 
-        file.close();
-    }
-    catch (const std::exception& ex)
-    {
-        std::cout << "Exception caught: " << ex.what() << std::endl;
-        throw;
+            else if (Annotation_shptr annotation = std::dynamic_pointer_cast<Annotation>(o))
+                annotations.emplace_back(annotation, layer_pos);
+        }
     }
 }
 
-void LogicModelExporter::add_nets(QDomDocument& doc, QDomElement& nets_elem, LogicModel_shptr lmodel)
+void LogicModelExporter::add_nets(QXmlStreamWriter& stream, LogicModel_shptr lmodel)
 {
     for (LogicModel::net_collection::iterator net_iter = lmodel->nets_begin(); net_iter != lmodel->nets_end();
          ++net_iter)
     {
-        QDomElement net_elem = doc.createElement("net");
+        stream.writeStartElement("net");
 
         Net_shptr net = net_iter->second;
         assert(net != nullptr);
@@ -159,286 +180,249 @@ void LogicModelExporter::add_nets(QDomDocument& doc, QDomElement& nets_elem, Log
         assert(old_net_id != 0);
         object_id_t new_net_id = oid_rewriter->get_new_object_id(old_net_id);
 
-        net_elem.setAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_net_id)));
+        stream.writeAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_net_id)));
 
         for (Net::connection_iterator conn_iter = net->begin(); conn_iter != net->end(); ++conn_iter)
         {
             object_id_t oid = *conn_iter;
 
-            const ConnectedLogicModelObject_shptr conn_obj =
-                    std::dynamic_pointer_cast<ConnectedLogicModelObject>(lmodel->get_object(oid));
-
-            QDomElement conn_elem = doc.createElement("connection");
-            conn_elem.setAttribute(
+            stream.writeEmptyElement("connection");
+            stream.writeAttribute(
                     "object-id",
                     QString::fromStdString(number_to_string<object_id_t>(oid_rewriter->get_new_object_id(oid))));
-            net_elem.appendChild(conn_elem);
         }
 
-        nets_elem.appendChild(net_elem);
+        stream.writeEndElement();
     }
 }
 
-void LogicModelExporter::add_gate(QDomDocument& doc,
-                                  QDomElement& gates_elem,
-                                  Gate_shptr gate,
-                                  layer_position_t layer_pos)
+void LogicModelExporter::add_gate(QXmlStreamWriter& stream, Gate_shptr gate, layer_position_t layer_pos)
 {
-    QDomElement gate_elem = doc.createElement("gate");
-    if (gate_elem.isNull())
-        throw(std::runtime_error("Failed to create node."));
+    stream.writeStartElement("gate");
 
     object_id_t new_oid = oid_rewriter->get_new_object_id(gate->get_object_id());
-    gate_elem.setAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_oid)));
-    gate_elem.setAttribute("name", QString::fromStdString(gate->get_name()));
-    gate_elem.setAttribute("description", QString::fromStdString(gate->get_description()));
-    gate_elem.setAttribute("layer", QString::fromStdString(number_to_string<layer_position_t>(layer_pos)));
-    gate_elem.setAttribute("orientation", QString::fromStdString(gate->get_orienation_type_as_string()));
+    stream.writeAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_oid)));
+    stream.writeAttribute("name", QString::fromStdString(gate->get_name()));
+    stream.writeAttribute("description", QString::fromStdString(gate->get_description()));
+    stream.writeAttribute("layer", QString::fromStdString(number_to_string<layer_position_t>(layer_pos)));
+    stream.writeAttribute("orientation", QString::fromStdString(gate->get_orienation_type_as_string()));
 
-    gate_elem.setAttribute("min-x", QString::fromStdString(number_to_string<float>(gate->get_min_x())));
-    gate_elem.setAttribute("min-y", QString::fromStdString(number_to_string<float>(gate->get_min_y())));
-    gate_elem.setAttribute("max-x", QString::fromStdString(number_to_string<float>(gate->get_max_x())));
-    gate_elem.setAttribute("max-y", QString::fromStdString(number_to_string<float>(gate->get_max_y())));
+    stream.writeAttribute("min-x", QString::fromStdString(number_to_string<float>(gate->get_min_x())));
+    stream.writeAttribute("min-y", QString::fromStdString(number_to_string<float>(gate->get_min_y())));
+    stream.writeAttribute("max-x", QString::fromStdString(number_to_string<float>(gate->get_max_x())));
+    stream.writeAttribute("max-y", QString::fromStdString(number_to_string<float>(gate->get_max_y())));
 
-    gate_elem.setAttribute("type-id",
-                           QString::fromStdString(number_to_string<object_id_t>(
-                                   oid_rewriter->get_new_object_id(gate->get_template_type_id()))));
+    stream.writeAttribute("type-id",
+                          QString::fromStdString(number_to_string<object_id_t>(
+                                  oid_rewriter->get_new_object_id(gate->get_template_type_id()))));
 
 
     for (Gate::port_iterator iter = gate->ports_begin(); iter != gate->ports_end(); ++iter)
     {
         GatePort_shptr port = *iter;
 
-        QDomElement port_elem = doc.createElement("port");
-        if (port_elem.isNull())
-            throw(std::runtime_error("Failed to create node."));
+        stream.writeEmptyElement("port");
 
         object_id_t new_port_id = oid_rewriter->get_new_object_id(port->get_object_id());
-        port_elem.setAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_port_id)));
+        stream.writeAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_port_id)));
 
         if (port->get_name().size() > 0)
-            port_elem.setAttribute("name", QString::fromStdString(port->get_name()));
+            stream.writeAttribute("name", QString::fromStdString(port->get_name()));
         if (port->get_description().size() > 0)
-            port_elem.setAttribute("description", QString::fromStdString(port->get_description()));
+            stream.writeAttribute("description", QString::fromStdString(port->get_description()));
 
         object_id_t new_type_id = oid_rewriter->get_new_object_id(port->get_template_port_type_id());
-        port_elem.setAttribute("type-id", QString::fromStdString(number_to_string<object_id_t>(new_type_id)));
-
-        port_elem.setAttribute("diameter", QString::fromStdString(number_to_string<diameter_t>(port->get_diameter())));
+        stream.writeAttribute("type-id", QString::fromStdString(number_to_string<object_id_t>(new_type_id)));
 
-        gate_elem.appendChild(port_elem);
+        stream.writeAttribute("diameter", QString::fromStdString(number_to_string<diameter_t>(port->get_diameter())));
     }
 
-    gates_elem.appendChild(gate_elem);
+    stream.writeEndElement();
 }
 
-void LogicModelExporter::add_wire(QDomDocument& doc,
-                                  QDomElement& wires_elem,
-                                  Wire_shptr wire,
-                                  layer_position_t layer_pos)
+void LogicModelExporter::add_wire(QXmlStreamWriter& stream, Wire_shptr wire, layer_position_t layer_pos)
 {
-    QDomElement wire_elem = doc.createElement("wire");
-    if (wire_elem.isNull())
-        throw(std::runtime_error("Failed to create node."));
+    stream.writeEmptyElement("wire");
 
     object_id_t new_oid = oid_rewriter->get_new_object_id(wire->get_object_id());
-    wire_elem.setAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_oid)));
-    wire_elem.setAttribute("name", QString::fromStdString(wire->get_name()));
-    wire_elem.setAttribute("description", QString::fromStdString(wire->get_description()));
-    wire_elem.setAttribute("layer", QString::fromStdString(number_to_string<layer_position_t>(layer_pos)));
-    wire_elem.setAttribute("diameter", QString::fromStdString(number_to_string<unsigned int>(wire->get_diameter())));
-
-    wire_elem.setAttribute("from-x", QString::fromStdString(number_to_string<float>(wire->get_from_x())));
-    wire_elem.setAttribute("from-y", QString::fromStdString(number_to_string<float>(wire->get_from_y())));
-    wire_elem.setAttribute("to-x", QString::fromStdString(number_to_string<float>(wire->get_to_x())));
-    wire_elem.setAttribute("to-y", QString::fromStdString(number_to_string<float>(wire->get_to_y())));
-
-    wire_elem.setAttribute("fill-color", QString::fromStdString(to_color_string(wire->get_fill_color())));
-    wire_elem.setAttribute("frame-color", QString::fromStdString(to_color_string(wire->get_frame_color())));
-
-    wire_elem.setAttribute("remote-id",
-                           QString::fromStdString(number_to_string<object_id_t>(wire->get_remote_object_id())));
-
-    wires_elem.appendChild(wire_elem);
+    stream.writeAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_oid)));
+    stream.writeAttribute("name", QString::fromStdString(wire->get_name()));
+    stream.writeAttribute("description", QString::fromStdString(wire->get_description()));
+    stream.writeAttribute("layer", QString::fromStdString(number_to_string<layer_position_t>(layer_pos)));
+    stream.writeAttribute("diameter", QString::fromStdString(number_to_string<unsigned int>(wire->get_diameter())));
+
+    stream.writeAttribute("from-x", QString::fromStdString(number_to_string<float>(wire->get_from_x())));
+    stream.writeAttribute("from-y", QString::fromStdString(number_to_string<float>(wire->get_from_y())));
+    stream.writeAttribute("to-x", QString::fromStdString(number_to_string<float>(wire->get_to_x())));
+    stream.writeAttribute("to-y", QString::fromStdString(number_to_string<float>(wire->get_to_y())));
+
+    stream.writeAttribute("fill-color", QString::fromStdString(to_color_string(wire->get_fill_color())));
+    stream.writeAttribute("frame-color", QString::fromStdString(to_color_string(wire->get_frame_color())));
+
+    stream.writeAttribute("remote-id",
+                          QString::fromStdString(number_to_string<object_id_t>(wire->get_remote_object_id())));
 }
 
-void LogicModelExporter::add_via(QDomDocument& doc, QDomElement& vias_elem, Via_shptr via, layer_position_t layer_pos)
+void LogicModelExporter::add_via(QXmlStreamWriter& stream, Via_shptr via, layer_position_t layer_pos)
 {
-    QDomElement via_elem = doc.createElement("via");
-    if (via_elem.isNull())
-        throw(std::runtime_error("Failed to create node."));
+    stream.writeEmptyElement("via");
 
     object_id_t new_oid = oid_rewriter->get_new_object_id(via->get_object_id());
-    via_elem.setAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_oid)));
-    via_elem.setAttribute("name", QString::fromStdString(via->get_name()));
-    via_elem.setAttribute("description", QString::fromStdString(via->get_description()));
-    via_elem.setAttribute("layer", QString::fromStdString(number_to_string<layer_position_t>(layer_pos)));
-    via_elem.setAttribute("diameter", QString::fromStdString(number_to_string<unsigned int>(via->get_diameter())));
+    stream.writeAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_oid)));
+    stream.writeAttribute("name", QString::fromStdString(via->get_name()));
+    stream.writeAttribute("description", QString::fromStdString(via->get_description()));
+    stream.writeAttribute("layer", QString::fromStdString(number_to_string<layer_position_t>(layer_pos)));
+    stream.writeAttribute("diameter", QString::fromStdString(number_to_string<unsigned int>(via->get_diameter())));
 
-    via_elem.setAttribute("x", QString::fromStdString(number_to_string<float>(via->get_x())));
-    via_elem.setAttribute("y", QString::fromStdString(number_to_string<float>(via->get_y())));
+    stream.writeAttribute("x", QString::fromStdString(number_to_string<float>(via->get_x())));
+    stream.writeAttribute("y", QString::fromStdString(number_to_string<float>(via->get_y())));
 
-    via_elem.setAttribute("fill-color", QString::fromStdString(to_color_string(via->get_fill_color())));
-    via_elem.setAttribute("frame-color", QString::fromStdString(to_color_string(via->get_frame_color())));
+    stream.writeAttribute("fill-color", QString::fromStdString(to_color_string(via->get_fill_color())));
+    stream.writeAttribute("frame-color", QString::fromStdString(to_color_string(via->get_frame_color())));
 
-    via_elem.setAttribute("direction", QString::fromStdString(via->get_direction_as_string()));
-    via_elem.setAttribute("remote-id",
+    stream.writeAttribute("direction", QString::fromStdString(via->get_direction_as_string()));
+    stream.writeAttribute("remote-id",
                           QString::fromStdString(number_to_string<object_id_t>(via->get_remote_object_id())));
-
-    vias_elem.appendChild(via_elem);
 }
 
-void LogicModelExporter::add_emarker(QDomDocument& doc,
-                                     QDomElement& emarkers_elem,
-                                     EMarker_shptr emarker,
-                                     layer_position_t layer_pos)
+void LogicModelExporter::add_emarker(QXmlStreamWriter& stream, EMarker_shptr emarker, layer_position_t layer_pos)
 {
-    QDomElement emarker_elem = doc.createElement("emarker");
-    if (emarker_elem.isNull())
-        throw(std::runtime_error("Failed to create node."));
+    stream.writeEmptyElement("emarker");
 
     object_id_t new_oid = oid_rewriter->get_new_object_id(emarker->get_object_id());
-    emarker_elem.setAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_oid)));
-    emarker_elem.setAttribute("name", QString::fromStdString(emarker->get_name()));
-    emarker_elem.setAttribute("description", QString::fromStdString(emarker->get_description()));
-    emarker_elem.setAttribute("is-module-port", emarker->is_module_port());
-    emarker_elem.setAttribute("layer", QString::fromStdString(number_to_string<layer_position_t>(layer_pos)));
-    emarker_elem.setAttribute("diameter",
-                              QString::fromStdString(number_to_string<unsigned int>(emarker->get_diameter())));
-
-    emarker_elem.setAttribute("x", QString::fromStdString(number_to_string<float>(emarker->get_x())));
-    emarker_elem.setAttribute("y", QString::fromStdString(number_to_string<float>(emarker->get_y())));
-
-    emarker_elem.setAttribute("fill-color", QString::fromStdString(to_color_string(emarker->get_fill_color())));
-    emarker_elem.setAttribute("frame-color", QString::fromStdString(to_color_string(emarker->get_frame_color())));
-
-    emarker_elem.setAttribute("remote-id",
-                              QString::fromStdString(number_to_string<object_id_t>(emarker->get_remote_object_id())));
-
-    emarkers_elem.appendChild(emarker_elem);
+    stream.writeAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_oid)));
+    stream.writeAttribute("name", QString::fromStdString(emarker->get_name()));
+    stream.writeAttribute("description", QString::fromStdString(emarker->get_description()));
+    stream.writeAttribute("is-module-port", QString::number(emarker->is_module_port()));
+    stream.writeAttribute("layer", QString::fromStdString(number_to_string<layer_position_t>(layer_pos)));
+    stream.writeAttribute("diameter",
+                          QString::fromStdString(number_to_string<unsigned int>(emarker->get_diameter())));
+
+    stream.writeAttribute("x", QString::fromStdString(number_to_string<float>(emarker->get_x())));
+    stream.writeAttribute("y", QString::fromStdString(number_to_string<float>(emarker->get_y())));
+
+    stream.writeAttribute("fill-color", QString::fromStdString(to_color_string(emarker->get_fill_color())));
+    stream.writeAttribute("frame-color", QString::fromStdString(to_color_string(emarker->get_frame_color())));
+
+    stream.writeAttribute("remote-id",
+                          QString::fromStdString(number_to_string<object_id_t>(emarker->get_remote_object_id())));
 }
 
 
-void LogicModelExporter::add_annotation(QDomDocument& doc,
-                                        QDomElement& annotations_elem,
+void LogicModelExporter::add_annotation(QXmlStreamWriter& stream,
                                         Annotation_shptr annotation,
                                         layer_position_t layer_pos)
 {
-    QDomElement annotation_elem = doc.createElement("annotation");
-    if (annotation_elem.isNull())
-        throw(std::runtime_error("Failed to create node."));
+    stream.writeEmptyElement("annotation");
 
     object_id_t new_oid = oid_rewriter->get_new_object_id(annotation->get_object_id());
-    annotation_elem.setAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_oid)));
-    annotation_elem.setAttribute("name", QString::fromStdString(annotation->get_name()));
-    annotation_elem.setAttribute("description", QString::fromStdString(annotation->get_description()));
-    annotation_elem.setAttribute("layer", QString::fromStdString(number_to_string<layer_position_t>(layer_pos)));
-    annotation_elem.setAttribute(
+    stream.writeAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_oid)));
+    stream.writeAttribute("name", QString::fromStdString(annotation->get_name()));
+    stream.writeAttribute("description", QString::fromStdString(annotation->get_description()));
+    stream.writeAttribute("layer", QString::fromStdString(number_to_string<layer_position_t>(layer_pos)));
+    stream.writeAttribute(
             "class-id",
             QString::fromStdString(number_to_string<layer_position_t>(annotation->get_class_id())));
 
-    annotation_elem.setAttribute("min-x", QString::fromStdString(number_to_string<float>(annotation->get_min_x())));
-    annotation_elem.setAttribute("min-y", QString::fromStdString(number_to_string<float>(annotation->get_min_y())));
-    annotation_elem.setAttribute("max-x", QString::fromStdString(number_to_string<float>(annotation->get_max_x())));
-    annotation_elem.setAttribute("max-y", QString::fromStdString(number_to_string<float>(annotation->get_max_y())));
+    stream.writeAttribute("min-x", QString::fromStdString(number_to_string<float>(annotation->get_min_x())));
+    stream.writeAttribute("min-y", QString::fromStdString(number_to_string<float>(annotation->get_min_y())));
+    stream.writeAttribute("max-x", QString::fromStdString(number_to_string<float>(annotation->get_max_x())));
+    stream.writeAttribute("max-y", QString::fromStdString(number_to_string<float>(annotation->get_max_y())));
 
-    annotation_elem.setAttribute("fill-color", QString::fromStdString(to_color_string(annotation->get_fill_color())));
-    annotation_elem.setAttribute("frame-color", QString::fromStdString(to_color_string(annotation->get_frame_color())));
+    stream.writeAttribute("fill-color", QString::fromStdString(to_color_string(annotation->get_fill_color())));
+    stream.writeAttribute("frame-color", QString::fromStdString(to_color_string(annotation->get_frame_color())));
 
     for (Annotation::parameter_set_type::const_iterator iter = annotation->parameters_begin();
          iter != annotation->parameters_end();
          ++iter)
     {
-        annotation_elem.setAttribute(QString::fromStdString(iter->first), QString::fromStdString(iter->second));
+        stream.writeAttribute(QString::fromStdString(iter->first), QString::fromStdString(iter->second));
     }
-
-    annotations_elem.appendChild(annotation_elem);
 }
 
 
-void LogicModelExporter::add_module(QDomDocument& doc,
-                                    QDomElement& modules_elem,
-                                    LogicModel_shptr lmodel,
-                                    Module_shptr module)
+void LogicModelExporter::add_module(QXmlStreamWriter& stream, LogicModel_shptr lmodel, Module_shptr module)
 {
-    QDomElement this_elem = doc.createElement("module");
-    if (this_elem.isNull())
-        throw(std::runtime_error("Failed to create node."));
-
-    QDomElement module_ports_elem = doc.createElement("module-ports");
-    QDomElement cells_elem = doc.createElement("cells");
-    QDomElement sub_modules_elem = doc.createElement("modules");
-    if (module_ports_elem.isNull() || cells_elem.isNull() || sub_modules_elem.isNull())
-        throw(std::runtime_error("Failed to create node."));
-
     /*
       <module id="42" name="ff23" entity-type="flip-flop">
   
-        <module-ports>
-          <module-port name="d" object-id="666"/> -- connected with object 666
-          <module-port name="q" object-id="667"/>
-        </module-ports>
+        <modules>
+          ...
+        </modules>
   
         <cells>
           <cell id="9999"/>
         </cells>
   
-        <modules>
-          ...
-        </modules>
+        <module-ports>
+          <module-port name="d" object-id="666"/> -- connected with object 666
+          <module-port name="q" object-id="667"/>
+        </module-ports>
   
       </module>
   
     */
 
+    stream.writeStartElement("module");
+
     // module itself
 
     object_id_t new_mod_id = oid_rewriter->get_new_object_id(module->get_object_id());
-    this_elem.setAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_mod_id)));
-    this_elem.setAttribute("name", QString::fromStdString(module->get_name()));
-    this_elem.setAttribute("entity", QString::fromStdString(module->get_entity_name()));
+    stream.writeAttribute("id", QString::fromStdString(number_to_string<object_id_t>(new_mod_id)));
+    stream.writeAttribute("name", QString::fromStdString(module->get_name()));
+    stream.writeAttribute("entity", QString::fromStdString(module->get_entity_name()));
 
-    // write module ports
+    // The children are written in the same order as before, but the object IDs are
+    // rewritten in the module ports, cells, sub-modules order (as before too).
     for (Module::port_collection::const_iterator p_iter = module->ports_begin(); p_iter != module->ports_end();
          ++p_iter)
-    {
-        QDomElement mport_elem = doc.createElement("module-port");
-        if (mport_elem.isNull())
-            throw(std::runtime_error("Failed to create node."));
+        oid_rewriter->get_new_object_id(p_iter->second->get_object_id());
 
-        GatePort_shptr gport = p_iter->second;
+    for (Module::gate_collection::const_iterator g_iter = module->gates_begin(); g_iter != module->gates_end();
+         ++g_iter)
+        oid_rewriter->get_new_object_id((*g_iter)->get_object_id());
 
-        mport_elem.setAttribute("name", QString::fromStdString(p_iter->first));
-        new_mod_id = oid_rewriter->get_new_object_id(gport->get_object_id());
-        mport_elem.setAttribute("object-id", QString::fromStdString(number_to_string<object_id_t>(new_mod_id)));
+    // write sub-modules
+    stream.writeStartElement("modules");
 
-        module_ports_elem.appendChild(mport_elem);
+    for (Module::module_collection::const_iterator m_iter = module->modules_begin(); m_iter != module->modules_end();
+         ++m_iter)
+    {
+        add_module(stream, lmodel, *m_iter);
     }
 
+    stream.writeEndElement();
+
     // write standard cells
+    stream.writeStartElement("cells");
+
     for (Module::gate_collection::const_iterator g_iter = module->gates_begin(); g_iter != module->gates_end();
          ++g_iter)
     {
-        QDomElement cell_elem = doc.createElement("cell");
-        if (cell_elem.isNull())
-            throw(std::runtime_error("Failed to create node."));
+        stream.writeEmptyElement("cell");
 
         new_mod_id = oid_rewriter->get_new_object_id((*g_iter)->get_object_id());
-        cell_elem.setAttribute("object-id", QString::fromStdString(number_to_string<object_id_t>(new_mod_id)));
-
-        cells_elem.appendChild(cell_elem);
+        stream.writeAttribute("object-id", QString::fromStdString(number_to_string<object_id_t>(new_mod_id)));
     }
 
-    // write sub-modules
-    for (Module::module_collection::const_iterator m_iter = module->modules_begin(); m_iter != module->modules_end();
-         ++m_iter)
+    stream.writeEndElement();
+
+    // write module ports
+    stream.writeStartElement("module-ports");
+
+    for (Module::port_collection::const_iterator p_iter = module->ports_begin(); p_iter != module->ports_end();
+         ++p_iter)
     {
-        add_module(doc, sub_modules_elem, lmodel, *m_iter);
+        stream.writeEmptyElement("module-port");
+
+        GatePort_shptr gport = p_iter->second;
+
+        stream.writeAttribute("name", QString::fromStdString(p_iter->first));
+        new_mod_id = oid_rewriter->get_new_object_id(gport->get_object_id());
+        stream.writeAttribute("object-id", QString::fromStdString(number_to_string<object_id_t>(new_mod_id)));
     }
 
-    this_elem.appendChild(sub_modules_elem);
-    this_elem.appendChild(cells_elem);
-    this_elem.appendChild(module_ports_elem);
+    stream.writeEndElement();
 
-    modules_elem.appendChild(this_elem);
+    stream.writeEndElement();
 }
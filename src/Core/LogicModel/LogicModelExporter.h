@@ -28,32 +28,53 @@
 #include "Core/Utils/ObjectIDRewriter.h"
 #include "Layer.h"
 
+#include <QXmlStreamWriter>
+
+#include <memory>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace degate
 {
     /**
      * The LogicModelExporter exports a logic model. That is the file lmodel.xml from your degate project.
      *
+     * The file is written with a QXmlStreamWriter while iterating the logic model, without
+     * building a document tree in memory.
      */
     class LogicModelExporter : public XMLExporter
     {
     private:
-        typedef std::map<object_id_t /* net id */, QDomElement&> net_element_map_type;
 
-        void add_gate(QDomDocument& doc, QDomElement& gates_elem, Gate_shptr gate, layer_position_t layer_pos);
-        void add_wire(QDomDocument& doc, QDomElement& wires_elem, Wire_shptr wire, layer_position_t layer_pos);
-        void add_via(QDomDocument& doc, QDomElement& vias_elem, Via_shptr via, layer_position_t layer_pos);
+        /**
+         * Objects of a type, with their layer position, in layer order.
+         */
+        template<typename T>
+        using placed_objects = std::vector<std::pair<std::shared_ptr<T>, layer_position_t>>;
+
+        /**
+         * Sort the objects of the layers by type. The new object IDs are assigned in the
+         * layer order, like if the objects were exported in that order.
+         */
+        void collect_objects(LogicModel_shptr lmodel,
+                             placed_objects<Gate>& gates,
+                             placed_objects<Via>& vias,
+                             placed_objects<EMarker>& emarkers,
+                             placed_objects<Wire>& wires,
+                             placed_objects<Annotation>& annotations);
+
+        void add_gate(QXmlStreamWriter& stream, Gate_shptr gate, layer_position_t layer_pos);
+        void add_wire(QXmlStreamWriter& stream, Wire_shptr wire, layer_position_t layer_pos);
+        void add_via(QXmlStreamWriter& stream, Via_shptr via, layer_position_t layer_pos);
 
-        void add_emarker(QDomDocument& doc, QDomElement& emarkers_elem, EMarker_shptr emarker,
-                         layer_position_t layer_pos);
+        void add_emarker(QXmlStreamWriter& stream, EMarker_shptr emarker, layer_position_t layer_pos);
 
-        void add_nets(QDomDocument& doc, QDomElement& nets_elem, LogicModel_shptr lmodel);
+        void add_nets(QXmlStreamWriter& stream, LogicModel_shptr lmodel);
 
-        void add_annotation(QDomDocument& doc, QDomElement& annotations_elem, Annotation_shptr annotation,
-                            layer_position_t layer_pos);
+        void add_annotation(QXmlStreamWriter& stream, Annotation_shptr annotation, layer_position_t layer_pos);
 
-        void add_module(QDomDocument& doc, QDomElement& modules_elem, LogicModel_shptr lmodel, Module_shptr module);
+        void add_module(QXmlStreamWriter& stream, LogicModel_shptr lmodel, Module_shptr module);
 
         ObjectIDRewriter_shptr oid_rewriter;
 
@@ -66,6 +87,11 @@ namespace degate
         {
         }
 
+        /**
+         * @exception InvalidPathException
+         * @exception InvalidPointerException
+         * @exception std::runtime_error
+         */
         void export_data(std::string const& filename, LogicModel_shptr lmodel);
     };
 }
@@ -26,13 +26,45 @@
 #include "GUI/Preferences/PreferencesHandler.h"
 
 #include <boost/format.hpp>
-#include <boost/range/counting_range.hpp>
 
+#include <QImageReader>
 #include <QMutex>
-#include <QtConcurrent/QtConcurrent>
+#include <QThread>
+
+#include <algorithm>
+#include <climits>
+#include <memory>
 
 using namespace degate;
 
+namespace
+{
+    /**
+     * Read an image, or only the part in \p clip_rect if it is not null.
+     * The allocation limit of the reader is raised to the size of the decoded
+     * part, so a handler can't allocate more than the header announces.
+     */
+    QImage read_image(std::string const& image_file, int image_number, QSize const& size, QRect const& clip_rect)
+    {
+        QImageReader reader(image_file.c_str());
+
+        if (image_number >= 0)
+            reader.jumpToImage(image_number);
+
+        // Up to 8 bytes per pixel (16 bits per channel images)
+        const QRect rect = clip_rect.isNull() ? QRect(QPoint(0, 0), size) : clip_rect;
+        const uint_fast64_t bytes = static_cast<uint_fast64_t>(rect.width()) * rect.height() * 8;
+        const int limit = static_cast<int>(std::min<uint_fast64_t>(bytes / (1024 * 1024) + 1, INT_MAX));
+
+        reader.setAllocationLimit(std::max(reader.allocationLimit(), limit));
+
+        if (!clip_rect.isNull())
+            reader.setClipRect(clip_rect);
+
+        return reader.read();
+    }
+}
+
 Layer_shptr degate::get_first_layer(LogicModel_shptr lmodel, Layer::LAYER_TYPE layer_type)
 {
     if (layer_type == Layer::UNDEFINED)
@@ -199,169 +231,9 @@ void degate::grab_template_images(LogicModel_shptr lmodel,
     }
 }
 
-void load_tile(const QRgb* rba_data,
-               unsigned int tile_size,
-               unsigned int tile_index,
-               const std::string& path,
-               QSize local_size,
-               unsigned int global_tile_x,
-               unsigned int global_tile_y,
-               unsigned int tile_count_x)
-{
-    unsigned int local_tile_x = tile_index % tile_count_x;
-    unsigned int local_tile_y = tile_index / tile_count_x;
-
-    ////////////////
-    unsigned int tile_x = global_tile_x + local_tile_x;
-    unsigned int tile_y = global_tile_y + local_tile_y;
-
-    // Create a file name from tile number.
-    auto filename = QString("%1_%2.dat").arg(tile_x).arg(tile_y).toStdString();
-
-    auto data = new BackgroundImage::pixel_type[tile_size * tile_size];
-    memset(data,
-           0,
-           static_cast<std::size_t>(tile_size) *
-           static_cast<std::size_t>(tile_size) *
-           sizeof(BackgroundImage::pixel_type));
-
-    unsigned int min_x = tile_size * local_tile_x;
-    unsigned int min_y = tile_size * local_tile_y;
-
-    unsigned int default_max_x = min_x + tile_size;
-    unsigned int default_max_y = min_y + tile_size;
-
-    unsigned int max_x = default_max_x > static_cast<unsigned int>(local_size.width()) ?
-                         static_cast<unsigned int>(local_size.width()) : default_max_x;
-    unsigned int max_y = default_max_y > static_cast<unsigned int>(local_size.height()) ?
-                         static_cast<unsigned int>(local_size.height()) : default_max_y;
-
-    // Fill image (can be long with big images).
-    QRgb rgb;
-    for (unsigned int y = min_y; y < max_y; y++)
-    {
-        for (unsigned int x = min_x; x < max_x; x++)
-        {
-            rgb = rba_data[y * local_size.width() + x];
-            data[(y - min_y) * tile_size + (x - min_x)] = MERGE_CHANNELS(qRed(rgb), qGreen(rgb), qBlue(rgb), qAlpha(rgb));
-        }
-    }
-
-    assert(!file_exists(path + "/" + filename));
-
-    auto file = std::fstream(path + "/" + filename, std::ios::out | std::ios::binary);
-
-    file.write(reinterpret_cast<const char*>(&data[0]),
-               static_cast<std::size_t>(tile_size) *
-               static_cast<std::size_t>(tile_size) *
-               sizeof(BackgroundImage::pixel_type));
-
-    file.close();
-
-    delete[] data;
-}
-
-
-void create_scaled_background_image(const std::string& dir, const BackgroundImage_shptr& bg_image, QSize scaled_size, unsigned int tile_image_size, QImageReader& reader)
-{
-    QSize read_size{0, 0};
-
-    // Start image conversion and loading
-    while (true)
-    {
-        QSize reading_size{static_cast<int>(tile_image_size), static_cast<int>(tile_image_size)};
-
-        // Check width
-        if (reading_size.width() + read_size.width() > scaled_size.width())
-            reading_size.setWidth(scaled_size.width() - read_size.width());
-
-        // Check height
-        if (reading_size.height() + read_size.height() > scaled_size.height())
-            reading_size.setHeight(scaled_size.height() - read_size.height());
-
-        reader.device()->seek(0);
-
-        QImageReader current_reader(reader.device(), reader.format());
-
-        QRect rect(read_size.width(), read_size.height(), reading_size.width(), reading_size.height());
-
-        current_reader.setScaledSize(scaled_size);
-        current_reader.setScaledClipRect(rect);
-
-        QImage img = current_reader.read();
-        if (img.isNull())
-        {
-            debug(TM, "can't create %s (can't read image)\n", bg_image->get_path().c_str());
-        }
-
-        // Convert to good format
-        if (img.format() != QImage::Format_ARGB32 && img.format() != QImage::Format_RGB32)
-        {
-            img = img.convertToFormat(QImage::Format_ARGB32);
-        }
-
-        //////////////////// Process start ///////////////////////////
-
-        unsigned int global_tile_x = static_cast<unsigned int>(read_size.width()) >> bg_image->get_tile_width_exp();
-        unsigned int global_tile_y = static_cast<unsigned int>(read_size.height()) >> bg_image->get_tile_width_exp();
-
-        auto tile_count_x = static_cast<unsigned int>(std::ceil(static_cast<double>(reading_size.width()) / static_cast<double>(bg_image->get_tile_size())));
-        auto tile_count_y = static_cast<unsigned int>(std::ceil(static_cast<double>(reading_size.height()) / static_cast<double>(bg_image->get_tile_size())));
-
-        const auto *rgb_data = reinterpret_cast<const QRgb*>(&img.constBits()[0]);
-
-        // Multi-threaded function
-        std::function<void(const unsigned int& y)> function = [&rgb_data, &bg_image, &dir, &reading_size, &global_tile_x, &global_tile_y, &tile_count_x](const unsigned int& i)
-        {
-            load_tile(rgb_data, bg_image->get_tile_size(), i, dir, reading_size, global_tile_x, global_tile_y, tile_count_x);
-        };
-
-        // Start multithreading
-        const auto& it = boost::counting_range<unsigned int>(0, tile_count_x * tile_count_y);
-        QtConcurrent::blockingMap(it, function);
-
-        /////////////////////////////////////////////////////////////
-
-        read_size.setWidth(read_size.width() + reading_size.width());
-
-        if (read_size.width() >= scaled_size.width())
-        {
-            read_size.setWidth(0);
-            read_size.setHeight(read_size.height() + reading_size.height());
-        }
-
-        debug(TM, "New scaled image loading step.");
-
-        if (read_size.height() >= scaled_size.height())
-            break;
-    }
-}
-
-
-void create_scaled_background_images(const BackgroundImage_shptr& bg_image, unsigned int tile_image_size, QImageReader& reader, QSize default_size)
-{
-    auto w = static_cast<unsigned int>(default_size.width());
-    auto h = static_cast<unsigned int>(default_size.height());
-    unsigned int min_size = bg_image->get_tile_size();
-
-    for (int i = 2; ((h > min_size) || (w > min_size)) && (i < static_cast<int>(1u << 24u)); i *= 2) // max 24 scaling levels
-    {
-        w >>= 1u;
-        h >>= 1u;
-
-        // create a new image
-        auto dir_path = join_pathes(bg_image->get_path(), QString("scaling_%1.dimg").arg(i).toStdString());
-
-        create_directory(dir_path);
-
-        reader.device()->seek(0);
-
-        create_scaled_background_image(dir_path, bg_image, QSize(static_cast<int>(w), static_cast<int>(h)), tile_image_size, reader);
-    }
-}
-
-
-void degate::load_new_background_image(Layer_shptr layer, std::string const& project_dir, std::string const& image_file)
+BackgroundImageImporter::statistics degate::load_new_background_image(Layer_shptr layer,
+                                                                     std::string const& project_dir,
+                                                                     std::string const& image_file)
 {
     if (layer == nullptr)
         throw InvalidPointerException("Error: you passed an invalid pointer to load_background_image()");
@@ -370,9 +242,6 @@ void degate::load_new_background_image(Layer_shptr layer, std::string const& pro
     static const unsigned int loading_cache_size = PREFERENCES_HANDLER.get_preferences().image_importer_cache_size;
     ///////
 
-    // Maximum image tile size for reading, regarding the maximum allowed loading cache size.
-    unsigned int tile_image_size = std::floor<unsigned int>((std::sqrt<unsigned int>(loading_cache_size) * std::sqrt<unsigned int>(1024 * 1024)) / sizeof(BackgroundImage::pixel_type));
-
     // Layer directory
     boost::format fmter("layer_%1%.dimg");
     fmter % layer->get_layer_id(); // was get_layer_pos()
@@ -389,14 +258,6 @@ void degate::load_new_background_image(Layer_shptr layer, std::string const& pro
                                                                        static_cast<unsigned int>(layer->get_height()),
                                                                        dir);
 
-    // Adjust image size to be a multiple of tile size.
-    tile_image_size = (tile_image_size / bg_image->get_tile_size()) * bg_image->get_tile_size();
-
-    debug(TM, "%d", tile_image_size);
-
-    if (tile_image_size < bg_image->get_tile_size())
-        tile_image_size = bg_image->get_tile_size();
-
     //////////////// Convert new image to Degate internal format.
 
     // Create reader
@@ -426,35 +287,43 @@ void degate::load_new_background_image(Layer_shptr layer, std::string const& pro
     if (!size.isValid())
     {
         debug(TM, "can't read size of %s\n", image_file.c_str());
-        return;
+        return BackgroundImageImporter::statistics();
     }
 
-    QSize read_size{0, 0};
+    // Strips can be decoded alone only if the format decodes the clipped part alone
+    // (e.g. not TIFF and PNG, whose handlers decode the whole image for each clip rect).
+    const bool clip_supported = reader.supportsOption(QImageIOHandler::ClipRect);
 
-    // Start image conversion and loading
-    while (true)
-    {
-        QSize reading_size{static_cast<int>(tile_image_size), static_cast<int>(tile_image_size)};
+    // Else the image is decoded once and the strips are cut from it. Strips are then
+    // decoded in order by a single thread, the image is released after the last strip.
+    auto decoded_image = std::make_shared<QImage>();
 
-        // Check width
-        if (reading_size.width() + read_size.width() > size.width())
-            reading_size.setWidth(size.width() - read_size.width());
-
-        // Check height
-        if (reading_size.height() + read_size.height() > size.height())
-            reading_size.setHeight(size.height() - read_size.height());
+    BackgroundImageImporter::strip_decoder decoder = [&image_file, best_image_number, size, clip_supported, decoded_image](
+        unsigned int min_y,
+        unsigned int height,
+        std::vector<rgba_pixel_t>& pixels)
+    {
+        const QRect strip(0, static_cast<int>(min_y), size.width(), static_cast<int>(height));
 
-        reader.device()->seek(0);
+        QImage img;
+        if (clip_supported)
+            img = read_image(image_file, best_image_number, size, strip);
+        else
+        {
+            if (decoded_image->isNull())
+                *decoded_image = read_image(image_file, best_image_number, size, QRect());
 
-        QImageReader current_reader(reader.device(), reader.format());
+            if (decoded_image->size() == size)
+                img = decoded_image->copy(strip);
 
-        QRect rect(read_size.width(), read_size.height(), reading_size.width(), reading_size.height());
+            if (min_y + height >= static_cast<unsigned int>(size.height()))
+                *decoded_image = QImage();
+        }
 
-        current_reader.setClipRect(rect);
-        QImage img = current_reader.read();
-        if (img.isNull())
+        if (img.isNull() || img.width() != size.width() || img.height() != static_cast<int>(height))
         {
             debug(TM, "can't read %s\n", image_file.c_str());
+            return false;
         }
 
         // Convert to good format
@@ -463,53 +332,48 @@ void degate::load_new_background_image(Layer_shptr layer, std::string const& pro
             img = img.convertToFormat(QImage::Format_ARGB32);
         }
 
-        //////////////////// Process start ///////////////////////////
-
-        unsigned int global_tile_x = static_cast<unsigned int>(read_size.width()) >> bg_image->get_tile_width_exp();
-        unsigned int global_tile_y = static_cast<unsigned int>(read_size.height()) >> bg_image->get_tile_width_exp();
-
-        auto tile_count_x = static_cast<unsigned int>(std::ceil(static_cast<double>(reading_size.width()) / static_cast<double>(bg_image->get_tile_size())));
-        auto tile_count_y = static_cast<unsigned int>(std::ceil(static_cast<double>(reading_size.height()) / static_cast<double>(bg_image->get_tile_size())));
+        const auto width = static_cast<unsigned int>(size.width());
+        pixels.resize(static_cast<std::size_t>(width) * height);
 
-        const auto *rgb_data = reinterpret_cast<const QRgb*>(&img.constBits()[0]);
-
-        // Multi-threaded function
-        std::function<void(const unsigned int& y)> function = [&rgb_data, &bg_image, &dir, &reading_size, &global_tile_x, &global_tile_y, &tile_count_x](const unsigned int& i)
+        QRgb rgb;
+        for (unsigned int y = 0; y < height; y++)
         {
-            load_tile(rgb_data, bg_image->get_tile_size(), i, dir, reading_size, global_tile_x, global_tile_y, tile_count_x);
-        };
-
-        // Start multithreading
-        const auto& it = boost::counting_range<unsigned int>(0, tile_count_x * tile_count_y);
-        QtConcurrent::blockingMap(it, function);
-
-        /////////////////////////////////////////////////////////////
+            const auto* line = reinterpret_cast<const QRgb*>(img.constScanLine(static_cast<int>(y)));
+            rgba_pixel_t* dst = &pixels[static_cast<std::size_t>(y) * width];
 
-        read_size.setWidth(read_size.width() + reading_size.width());
-
-        if (read_size.width() >= size.width())
-        {
-            read_size.setWidth(0);
-            read_size.setHeight(read_size.height() + reading_size.height());
+            for (unsigned int x = 0; x < width; x++)
+            {
+                rgb = line[x];
+                dst[x] = MERGE_CHANNELS(qRed(rgb), qGreen(rgb), qBlue(rgb), qAlpha(rgb));
+            }
         }
 
-        debug(TM, "New image loading step.");
+        return true;
+    };
 
-        if (read_size.height() >= size.height())
-            break;
-    }
+    BackgroundImageImporter importer(dir,
+                                     static_cast<unsigned int>(size.width()),
+                                     static_cast<unsigned int>(size.height()),
+                                     bg_image->get_tile_size(),
+                                     decoder);
 
-    ///////////////
+    importer.set_memory_budget(static_cast<uint_fast64_t>(loading_cache_size) * 1024 * 1024);
+
+    if (clip_supported)
+        importer.set_decode_threads(static_cast<unsigned int>(std::max(1, QThread::idealThreadCount())));
 
-    debug(TM, "Create scaled images.");
-    create_scaled_background_images(bg_image, tile_image_size, reader, size);
-    debug(TM, "Finished creating scaled images.");
+    debug(TM, "Import %s in strips of %u rows.", image_file.c_str(), importer.get_strip_height());
+    BackgroundImageImporter::statistics stats = importer.run();
+    debug(TM, "Imported %u tiles on %u levels in %.2f s (%.1f MB/s).",
+          stats.tiles, stats.levels, stats.seconds, stats.get_throughput());
 
     ///////////////
 
     debug(TM, "Set image to layer.");
     layer->set_image(bg_image);
     debug(TM, "Done.");
+
+    return stats;
 }
 
 
@@ -23,6 +23,7 @@
 #define __LOGICMODELHELPER_H__
 
 #include "Core/Image/ImageHelper.h"
+#include "Core/Image/BackgroundImageImporter.h"
 #include "Core/LogicModel/ConnectedLogicModelObject.h"
 #include "Core/Project/Project.h"
 #include "Core/LogicModel/ObjectSet.h"
@@ -325,13 +326,17 @@ namespace degate
     /**
      * Load a new background image (optimized version).
      *
+     * The image is decoded once, in strips, and all the scaling levels are
+     * created in the same pass (see BackgroundImageImporter).
+     *
      * @param layer : the concerned layer.
      * @param project_dir : the project directory path.
      * @param image_file : the image file path.
+     * @return Returns the import statistics (tiles, throughput in MB/s...).
      */
-    void load_new_background_image(Layer_shptr layer,
-                                   std::string const& project_dir,
-                                   std::string const& image_file);
+    BackgroundImageImporter::statistics load_new_background_image(Layer_shptr layer,
+                                                                  std::string const& project_dir,
+                                                                  std::string const& image_file);
 
     /**
      * Clear the logic model for a layer.
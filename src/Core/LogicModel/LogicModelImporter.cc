@@ -25,6 +25,9 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <cerrno>
+#include <algorithm>
+#include <deque>
+#include <exception>
 #include <memory>
 #include <string>
 #include <iostream>
@@ -35,6 +38,8 @@
 #include <boost/format.hpp>
 #include <boost/algorithm/string/case_conv.hpp>
 
+#include <QtConcurrent/QtConcurrent>
+
 using namespace std;
 using namespace degate;
 
@@ -49,8 +54,6 @@ void LogicModelImporter::import_into(LogicModel_shptr lmodel,
 
     try
     {
-        QDomDocument parser;
-
         QFile file(QString::fromStdString(filename));
         if (!file.open(QIODevice::ReadOnly))
         {
@@ -59,19 +62,76 @@ void LogicModelImporter::import_into(LogicModel_shptr lmodel,
                 "The LogicModelImporter cannot load the project file. Can't open the file.");
         }
 
-        if (!parser.setContent(&file))
+        lmodel->set_gate_library(gate_library);
+
+        gates.clear();
+
+        // Template ports by ID, to not search the gate library for each gate port.
+        template_ports.clear();
+        if (gate_library != nullptr)
+        {
+            for (GateLibrary::template_iterator iter = gate_library->begin(); iter != gate_library->end(); ++iter)
+            {
+                GateTemplate_shptr tmpl = iter->second;
+
+                for (GateTemplate::port_iterator piter = tmpl->ports_begin(); piter != tmpl->ports_end(); ++piter)
+                    template_ports.insert(std::make_pair((*piter)->get_object_id(), *piter));
+            }
+        }
+
+        std::vector<net_record> nets;
+        std::vector<module_record> modules;
+
+        QXmlStreamReader reader(&file);
+
+        if (reader.readNextStartElement())
+        {
+            while (reader.readNextStartElement())
+            {
+                if (reader.name() == QLatin1String("gates"))
+                    parse_objects_element(reader, lmodel, "gate", "port", &LogicModelImporter::create_gate);
+
+                else if (reader.name() == QLatin1String("vias"))
+                    parse_objects_element(reader, lmodel, "via", QString(), &LogicModelImporter::create_via);
+
+                else if (reader.name() == QLatin1String("emarkers"))
+                    parse_objects_element(reader, lmodel, "emarker", QString(), &LogicModelImporter::create_emarker);
+
+                else if (reader.name() == QLatin1String("wires"))
+                    parse_objects_element(reader, lmodel, "wire", QString(), &LogicModelImporter::create_wire);
+
+                else if (reader.name() == QLatin1String("annotations"))
+                    parse_objects_element(reader, lmodel, "annotation", QString(),
+                                          &LogicModelImporter::create_annotation);
+
+                else if (reader.name() == QLatin1String("nets"))
+                    parse_nets_element(reader, nets);
+
+                else if (reader.name() == QLatin1String("modules"))
+                    modules = parse_modules_element(reader);
+
+                else
+                    reader.skipCurrentElement();
+            }
+        }
+
+        if (reader.hasError())
         {
             debug(TM, "Problem: can't parse the file %s.", filename.c_str());
             throw InvalidXMLException("The LogicModelImporter cannot load the project file. Can't parse the file.");
         }
+
         file.close();
 
-        const QDomElement root_elem = parser.documentElement();
-        assert(!root_elem.isNull());
+        // Nets and modules reference the objects, they are added once all the objects are there.
+        add_nets(nets, lmodel);
 
-        lmodel->set_gate_library(gate_library);
+        if (!modules.empty())
+        {
+            assert(modules.size() == 1);
 
-        parse_logic_model_element(root_elem, lmodel);
+            lmodel->set_main_module(create_module(modules.front(), lmodel));
+        }
 
         // check if the ports of placed standard cell are available and create them if necessary
         for (auto g : gates)
@@ -96,465 +156,530 @@ LogicModel_shptr LogicModelImporter::import(std::string const& filename, Project
     return lmodel;
 }
 
-void LogicModelImporter::parse_logic_model_element(QDomElement const lm_elem,
-                                                   LogicModel_shptr lmodel)
+void LogicModelImporter::read_element(QXmlStreamReader& reader,
+                                      element_record& record,
+                                      QString const& child_name) const
 {
-    const QDomElement gates_elem = get_dom_twig(lm_elem, "gates");
-    if (!gates_elem.isNull()) parse_gates_element(gates_elem, lmodel);
+    record.attributes = reader.attributes();
 
-    const QDomElement vias_elem = get_dom_twig(lm_elem, "vias");
-    if (!vias_elem.isNull()) parse_vias_element(vias_elem, lmodel);
-
-    const QDomElement emarkers_elem = get_dom_twig(lm_elem, "emarkers");
-    if (!emarkers_elem.isNull()) parse_emarkers_element(emarkers_elem, lmodel);
-
-    const QDomElement wires_elem = get_dom_twig(lm_elem, "wires");
-    if (!wires_elem.isNull()) parse_wires_element(wires_elem, lmodel);
+    while (reader.readNextStartElement())
+    {
+        if (!child_name.isEmpty() && reader.name() == child_name)
+            record.children.push_back(reader.attributes());
 
-    const QDomElement nets_elem = get_dom_twig(lm_elem, "nets");
-    if (!nets_elem.isNull()) parse_nets_element(nets_elem, lmodel);
+        reader.skipCurrentElement();
+    }
+}
 
-    const QDomElement annotations_elem = get_dom_twig(lm_elem, "annotations");
-    if (!annotations_elem.isNull()) parse_annotations_element(annotations_elem, lmodel);
+void LogicModelImporter::parse_objects_element(QXmlStreamReader& reader,
+                                               LogicModel_shptr lmodel,
+                                               QString const& element_name,
+                                               QString const& child_name,
+                                               object_builder builder)
+{
+    if (lmodel == nullptr)
+        throw InvalidPointerException("Got a nullptr pointer in LogicModelImporter::parse_objects_element()");
 
-    const QDomElement modules_elem = get_dom_twig(lm_elem, "modules");
-    if (!modules_elem.isNull())
+    struct created_batch
     {
-        std::list<Module_shptr> mods = parse_modules_element(modules_elem, lmodel);
+        element_batch elements;
+        object_batch objects;
+        std::exception_ptr error;
+    };
 
-        assert(mods.size() == 1);
+    const std::size_t batch_size = 1024;
+    const std::size_t max_pending_batches =
+        2 * static_cast<std::size_t>(std::max(1, QThreadPool::globalInstance()->maxThreadCount()));
 
-        lmodel->set_main_module(mods.front());
-    }
-}
+    std::deque<std::pair<std::shared_ptr<created_batch>, QFuture<void>>> pending;
 
-void LogicModelImporter::parse_nets_element(QDomElement const nets_element,
-                                            LogicModel_shptr lmodel)
-{
-    if (nets_element.isNull() || lmodel == nullptr)
-        throw InvalidPointerException("Got a nullptr pointer in  LogicModelImporter::parse_nets_element()");
+    // The objects of each layer, added at once to build the layer quadtrees in one pass.
+    std::map<int, std::vector<PlacedLogicModelObject_shptr>> layer_objects;
 
-    const QDomNodeList net_list = nets_element.elementsByTagName("net");
-    for (int i = 0; i < net_list.count(); i++)
+    // Collect the objects of the oldest batch.
+    auto add_batch = [&]()
     {
-        int object_counter = 0;
+        pending.front().second.waitForFinished();
+
+        std::shared_ptr<created_batch> batch = pending.front().first;
+        pending.pop_front();
+
+        if (batch->error)
+            std::rethrow_exception(batch->error);
 
-        QDomElement net_elem = net_list.at(i).toElement();
-        if (!net_elem.isNull())
+        for (auto const& o : batch->objects)
         {
-            object_id_t net_id = parse_number<object_id_t>(net_elem, "id");
+            layer_objects[o.first].push_back(o.second);
 
-            Net_shptr net(new Net());
-            net->set_object_id(net_id);
+            #if DEBUG_PROJECT_IMPORT
+                o.second->print();
+            #endif
 
-            const QDomNodeList connection_list = net_elem.elementsByTagName("connection");
-            for (int j = 0; j < connection_list.count(); j++)
+            // Collect placed standard cells in a first step.
+            // Later we call lmodel->update_ports().
+            if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(o.second))
+                gates.push_back(gate);
+        }
+    };
+
+    // Create the objects of the batch in the global thread pool.
+    auto start_batch = [&](std::shared_ptr<created_batch> batch)
+    {
+        QFuture<void> future = QtConcurrent::run([this, batch, builder]()
+        {
+            try
             {
-                QDomElement conn_elem = connection_list.at(j).toElement();
-                if (!conn_elem.isNull())
+                batch->objects.reserve(batch->elements.size());
+
+                for (auto const& record : batch->elements)
                 {
-                    object_id_t object_id = parse_number<object_id_t>(conn_elem, "object-id");
+                    int layer = 0;
+                    PlacedLogicModelObject_shptr o = (this->*builder)(record, layer);
+                    batch->objects.emplace_back(layer, o);
+                }
+            }
+            catch (...)
+            {
+                batch->error = std::current_exception();
+            }
 
-                    // add connection
-                    try
-                    {
-                        PlacedLogicModelObject_shptr placed_object = lmodel->get_object(object_id);
-                        if (placed_object == nullptr)
-                        {
-                            debug(TM,
-                                  "Failed to lookup logic model object %llu. Can't connect it to net %llu.",
-                                  object_id, net_id);
-                        }
-                        else
-                        {
-                            ConnectedLogicModelObject_shptr o =
-                                std::dynamic_pointer_cast<ConnectedLogicModelObject>(placed_object);
-                            if (o != nullptr)
-                            {
-                                o->set_net(net);
-                            }
-                            else
-                            {
-                                debug(TM, "Failed to dynamic_cast<> a logic model object with ID %llu", object_id);
-                            }
-                        }
-                    }
-                    catch (CollectionLookupException const&)
-                    {
-                        debug(TM,
-                              "Failed to insert a connection for net %llu into the logic layer. "
-                              "Can't lookup logic model object %llu that should be connected to that net.",
-                              net_id, object_id);
-                        throw; // rethrow
-                    }
-                } // end of if
+            batch->elements.clear();
+        });
+
+        pending.emplace_back(batch, future);
+    };
 
-                object_counter++;
-            } // end of for
+    try
+    {
+        auto batch = std::make_shared<created_batch>();
 
-            if (object_counter < 2)
+        while (reader.readNextStartElement())
+        {
+            if (reader.name() != element_name)
             {
-                boost::format f("Net with ID %1% has only a single object. This should not occur.");
-                f % net_id;
-                std::cout << "WARNING: " << f.str() << std::endl;
-                //throw DegateLogicException(f.str());
+                reader.skipCurrentElement();
+                continue;
+            }
+
+            batch->elements.emplace_back();
+            read_element(reader, batch->elements.back(), child_name);
+
+            if (batch->elements.size() == batch_size)
+            {
+                start_batch(batch);
+                batch = std::make_shared<created_batch>();
+
+                // Bound the memory in use while the parser is ahead of the threads.
+                while (pending.size() > max_pending_batches)
+                    add_batch();
             }
-            lmodel->add_net(net);
         }
+
+        if (!batch->elements.empty())
+            start_batch(batch);
+
+        while (!pending.empty())
+            add_batch();
+
+        for (auto const& layer : layer_objects)
+            lmodel->add_objects(layer.first, layer.second);
+    }
+    catch (...)
+    {
+        // The batches reference this importer.
+        for (auto& p : pending)
+            p.second.waitForFinished();
+
+        throw;
     }
 }
 
-void LogicModelImporter::parse_wires_element(QDomElement const wires_element,
-                                             LogicModel_shptr lmodel)
+void LogicModelImporter::parse_nets_element(QXmlStreamReader& reader, std::vector<net_record>& nets)
 {
-    if (wires_element.isNull() || lmodel == nullptr)
-        throw InvalidPointerException("Null pointer in LogicModelImporter::parse_wires_element()");
-
-    const QDomNodeList wire_list = wires_element.elementsByTagName("wire");
-    for (int i = 0; i < wire_list.count(); i++)
+    while (reader.readNextStartElement())
     {
-        QDomElement wire_elem = wire_list.at(i).toElement();
-        if (!wire_elem.isNull())
+        if (reader.name() != QLatin1String("net"))
         {
-            // XXX PORT ID REPLACER ...
-
-            object_id_t object_id = parse_number<object_id_t>(wire_elem, "id");
-            float from_x = parse_number<float>(wire_elem, "from-x");
-            float from_y = parse_number<float>(wire_elem, "from-y");
-            float to_x = parse_number<float>(wire_elem, "to-x");
-            float to_y = parse_number<float>(wire_elem, "to-y");
-            int diameter = parse_number<int>(wire_elem, "diameter");
-            int layer = parse_number<int>(wire_elem, "layer");
-            int remote_id = parse_number<object_id_t>(wire_elem, "remote-id", 0);
-
-            const std::string name(wire_elem.attribute("name").toStdString());
-            const std::string description(wire_elem.attribute("description").toStdString());
-            const std::string fill_color_str(wire_elem.attribute("fill-color").toStdString());
-            const std::string frame_color_str(wire_elem.attribute("frame-color").toStdString());
-
-
-            Wire_shptr wire(new Wire(from_x, from_y, to_x, to_y, diameter));
-            wire->set_name(name.c_str());
-            wire->set_description(description.c_str());
-            wire->set_object_id(object_id);
-            wire->set_fill_color(parse_color_string(fill_color_str));
-            wire->set_frame_color(parse_color_string(frame_color_str));
-
-            wire->set_remote_object_id(remote_id);
-            lmodel->add_object(layer, wire);
+            reader.skipCurrentElement();
+            continue;
         }
+
+        element_record record;
+        read_element(reader, record, "connection");
+
+        net_record net;
+        net.id = parse_number<object_id_t>(record.attributes, "id");
+
+        for (auto const& conn_attributes : record.children)
+            net.connections.push_back(parse_number<object_id_t>(conn_attributes, "object-id"));
+
+        nets.push_back(std::move(net));
     }
 }
 
-void LogicModelImporter::parse_vias_element(QDomElement const vias_element,
-                                            LogicModel_shptr lmodel)
+void LogicModelImporter::add_nets(std::vector<net_record> const& nets, LogicModel_shptr lmodel)
 {
-    if (vias_element.isNull() || lmodel == nullptr) throw InvalidPointerException();
+    if (lmodel == nullptr)
+        throw InvalidPointerException("Got a nullptr pointer in  LogicModelImporter::add_nets()");
 
-    const QDomNodeList via_list = vias_element.elementsByTagName("via");
-    for (int i = 0; i < via_list.count(); i++)
+    for (auto const& net_rec : nets)
     {
-        QDomElement via_elem = via_list.at(i).toElement();
-        if (!via_elem.isNull())
+        object_id_t net_id = net_rec.id;
+
+        Net_shptr net(new Net());
+        net->set_object_id(net_id);
+
+        for (object_id_t object_id : net_rec.connections)
         {
-            // XXX PORT ID REPLACER ...
-
-            object_id_t object_id = parse_number<object_id_t>(via_elem, "id");
-            float x = parse_number<float>(via_elem, "x");
-            float y = parse_number<float>(via_elem, "y");
-            int diameter = parse_number<int>(via_elem, "diameter");
-            int layer = parse_number<int>(via_elem, "layer");
-            int remote_id = parse_number<object_id_t>(via_elem, "remote-id", 0);
-
-            const std::string name(via_elem.attribute("name").toStdString());
-            const std::string description(via_elem.attribute("description").toStdString());
-            const std::string fill_color_str(via_elem.attribute("fill-color").toStdString());
-            const std::string frame_color_str(via_elem.attribute("frame-color").toStdString());
-            const std::string direction_str(
-                boost::algorithm::to_lower_copy(via_elem.attribute("direction").toStdString()));
-
-            Via::DIRECTION direction;
-            if (direction_str == "undefined") direction = Via::DIRECTION_UNDEFINED;
-            else if (direction_str == "up") direction = Via::DIRECTION_UP;
-            else if (direction_str == "down") direction = Via::DIRECTION_DOWN;
-            else
+            // add connection
+            try
             {
-                boost::format f("Can't parse via direction type: %1%");
-                f % direction_str;
-                throw XMLAttributeParseException(f.str());
+                PlacedLogicModelObject_shptr placed_object = lmodel->get_object(object_id);
+                if (placed_object == nullptr)
+                {
+                    debug(TM,
+                          "Failed to lookup logic model object %llu. Can't connect it to net %llu.",
+                          object_id, net_id);
+                }
+                else
+                {
+                    ConnectedLogicModelObject_shptr o =
+                        std::dynamic_pointer_cast<ConnectedLogicModelObject>(placed_object);
+                    if (o != nullptr)
+                    {
+                        o->set_net(net);
+                    }
+                    else
+                    {
+                        debug(TM, "Failed to dynamic_cast<> a logic model object with ID %llu", object_id);
+                    }
+                }
             }
+            catch (CollectionLookupException const&)
+            {
+                debug(TM,
+                      "Failed to insert a connection for net %llu into the logic layer. "
+                      "Can't lookup logic model object %llu that should be connected to that net.",
+                      net_id, object_id);
+                throw; // rethrow
+            }
+        }
 
-            Via_shptr via(new Via(x, y, diameter, direction));
-            via->set_name(name.c_str());
-            via->set_description(description.c_str());
-            via->set_object_id(object_id);
-            via->set_fill_color(parse_color_string(fill_color_str));
-            via->set_frame_color(parse_color_string(frame_color_str));
-
-            via->set_remote_object_id(remote_id);
-
-            lmodel->add_object(layer, via);
+        if (net_rec.connections.size() < 2)
+        {
+            boost::format f("Net with ID %1% has only a single object. This should not occur.");
+            f % net_id;
+            std::cout << "WARNING: " << f.str() << std::endl;
+            //throw DegateLogicException(f.str());
         }
+        lmodel->add_net(net);
     }
 }
 
-void LogicModelImporter::parse_emarkers_element(QDomElement const emarkers_element,
-                                                LogicModel_shptr lmodel)
+PlacedLogicModelObject_shptr LogicModelImporter::create_wire(element_record const& record, int& layer)
 {
-    if (emarkers_element.isNull() || lmodel == nullptr) throw InvalidPointerException();
+    QXmlStreamAttributes const& wire_attributes = record.attributes;
+
+    // XXX PORT ID REPLACER ...
+
+    object_id_t object_id = parse_number<object_id_t>(wire_attributes, "id");
+    float from_x = parse_number<float>(wire_attributes, "from-x");
+    float from_y = parse_number<float>(wire_attributes, "from-y");
+    float to_x = parse_number<float>(wire_attributes, "to-x");
+    float to_y = parse_number<float>(wire_attributes, "to-y");
+    int diameter = parse_number<int>(wire_attributes, "diameter");
+    layer = parse_number<int>(wire_attributes, "layer");
+    int remote_id = parse_number<object_id_t>(wire_attributes, "remote-id", 0);
+
+    const std::string name(get_attribute(wire_attributes, "name"));
+    const std::string description(get_attribute(wire_attributes, "description"));
+    const std::string fill_color_str(get_attribute(wire_attributes, "fill-color"));
+    const std::string frame_color_str(get_attribute(wire_attributes, "frame-color"));
+
+
+    Wire_shptr wire(new Wire(from_x, from_y, to_x, to_y, diameter));
+    wire->set_name(name.c_str());
+    wire->set_description(description.c_str());
+    wire->set_object_id(object_id);
+    wire->set_fill_color(parse_color_string(fill_color_str));
+    wire->set_frame_color(parse_color_string(frame_color_str));
 
-    const QDomNodeList emarker_list = emarkers_element.elementsByTagName("emarker");
-    for (int i = 0; i < emarker_list.count(); i++)
+    wire->set_remote_object_id(remote_id);
+
+    return wire;
+}
+
+PlacedLogicModelObject_shptr LogicModelImporter::create_via(element_record const& record, int& layer)
+{
+    QXmlStreamAttributes const& via_attributes = record.attributes;
+
+    // XXX PORT ID REPLACER ...
+
+    object_id_t object_id = parse_number<object_id_t>(via_attributes, "id");
+    float x = parse_number<float>(via_attributes, "x");
+    float y = parse_number<float>(via_attributes, "y");
+    int diameter = parse_number<int>(via_attributes, "diameter");
+    layer = parse_number<int>(via_attributes, "layer");
+    int remote_id = parse_number<object_id_t>(via_attributes, "remote-id", 0);
+
+    const std::string name(get_attribute(via_attributes, "name"));
+    const std::string description(get_attribute(via_attributes, "description"));
+    const std::string fill_color_str(get_attribute(via_attributes, "fill-color"));
+    const std::string frame_color_str(get_attribute(via_attributes, "frame-color"));
+    const std::string direction_str(boost::algorithm::to_lower_copy(get_attribute(via_attributes, "direction")));
+
+    Via::DIRECTION direction;
+    if (direction_str == "undefined") direction = Via::DIRECTION_UNDEFINED;
+    else if (direction_str == "up") direction = Via::DIRECTION_UP;
+    else if (direction_str == "down") direction = Via::DIRECTION_DOWN;
+    else
     {
-        QDomElement emarker_elem = emarker_list.at(i).toElement();
-        if (!emarker_elem.isNull())
-        {
-            // XXX PORT ID REPLACER ...
-
-            object_id_t object_id = parse_number<object_id_t>(emarker_elem, "id");
-            float x = parse_number<float>(emarker_elem, "x");
-            float y = parse_number<float>(emarker_elem, "y");
-            int diameter = parse_number<diameter_t>(emarker_elem, "diameter");
-            int layer = parse_number<int>(emarker_elem, "layer");
-            int remote_id = parse_number<object_id_t>(emarker_elem, "remote-id", 0);
-
-            const std::string name(emarker_elem.attribute("name").toStdString());
-            const std::string description(emarker_elem.attribute("description").toStdString());
-            const bool is_module_port(emarker_elem.attribute("is-module-port", "0").toInt());
-            const std::string fill_color_str(emarker_elem.attribute("fill-color").toStdString());
-            const std::string frame_color_str(emarker_elem.attribute("frame-color").toStdString());
-            const std::string direction_str(
-                boost::algorithm::to_lower_copy(emarker_elem.attribute("direction").toStdString()));
-
-            EMarker_shptr emarker(new EMarker(x, y, diameter, is_module_port));
-            emarker->set_name(name.c_str());
-            emarker->set_description(description.c_str());
-            emarker->set_object_id(object_id);
-            emarker->set_fill_color(parse_color_string(fill_color_str));
-            emarker->set_frame_color(parse_color_string(frame_color_str));
-
-            emarker->set_remote_object_id(remote_id);
-
-            lmodel->add_object(layer, emarker);
-        }
+        boost::format f("Can't parse via direction type: %1%");
+        f % direction_str;
+        throw XMLAttributeParseException(f.str());
     }
+
+    Via_shptr via(new Via(x, y, diameter, direction));
+    via->set_name(name.c_str());
+    via->set_description(description.c_str());
+    via->set_object_id(object_id);
+    via->set_fill_color(parse_color_string(fill_color_str));
+    via->set_frame_color(parse_color_string(frame_color_str));
+
+    via->set_remote_object_id(remote_id);
+
+    return via;
 }
 
-void LogicModelImporter::parse_gates_element(QDomElement const gates_element,
-                                             LogicModel_shptr lmodel)
+PlacedLogicModelObject_shptr LogicModelImporter::create_emarker(element_record const& record, int& layer)
 {
-    if (gates_element.isNull() || lmodel == nullptr) throw InvalidPointerException();
+    QXmlStreamAttributes const& emarker_attributes = record.attributes;
 
+    // XXX PORT ID REPLACER ...
 
-    const QDomNodeList gate_list = gates_element.elementsByTagName("gate");
-    for (int i = 0; i < gate_list.count(); i++)
-    {
-        QDomElement gate_elem = gate_list.at(i).toElement();
-        if (!gate_elem.isNull())
-        {
-            object_id_t object_id = parse_number<object_id_t>(gate_elem, "id");
-            float min_x = parse_number<float>(gate_elem, "min-x");
-            float min_y = parse_number<float>(gate_elem, "min-y");
-            float max_x = parse_number<float>(gate_elem, "max-x");
-            float max_y = parse_number<float>(gate_elem, "max-y");
-
-            int layer = parse_number<int>(gate_elem, "layer");
-
-            int gate_type_id = parse_number<int>(gate_elem, "type-id");
-            const std::string name(gate_elem.attribute("name").toStdString());
-            const std::string description(gate_elem.attribute("description").toStdString());
-            const std::string orientation_str(
-                boost::algorithm::to_lower_copy(gate_elem.attribute("orientation").toStdString()));
-            const std::string frame_color_str(gate_elem.attribute("frame-color").toStdString());
-            const std::string fill_color_str(gate_elem.attribute("fill-color").toStdString());
-
-            Gate::ORIENTATION orientation;
-            if (orientation_str == "undefined") orientation = Gate::ORIENTATION_UNDEFINED;
-            else if (orientation_str == "normal") orientation = Gate::ORIENTATION_NORMAL;
-            else if (orientation_str == "flipped-left-right") orientation = Gate::ORIENTATION_FLIPPED_LEFT_RIGHT;
-            else if (orientation_str == "flipped-up-down") orientation = Gate::ORIENTATION_FLIPPED_UP_DOWN;
-            else if (orientation_str == "flipped-both") orientation = Gate::ORIENTATION_FLIPPED_BOTH;
-            else throw XMLAttributeParseException("Can't parse orientation type.");
-
-            // create a new gate and add it into the logic model
-
-            Gate_shptr gate(new Gate(min_x, max_x, min_y, max_y, orientation));
-            gate->set_name(name.c_str());
-            gate->set_description(description.c_str());
-            gate->set_object_id(object_id);
-            gate->set_template_type_id(gate_type_id);
-            gate->set_fill_color(parse_color_string(fill_color_str));
-            gate->set_frame_color(parse_color_string(frame_color_str));
-
-            if (gate_library != nullptr && gate_type_id != 0)
-            {
-                GateTemplate_shptr tmpl = gate_library->get_template(gate_type_id);
-                assert(tmpl != nullptr);
-                gate->set_gate_template(tmpl);
-            }
+    object_id_t object_id = parse_number<object_id_t>(emarker_attributes, "id");
+    float x = parse_number<float>(emarker_attributes, "x");
+    float y = parse_number<float>(emarker_attributes, "y");
+    int diameter = parse_number<diameter_t>(emarker_attributes, "diameter");
+    layer = parse_number<int>(emarker_attributes, "layer");
+    int remote_id = parse_number<object_id_t>(emarker_attributes, "remote-id", 0);
 
-            // parse port instances
-            const QDomNodeList port_list = gate_elem.elementsByTagName("port");
-            for (int j = 0; j < port_list.count(); j++)
-            {
-                QDomElement port_elem = port_list.at(j).toElement();
-                if (!port_elem.isNull())
-                {
-                    object_id_t template_port_id = parse_number<object_id_t>(port_elem, "type-id");
+    const std::string name(get_attribute(emarker_attributes, "name"));
+    const std::string description(get_attribute(emarker_attributes, "description"));
+    const bool is_module_port(emarker_attributes.value("is-module-port").toInt());
+    const std::string fill_color_str(get_attribute(emarker_attributes, "fill-color"));
+    const std::string frame_color_str(get_attribute(emarker_attributes, "frame-color"));
 
-                    // create a new port
-                    GatePort_shptr gate_port = std::make_shared<GatePort>(gate);
-                    gate_port->set_object_id(parse_number<object_id_t>(port_elem, "id"));
-                    gate_port->set_template_port_type_id(template_port_id);
-                    gate_port->set_diameter(parse_number<diameter_t>(port_elem, "diameter", 5));
+    EMarker_shptr emarker(new EMarker(x, y, diameter, is_module_port));
+    emarker->set_name(name.c_str());
+    emarker->set_description(description.c_str());
+    emarker->set_object_id(object_id);
+    emarker->set_fill_color(parse_color_string(fill_color_str));
+    emarker->set_frame_color(parse_color_string(frame_color_str));
 
-                    if (gate_library != nullptr)
-                    {
-                        GateTemplatePort_shptr tmpl_port = gate_library->get_template_port(template_port_id);
-                        gate_port->set_template_port(tmpl_port);
-                    }
+    emarker->set_remote_object_id(remote_id);
 
-                    gate->add_port(gate_port);
-                }
-            }
+    return emarker;
+}
+
+PlacedLogicModelObject_shptr LogicModelImporter::create_gate(element_record const& record, int& layer)
+{
+    QXmlStreamAttributes const& gate_attributes = record.attributes;
+
+    object_id_t object_id = parse_number<object_id_t>(gate_attributes, "id");
+    float min_x = parse_number<float>(gate_attributes, "min-x");
+    float min_y = parse_number<float>(gate_attributes, "min-y");
+    float max_x = parse_number<float>(gate_attributes, "max-x");
+    float max_y = parse_number<float>(gate_attributes, "max-y");
+
+    layer = parse_number<int>(gate_attributes, "layer");
+
+    int gate_type_id = parse_number<int>(gate_attributes, "type-id");
+    const std::string name(get_attribute(gate_attributes, "name"));
+    const std::string description(get_attribute(gate_attributes, "description"));
+    const std::string orientation_str(boost::algorithm::to_lower_copy(get_attribute(gate_attributes, "orientation")));
+    const std::string frame_color_str(get_attribute(gate_attributes, "frame-color"));
+    const std::string fill_color_str(get_attribute(gate_attributes, "fill-color"));
+
+    Gate::ORIENTATION orientation;
+    if (orientation_str == "undefined") orientation = Gate::ORIENTATION_UNDEFINED;
+    else if (orientation_str == "normal") orientation = Gate::ORIENTATION_NORMAL;
+    else if (orientation_str == "flipped-left-right") orientation = Gate::ORIENTATION_FLIPPED_LEFT_RIGHT;
+    else if (orientation_str == "flipped-up-down") orientation = Gate::ORIENTATION_FLIPPED_UP_DOWN;
+    else if (orientation_str == "flipped-both") orientation = Gate::ORIENTATION_FLIPPED_BOTH;
+    else throw XMLAttributeParseException("Can't parse orientation type.");
+
+    // create a new gate
+
+    Gate_shptr gate(new Gate(min_x, max_x, min_y, max_y, orientation));
+    gate->set_name(name.c_str());
+    gate->set_description(description.c_str());
+    gate->set_object_id(object_id);
+    gate->set_template_type_id(gate_type_id);
+    gate->set_fill_color(parse_color_string(fill_color_str));
+    gate->set_frame_color(parse_color_string(frame_color_str));
+
+    if (gate_library != nullptr && gate_type_id != 0)
+    {
+        // The gate library is shared by the threads, and the template counts its references.
+        std::lock_guard<std::mutex> lock(template_mutex);
 
-            lmodel->add_object(layer, gate);
+        GateTemplate_shptr tmpl = gate_library->get_template(gate_type_id);
+        assert(tmpl != nullptr);
+        gate->set_gate_template(tmpl);
+    }
 
-            #if DEBUG_PROJECT_IMPORT
-                gate->print();
-            #endif
+    // parse port instances
+    for (auto const& port_attributes : record.children)
+    {
+        object_id_t template_port_id = parse_number<object_id_t>(port_attributes, "type-id");
 
-            // Collect placed standard cells in a first step.
-            // Later we call lmodel->update_ports().
-            gates.push_back(gate);
+        // create a new port
+        GatePort_shptr gate_port = std::make_shared<GatePort>(gate);
+        gate_port->set_object_id(parse_number<object_id_t>(port_attributes, "id"));
+        gate_port->set_template_port_type_id(template_port_id);
+        gate_port->set_diameter(parse_number<diameter_t>(port_attributes, "diameter", 5));
+
+        if (gate_library != nullptr)
+        {
+            auto found = template_ports.find(template_port_id);
+            if (found == template_ports.end())
+            {
+                std::ostringstream stm;
+                stm << "There is no template port with ID. " << template_port_id << " in the gate library.";
+                throw CollectionLookupException(stm.str());
+            }
+
+            gate_port->set_template_port(found->second);
         }
+
+        gate->add_port(gate_port);
     }
+
+    return gate;
 }
 
 
-void LogicModelImporter::parse_annotations_element(QDomElement const annotations_element,
-                                                   LogicModel_shptr lmodel)
+PlacedLogicModelObject_shptr LogicModelImporter::create_annotation(element_record const& record, int& layer)
 {
-    if (annotations_element.isNull() || lmodel == nullptr) throw InvalidPointerException();
+    QXmlStreamAttributes const& annotation_attributes = record.attributes;
 
-    const QDomNodeList annotation_list = annotations_element.elementsByTagName("annotation");
-    for (int i = 0; i < annotation_list.count(); i++)
-    {
-        QDomElement annotation_elem = annotation_list.at(i).toElement();
-        if (!annotation_elem.isNull())
-        {
-            object_id_t object_id = parse_number<object_id_t>(annotation_elem, "id");
+    object_id_t object_id = parse_number<object_id_t>(annotation_attributes, "id");
 
-            float min_x = parse_number<float>(annotation_elem, "min-x");
-            float min_y = parse_number<float>(annotation_elem, "min-y");
-            float max_x = parse_number<float>(annotation_elem, "max-x");
-            float max_y = parse_number<float>(annotation_elem, "max-y");
+    float min_x = parse_number<float>(annotation_attributes, "min-x");
+    float min_y = parse_number<float>(annotation_attributes, "min-y");
+    float max_x = parse_number<float>(annotation_attributes, "max-x");
+    float max_y = parse_number<float>(annotation_attributes, "max-y");
 
-            int layer = parse_number<int>(annotation_elem, "layer");
-            Annotation::class_id_t class_id = parse_number<Annotation::class_id_t>(annotation_elem, "class-id");
+    layer = parse_number<int>(annotation_attributes, "layer");
+    Annotation::class_id_t class_id = parse_number<Annotation::class_id_t>(annotation_attributes, "class-id");
 
-            const std::string name(annotation_elem.attribute("name").toStdString());
-            const std::string description(annotation_elem.attribute("description").toStdString());
-            const std::string fill_color_str(annotation_elem.attribute("fill-color").toStdString());
-            const std::string frame_color_str(annotation_elem.attribute("frame-color").toStdString());
+    const std::string name(get_attribute(annotation_attributes, "name"));
+    const std::string description(get_attribute(annotation_attributes, "description"));
+    const std::string fill_color_str(get_attribute(annotation_attributes, "fill-color"));
+    const std::string frame_color_str(get_attribute(annotation_attributes, "frame-color"));
 
 
-            Annotation_shptr annotation;
+    Annotation_shptr annotation;
 
-            if (class_id == Annotation::SUBPROJECT)
-            {
-                const std::string path = annotation_elem.attribute("subproject-directory").toStdString();
-                annotation = std::make_shared<SubProjectAnnotation>(min_x, max_x, min_y, max_y, path);
-            }
-            else
-                annotation = std::make_shared<Annotation>(min_x, max_x, min_y, max_y, class_id);
+    if (class_id == Annotation::SUBPROJECT)
+    {
+        const std::string path = get_attribute(annotation_attributes, "subproject-directory");
+        annotation = std::make_shared<SubProjectAnnotation>(min_x, max_x, min_y, max_y, path);
+    }
+    else
+        annotation = std::make_shared<Annotation>(min_x, max_x, min_y, max_y, class_id);
 
-            annotation->set_name(name.c_str());
-            annotation->set_description(description.c_str());
-            annotation->set_object_id(object_id);
-            annotation->set_fill_color(parse_color_string(fill_color_str));
-            annotation->set_frame_color(parse_color_string(frame_color_str));
+    annotation->set_name(name.c_str());
+    annotation->set_description(description.c_str());
+    annotation->set_object_id(object_id);
+    annotation->set_fill_color(parse_color_string(fill_color_str));
+    annotation->set_frame_color(parse_color_string(frame_color_str));
 
-            lmodel->add_object(layer, annotation);
-        }
-    }
+    return annotation;
 }
 
-std::list<Module_shptr> LogicModelImporter::parse_modules_element(QDomElement const modules_element,
-                                                                  LogicModel_shptr lmodel)
+std::vector<LogicModelImporter::module_record> LogicModelImporter::parse_modules_element(QXmlStreamReader& reader)
 {
-    if (modules_element.isNull() || lmodel == nullptr)
-        throw InvalidPointerException("Got a nullptr pointer in LogicModelImporter::parse_modules_element()");
-
-    std::list<Module_shptr> modules;
-
-    QDomElement module_elem = modules_element.firstChildElement("module");
+    std::vector<module_record> modules;
 
-    while (!module_elem.isNull())
+    while (reader.readNextStartElement())
     {
-        // parse module attributes
-        object_id_t id = parse_number<object_id_t>(module_elem, "id");
-        const std::string name(module_elem.attribute("name").toStdString());
-        const std::string entity(module_elem.attribute("entity").toStdString());
+        if (reader.name() != QLatin1String("module"))
+        {
+            reader.skipCurrentElement();
+            continue;
+        }
 
-        Module_shptr module(new Module(name, entity));
-        module->set_object_id(id);
+        // parse module attributes
+        module_record module;
+        module.id = parse_number<object_id_t>(reader.attributes(), "id");
+        module.name = get_attribute(reader.attributes(), "name");
+        module.entity = get_attribute(reader.attributes(), "entity");
 
-        // parse standard cell list
-        const QDomElement cells_elem = module_elem.firstChildElement("cells");
-        if (!cells_elem.isNull())
+        while (reader.readNextStartElement())
         {
-            const QDomNodeList cell_list = cells_elem.elementsByTagName("cell");
-            for (int j = 0; j < cell_list.count(); j++)
+            // parse standard cell list
+            if (reader.name() == QLatin1String("cells"))
             {
-                QDomElement cell_elem = cell_list.at(j).toElement();
-                if (!cell_elem.isNull())
-                {
-                    object_id_t cell_id = parse_number<object_id_t>(cell_elem, "object-id");
+                element_record cells;
+                read_element(reader, cells, "cell");
 
-                    // Lookup will throw an exception, if cell is not in the logic model. This is intended behaviour.
-                    if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(lmodel->get_object(cell_id)))
-                        module->add_gate(gate, /* autodetect module ports = */ false);
-                }
+                for (auto const& cell_attributes : cells.children)
+                    module.cells.push_back(parse_number<object_id_t>(cell_attributes, "object-id"));
             }
-        }
 
-        // parse module ports
-        const QDomElement mports_elem = module_elem.firstChildElement("module-ports");
-        if (!mports_elem.isNull())
-        {
-            const QDomNodeList mport_list = mports_elem.elementsByTagName("module-port");
-            for (int k = 0; k < mport_list.count(); k++)
+            // parse module ports
+            else if (reader.name() == QLatin1String("module-ports"))
             {
-                QDomElement mport_elem = mport_list.at(k).toElement();
-                if (!mport_elem.isNull())
-                {
-                    const std::string port_name(mport_elem.attribute("name").toStdString());
-                    object_id_t ref_id = parse_number<object_id_t>(mport_elem, "object-id");
+                element_record mports;
+                read_element(reader, mports, "module-port");
 
-                    // Lookup will throw an exception, if cell is not in the logic model. This is intended behaviour.
-                    if (GatePort_shptr gport = std::dynamic_pointer_cast<GatePort>(lmodel->get_object(ref_id)))
-                        module->add_module_port(port_name, gport);
-                }
+                for (auto const& mport_attributes : mports.children)
+                    module.ports.emplace_back(get_attribute(mport_attributes, "name"),
+                                              parse_number<object_id_t>(mport_attributes, "object-id"));
             }
-        }
 
+            // parse sub-modules
+            else if (reader.name() == QLatin1String("modules"))
+                module.modules = parse_modules_element(reader);
 
-        // parse sub-modules
-        const QDomElement sub_modules_elem = module_elem.firstChildElement("modules");
-        if (!sub_modules_elem.isNull())
-        {
-            std::list<Module_shptr> sub_modules = parse_modules_element(sub_modules_elem, lmodel);
-            for (auto submod : sub_modules)
-            {
-                module->add_module(submod);
-            }
+            else
+                reader.skipCurrentElement();
         }
 
-        modules.push_back(module);
-
-        module_elem = module_elem.nextSiblingElement("module");
+        modules.push_back(std::move(module));
     }
 
     return modules;
 }
+
+Module_shptr LogicModelImporter::create_module(module_record const& record, LogicModel_shptr lmodel)
+{
+    if (lmodel == nullptr)
+        throw InvalidPointerException("Got a nullptr pointer in LogicModelImporter::create_module()");
+
+    Module_shptr module(new Module(record.name, record.entity));
+    module->set_object_id(record.id);
+
+    for (object_id_t cell_id : record.cells)
+    {
+        // Lookup will throw an exception, if cell is not in the logic model. This is intended behaviour.
+        if (Gate_shptr gate = std::dynamic_pointer_cast<Gate>(lmodel->get_object(cell_id)))
+            module->add_gate(gate, /* autodetect module ports = */ false);
+    }
+
+    for (auto const& port : record.ports)
+    {
+        // Lookup will throw an exception, if cell is not in the logic model. This is intended behaviour.
+        if (GatePort_shptr gport = std::dynamic_pointer_cast<GatePort>(lmodel->get_object(port.second)))
+            module->add_module_port(port.first, gport);
+    }
+
+    for (auto const& sub_module : record.modules)
+    {
+        module->add_module(create_module(sub_module, lmodel));
+    }
+
+    return module;
+}
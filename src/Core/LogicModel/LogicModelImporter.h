@@ -26,44 +26,104 @@
 #include "LogicModel.h"
 #include "Core/XML/XMLImporter.h"
 
+#include <QXmlStreamReader>
+
+#include <list>
+#include <map>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace degate
 {
     /**
      * This class implements a logic model loader.
+     *
+     * The file is read with a QXmlStreamReader. The elements of the placed objects are
+     * collected in batches, the objects of a batch are created by a thread of the global
+     * thread pool, and the batches are added into the logic model in the file order.
      */
     class LogicModelImporter : public XMLImporter
     {
     private:
 
+        /**
+         * The attributes of an element and of its child elements (e.g. a gate and its ports).
+         */
+        struct element_record
+        {
+            QXmlStreamAttributes attributes;
+            std::vector<QXmlStreamAttributes> children;
+        };
+
+        typedef std::vector<element_record> element_batch;
+
+        /**
+         * Placed objects, with their layer position.
+         */
+        typedef std::vector<std::pair<int, PlacedLogicModelObject_shptr>> object_batch;
+
+        /**
+         * Create a placed object from an element, and get its layer position.
+         * It is called from the threads of the global thread pool.
+         */
+        typedef PlacedLogicModelObject_shptr (LogicModelImporter::*object_builder)(element_record const& record,
+                                                                                    int& layer);
+
+        /**
+         * A net, read before the objects are connected.
+         */
+        struct net_record
+        {
+            object_id_t id;
+            std::vector<object_id_t> connections;
+        };
+
+        /**
+         * A module, read before the cells and the module ports are looked up.
+         */
+        struct module_record
+        {
+            object_id_t id;
+            std::string name;
+            std::string entity;
+
+            std::vector<object_id_t> cells;
+            std::vector<std::pair<std::string, object_id_t>> ports;
+            std::vector<module_record> modules;
+        };
+
         unsigned int width, height;
         GateLibrary_shptr gate_library;
 
         std::list<Gate_shptr> gates;
 
-        void parse_logic_model_element(QDomElement const lm_element,
-                                       LogicModel_shptr lmodel);
+        std::map<object_id_t, GateTemplatePort_shptr> template_ports;
+        std::mutex template_mutex;
 
-        void parse_gates_element(QDomElement const gates_element, LogicModel_shptr lmodel);
+        void read_element(QXmlStreamReader& reader, element_record& record, QString const& child_name) const;
 
-        void parse_vias_element(QDomElement const vias_element,
-                                LogicModel_shptr lmodel);
+        void parse_objects_element(QXmlStreamReader& reader,
+                                   LogicModel_shptr lmodel,
+                                   QString const& element_name,
+                                   QString const& child_name,
+                                   object_builder builder);
 
-        void parse_emarkers_element(QDomElement const emarkers_element,
-                                    LogicModel_shptr lmodel);
+        PlacedLogicModelObject_shptr create_gate(element_record const& record, int& layer);
+        PlacedLogicModelObject_shptr create_via(element_record const& record, int& layer);
+        PlacedLogicModelObject_shptr create_emarker(element_record const& record, int& layer);
+        PlacedLogicModelObject_shptr create_wire(element_record const& record, int& layer);
+        PlacedLogicModelObject_shptr create_annotation(element_record const& record, int& layer);
 
-        void parse_wires_element(QDomElement const wires_element,
-                                 LogicModel_shptr lmodel);
+        void parse_nets_element(QXmlStreamReader& reader, std::vector<net_record>& nets);
 
-        void parse_nets_element(QDomElement const nets_element,
-                                LogicModel_shptr lmodel);
+        void add_nets(std::vector<net_record> const& nets, LogicModel_shptr lmodel);
 
-        void parse_annotations_element(QDomElement const annotations_element,
-                                       LogicModel_shptr lmodel);
+        std::vector<module_record> parse_modules_element(QXmlStreamReader& reader);
 
-        std::list<Module_shptr> parse_modules_element(QDomElement const modules_element,
-                                                      LogicModel_shptr lmodel);
+        Module_shptr create_module(module_record const& record, LogicModel_shptr lmodel);
 
     public:
 
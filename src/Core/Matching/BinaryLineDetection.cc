@@ -65,7 +65,7 @@ TileImage_GS_DOUBLE_shptr BinaryLineDetection::run(ImageBase_shptr img_in,
                                                    std::string const& directory)
 {
     set_directory(directory);
-    gray_image = std::dynamic_pointer_cast<TileImage_GS_DOUBLE>(pipe.run(img_in));
+    gray_image = std::dynamic_pointer_cast<TileImage_GS_DOUBLE>(pipe.run_tiled(img_in));
     //save_normalized_image<TileImage_GS_DOUBLE>("/tmp/gray.tif", gray_image);
 
     TileImage_GS_DOUBLE_shptr bin_otsu; //, binMean1_0, binMean1_1, binMean1_2;
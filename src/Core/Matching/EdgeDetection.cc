@@ -116,7 +116,7 @@ bool EdgeDetection::has_directory() const
 
 void EdgeDetection::run_edge_detection(ImageBase_shptr in)
 {
-    ImageBase_shptr out = pipe.run(in);
+    ImageBase_shptr out = pipe.run_tiled(in);
     assert(out != nullptr);
 
     std::shared_ptr<SobelYOperator> sobel_y(new SobelYOperator());
@@ -127,8 +127,12 @@ void EdgeDetection::run_edge_detection(ImageBase_shptr in)
     std::shared_ptr<IPConvolve<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>> edge_filter_y
         (new IPConvolve<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>(sobel_x));
 
-    i1 = std::dynamic_pointer_cast<TileImage_GS_DOUBLE>(edge_filter_x->run(out));
-    i2 = std::dynamic_pointer_cast<TileImage_GS_DOUBLE>(edge_filter_y->run(out));
+    IPPipe edge_pipe_x, edge_pipe_y;
+    edge_pipe_x.add(edge_filter_x);
+    edge_pipe_y.add(edge_filter_y);
+
+    i1 = std::dynamic_pointer_cast<TileImage_GS_DOUBLE>(edge_pipe_x.run_tiled(out));
+    i2 = std::dynamic_pointer_cast<TileImage_GS_DOUBLE>(edge_pipe_y.run_tiled(out));
     assert(i1 != nullptr && i2 != nullptr);
 
     if (has_path) save_normalized_image<TileImage_GS_DOUBLE>(join_pathes(directory, "01_sobelx.tif"), i1);
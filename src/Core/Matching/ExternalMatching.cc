@@ -21,6 +21,7 @@
 
 #include "Core/Image/ImageHelper.h"
 #include "Core/Matching/ExternalMatching.h"
+#include "Core/LogicModel/BulkInsert.h"
 #include "Core/Primitive/BoundingBox.h"
 #include "Core/Utils/DegateHelper.h"
 #include <cstdlib>
@@ -101,10 +102,11 @@ void ExternalMatching::run()
     }
     else
     {
-        for (auto plo : parse_file(results_file))
-        {
-            lmodel->add_object(layer, plo);
-        }
+        BulkInsert objects(lmodel, layer);
+        for (auto const& o : parse_file(results_file))
+            objects.add(o);
+
+        objects.commit();
     }
 
     // cleanup
@@ -0,0 +1,265 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Matching/FFTCorrelation.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+using namespace degate;
+
+namespace
+{
+    /**
+     * Radix-2 butterfly, with an explicit complex multiplication
+     * (std::complex operator* checks for infinities and NaNs).
+     */
+    inline void butterfly(std::complex<double>& a, std::complex<double>& b, std::complex<double> const& w)
+    {
+        const double
+            re = b.real() * w.real() - b.imag() * w.imag(),
+            im = b.real() * w.imag() + b.imag() * w.real();
+
+        b = std::complex<double>(a.real() - re, a.imag() - im);
+        a = std::complex<double>(a.real() + re, a.imag() + im);
+    }
+
+    /**
+     * Get the FFT block size for a template size.
+     * Larger blocks drop less wrapped results, but waste more at the border of the
+     * searched area. At least half of a block must contain valid results.
+     */
+    unsigned int get_block_size(unsigned int tmpl_size)
+    {
+        unsigned int size = 64;
+
+        while (size < 4 * tmpl_size && size < 1024)
+            size <<= 1;
+
+        while (size < 2 * tmpl_size)
+            size <<= 1;
+
+        return size;
+    }
+}
+
+FFT::FFT(unsigned int size)
+    : size(size),
+      bit_reversed(size),
+      twiddles(size / 2)
+{
+    assert(size > 0 && (size & (size - 1)) == 0);
+
+    unsigned int bits = 0;
+    while ((1u << bits) < size)
+        bits++;
+
+    for (unsigned int i = 0; i < size; i++)
+    {
+        unsigned int reversed = 0;
+        for (unsigned int b = 0; b < bits; b++)
+            if (i & (1u << b))
+                reversed |= 1u << (bits - 1 - b);
+
+        bit_reversed[i] = reversed;
+    }
+
+    for (unsigned int k = 0; k < size / 2; k++)
+    {
+        const double angle = 2.0 * M_PI * k / size;
+        twiddles[k] = std::complex<double>(cos(angle), -sin(angle));
+    }
+}
+
+void FFT::transform(std::complex<double>* data, bool inverse) const
+{
+    for (unsigned int i = 0; i < size; i++)
+    {
+        if (i < bit_reversed[i])
+            std::swap(data[i], data[bit_reversed[i]]);
+    }
+
+    for (unsigned int length = 2; length <= size; length <<= 1)
+    {
+        const unsigned int half = length / 2, step = size / length;
+
+        for (unsigned int start = 0; start < size; start += length)
+            for (unsigned int k = 0; k < half; k++)
+            {
+                const std::complex<double> w = inverse ? std::conj(twiddles[k * step]) : twiddles[k * step];
+                butterfly(data[start + k], data[start + k + half], w);
+            }
+    }
+}
+
+void FFT::transform_columns(std::complex<double>* data, unsigned int columns, bool inverse) const
+{
+    // Same as transform(), but every sample is a whole row, so rows are read contiguously
+    for (unsigned int i = 0; i < size; i++)
+    {
+        if (i < bit_reversed[i])
+            std::swap_ranges(data + i * columns, data + (i + 1) * columns, data + bit_reversed[i] * columns);
+    }
+
+    for (unsigned int length = 2; length <= size; length <<= 1)
+    {
+        const unsigned int half = length / 2, step = size / length;
+
+        for (unsigned int start = 0; start < size; start += length)
+            for (unsigned int k = 0; k < half; k++)
+            {
+                const std::complex<double> w = inverse ? std::conj(twiddles[k * step]) : twiddles[k * step];
+
+                std::complex<double>* a = data + (start + k) * columns;
+                std::complex<double>* b = data + (start + k + half) * columns;
+
+                for (unsigned int c = 0; c < columns; c++)
+                    butterfly(a[c], b[c], w);
+            }
+    }
+}
+
+FFTCorrelation::FFTCorrelation(TempImage_GS_DOUBLE_shptr zero_mean_template)
+    : tmpl_width(zero_mean_template->get_width()),
+      tmpl_height(zero_mean_template->get_height()),
+      tmpl_sum(0),
+      fft_rows(get_block_size(tmpl_width)),
+      fft_cols(get_block_size(tmpl_height))
+{
+    const unsigned int
+        block_width = fft_rows.get_size(),
+        block_height = fft_cols.get_size();
+
+    tmpl_spectrum.assign(static_cast<std::size_t>(block_width) * block_height, 0);
+
+    for (unsigned int y = 0; y < tmpl_height; y++)
+        for (unsigned int x = 0; x < tmpl_width; x++)
+        {
+            const double p = zero_mean_template->get_pixel(x, y);
+            tmpl_spectrum[y * block_width + x] = p;
+            tmpl_sum += p;
+        }
+
+    for (unsigned int y = 0; y < block_height; y++)
+        fft_rows.transform(&tmpl_spectrum[y * block_width], false);
+    fft_cols.transform_columns(tmpl_spectrum.data(), block_width, false);
+
+    // The correlation is the inverse transform of the master spectrum multiplied by the
+    // conjugate template spectrum.
+    const double normalization = 1.0 / (static_cast<double>(block_width) * block_height);
+    for (auto& v : tmpl_spectrum)
+        v = std::conj(v) * normalization;
+}
+
+void FFTCorrelation::calc_nummerators(const TileImage_GS_BYTE_shptr master,
+                                      unsigned int min_x,
+                                      unsigned int min_y,
+                                      unsigned int width,
+                                      unsigned int height,
+                                      double* results) const
+{
+    const unsigned int
+        block_width = fft_rows.get_size(),
+        block_height = fft_cols.get_size(),
+        valid_width = block_width - tmpl_width + 1,
+        valid_height = block_height - tmpl_height + 1;
+
+    // Block origins, relative to (min_x, min_y)
+    std::vector<std::pair<unsigned int, unsigned int>> blocks;
+    for (unsigned int y = 0; y < height; y += valid_height)
+        for (unsigned int x = 0; x < width; x += valid_width)
+            blocks.emplace_back(x, y);
+
+    std::shared_ptr<const TileImage_GS_BYTE> view = master;
+    std::vector<std::complex<double>> buffer(static_cast<std::size_t>(block_width) * block_height);
+
+    // The master image and the template are real, so two blocks are transformed at once:
+    // the first one as the real part, the second one as the imaginary part.
+    for (unsigned int i = 0; i < blocks.size(); i += 2)
+    {
+        const unsigned int parts = std::min<unsigned int>(2, static_cast<unsigned int>(blocks.size()) - i);
+
+        std::fill(buffer.begin(), buffer.end(), std::complex<double>(0, 0));
+
+        for (unsigned int part = 0; part < parts; part++)
+        {
+            const unsigned int
+                block_x = min_x + blocks[i + part].first,
+                block_y = min_y + blocks[i + part].second;
+
+            for (unsigned int row = 0; row < block_height && block_y + row < master->get_height(); row++)
+            {
+                std::complex<double>* dst = &buffer[row * block_width];
+
+                for_each_row_segment(view, block_x, block_y + row, block_width,
+                                     [&](unsigned int x, const gs_byte_pixel_t* pixels, unsigned int length)
+                                     {
+                                         for (unsigned int k = 0; k < length; k++)
+                                         {
+                                             if (part == 0)
+                                                 dst[x - block_x + k].real(pixels[k]);
+                                             else
+                                                 dst[x - block_x + k].imag(pixels[k]);
+                                         }
+                                     });
+            }
+        }
+
+        for (unsigned int row = 0; row < block_height; row++)
+            fft_rows.transform(&buffer[row * block_width], false);
+        fft_cols.transform_columns(buffer.data(), block_width, false);
+
+        for (std::size_t k = 0; k < buffer.size(); k++)
+        {
+            const std::complex<double> a = buffer[k], b = tmpl_spectrum[k];
+            buffer[k] = std::complex<double>(a.real() * b.real() - a.imag() * b.imag(),
+                                             a.real() * b.imag() + a.imag() * b.real());
+        }
+
+        // Rows below the valid height contain wrapped results only
+        fft_cols.transform_columns(buffer.data(), block_width, true);
+        for (unsigned int row = 0; row < valid_height; row++)
+            fft_rows.transform(&buffer[row * block_width], true);
+
+        for (unsigned int part = 0; part < parts; part++)
+        {
+            const unsigned int
+                block_x = blocks[i + part].first,
+                block_y = blocks[i + part].second;
+
+            for (unsigned int row = 0; row < valid_height && block_y + row < height; row++)
+            {
+                const std::complex<double>* src = &buffer[row * block_width];
+                double* dst = results + static_cast<std::size_t>(block_y + row) * width + block_x;
+
+                const unsigned int count = std::min(valid_width, width - block_x);
+                for (unsigned int k = 0; k < count; k++)
+                    dst[k] = part == 0 ? src[k].real() : src[k].imag();
+            }
+        }
+    }
+}
@@ -0,0 +1,152 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __FFTCORRELATION_H__
+#define __FFTCORRELATION_H__
+
+#include "Core/Image/Image.h"
+
+#include <complex>
+#include <memory>
+#include <vector>
+
+namespace degate
+{
+    /**
+     * In-place radix-2 complex FFT, for a fixed size.
+     */
+    class FFT
+    {
+    public:
+
+        /**
+         * Create a FFT.
+         *
+         * @param size The number of samples, it must be a power of 2.
+         */
+        explicit FFT(unsigned int size = 1);
+
+        inline unsigned int get_size() const
+        {
+            return size;
+        }
+
+        /**
+         * Transform \p size contiguous samples.
+         * The inverse transform is not normalized.
+         */
+        void transform(std::complex<double>* data, bool inverse) const;
+
+        /**
+         * Transform every column of a row-major array of \p size rows.
+         * The inverse transform is not normalized.
+         *
+         * @param columns The number of columns (the row length).
+         */
+        void transform_columns(std::complex<double>* data, unsigned int columns, bool inverse) const;
+
+    private:
+
+        unsigned int size;
+        std::vector<unsigned int> bit_reversed;
+        std::vector<std::complex<double>> twiddles;
+    };
+
+    /**
+     * Cross correlation of a template with an image in the frequency domain.
+     *
+     * The image is processed in blocks with overlap-save FFTs: a block of
+     * the image is transformed, multiplied by the conjugate template spectrum
+     * and transformed back. Results wrapping around the block are dropped,
+     * so blocks overlap by the template size.
+     */
+    class FFTCorrelation
+    {
+    public:
+
+        /**
+         * Prepare the template spectrum.
+         *
+         * @param zero_mean_template The template, usually zero-mean.
+         */
+        explicit FFTCorrelation(TempImage_GS_DOUBLE_shptr zero_mean_template);
+
+        inline unsigned int get_template_width() const
+        {
+            return tmpl_width;
+        }
+
+        inline unsigned int get_template_height() const
+        {
+            return tmpl_height;
+        }
+
+        /**
+         * Get the sum over the template pixels.
+         */
+        inline double get_template_sum() const
+        {
+            return tmpl_sum;
+        }
+
+        /**
+         * Get the memory used by the template spectrum (in bytes).
+         */
+        inline std::size_t get_memory_size() const
+        {
+            return tmpl_spectrum.size() * sizeof(std::complex<double>);
+        }
+
+        /**
+         * Calculate the correlation nummerators sum(master(x + i, y + j) * tmpl(i, j))
+         * for an area of template positions. Pixels outside of \p master are zero.
+         *
+         * This is thread-safe.
+         *
+         * @param master The image where we look for matchings.
+         * @param min_x The first position in \p master.
+         * @param min_y The first position in \p master.
+         * @param width The number of positions per row.
+         * @param height The number of rows.
+         * @param results The nummerators, row by row (width * height values).
+         */
+        void calc_nummerators(const TileImage_GS_BYTE_shptr master,
+                              unsigned int min_x,
+                              unsigned int min_y,
+                              unsigned int width,
+                              unsigned int height,
+                              double* results) const;
+
+    private:
+
+        unsigned int tmpl_width, tmpl_height;
+        double tmpl_sum;
+
+        FFT fft_rows, fft_cols;
+
+        // conjugate template spectrum, with the inverse transform normalization
+        std::vector<std::complex<double>> tmpl_spectrum;
+    };
+
+    typedef std::shared_ptr<FFTCorrelation> FFTCorrelation_shptr;
+}
+
+#endif
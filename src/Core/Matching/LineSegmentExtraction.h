@@ -25,8 +25,15 @@
 #include "Core/Image/Image.h"
 #include "Core/Image/Manipulation/ImageManipulation.h"
 #include "Core/Primitive/Line.h"
-#include <memory>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
 #include <fstream>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace degate
 {
@@ -71,24 +78,27 @@ namespace degate
      */
     class LineSegment : public LinearPrimitive
     {
-    private:
-        std::list<LinearPrimitive_shptr> segments;
     public:
         LineSegment(LinearPrimitive_shptr lp) :
             LinearPrimitive(lp->get_from_x(), lp->get_from_y(), lp->get_to_x(), lp->get_to_y())
         {
         }
 
-        void merge(LineSegment_shptr seg)
+        LineSegment(int from_x, int from_y, int to_x, int to_y) :
+            LinearPrimitive(from_x, from_y, to_x, to_y)
+        {
+        }
+
+        void merge(LineSegment const& seg)
         {
             //std::cout << "merging lines:" << std::endl;
             //print();
-            //seg->print();
+            //seg.print();
 
             Point a1 = get_p1();
             Point a2 = get_p2();
-            Point b1 = seg->get_p1();
-            Point b2 = seg->get_p2();
+            Point b1 = seg.get_p1();
+            Point b2 = seg.get_p2();
 
             unsigned int a1b1 = a1.get_distance(b1);
             unsigned int a1b2 = a1.get_distance(b2);
@@ -134,6 +144,53 @@ namespace degate
             //std::cout << "Result: " << std::endl;
             //print();
         }
+
+        /**
+         * Check if a segment is adjacent: same orientation, an endpoint of each segment
+         * within \p search_radius_along and both segments within a band narrower than
+         * \p search_radius_across.
+         */
+        bool is_adjacent(LineSegment const& seg,
+                         unsigned int search_radius_along,
+                         unsigned int search_radius_across) const
+        {
+            if (seg.get_orientation() != get_orientation())
+                return false;
+
+            Point a1 = get_p1();
+            Point a2 = get_p2();
+            Point b1 = seg.get_p1();
+            Point b2 = seg.get_p2();
+
+            if (a1.get_distance(b1) <= search_radius_along ||
+                a1.get_distance(b2) <= search_radius_along ||
+                a2.get_distance(b1) <= search_radius_along ||
+                a2.get_distance(b2) <= search_radius_along)
+            {
+                if (get_orientation() == LineSegment::HORIZONTAL)
+                {
+                    int _min = std::min(a1.get_y(),
+                                        std::min(a2.get_y(),
+                                                 std::min(b1.get_y(), b2.get_y())));
+                    int _max = std::max(a1.get_y(),
+                                        std::max(a2.get_y(),
+                                                 std::max(b1.get_y(), b2.get_y())));
+                    return (unsigned int)(_max - _min) < search_radius_across;
+                }
+                else
+                {
+                    int _min = std::min(a1.get_x(),
+                                        std::min(a2.get_x(),
+                                                 std::min(b1.get_x(), b2.get_x())));
+                    int _max = std::max(a1.get_x(),
+                                        std::max(a2.get_x(),
+                                                 std::max(b1.get_x(), b2.get_x())));
+                    return (unsigned int)(_max - _min) < search_radius_across;
+                }
+            }
+
+            return false;
+        }
     };
 
 
@@ -141,18 +198,31 @@ namespace degate
 
     /**
      * Line segment map.
+     *
+     * Segments are stored by value, in a contiguous pool. While merging, the segment
+     * endpoints are indexed in a uniform grid per orientation, so that adjacency queries
+     * only visit the cells around the endpoints instead of every segment.
      */
     class LineSegmentMap
     {
     public:
 
-        typedef std::list<LineSegment_shptr> list_type;
-        typedef list_type::iterator iterator;
-        typedef list_type::const_iterator const_iterator;
+        typedef std::vector<LineSegment> pool_type;
+        typedef pool_type::iterator iterator;
+        typedef pool_type::const_iterator const_iterator;
 
     private:
 
-        list_type lines;
+        pool_type lines;
+
+        // Merge state: endpoints grid (one per orientation), position of the segments
+        // in the merge queue and merged segments.
+        typedef std::unordered_map<std::uint64_t, std::vector<unsigned int>> grid_type;
+
+        grid_type grids[2];
+        float cell_size = 1;
+        std::vector<std::uint64_t> queue_positions;
+        std::vector<bool> removed;
 
     public:
 
@@ -160,107 +230,93 @@ namespace degate
         {
         }
 
-        void erase(iterator iter)
-        {
-            lines.erase(iter);
-        }
-
         size_t size() const
         {
             return lines.size();
         }
 
-
-        void add(LineSegment_shptr segment)
+        void add(LineSegment const& segment)
         {
             lines.push_back(segment);
         }
 
-        void erase(LineSegment_shptr segment)
-        {
-            iterator iter = find(lines.begin(), lines.end(), segment);
-            if (iter != lines.end())
-                lines.erase(iter);
-        }
-
         iterator begin() { return lines.begin(); }
         iterator end() { return lines.end(); }
         const_iterator begin() const { return lines.begin(); }
         const_iterator end() const { return lines.end(); }
 
-        LineSegment_shptr find_adjacent(LineSegment_shptr elem,
-                                        unsigned int search_radius_along,
-                                        unsigned int search_radius_across) const
+        /**
+         * Merge adjacent segments.
+         *
+         * Segments are taken from a rotating queue and merged with the first adjacent
+         * segment in queue order. The search radius along the segments grows from 1
+         * to \p search_radius_along + 1, once a whole round found nothing to merge.
+         * The map keeps the queue order.
+         */
+        void merge(unsigned int search_radius_along,
+                   unsigned int search_radius_across)
         {
-            for (auto elem2 : *this)
+            if (lines.empty())
+                return;
+
+            const auto count = static_cast<unsigned int>(lines.size());
+
+            // Cells are as large as the largest search radius, so the neighbour cells
+            // of an endpoint contain every endpoint within the search radius.
+            cell_size = static_cast<float>(search_radius_along + 1);
+
+            for (auto& grid : grids)
             {
-                if (elem != elem2 && elem2->get_orientation() == elem->get_orientation())
-                {
-                    Point a1 = elem->get_p1();
-                    Point a2 = elem->get_p2();
-                    Point b1 = elem2->get_p1();
-                    Point b2 = elem2->get_p2();
+                grid.clear();
+                grid.reserve(count);
+            }
 
+            for (unsigned int i = 0; i < count; i++)
+                insert_in_grid(i);
 
-                    if (a1.get_distance(b1) <= search_radius_along ||
-                        a1.get_distance(b2) <= search_radius_along ||
-                        a2.get_distance(b1) <= search_radius_along ||
-                        a2.get_distance(b2) <= search_radius_along)
-                    {
-                        if (elem->get_orientation() == LineSegment::HORIZONTAL)
-                        {
-                            int _min = std::min(a1.get_y(),
-                                                std::min(a2.get_y(),
-                                                         std::min(b1.get_y(), b2.get_y())));
-                            int _max = std::max(a1.get_y(),
-                                                std::max(a2.get_y(),
-                                                         std::max(b1.get_y(), b2.get_y())));
-                            if ((unsigned int)(_max - _min) < search_radius_across) return elem2;
-                        }
-                        else
-                        {
-                            int _min = std::min(a1.get_x(),
-                                                std::min(a2.get_x(),
-                                                         std::min(b1.get_x(), b2.get_x())));
-                            int _max = std::max(a1.get_x(),
-                                                std::max(a2.get_x(),
-                                                         std::max(b1.get_x(), b2.get_x())));
-
-                            if ((unsigned int)(_max - _min) < search_radius_across) return elem2;
-                        }
-                    }
-                }
+            std::deque<unsigned int> queue;
+            queue_positions.resize(count);
+            for (unsigned int i = 0; i < count; i++)
+            {
+                queue.push_back(i);
+                queue_positions[i] = i;
             }
-            return LineSegment_shptr();
-        }
 
-        void merge(unsigned int search_radius_along,
-                   unsigned int search_radius_across)
-        {
+            std::uint64_t next_position = count;
+            removed.assign(count, false);
+            unsigned int remaining = count;
+
             unsigned int counter = 0;
-            unsigned int max_rounds = static_cast<unsigned int>(lines.size());
+            unsigned int max_rounds = count;
             int distance = 1;
             int max_distance = search_radius_along;
-            bool running = lines.size() > 0;
+            bool running = true;
 
             while (running)
             {
-                debug(TM, "#segments: %lu", lines.size());
                 running = false;
 
-                LineSegment_shptr ls = lines.front();
-                lines.pop_front();
+                // Merged segments are dropped from the queue lazily
+                while (removed[queue.front()])
+                    queue.pop_front();
 
-                LineSegment_shptr ls2 = find_adjacent(ls, distance, search_radius_across);
-                if (ls2 != nullptr)
+                const unsigned int ls = queue.front();
+                queue.pop_front();
+
+                const int ls2 = find_adjacent(ls, distance, search_radius_across);
+                if (ls2 >= 0)
                 {
                     running = true;
+
                     // We could check here if line segments differ in their angles
-                    ls->merge(ls2);
+                    remove_from_grid(ls);
+                    remove_from_grid(ls2);
 
-                    iterator found = find(lines.begin(), lines.end(), ls2);
-                    assert(found != lines.end());
-                    lines.erase(found);
+                    lines[ls].merge(lines[ls2]);
+
+                    insert_in_grid(ls);
+                    removed[ls2] = true;
+                    remaining--;
                 }
                 else
                 {
@@ -270,6 +326,8 @@ namespace degate
                     {
                         if (distance <= max_distance)
                         {
+                            debug(TM, "#segments: %u", remaining);
+
                             distance++;
                             counter = 0;
                             running = true;
@@ -278,8 +336,26 @@ namespace degate
                     }
                 }
 
-                lines.push_back(ls);
+                queue.push_back(ls);
+                queue_positions[ls] = next_position++;
             }
+
+            pool_type merged;
+            merged.reserve(remaining);
+
+            for (auto i : queue)
+            {
+                if (!removed[i])
+                    merged.push_back(lines[i]);
+            }
+
+            lines.swap(merged);
+
+            for (auto& grid : grids)
+                grid_type().swap(grid);
+
+            std::vector<std::uint64_t>().swap(queue_positions);
+            std::vector<bool>().swap(removed);
         }
 
         void write() const
@@ -287,19 +363,113 @@ namespace degate
             std::ofstream myfile;
             myfile.open("/tmp/example.txt");
 
-            for (auto e : *this)
+            for (auto const& e : *this)
             {
-                if (e->get_length() > 0)
+                if (e.get_length() > 0)
                 {
                     myfile << "line "
-                        << e->get_from_x() << "," << e->get_from_y()
+                        << e.get_from_x() << "," << e.get_from_y()
                         << " "
-                        << e->get_to_x() << "," << e->get_to_y()
+                        << e.get_to_x() << "," << e.get_to_y()
                         << std::endl;
                 }
             }
             myfile.close();
         }
+
+    private:
+
+        std::uint64_t get_cell(float x, float y) const
+        {
+            const auto cell_x = static_cast<std::int32_t>(std::floor(x / cell_size));
+            const auto cell_y = static_cast<std::int32_t>(std::floor(y / cell_size));
+
+            return get_cell_key(cell_x, cell_y);
+        }
+
+        static std::uint64_t get_cell_key(std::int32_t cell_x, std::int32_t cell_y)
+        {
+            return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(cell_x)) << 32) |
+                   static_cast<std::uint32_t>(cell_y);
+        }
+
+        void insert_in_grid(unsigned int index)
+        {
+            LineSegment const& ls = lines[index];
+            grid_type& grid = grids[ls.get_orientation()];
+
+            const std::uint64_t
+                cell_1 = get_cell(ls.get_from_x(), ls.get_from_y()),
+                cell_2 = get_cell(ls.get_to_x(), ls.get_to_y());
+
+            grid[cell_1].push_back(index);
+            if (cell_2 != cell_1)
+                grid[cell_2].push_back(index);
+        }
+
+        void remove_from_grid(unsigned int index)
+        {
+            LineSegment const& ls = lines[index];
+            grid_type& grid = grids[ls.get_orientation()];
+
+            for (auto cell : {get_cell(ls.get_from_x(), ls.get_from_y()), get_cell(ls.get_to_x(), ls.get_to_y())})
+            {
+                auto found = grid.find(cell);
+                if (found == grid.end())
+                    continue;
+
+                auto& indices = found->second;
+                auto pos = std::find(indices.begin(), indices.end(), index);
+                if (pos == indices.end())
+                    continue;
+
+                *pos = indices.back();
+                indices.pop_back();
+
+                if (indices.empty())
+                    grid.erase(found);
+            }
+        }
+
+        /**
+         * Find the first adjacent segment in queue order.
+         * @return Returns the segment index, or -1 if there is none.
+         */
+        int find_adjacent(unsigned int index,
+                          unsigned int search_radius_along,
+                          unsigned int search_radius_across) const
+        {
+            LineSegment const& elem = lines[index];
+            grid_type const& grid = grids[elem.get_orientation()];
+
+            int best = -1;
+
+            for (auto const& p : {elem.get_p1(), elem.get_p2()})
+            {
+                const auto cell_x = static_cast<std::int32_t>(std::floor(p.get_x() / cell_size));
+                const auto cell_y = static_cast<std::int32_t>(std::floor(p.get_y() / cell_size));
+
+                for (std::int32_t y = cell_y - 1; y <= cell_y + 1; y++)
+                    for (std::int32_t x = cell_x - 1; x <= cell_x + 1; x++)
+                    {
+                        auto found = grid.find(get_cell_key(x, y));
+                        if (found == grid.end())
+                            continue;
+
+                        for (auto other : found->second)
+                        {
+                            if (other == index ||
+                                (best >= 0 && queue_positions[other] >= queue_positions[best]))
+                                continue;
+
+                            if (elem.is_adjacent(lines[other], search_radius_along, search_radius_across))
+                                best = static_cast<int>(other);
+                        }
+                    }
+            }
+
+            return best;
+        }
     };
 
     typedef std::shared_ptr<LineSegmentMap> LineSegmentMap_shptr;
@@ -354,11 +524,7 @@ namespace degate
                     {
                         LinearPrimitive_shptr lp = trace_line_primitive(processed, x, y);
                         if (lp != nullptr)
-                        {
-                            LineSegment_shptr segment(new LineSegment(lp));
-                            //segment->print();
-                            line_segments->add(segment);
-                        }
+                            line_segments->add(LineSegment(lp));
                     }
                 }
         }
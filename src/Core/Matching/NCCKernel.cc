@@ -0,0 +1,301 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Matching/NCCKernel.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NCC_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang need the target of functions using intrinsics, MSVC does not.
+#if defined(NCC_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define NCC_KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define NCC_KERNEL_TARGET(isa)
+#endif
+
+using namespace degate;
+
+namespace
+{
+    NCCInstructionSet detect_instruction_set()
+    {
+#if !defined(NCC_KERNEL_X86)
+        return NCCInstructionSet::Scalar;
+#elif defined(_MSC_VER)
+        int info[4];
+
+        __cpuid(info, 0);
+        const int max_leaf = info[0];
+
+        __cpuid(info, 1);
+        const bool sse4_1 = (info[2] & (1 << 19)) != 0;
+        const bool fma = (info[2] & (1 << 12)) != 0;
+        const bool os_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 &&
+                            (_xgetbv(0) & 6) == 6; // xmm and ymm states saved by the OS
+
+        bool avx2 = false;
+        if (max_leaf >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+
+        if (os_avx && avx2 && fma)
+            return NCCInstructionSet::AVX2;
+
+        return sse4_1 ? NCCInstructionSet::SSE4_1 : NCCInstructionSet::Scalar;
+#else
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return NCCInstructionSet::AVX2;
+
+        return __builtin_cpu_supports("sse4.1") ? NCCInstructionSet::SSE4_1 : NCCInstructionSet::Scalar;
+#endif
+    }
+
+
+    /* -------------------------------------------------------------------------- *
+     * scalar kernels (reference)
+     * -------------------------------------------------------------------------- */
+
+    double dot_product_scalar(const std::uint8_t* master, const float* tmpl, unsigned int length)
+    {
+        double sum = 0;
+
+        for (unsigned int i = 0; i < length; i++)
+            sum += master[i] * static_cast<double>(tmpl[i]);
+
+        return sum;
+    }
+
+    void dot_product_row_scalar(const std::uint8_t* master,
+                                const float* tmpl,
+                                unsigned int length,
+                                unsigned int count,
+                                double* results)
+    {
+        for (unsigned int i = 0; i < count; i++)
+            results[i] += dot_product_scalar(master + i, tmpl, length);
+    }
+
+#ifdef NCC_KERNEL_X86
+
+    /* -------------------------------------------------------------------------- *
+     * SSE4.1 kernels (4 pixels per step)
+     * -------------------------------------------------------------------------- */
+
+    NCC_KERNEL_TARGET("sse4.1")
+    inline __m128i load_4_pixels(const std::uint8_t* master)
+    {
+        int pixels;
+        std::memcpy(&pixels, master, sizeof(pixels));
+        return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(pixels));
+    }
+
+    NCC_KERNEL_TARGET("sse4.1")
+    double dot_product_sse4_1(const std::uint8_t* master, const float* tmpl, unsigned int length)
+    {
+        __m128d acc_lo = _mm_setzero_pd();
+        __m128d acc_hi = _mm_setzero_pd();
+
+        unsigned int i = 0;
+        for (; i + 4 <= length; i += 4)
+        {
+            const __m128i m = load_4_pixels(master + i);
+            const __m128 t = _mm_loadu_ps(tmpl + i);
+
+            acc_lo = _mm_add_pd(acc_lo, _mm_mul_pd(_mm_cvtepi32_pd(m), _mm_cvtps_pd(t)));
+            acc_hi = _mm_add_pd(acc_hi, _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(m, m)),
+                                                   _mm_cvtps_pd(_mm_movehl_ps(t, t))));
+        }
+
+        const __m128d acc = _mm_add_pd(acc_lo, acc_hi);
+        double sum = _mm_cvtsd_f64(acc) + _mm_cvtsd_f64(_mm_unpackhi_pd(acc, acc));
+
+        return sum + dot_product_scalar(master + i, tmpl + i, length - i);
+    }
+
+    NCC_KERNEL_TARGET("sse4.1")
+    void dot_product_row_sse4_1(const std::uint8_t* master,
+                                const float* tmpl,
+                                unsigned int length,
+                                unsigned int count,
+                                double* results)
+    {
+        // 4 candidate positions at once, the template pixel is broadcasted
+        unsigned int i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128d acc_lo = _mm_loadu_pd(results + i);
+            __m128d acc_hi = _mm_loadu_pd(results + i + 2);
+
+            for (unsigned int k = 0; k < length; k++)
+            {
+                const __m128i m = load_4_pixels(master + i + k);
+                const __m128d t = _mm_set1_pd(tmpl[k]);
+
+                acc_lo = _mm_add_pd(acc_lo, _mm_mul_pd(_mm_cvtepi32_pd(m), t));
+                acc_hi = _mm_add_pd(acc_hi, _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(m, m)), t));
+            }
+
+            _mm_storeu_pd(results + i, acc_lo);
+            _mm_storeu_pd(results + i + 2, acc_hi);
+        }
+
+        dot_product_row_scalar(master + i, tmpl, length, count - i, results + i);
+    }
+
+
+    /* -------------------------------------------------------------------------- *
+     * AVX2 kernels (8 pixels per step)
+     * -------------------------------------------------------------------------- */
+
+    NCC_KERNEL_TARGET("avx2,fma")
+    double dot_product_avx2(const std::uint8_t* master, const float* tmpl, unsigned int length)
+    {
+        __m256d acc_lo = _mm256_setzero_pd();
+        __m256d acc_hi = _mm256_setzero_pd();
+
+        unsigned int i = 0;
+        for (; i + 8 <= length; i += 8)
+        {
+            const __m256i m = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(master + i)));
+            const __m256 t = _mm256_loadu_ps(tmpl + i);
+
+            acc_lo = _mm256_fmadd_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(m)),
+                                     _mm256_cvtps_pd(_mm256_castps256_ps128(t)), acc_lo);
+            acc_hi = _mm256_fmadd_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(m, 1)),
+                                     _mm256_cvtps_pd(_mm256_extractf128_ps(t, 1)), acc_hi);
+        }
+
+        const __m256d acc = _mm256_add_pd(acc_lo, acc_hi);
+        const __m128d acc2 = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+        double sum = _mm_cvtsd_f64(acc2) + _mm_cvtsd_f64(_mm_unpackhi_pd(acc2, acc2));
+
+        return sum + dot_product_scalar(master + i, tmpl + i, length - i);
+    }
+
+    NCC_KERNEL_TARGET("avx2,fma")
+    void dot_product_row_avx2(const std::uint8_t* master,
+                              const float* tmpl,
+                              unsigned int length,
+                              unsigned int count,
+                              double* results)
+    {
+        // 8 candidate positions at once, the template pixel is broadcasted
+        unsigned int i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256d acc_lo = _mm256_loadu_pd(results + i);
+            __m256d acc_hi = _mm256_loadu_pd(results + i + 4);
+
+            for (unsigned int k = 0; k < length; k++)
+            {
+                const __m256i m = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(master + i + k)));
+                const __m256d t = _mm256_set1_pd(tmpl[k]);
+
+                acc_lo = _mm256_fmadd_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(m)), t, acc_lo);
+                acc_hi = _mm256_fmadd_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(m, 1)), t, acc_hi);
+            }
+
+            _mm256_storeu_pd(results + i, acc_lo);
+            _mm256_storeu_pd(results + i + 4, acc_hi);
+        }
+
+        dot_product_row_scalar(master + i, tmpl, length, count - i, results + i);
+    }
+
+#endif
+}
+
+NCCInstructionSet degate::get_ncc_instruction_set()
+{
+    static const NCCInstructionSet instruction_set = detect_instruction_set();
+    return instruction_set;
+}
+
+bool degate::is_ncc_instruction_set_supported(NCCInstructionSet instruction_set)
+{
+    return static_cast<int>(instruction_set) <= static_cast<int>(get_ncc_instruction_set());
+}
+
+double degate::ncc_dot_product(const std::uint8_t* master,
+                               const float* tmpl,
+                               unsigned int length,
+                               NCCInstructionSet instruction_set)
+{
+    switch (instruction_set)
+    {
+#ifdef NCC_KERNEL_X86
+    case NCCInstructionSet::AVX2:
+        return dot_product_avx2(master, tmpl, length);
+    case NCCInstructionSet::SSE4_1:
+        return dot_product_sse4_1(master, tmpl, length);
+#endif
+    default:
+        return dot_product_scalar(master, tmpl, length);
+    }
+}
+
+void degate::ncc_dot_product_row(const std::uint8_t* master,
+                                 const float* tmpl,
+                                 unsigned int length,
+                                 unsigned int count,
+                                 double* results,
+                                 NCCInstructionSet instruction_set)
+{
+    switch (instruction_set)
+    {
+#ifdef NCC_KERNEL_X86
+    case NCCInstructionSet::AVX2:
+        dot_product_row_avx2(master, tmpl, length, count, results);
+        break;
+    case NCCInstructionSet::SSE4_1:
+        dot_product_row_sse4_1(master, tmpl, length, count, results);
+        break;
+#endif
+    default:
+        dot_product_row_scalar(master, tmpl, length, count, results);
+        break;
+    }
+}
+
+NCCTemplate::NCCTemplate(TempImage_GS_DOUBLE_shptr zero_mean_template)
+    : width(zero_mean_template->get_width()),
+      height(zero_mean_template->get_height()),
+      data(static_cast<std::size_t>(width) * height)
+{
+    for (unsigned int y = 0; y < height; y++)
+        for (unsigned int x = 0; x < width; x++)
+        {
+            float p = static_cast<float>(zero_mean_template->get_pixel(x, y));
+            data[static_cast<std::size_t>(y) * width + x] = p;
+            sum += p;
+        }
+}
@@ -0,0 +1,134 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __NCCKERNEL_H__
+#define __NCCKERNEL_H__
+
+#include "Core/Image/Image.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace degate
+{
+    /**
+     * Instruction sets supported by the NCC kernels.
+     */
+    enum class NCCInstructionSet
+    {
+        Scalar,
+        SSE4_1,
+        AVX2
+    };
+
+    /**
+     * Get the best instruction set supported by the running CPU (detected once).
+     */
+    NCCInstructionSet get_ncc_instruction_set();
+
+    /**
+     * Check if an instruction set is supported by the running CPU.
+     */
+    bool is_ncc_instruction_set_supported(NCCInstructionSet instruction_set);
+
+    /**
+     * Calculate the dot product of a master image row and a template row.
+     * Products are accumulated in double precision.
+     *
+     * @param master The master pixels.
+     * @param tmpl The template pixels.
+     * @param length The number of pixels.
+     * @param instruction_set The instruction set to use, it must be supported.
+     */
+    double ncc_dot_product(const std::uint8_t* master,
+                           const float* tmpl,
+                           unsigned int length,
+                           NCCInstructionSet instruction_set = get_ncc_instruction_set());
+
+    /**
+     * Calculate the dot products of a template row with a row of candidate
+     * positions in the master image: results[i] += dot(master + i, tmpl).
+     *
+     * @param master The master pixels, count + length - 1 pixels are read.
+     * @param tmpl The template pixels.
+     * @param length The number of template pixels.
+     * @param count The number of candidate positions.
+     * @param results The dot products are added to these values.
+     * @param instruction_set The instruction set to use, it must be supported.
+     */
+    void ncc_dot_product_row(const std::uint8_t* master,
+                             const float* tmpl,
+                             unsigned int length,
+                             unsigned int count,
+                             double* results,
+                             NCCInstructionSet instruction_set = get_ncc_instruction_set());
+
+    /**
+     * A zero-mean template, stored as contiguous float rows for the NCC kernels.
+     */
+    class NCCTemplate
+    {
+    public:
+
+        NCCTemplate() = default;
+
+        /**
+         * Create a template from a zero-mean template image.
+         */
+        explicit NCCTemplate(TempImage_GS_DOUBLE_shptr zero_mean_template);
+
+        inline unsigned int get_width() const
+        {
+            return width;
+        }
+
+        inline unsigned int get_height() const
+        {
+            return height;
+        }
+
+        inline const float* get_row(unsigned int row) const
+        {
+            return &data[static_cast<std::size_t>(row) * width];
+        }
+
+        /**
+         * Get the sum over the (float) pixels.
+         *
+         * The float pixels are not exactly zero-mean anymore. Kernels results
+         * must be corrected with this sum, otherwise the rounding error would
+         * be amplified by the master image mean.
+         */
+        inline double get_sum() const
+        {
+            return sum;
+        }
+
+    private:
+
+        unsigned int width = 0;
+        unsigned int height = 0;
+        double sum = 0;
+        std::vector<float> data;
+    };
+}
+
+#endif
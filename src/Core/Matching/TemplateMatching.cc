@@ -20,6 +20,7 @@
  */
 
 #include "Core/Matching/TemplateMatching.h"
+#include "Core/Matching/TemplateMatchingCache.h"
 #include "Core/Image/Image.h"
 #include "Globals.h"
 #include <algorithm>
@@ -27,11 +28,22 @@
 #include "Core/Image/ImageHelper.h"
 #include "Core/Image/Manipulation/MedianFilter.h"
 #include "Core/Utils/DegateHelper.h"
+#include "Core/Utils/Instrumentation.h"
 
 #include <memory>
 
 #include <utility>
 #include <cmath>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include <boost/format.hpp>
+#include <boost/range/counting_range.hpp>
+
+#include <QtConcurrent/QtConcurrent>
 
 using namespace degate;
 
@@ -48,6 +60,9 @@ TemplateMatching::TemplateMatching()
     threshold_detection = 0.70;
     max_step_size_search = 3;
     scale_down = 1;
+    correlation_mode = CorrelationMode::Automatic;
+    split_search_areas = true;
+    stats.reset();
 }
 
 TemplateMatching::~TemplateMatching()
@@ -58,35 +73,91 @@ void TemplateMatching::precalc_sum_tables(TileImage_GS_BYTE_shptr img,
                                           TileImage_GS_DOUBLE_shptr summation_table_single,
                                           TileImage_GS_DOUBLE_shptr summation_table_squared)
 {
-    unsigned int x, y;
+    assert(summation_table_single->get_tile_size() == summation_table_squared->get_tile_size());
 
-    for (y = 0; y < img->get_height(); y++)
-        for (x = 0; x < img->get_width(); x++)
+    const unsigned int
+        width = img->get_width(),
+        height = img->get_height(),
+        tile_size = summation_table_single->get_tile_size(),
+        bands = (height + tile_size - 1) / tile_size,
+        strips = (width + tile_size - 1) / tile_size;
+
+    std::shared_ptr<const TileImage_GS_BYTE> view = img;
+
+    // First pass: row prefix sums, one row of tiles per task. Sums are accumulated
+    // in integers, so they are exact.
+    std::function<void(const unsigned int& band)> row_pass = [&](const unsigned int& band)
+    {
+        const unsigned int
+            min_y = band * tile_size,
+            rows = std::min(tile_size, height - min_y);
+
+        std::vector<std::uint64_t> sum_single(rows, 0), sum_squared(rows, 0);
+
+        for (unsigned int min_x = 0; min_x < width; min_x += tile_size)
         {
-            summation_table_single->set_pixel(x, y, 0);
-            summation_table_squared->set_pixel(x, y, 0);
+            auto single = summation_table_single->get_block(min_x, min_y, tile_size, rows);
+            auto squared = summation_table_squared->get_block(min_x, min_y, tile_size, rows);
+
+            for (unsigned int row = 0; row < rows; row++)
+            {
+                double* single_row = single.get_row(row);
+                double* squared_row = squared.get_row(row);
+
+                for_each_row_segment(view, min_x, min_y + row, single.get_width(),
+                                     [&](unsigned int x, const gs_byte_pixel_t* pixels, unsigned int length)
+                                     {
+                                         for (unsigned int k = 0; k < length; k++)
+                                         {
+                                             const std::uint64_t f = pixels[k];
+                                             sum_single[row] += f;
+                                             sum_squared[row] += f * f;
+
+                                             single_row[x - min_x + k] = static_cast<double>(sum_single[row]);
+                                             squared_row[x - min_x + k] = static_cast<double>(sum_squared[row]);
+                                         }
+                                     });
+            }
         }
+    };
 
-    for (y = 0; y < img->get_height(); y++)
-        for (x = 0; x < img->get_width(); x++)
-        {
-            double f = img->get_pixel_as<gs_double_pixel_t>(x, y);
+    // Second pass: column prefix sums, one column of tiles per task. Values are
+    // integers below 2^53, additions are exact.
+    std::function<void(const unsigned int& strip)> column_pass = [&](const unsigned int& strip)
+    {
+        const unsigned int
+            min_x = strip * tile_size,
+            columns = std::min(tile_size, width - min_x);
 
-            double s_l = x > 0 ? summation_table_single->get_pixel(x - 1, y) : 0;
-            double s_o = y > 0 ? summation_table_single->get_pixel(x, y - 1) : 0;
-            double s_lo = x > 0 && y > 0 ? summation_table_single->get_pixel(x - 1, y - 1) : 0;
+        std::vector<double> sum_single(columns, 0), sum_squared(columns, 0);
 
+        for (unsigned int min_y = 0; min_y < height; min_y += tile_size)
+        {
+            auto single = summation_table_single->get_block(min_x, min_y, columns, tile_size);
+            auto squared = summation_table_squared->get_block(min_x, min_y, columns, tile_size);
 
-            double s2_l = x > 0 ? summation_table_squared->get_pixel(x - 1, y) : 0;
-            double s2_o = y > 0 ? summation_table_squared->get_pixel(x, y - 1) : 0;
-            double s2_lo = x > 0 && y > 0 ? summation_table_squared->get_pixel(x - 1, y - 1) : 0;
+            for (unsigned int row = 0; row < single.get_height(); row++)
+            {
+                double* single_row = single.get_row(row);
+                double* squared_row = squared.get_row(row);
 
-            double f1 = f + s_l + s_o - s_lo;
-            double f2 = f * f + s2_l + s2_o - s2_lo;
+                for (unsigned int x = 0; x < columns; x++)
+                {
+                    sum_single[x] += single_row[x];
+                    sum_squared[x] += squared_row[x];
 
-            summation_table_single->set_pixel(x, y, f1);
-            summation_table_squared->set_pixel(x, y, f2);
+                    single_row[x] = sum_single[x];
+                    squared_row[x] = sum_squared[x];
+                }
+            }
         }
+    };
+
+    const auto& bands_it = boost::counting_range<unsigned int>(0, bands);
+    QtConcurrent::blockingMap(bands_it, row_pass);
+
+    const auto& strips_it = boost::counting_range<unsigned int>(0, strips);
+    QtConcurrent::blockingMap(strips_it, column_pass);
 }
 
 
@@ -104,12 +175,52 @@ void TemplateMatching::init(BoundingBox const& bounding_box, Project_shptr proje
     if (this->bounding_box.get_max_y() + 1 > static_cast<int>(project->get_height()))
         this->bounding_box.set_max_y(LENGTH_TO_MAX(project->get_height()));
 
+    TemplateMatchingCache& cache = TemplateMatchingCache::get_instance();
+
+    const TemplateMatchingCache::region_key key = {layer_matching->get_layer_id(),
+                                                   layer_matching->get_image_revision(),
+                                                   static_cast<int>(bounding_box.get_min_x()),
+                                                   static_cast<int>(bounding_box.get_max_x()),
+                                                   static_cast<int>(bounding_box.get_min_y()),
+                                                   static_cast<int>(bounding_box.get_max_y()),
+                                                   get_scaling_factor()};
+
+    if (auto region = cache.get_region(key))
+    {
+        debug(TM, "Use cached background and sum tables.");
+
+        gs_img_normal = region->gs_img_normal;
+        gs_img_scaled = region->gs_img_scaled;
+        sum_table_single_normal = region->sum_table_single_normal;
+        sum_table_squared_normal = region->sum_table_squared_normal;
+        sum_table_single_scaled = region->sum_table_single_scaled;
+        sum_table_squared_scaled = region->sum_table_squared_scaled;
+
+        return;
+    }
+
     ScalingManager_shptr sm = layer_matching->get_scaling_manager();
 
+    Instrumentation& instrumentation = Instrumentation::get_instance();
+
     debug(TM, "Prepare background.");
-    prepare_background_images(sm, bounding_box, get_scaling_factor());
+    {
+        static Histogram& prepare_timer = instrumentation.get_timer("template_matching.prepare_background");
+        ScopedTimer timer(prepare_timer);
+        prepare_background_images(sm, bounding_box, get_scaling_factor());
+    }
+
     debug(TM, "Prepare sum tabes.");
-    prepare_sum_tables(gs_img_normal, gs_img_scaled);
+    {
+        static Histogram& sum_tables_timer = instrumentation.get_timer("template_matching.sum_tables");
+        ScopedTimer timer(sum_tables_timer);
+        prepare_sum_tables(gs_img_normal, gs_img_scaled);
+    }
+
+    cache.add_region(key, std::make_shared<const TemplateMatchingCache::region_images>(
+                         TemplateMatchingCache::region_images{gs_img_normal, gs_img_scaled,
+                                                              sum_table_single_normal, sum_table_squared_normal,
+                                                              sum_table_single_scaled, sum_table_squared_scaled}));
 }
 
 
@@ -214,10 +325,20 @@ void TemplateMatching::prepare_sum_tables(TileImage_GS_BYTE_shptr gs_img_normal,
 
     sum_table_single_normal = std::make_shared<TileImage_GS_DOUBLE>(w_n, h_n);
     sum_table_squared_normal = std::make_shared<TileImage_GS_DOUBLE>(w_n, h_n);
+
+    precalc_sum_tables(gs_img_normal, sum_table_single_normal, sum_table_squared_normal);
+
+    // Without scaling, the scaled image is the normal one
+    if (gs_img_scaled == gs_img_normal)
+    {
+        sum_table_single_scaled = sum_table_single_normal;
+        sum_table_squared_scaled = sum_table_squared_normal;
+        return;
+    }
+
     sum_table_single_scaled = std::make_shared<TileImage_GS_DOUBLE>(w_s, h_s);
     sum_table_squared_scaled = std::make_shared<TileImage_GS_DOUBLE>(w_s, h_s);
 
-    precalc_sum_tables(gs_img_normal, sum_table_single_normal, sum_table_squared_normal);
     precalc_sum_tables(gs_img_scaled, sum_table_single_scaled, sum_table_squared_scaled);
 }
 
@@ -249,64 +370,141 @@ void TemplateMatching::set_orientations(std::list<Gate::ORIENTATION> tmpl_orient
     }
 }
 
+std::vector<BoundingBox> TemplateMatching::get_search_areas(struct prepared_template const& tmpl) const
+{
+    std::vector<BoundingBox> search_areas;
+
+    if (!split_search_areas)
+    {
+        search_areas.push_back(bounding_box);
+        return search_areas;
+    }
+
+    const unsigned int
+        tile_size = gs_img_normal->get_tile_size(),
+        width = gs_img_normal->get_width(),
+        height = gs_img_normal->get_height(),
+        tmpl_w = tmpl.tmpl_img_normal->get_width(),
+        tmpl_h = tmpl.tmpl_img_normal->get_height();
+
+    // One search area per tile of the (cropped) background image. A scan
+    // starts one pixel after the search area origin and stops a template
+    // size before its end, hence the extension on each side.
+    for (unsigned int tile_y = 0; tile_y < height; tile_y += tile_size)
+        for (unsigned int tile_x = 0; tile_x < width; tile_x += tile_size)
+        {
+            search_areas.emplace_back(bounding_box.get_min_x() + (tile_x > 0 ? tile_x - 1 : 0),
+                                      std::min(bounding_box.get_min_x() + tile_x + tile_size + tmpl_w,
+                                               bounding_box.get_max_x()),
+                                      bounding_box.get_min_y() + (tile_y > 0 ? tile_y - 1 : 0),
+                                      std::min(bounding_box.get_min_y() + tile_y + tile_size + tmpl_h,
+                                               bounding_box.get_max_y()));
+        }
+
+    return search_areas;
+}
+
 void TemplateMatching::run()
 {
     if (is_canceled()) return;
 
     debug(TM, "run template matching");
-    std::list<match_found> matches;
 
     stats.reset();
-    set_progress_step_size(1.0 / (tmpl_set.size() * tmpl_orientations.size()));
 
-    /*
-    BOOST_FOREACH(GateTemplate_shptr tmpl, tmpl_set) {
-      BOOST_FOREACH(Gate::ORIENTATION orientation, tmpl_orientations) {
-        add_task( run2, parameter)
-      }
-    }
-  
-    wait;
-    */
+    // Every template/orientation couple is an independent job. Jobs are listed
+    // in the serial order (larger templates first).
+    std::vector<std::pair<GateTemplate_shptr, Gate::ORIENTATION>> jobs;
     for (auto tmpl : tmpl_set)
-    {
         for (auto orientation : tmpl_orientations)
-        {
-            boost::format f("Check cell \"%1%\"");
-            f % tmpl->get_name();
-            set_log_message(f.str());
+            jobs.emplace_back(tmpl, orientation);
 
-            prepared_template prep_tmpl_img = prepare_template(tmpl, orientation);
-            //match_single_template(prep_tmpl_img, t_hc, t_det);
+    std::vector<std::shared_ptr<const prepared_template>> prepared_templates(jobs.size());
 
+    std::function<void(const unsigned int& i)> prepare_function = [this, &jobs, &prepared_templates](const unsigned int& i)
+    {
+        prepared_templates[i] = get_prepared_template(jobs[i].first, jobs[i].second);
+    };
 
-            std::list<match_found> m = match_single_template(prep_tmpl_img,
-                                                             threshold_hc,
-                                                             threshold_detection);
+    const auto& jobs_it = boost::counting_range<unsigned int>(0, static_cast<unsigned int>(jobs.size()));
+    QtConcurrent::blockingMap(jobs_it, prepare_function);
 
+    // Then every job is split into search areas (one per background image tile),
+    // so a single large template can also be matched concurrently.
+    std::vector<std::pair<unsigned int, BoundingBox>> tasks;
+    for (unsigned int i = 0; i < jobs.size(); i++)
+        for (auto const& search_area : get_search_areas(*prepared_templates[i]))
+            tasks.emplace_back(i, search_area);
 
-            matches.insert(matches.end(), m.begin(), m.end());
+    set_progress_step_size(1.0 / tasks.size());
 
-            progress_step_done();
-            if (is_canceled())
-            {
-                reset_progress();
-                return;
-            }
-        }
+    // One result list per task, so workers never share a list.
+    std::vector<std::list<match_found>> task_matches(tasks.size());
+
+    // Multi-threaded function
+    std::function<void(const unsigned int& i)> function = [this, &jobs, &prepared_templates, &tasks, &task_matches](const unsigned int& i)
+    {
+        if (is_canceled())
+            return;
+
+        const unsigned int job = tasks[i].first;
+
+        boost::format f("Check cell \"%1%\"");
+        f % jobs[job].first->get_name();
+        set_log_message(f.str());
+
+        static Histogram& scan_timer = Instrumentation::get_instance().get_timer("template_matching.scan");
+        ScopedTimer timer(scan_timer);
+
+        task_matches[i] = match_single_template(*prepared_templates[job],
+                                                tasks[i].second,
+                                                threshold_hc,
+                                                threshold_detection);
+
+        progress_step_done();
+    };
+
+    // Start multithreading
+    const auto& tasks_it = boost::counting_range<unsigned int>(0, static_cast<unsigned int>(tasks.size()));
+    QtConcurrent::blockingMap(tasks_it, function);
+
+    if (is_canceled())
+    {
+        reset_progress();
+        return;
     }
 
+    // Merge in task order, so the result does not depend on the scheduling.
+    // Search areas overlap, hill climbing from two areas can end on the same
+    // position: keep the first one.
+    std::list<match_found> matches;
+    std::set<std::tuple<unsigned int, unsigned int, unsigned int>> found_positions;
+
+    for (unsigned int i = 0; i < tasks.size(); i++)
+        for (auto const& m : task_matches[i])
+        {
+            if (found_positions.insert(std::make_tuple(tasks[i].first, m.x, m.y)).second)
+                matches.push_back(m);
+        }
 
     matches.sort(compare_correlation);
 
+    static Histogram& insert_timer = Instrumentation::get_instance().get_timer("template_matching.insert");
+    ScopedTimer timer(insert_timer);
+
+    // The gates and their ports are added into the logic model at once.
+    BulkInsert gates(project->get_logic_model(), layer_insert);
+
     for (const auto& m : matches)
     {
         std::cout << "Try to insert gate of type " << m.tmpl->get_name() << " with corr="
             << m.correlation << " at " << m.x << "," << m.y << std::endl;
-        if (add_gate(m.x, m.y, m.tmpl, m.orientation, m.correlation, m.t_hc))
+        if (add_gate(m.x, m.y, m.tmpl, m.orientation, m.correlation, m.t_hc, gates))
             std::cout << "\tInserted gate of type " << m.tmpl->get_name() << std::endl;
     }
 
+    gates.commit();
+
     reset_progress();
 }
 
@@ -409,10 +607,63 @@ TemplateMatching::prepared_template TemplateMatching::prepare_template(GateTempl
     assert(prep.sum_over_zero_mean_template_normal > 0);
     assert(prep.sum_over_zero_mean_template_scaled > 0);
 
+    prep.ncc_template_normal = NCCTemplate(prep.zero_mean_template_normal);
+    prep.ncc_template_scaled = NCCTemplate(prep.zero_mean_template_scaled);
+
+    if (use_fft_correlation(w, h))
+    {
+        prep.fft_correlation_normal = std::make_shared<FFTCorrelation>(prep.zero_mean_template_normal);
+
+        if (get_scaling_factor() == 1)
+            prep.fft_correlation_scaled = prep.fft_correlation_normal;
+        else
+            prep.fft_correlation_scaled = std::make_shared<FFTCorrelation>(prep.zero_mean_template_scaled);
+    }
+
     return prep;
 }
 
 
+bool TemplateMatching::use_fft_correlation(unsigned int tmpl_width, unsigned int tmpl_height) const
+{
+    switch (correlation_mode)
+    {
+    case CorrelationMode::FFT:
+        return true;
+    case CorrelationMode::Automatic:
+        return tmpl_width * tmpl_height >= 64 * 64;
+    default:
+        return false;
+    }
+}
+
+std::shared_ptr<const TemplateMatching::prepared_template>
+TemplateMatching::get_prepared_template(GateTemplate_shptr tmpl, Gate::ORIENTATION orientation)
+{
+    GateTemplateImage_shptr tmpl_img = tmpl->get_image(layer_matching->get_layer_type());
+
+    const TemplateMatchingCache::template_key key = {tmpl->get_object_id(),
+                                                     tmpl->get_image_revision(),
+                                                     layer_matching->get_layer_type(),
+                                                     orientation,
+                                                     get_scaling_factor(),
+                                                     use_fft_correlation(tmpl_img->get_width(), tmpl_img->get_height())};
+
+    TemplateMatchingCache& cache = TemplateMatchingCache::get_instance();
+
+    auto prep = cache.get_template(key);
+    if (prep == nullptr)
+    {
+        static Histogram& prepare_timer = Instrumentation::get_instance().get_timer("template_matching.prepare_template");
+        ScopedTimer timer(prepare_timer);
+
+        prep = std::make_shared<const prepared_template>(prepare_template(tmpl, orientation));
+        cache.add_template(key, prep);
+    }
+
+    return prep;
+}
+
 void TemplateMatching::adjust_step_size(struct search_state& state, double corr_val) const
 {
     if (corr_val > 0)
@@ -426,7 +677,7 @@ void TemplateMatching::adjust_step_size(struct search_state& state, double corr_
 
 TemplateMatching::match_found
 TemplateMatching::keep_gate_match(unsigned int x, unsigned int y,
-                                  struct prepared_template& tmpl,
+                                  struct prepared_template const& tmpl,
                                   double corr_val, double threshold_hc) const
 {
     match_found hit;
@@ -442,10 +693,11 @@ TemplateMatching::keep_gate_match(unsigned int x, unsigned int y,
 bool TemplateMatching::add_gate(unsigned int x, unsigned int y,
                                 GateTemplate_shptr tmpl,
                                 Gate::ORIENTATION orientation,
-                                double corr_val, double threshold_hc)
+                                double corr_val, double threshold_hc,
+                                BulkInsert& gates)
 {
-    if (!layer_insert->exists_type_in_region<Gate>(x, x + tmpl->get_width(),
-                                                   y, y + tmpl->get_height()))
+    if (!gates.exists_type_in_region<Gate>(x, x + tmpl->get_width(),
+                                           y, y + tmpl->get_height()))
     {
         Gate_shptr gate(new Gate(x, x + tmpl->get_width(),
                                  y, y + tmpl->get_height(),
@@ -457,9 +709,7 @@ bool TemplateMatching::add_gate(unsigned int x, unsigned int y,
 
         gate->set_gate_template(tmpl);
 
-        LogicModel_shptr lmodel = project->get_logic_model();
-        lmodel->add_object(layer_insert, gate);
-        lmodel->update_ports(gate);
+        gates.add(gate);
 
         stats.hits++;
         return true;
@@ -468,7 +718,8 @@ bool TemplateMatching::add_gate(unsigned int x, unsigned int y,
 }
 
 std::list<TemplateMatching::match_found>
-TemplateMatching::match_single_template(struct prepared_template& tmpl,
+TemplateMatching::match_single_template(struct prepared_template const& tmpl,
+                                        BoundingBox const& search_area,
                                         double threshold_hc, double threshold_detection)
 {
     debug(TM, "match_single_template(): start iterating over background image");
@@ -477,27 +728,84 @@ TemplateMatching::match_single_template(struct prepared_template& tmpl,
     state.x = 1;
     state.y = 1;
     state.step_size_search = get_max_step_size();
-    state.search_area = bounding_box;
+    state.search_area = search_area;
     std::list<match_found> matches;
 
+    // position of the search area in the cropped image
+    const unsigned int
+        offset_x = static_cast<unsigned int>(search_area.get_min_x() - bounding_box.get_min_x()),
+        offset_y = static_cast<unsigned int>(search_area.get_min_y() - bounding_box.get_min_y());
+
+    // With FFTs, the correlation is calculated at once for all positions of the search
+    // area (and the hill climbing step around it). Values are then looked up.
+    correlation_surface surface_normal, surface_scaled;
+    correlation_surface const* coarse_surface = nullptr;
+
+    if (tmpl.fft_correlation_normal != nullptr)
+    {
+        const unsigned int
+            margin = get_max_step_size(),
+            area_width = static_cast<unsigned int>(search_area.get_width()),
+            area_height = static_cast<unsigned int>(search_area.get_height()),
+            min_x = offset_x > margin ? offset_x - margin : 0,
+            min_y = offset_y > margin ? offset_y - margin : 0;
+
+        surface_normal = calc_xcorr_surface(gs_img_normal,
+                                            sum_table_single_normal,
+                                            sum_table_squared_normal,
+                                            *tmpl.fft_correlation_normal,
+                                            tmpl.sum_over_zero_mean_template_normal,
+                                            min_x, min_y,
+                                            offset_x + area_width + margin - min_x,
+                                            offset_y + area_height + margin - min_y);
+
+        if (get_scaling_factor() == 1)
+            coarse_surface = &surface_normal;
+        else
+        {
+            const double scaling_factor = get_scaling_factor();
+            const unsigned int
+                scaled_min_x = lrint(offset_x / scaling_factor),
+                scaled_min_y = lrint(offset_y / scaling_factor);
+
+            surface_scaled = calc_xcorr_surface(gs_img_scaled,
+                                                sum_table_single_scaled,
+                                                sum_table_squared_scaled,
+                                                *tmpl.fft_correlation_scaled,
+                                                tmpl.sum_over_zero_mean_template_scaled,
+                                                scaled_min_x, scaled_min_y,
+                                                lrint((offset_x + area_width) / scaling_factor) - scaled_min_x + 1,
+                                                lrint((offset_y + area_height) / scaling_factor) - scaled_min_y + 1);
+            coarse_surface = &surface_scaled;
+        }
+    }
+
     double max_corr_for_search = -1;
 
     do
     {
         // works on unscaled, but cropped image
-
-        double corr_val = calc_single_xcorr(gs_img_scaled,
-                                            sum_table_single_scaled,
-                                            sum_table_squared_scaled,
-                                            tmpl.zero_mean_template_scaled,
-                                            tmpl.sum_over_zero_mean_template_scaled,
-                                            lrint(static_cast<double>(state.x) / get_scaling_factor()),
-                                            lrint(static_cast<double>(state.y) / get_scaling_factor()));
+        const unsigned int
+            x = state.x + offset_x,
+            y = state.y + offset_y,
+            scaled_x = lrint(static_cast<double>(x) / get_scaling_factor()),
+            scaled_y = lrint(static_cast<double>(y) / get_scaling_factor());
+
+        double corr_val;
+        if (coarse_surface != nullptr && coarse_surface->contains(scaled_x, scaled_y))
+            corr_val = coarse_surface->get(scaled_x, scaled_y);
+        else
+            corr_val = calc_xcorr(gs_img_scaled,
+                                  sum_table_single_scaled,
+                                  sum_table_squared_scaled,
+                                  tmpl.ncc_template_scaled,
+                                  tmpl.sum_over_zero_mean_template_scaled,
+                                  scaled_x, scaled_y);
 
         /*
-        debug(TM, "%d,%d  == %d,%d  -> %f", state.x, state.y,
-          lrint((double)state.x / get_scaling_factor()),
-          lrint((double)state.y / get_scaling_factor()),
+        debug(TM, "%d,%d  == %d,%d  -> %f", x, y,
+          lrint((double)x / get_scaling_factor()),
+          lrint((double)y / get_scaling_factor()),
           corr_val);
         */
         if (corr_val > max_corr_for_search) max_corr_for_search = corr_val;
@@ -507,13 +815,14 @@ TemplateMatching::match_single_template(struct prepared_template& tmpl,
 
         if (corr_val >= threshold_hc)
         {
-            //debug(TM, "start hill climbing at(%d,%d), corr=%f", state.x, state.y, corr_val);
+            //debug(TM, "start hill climbing at(%d,%d), corr=%f", x, y, corr_val);
             unsigned int max_corr_x, max_corr_y;
             double curr_max_val;
-            hill_climbing(state.x, state.y, corr_val,
+            hill_climbing(x, y, corr_val,
                           &max_corr_x, &max_corr_y, &curr_max_val,
-                          gs_img_normal, tmpl.zero_mean_template_normal,
-                          tmpl.sum_over_zero_mean_template_normal);
+                          gs_img_normal, tmpl.ncc_template_normal,
+                          tmpl.sum_over_zero_mean_template_normal,
+                          tmpl.fft_correlation_normal != nullptr ? &surface_normal : nullptr);
 
             //debug(TM, "hill climbing returned for (%d,%d) corr=%f", max_corr_x, max_corr_y, curr_max_val);
             if (curr_max_val >= threshold_detection)
@@ -526,8 +835,8 @@ TemplateMatching::match_single_template(struct prepared_template& tmpl,
     }
     while (get_next_pos(&state, tmpl) && !is_canceled());
 
-    std::cout << "The maximum correlation value for the current template and orientation is " << max_corr_for_search <<
-        std::endl;
+    debug(TM, "The maximum correlation value for template \"%s\" and orientation %d in the search area (%d,%d) is %f",
+          tmpl.gate_template->get_name().c_str(), tmpl.orientation, offset_x, offset_y, max_corr_for_search);
 
     return matches;
 }
@@ -538,69 +847,70 @@ void TemplateMatching::hill_climbing(unsigned int start_x, unsigned int start_y,
                                      unsigned int* max_corr_y_out,
                                      double* max_xcorr_out,
                                      const TileImage_GS_BYTE_shptr master,
-                                     const TempImage_GS_DOUBLE_shptr zero_mean_template,
-                                     double sum_over_zero_mean_template) const
+                                     NCCTemplate const& tmpl,
+                                     double sum_over_zero_mean_template,
+                                     struct correlation_surface const* surface) const
 {
+    static Histogram& hill_climbing_timer = Instrumentation::get_instance().get_timer("template_matching.hill_climbing");
+    ScopedTimer timer(hill_climbing_timer);
+
     unsigned int max_corr_x = start_x;
     unsigned int max_corr_y = start_y;
 
     double max_corr = xcorr_val;
     bool running = true;
 
-    //std::list<std::pair<unsigned int, unsigned int> > positions;
-
     const unsigned int radius = get_max_step_size();
-    const unsigned int size = (2 * radius + 1) * (2 * radius + 1);
 
-    auto positions_x = new unsigned int[size];
-    auto positions_y = new unsigned int[size];
+    std::vector<double> row_corr(2 * radius + 1);
 
     while (running)
     {
         running = false;
 
-        // first generate positions
+        // positions are generated around the maximum at the beginning of the step
+        const unsigned int
+            center_x = max_corr_x,
+            center_y = max_corr_y,
+            from_x = center_x >= radius ? center_x - radius : 0,
+            from_y = center_y >= radius ? center_y - radius : 0,
+            to_x = center_x + radius < master->get_width() ? center_x + radius : master->get_width(),
+            to_y = center_y + radius < master->get_height() ? center_y + radius : master->get_height();
 
-        unsigned int
-            from_x = max_corr_x >= radius ? max_corr_x - radius : 0,
-            from_y = max_corr_y >= radius ? max_corr_y - radius : 0,
-            to_x = max_corr_x + radius < master->get_width() ? max_corr_x + radius : master->get_width(),
-            to_y = max_corr_y + radius < master->get_height() ? max_corr_y + radius : master->get_height();
+        if (from_x >= to_x)
+            break;
 
-        unsigned int i = 0;
-        for (unsigned int _y = from_y; _y < to_y; _y++)
-            for (unsigned int _x = from_x; _x < to_x; _x++)
-            {
-                if (max_corr_x != _x && max_corr_y != _y)
-                {
-                    //positions.push_back(std::pair<unsigned int, unsigned int>(_x, _y));
-                    positions_x[i] = _x;
-                    positions_y[i] = _y;
-                    i++;
-                }
-            }
-
-        // check for position with highest correlation value
-        for (unsigned int i2 = 0; i2 < i; i2++)
+        // check for position with highest correlation value, row by row
+        for (unsigned int y = from_y; y < to_y; y++)
         {
-            unsigned int x = positions_x[i2], y = positions_y[i2];
-
-            //debug(TM, "hill climbing step at (%d,%d)", x, y);
+            if (y == center_y)
+                continue;
 
-            double curr_corr_val = calc_single_xcorr(master,
-                                                     sum_table_single_normal,
-                                                     sum_table_squared_normal,
-                                                     zero_mean_template,
-                                                     sum_over_zero_mean_template,
-                                                     x, y);
-
-            if (curr_corr_val > max_corr)
+            if (surface != nullptr && surface->contains(from_x, y) && surface->contains(to_x - 1, y))
             {
-                max_corr_x = x;
-                max_corr_y = y;
-                max_corr = curr_corr_val;
-                running = true;
-                //positions.clear();
+                for (unsigned int x = from_x; x < to_x; x++)
+                    row_corr[x - from_x] = surface->get(x, y);
+            }
+            else
+                calc_xcorr_row(master,
+                               sum_table_single_normal,
+                               sum_table_squared_normal,
+                               tmpl,
+                               sum_over_zero_mean_template,
+                               from_x, y, to_x - from_x,
+                               row_corr.data());
+
+            for (unsigned int x = from_x; x < to_x; x++)
+            {
+                const double curr_corr_val = row_corr[x - from_x];
+
+                if (x != center_x && curr_corr_val > max_corr)
+                {
+                    max_corr_x = x;
+                    max_corr_y = y;
+                    max_corr = curr_corr_val;
+                    running = true;
+                }
             }
         }
     }
@@ -608,9 +918,6 @@ void TemplateMatching::hill_climbing(unsigned int start_x, unsigned int start_y,
     *max_corr_x_out = max_corr_x;
     *max_corr_y_out = max_corr_y;
     *max_xcorr_out = max_corr;
-
-    delete[] positions_x;
-    delete[] positions_y;
 }
 
 
@@ -690,6 +997,222 @@ double TemplateMatching::calc_single_xcorr(const TileImage_GS_BYTE_shptr master,
     return q;
 }
 
+double TemplateMatching::calc_xcorr_denominator(const TileImage_GS_DOUBLE_shptr summation_table_single,
+                                                const TileImage_GS_DOUBLE_shptr summation_table_squared,
+                                                unsigned int tmpl_width,
+                                                unsigned int tmpl_height,
+                                                double sum_over_zero_mean_template,
+                                                unsigned int local_x,
+                                                unsigned int local_y,
+                                                double* mean) const
+{
+    double template_size = tmpl_width * tmpl_height;
+
+    unsigned int
+        x_plus_w = local_x + tmpl_width - 1,
+        y_plus_h = local_y + tmpl_height - 1,
+        lxm1 = local_x - 1, // can wrap, it's checked later
+        lym1 = local_y - 1;
+
+    double
+        f1 = summation_table_single->get_pixel(x_plus_w, y_plus_h),
+        f2 = summation_table_squared->get_pixel(x_plus_w, y_plus_h);
+
+    if (local_x > 0)
+    {
+        f1 -= summation_table_single->get_pixel(lxm1, y_plus_h);
+        f2 -= summation_table_squared->get_pixel(lxm1, y_plus_h);
+    }
+    if (local_y > 0)
+    {
+        f1 -= summation_table_single->get_pixel(x_plus_w, lym1);
+        f2 -= summation_table_squared->get_pixel(x_plus_w, lym1);
+    }
+    if (local_x > 0 && local_y > 0)
+    {
+        f1 += summation_table_single->get_pixel(lxm1, lym1);
+        f2 += summation_table_squared->get_pixel(lxm1, lym1);
+    }
+
+    *mean = f1 / template_size;
+
+    return sqrt((f2 - f1 * f1 / template_size) * sum_over_zero_mean_template);
+}
+
+double TemplateMatching::calc_xcorr(const TileImage_GS_BYTE_shptr master,
+                                    const TileImage_GS_DOUBLE_shptr summation_table_single,
+                                    const TileImage_GS_DOUBLE_shptr summation_table_squared,
+                                    NCCTemplate const& tmpl,
+                                    double sum_over_zero_mean_template,
+                                    unsigned int local_x,
+                                    unsigned int local_y) const
+{
+    const unsigned int w = tmpl.get_width(), h = tmpl.get_height();
+    assert(w > 0 && h > 0);
+
+    if (local_x + w > master->get_width() || local_y + h > master->get_height())
+        return -1.0;
+
+    double mean;
+    double denominator = calc_xcorr_denominator(summation_table_single, summation_table_squared,
+                                                w, h, sum_over_zero_mean_template,
+                                                local_x, local_y, &mean);
+
+    if (std::isinf(denominator) || std::isnan(denominator) || denominator == 0)
+        return -1.0;
+
+    // The master window is read row by row, directly from the tiles
+    std::shared_ptr<const TileImage_GS_BYTE> view = master;
+    double nummerator = 0;
+
+    const auto block = view->get_block(local_x, local_y, w, h);
+    if (block.get_width() == w && block.get_height() == h)
+    {
+        for (unsigned int row = 0; row < h; row++)
+            nummerator += ncc_dot_product(block.get_row(row), tmpl.get_row(row), w);
+    }
+    else
+    {
+        // the window crosses a tile border
+        for (unsigned int row = 0; row < h; row++)
+            for_each_row_segment(view, local_x, local_y + row, w,
+                                 [&](unsigned int x, const gs_byte_pixel_t* pixels, unsigned int length)
+                                 {
+                                     nummerator += ncc_dot_product(pixels, tmpl.get_row(row) + (x - local_x), length);
+                                 });
+    }
+
+    // The float template is not exactly zero-mean, remove the master mean contribution
+    double q = (nummerator - mean * tmpl.get_sum()) / denominator;
+
+    assert(q >= -1.1 && q <= 1.1);
+    return q;
+}
+
+void TemplateMatching::calc_xcorr_row(const TileImage_GS_BYTE_shptr master,
+                                      const TileImage_GS_DOUBLE_shptr summation_table_single,
+                                      const TileImage_GS_DOUBLE_shptr summation_table_squared,
+                                      NCCTemplate const& tmpl,
+                                      double sum_over_zero_mean_template,
+                                      unsigned int local_x,
+                                      unsigned int local_y,
+                                      unsigned int count,
+                                      double* results) const
+{
+    const unsigned int w = tmpl.get_width(), h = tmpl.get_height();
+    assert(w > 0 && h > 0);
+
+    // Only positions where the template fits in the master image are calculated
+    unsigned int valid_count = 0;
+    if (local_x + w <= master->get_width() && local_y + h <= master->get_height())
+        valid_count = std::min(count, master->get_width() - w - local_x + 1);
+
+    std::fill(results, results + valid_count, 0.0);
+    std::fill(results + valid_count, results + count, -1.0);
+
+    if (valid_count == 0)
+        return;
+
+    // Calculate the nummerators, row by row
+    std::shared_ptr<const TileImage_GS_BYTE> view = master;
+    const unsigned int span = valid_count + w - 1;
+
+    const auto block = view->get_block(local_x, local_y, span, h);
+    if (block.get_width() == span && block.get_height() == h)
+    {
+        for (unsigned int row = 0; row < h; row++)
+            ncc_dot_product_row(block.get_row(row), tmpl.get_row(row), w, valid_count, results);
+    }
+    else
+    {
+        // the windows cross a tile border, copy the rows
+        std::vector<gs_byte_pixel_t> pixels(span);
+
+        for (unsigned int row = 0; row < h; row++)
+        {
+            for_each_row_segment(view, local_x, local_y + row, span,
+                                 [&](unsigned int x, const gs_byte_pixel_t* segment, unsigned int length)
+                                 {
+                                     std::copy(segment, segment + length, pixels.begin() + (x - local_x));
+                                 });
+
+            ncc_dot_product_row(pixels.data(), tmpl.get_row(row), w, valid_count, results);
+        }
+    }
+
+    for (unsigned int i = 0; i < valid_count; i++)
+    {
+        double mean;
+        double denominator = calc_xcorr_denominator(summation_table_single, summation_table_squared,
+                                                    w, h, sum_over_zero_mean_template,
+                                                    local_x + i, local_y, &mean);
+
+        if (std::isinf(denominator) || std::isnan(denominator) || denominator == 0)
+            results[i] = -1.0;
+        else
+        {
+            results[i] = (results[i] - mean * tmpl.get_sum()) / denominator;
+            assert(results[i] >= -1.1 && results[i] <= 1.1);
+        }
+    }
+}
+
+TemplateMatching::correlation_surface
+TemplateMatching::calc_xcorr_surface(const TileImage_GS_BYTE_shptr master,
+                                     const TileImage_GS_DOUBLE_shptr summation_table_single,
+                                     const TileImage_GS_DOUBLE_shptr summation_table_squared,
+                                     FFTCorrelation const& tmpl,
+                                     double sum_over_zero_mean_template,
+                                     unsigned int min_x,
+                                     unsigned int min_y,
+                                     unsigned int width,
+                                     unsigned int height) const
+{
+    correlation_surface surface;
+
+    const unsigned int w = tmpl.get_template_width(), h = tmpl.get_template_height();
+    if (w > master->get_width() || h > master->get_height())
+        return surface;
+
+    // Only positions where the template fits in the master image are calculated
+    const unsigned int
+        max_x = std::min(min_x + width, master->get_width() - w + 1),
+        max_y = std::min(min_y + height, master->get_height() - h + 1);
+
+    if (min_x >= max_x || min_y >= max_y)
+        return surface;
+
+    surface.min_x = min_x;
+    surface.min_y = min_y;
+    surface.width = max_x - min_x;
+    surface.height = max_y - min_y;
+    surface.values.resize(static_cast<std::size_t>(surface.width) * surface.height);
+
+    tmpl.calc_nummerators(master, min_x, min_y, surface.width, surface.height, surface.values.data());
+
+    for (unsigned int y = min_y; y < max_y; y++)
+        for (unsigned int x = min_x; x < max_x; x++)
+        {
+            double& value = surface.values[static_cast<std::size_t>(y - min_y) * surface.width + (x - min_x)];
+
+            double mean;
+            double denominator = calc_xcorr_denominator(summation_table_single, summation_table_squared,
+                                                        w, h, sum_over_zero_mean_template,
+                                                        x, y, &mean);
+
+            if (std::isinf(denominator) || std::isnan(denominator) || denominator == 0)
+                value = -1.0;
+            else
+            {
+                // The template sum is not exactly zero, remove the master mean contribution
+                value = (value - mean * tmpl.get_template_sum()) / denominator;
+                assert(value >= -1.1 && value <= 1.1);
+            }
+        }
+
+    return surface;
+}
+
 bool TemplateMatchingNormal::get_next_pos(struct search_state* state,
                                           struct prepared_template const& tmpl) const
 {
@@ -25,7 +25,12 @@
 #include "Core/Image/Image.h"
 #include "Core/Project/Project.h"
 #include "Core/LogicModel/Layer.h"
+#include "Core/LogicModel/BulkInsert.h"
 #include "Core/Utils/ProgressControl.h"
+#include "Core/Matching/NCCKernel.h"
+#include "Core/Matching/FFTCorrelation.h"
+
+#include <vector>
 
 namespace degate
 {
@@ -58,12 +63,19 @@ namespace degate
     };
 
 
+    class TemplateMatchingCache;
+
     /**
      * This class implements the matching of gate representing images on
      * a background image.
+     *
+     * Prepared templates and background images are kept in the
+     * TemplateMatchingCache, to be reused by the next matching runs.
      */
     class TemplateMatching : public Matching
     {
+        friend class TemplateMatchingCache;
+
     protected:
 
         struct prepared_template
@@ -80,6 +92,14 @@ namespace degate
             double sum_over_zero_mean_template_normal;
             double sum_over_zero_mean_template_scaled;
 
+            // zero-mean templates for the NCC kernels
+            NCCTemplate ncc_template_normal;
+            NCCTemplate ncc_template_scaled;
+
+            // template spectrums, only set if the correlation is calculated with FFTs
+            FFTCorrelation_shptr fft_correlation_normal;
+            FFTCorrelation_shptr fft_correlation_scaled;
+
             Gate::ORIENTATION orientation;
             GateTemplate_shptr gate_template;
         };
@@ -98,10 +118,40 @@ namespace degate
                             iter_end;
         };
 
+        /**
+         * Correlation values for an area of template positions.
+         */
+        struct correlation_surface
+        {
+            unsigned int min_x = 0, min_y = 0; // first position, in the cropped image
+            unsigned int width = 0, height = 0;
+            std::vector<double> values; // row by row
+
+            bool contains(unsigned int x, unsigned int y) const
+            {
+                return x >= min_x && x < min_x + width && y >= min_y && y < min_y + height;
+            }
+
+            double get(unsigned int x, unsigned int y) const
+            {
+                return values[static_cast<std::size_t>(y - min_y) * width + (x - min_x)];
+            }
+        };
+
         struct TemplateMatchingStatistics stats;
 
     public:
 
+        /**
+         * How correlation values are calculated.
+         */
+        enum class CorrelationMode
+        {
+            Direct, // NCC kernels, position by position
+            FFT, // full correlation surface, with FFTs
+            Automatic // FFTs for large templates only
+        };
+
         typedef struct
         {
             unsigned int x, y; // absolut coordinates of the left upper corner
@@ -118,6 +168,8 @@ namespace degate
         double threshold_detection;
         unsigned int max_step_size_search;
         unsigned int scale_down;
+        CorrelationMode correlation_mode;
+        bool split_search_areas;
 
         // background images in greyscale
         TileImage_GS_BYTE_shptr gs_img_normal;
@@ -151,11 +203,6 @@ namespace degate
         void prepare_sum_tables(TileImage_GS_BYTE_shptr gs_img_normal,
                                 TileImage_GS_BYTE_shptr gs_img_scaled);
 
-        void precalc_sum_tables(TileImage_GS_BYTE_shptr img,
-                                TileImage_GS_DOUBLE_shptr summation_table_single,
-                                TileImage_GS_DOUBLE_shptr summation_table_squared);
-
-
         BoundingBox get_scaled_bounding_box(BoundingBox const& bounding_box,
                                             double scale_down) const;
 
@@ -166,25 +213,94 @@ namespace degate
         struct prepared_template prepare_template(GateTemplate_shptr tmpl,
                                                   Gate::ORIENTATION orientation);
 
+        /**
+         * Get a prepared template from the cache, or prepare it.
+         */
+        std::shared_ptr<const struct prepared_template> get_prepared_template(GateTemplate_shptr tmpl,
+                                                                              Gate::ORIENTATION orientation);
+
 
         void hill_climbing(unsigned int start_x, unsigned int start_y, double xcorr_val,
                            unsigned int* max_corr_x_out,
                            unsigned int* max_corr_y_out,
                            double* max_xcorr_out,
                            const TileImage_GS_BYTE_shptr master,
-                           const TempImage_GS_DOUBLE_shptr zero_mean_template,
-                           double sum_over_zero_mean_template) const;
+                           NCCTemplate const& tmpl,
+                           double sum_over_zero_mean_template,
+                           struct correlation_surface const* surface = nullptr) const;
+
+        /**
+         * Check if a template is matched with the FFT correlation.
+         */
+        bool use_fft_correlation(unsigned int tmpl_width, unsigned int tmpl_height) const;
 
         /**
          * Adjust step size depending on correlation value.
          */
         void adjust_step_size(struct search_state& state, double corr_val) const;
 
-        std::list<match_found> match_single_template(struct prepared_template& tmpl,
+        /**
+         * Split the background image in search areas for a template.
+         * There is one search area per tile of the background image, extended
+         * by the template size, so every start position belongs to exactly one area.
+         * If the split is disabled, the whole bounding box is the only search area.
+         */
+        std::vector<BoundingBox> get_search_areas(struct prepared_template const& tmpl) const;
+
+        /**
+         * Match a single template on a search area of the background image.
+         * This is called concurrently, it must not modify the logic model.
+         *
+         * @param tmpl The template to match.
+         * @param search_area The area to scan, on the unscaled uncropped image.
+         */
+        std::list<match_found> match_single_template(struct prepared_template const& tmpl,
+                                                     BoundingBox const& search_area,
                                                      double threshold_hc,
                                                      double threshold_detection);
 
 
+        /**
+         * Calculate the denominator of the correlation at a position.
+         *
+         * @param mean Set to the mean of the master image window.
+         */
+        double calc_xcorr_denominator(const TileImage_GS_DOUBLE_shptr summation_table_single,
+                                      const TileImage_GS_DOUBLE_shptr summation_table_squared,
+                                      unsigned int tmpl_width,
+                                      unsigned int tmpl_height,
+                                      double sum_over_zero_mean_template,
+                                      unsigned int local_x,
+                                      unsigned int local_y,
+                                      double* mean) const;
+
+        /**
+         * Create a gate, if there is no gate in the layer or in \p gates at this place.
+         * The gate is staged in \p gates, to be added into the logic model later.
+         */
+        bool add_gate(unsigned int x, unsigned int y,
+                      GateTemplate_shptr tmpl,
+                      Gate::ORIENTATION orientation,
+                      double corr_val, double t_hc,
+                      BulkInsert& gates);
+
+        match_found keep_gate_match(unsigned int x, unsigned int y,
+                                    struct prepared_template const& tmpl,
+                                    double corr_val = 0, double t_hc = 0) const;
+
+    protected:
+
+        /**
+         * Calculate the next position for a template to background matching.
+         * @return Returns false if there is no further position.
+         */
+        virtual bool get_next_pos(struct search_state* state,
+                                  struct prepared_template const& tmpl) const = 0;
+
+        void precalc_sum_tables(TileImage_GS_BYTE_shptr img,
+                                TileImage_GS_DOUBLE_shptr summation_table_single,
+                                TileImage_GS_DOUBLE_shptr summation_table_squared);
+
         /**
          * Calculate a zero mean image from an image and return
          * the variance(?).
@@ -211,24 +327,71 @@ namespace degate
                                  unsigned int local_x,
                                  unsigned int local_y) const;
 
+        /**
+         * Calculate correlation between template and background, with the NCC kernels.
+         * This gives the same result as calc_single_xcorr(), which is the reference
+         * implementation, up to rounding errors.
+         *
+         * @param master The image where we look for matchings.
+         * @param summation_table_single
+         * @param summation_table_squared
+         * @param tmpl The zero-mean template.
+         * @param sum_over_zero_mean_template
+         * @param local_x Coordinate within \p master.
+         * @param local_y Coordinate within \p master.
+         * @return Returns the correlation, or -1 if the template does not fit
+         *   in \p master at this position.
+         */
+        double calc_xcorr(const TileImage_GS_BYTE_shptr master,
+                          const TileImage_GS_DOUBLE_shptr summation_table_single,
+                          const TileImage_GS_DOUBLE_shptr summation_table_squared,
+                          NCCTemplate const& tmpl,
+                          double sum_over_zero_mean_template,
+                          unsigned int local_x,
+                          unsigned int local_y) const;
 
-        bool add_gate(unsigned int x, unsigned int y,
-                      GateTemplate_shptr tmpl,
-                      Gate::ORIENTATION orientation,
-                      double corr_val = 0, double t_hc = 0);
-
-        match_found keep_gate_match(unsigned int x, unsigned int y,
-                                    struct prepared_template& tmpl,
-                                    double corr_val = 0, double t_hc = 0) const;
-
-    protected:
+        /**
+         * Calculate correlations for a row of positions at once.
+         * @see calc_xcorr()
+         *
+         * @param count The number of positions, starting at \p local_x.
+         * @param results The correlations, for \p count positions.
+         */
+        void calc_xcorr_row(const TileImage_GS_BYTE_shptr master,
+                            const TileImage_GS_DOUBLE_shptr summation_table_single,
+                            const TileImage_GS_DOUBLE_shptr summation_table_squared,
+                            NCCTemplate const& tmpl,
+                            double sum_over_zero_mean_template,
+                            unsigned int local_x,
+                            unsigned int local_y,
+                            unsigned int count,
+                            double* results) const;
 
         /**
-         * Calculate the next position for a template to background matching.
-         * @return Returns false if there is no further position.
+         * Calculate correlations for an area of positions at once, with FFTs.
+         * This gives the same result as calc_single_xcorr(), up to rounding errors.
+         *
+         * @param master The image where we look for matchings.
+         * @param summation_table_single
+         * @param summation_table_squared
+         * @param tmpl The zero-mean template spectrum.
+         * @param sum_over_zero_mean_template
+         * @param min_x The first position within \p master.
+         * @param min_y The first position within \p master.
+         * @param width The number of positions per row.
+         * @param height The number of rows.
+         * @return Returns the correlations, for the positions where the
+         *   template fits in \p master.
          */
-        virtual bool get_next_pos(struct search_state* state,
-                                  struct prepared_template const& tmpl) const = 0;
+        struct correlation_surface calc_xcorr_surface(const TileImage_GS_BYTE_shptr master,
+                                                      const TileImage_GS_DOUBLE_shptr summation_table_single,
+                                                      const TileImage_GS_DOUBLE_shptr summation_table_squared,
+                                                      FFTCorrelation const& tmpl,
+                                                      double sum_over_zero_mean_template,
+                                                      unsigned int min_x,
+                                                      unsigned int min_y,
+                                                      unsigned int width,
+                                                      unsigned int height) const;
 
 
     public:
@@ -287,6 +450,38 @@ namespace degate
          */
         void set_scaling_factor(unsigned int factor) { scale_down = factor; }
 
+        /**
+         * Get the correlation mode.
+         */
+        CorrelationMode get_correlation_mode() const { return correlation_mode; }
+
+        /**
+         * Set the correlation mode.
+         *
+         * With FFTs, the correlation is calculated once for all positions of a
+         * search area. This is much faster for large templates (memory macros, pad
+         * cells...), matches are the same. By default, templates larger than
+         * 64x64 pixels are matched with FFTs.
+         */
+        void set_correlation_mode(CorrelationMode mode) { correlation_mode = mode; }
+
+        /**
+         * Check if the background image is split in search areas.
+         */
+        bool get_split_search_areas() const { return split_search_areas; }
+
+        /**
+         * Set if the background image is split in search areas, one per tile of
+         * the background image (default).
+         *
+         * The step size adapts to the correlation values along the scan, and it
+         * restarts in each search area. So the visited positions, and the matches,
+         * can differ from a scan of the whole bounding box in one area. Without the
+         * split, the matches are those of the serial scan of the whole bounding box,
+         * but a template/orientation pair is matched by a single thread.
+         */
+        void set_split_search_areas(bool split) { split_search_areas = split; }
+
 
         /**
          * Run the template matching.
@@ -295,6 +490,13 @@ namespace degate
 
         /**
          * Run the template matching.
+         *
+         * Templates and orientations are matched concurrently (on the global
+         * thread pool), each of them split in search areas along the background
+         * image tiles (see set_split_search_areas()). Matches are then inserted
+         * from the calling thread, in an order that does not depend on the
+         * scheduling: the result is the same for any number of threads, but
+         * not the same as with a single search area.
          */
         virtual void run();
 
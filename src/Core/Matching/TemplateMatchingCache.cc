@@ -0,0 +1,229 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Matching/TemplateMatchingCache.h"
+#include "Core/Configuration.h"
+
+#include <cstdlib>
+
+using namespace degate;
+
+namespace
+{
+    template<typename ImageType>
+    uint_fast64_t get_image_size(std::shared_ptr<ImageType> const& img)
+    {
+        if (img == nullptr)
+            return 0;
+
+        return static_cast<uint_fast64_t>(img->get_width()) * img->get_height() *
+               sizeof(typename ImageType::pixel_type);
+    }
+
+    uint_fast64_t get_template_size(TemplateMatchingCache::prepared_template_shptr const& tmpl)
+    {
+        const uint_fast64_t
+            normal_pixels = static_cast<uint_fast64_t>(tmpl->ncc_template_normal.get_width()) *
+                            tmpl->ncc_template_normal.get_height(),
+            scaled_pixels = static_cast<uint_fast64_t>(tmpl->ncc_template_scaled.get_width()) *
+                            tmpl->ncc_template_scaled.get_height();
+
+        uint_fast64_t size = get_image_size(tmpl->tmpl_img_normal) + get_image_size(tmpl->tmpl_img_scaled) +
+                             get_image_size(tmpl->zero_mean_template_normal) +
+                             get_image_size(tmpl->zero_mean_template_scaled) +
+                             (normal_pixels + scaled_pixels) * sizeof(float);
+
+        if (tmpl->fft_correlation_normal != nullptr)
+            size += tmpl->fft_correlation_normal->get_memory_size();
+
+        if (tmpl->fft_correlation_scaled != nullptr && tmpl->fft_correlation_scaled != tmpl->fft_correlation_normal)
+            size += tmpl->fft_correlation_scaled->get_memory_size();
+
+        return size;
+    }
+
+    uint_fast64_t get_region_size(TemplateMatchingCache::region_images_shptr const& region)
+    {
+        uint_fast64_t size = get_image_size(region->gs_img_normal) +
+                             get_image_size(region->sum_table_single_normal) +
+                             get_image_size(region->sum_table_squared_normal);
+
+        // without scaling, the scaled images are the normal ones
+        if (region->gs_img_scaled != region->gs_img_normal)
+            size += get_image_size(region->gs_img_scaled);
+
+        if (region->sum_table_single_scaled != region->sum_table_single_normal)
+            size += get_image_size(region->sum_table_single_scaled) + get_image_size(region->sum_table_squared_scaled);
+
+        return size;
+    }
+}
+
+TemplateMatchingCache::TemplateMatchingCache() : allocated_memory(0)
+{
+    max_memory = Configuration::get_max_matching_cache_size() * uint_fast64_t(1024) * uint_fast64_t(1024);
+
+    // The cached images release their tiles to the global tile caches, which are singletons too and
+    // may be destroyed first at exit. Handlers registered now run before the singletons are destroyed.
+    std::atexit([] { TemplateMatchingCache::get_instance().clear(); });
+}
+
+void TemplateMatchingCache::remove(lru_t::iterator position)
+{
+    if (position->type == entry_type::Template)
+    {
+        auto found = templates.find(position->tmpl);
+        allocated_memory -= found->second.size;
+        templates.erase(found);
+    }
+    else
+    {
+        auto found = regions.find(position->region);
+        allocated_memory -= found->second.size;
+        regions.erase(found);
+    }
+
+    lru.erase(position);
+}
+
+bool TemplateMatchingCache::reserve(uint_fast64_t size)
+{
+    if (size > max_memory)
+        return false;
+
+    while (allocated_memory + size > max_memory && !lru.empty())
+        remove(std::prev(lru.end()));
+
+    return true;
+}
+
+TemplateMatchingCache::prepared_template_shptr TemplateMatchingCache::get_template(template_key const& key)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    auto found = templates.find(key);
+    if (found == templates.end())
+        return nullptr;
+
+    lru.splice(lru.begin(), lru, found->second.lru_position);
+    return found->second.value;
+}
+
+void TemplateMatchingCache::add_template(template_key const& key, prepared_template_shptr tmpl)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    auto found = templates.find(key);
+    if (found != templates.end())
+        remove(found->second.lru_position);
+
+    // Drop entries for outdated images of the template
+    for (auto iter = templates.begin(); iter != templates.end();)
+    {
+        auto const& other = iter->first;
+        auto position = iter->second.lru_position;
+        ++iter;
+
+        if (other.template_id == key.template_id && other.layer_type == key.layer_type &&
+            other.image_revision != key.image_revision)
+            remove(position);
+    }
+
+    const uint_fast64_t size = get_template_size(tmpl);
+    if (!reserve(size))
+        return;
+
+    lru.push_front({entry_type::Template, key, region_key()});
+    templates[key] = {tmpl, size, lru.begin()};
+    allocated_memory += size;
+}
+
+TemplateMatchingCache::region_images_shptr TemplateMatchingCache::get_region(region_key const& key)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    auto found = regions.find(key);
+    if (found == regions.end())
+        return nullptr;
+
+    lru.splice(lru.begin(), lru, found->second.lru_position);
+    return found->second.value;
+}
+
+void TemplateMatchingCache::add_region(region_key const& key, region_images_shptr region)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    auto found = regions.find(key);
+    if (found != regions.end())
+        remove(found->second.lru_position);
+
+    // Drop entries for outdated images of the layer
+    for (auto iter = regions.begin(); iter != regions.end();)
+    {
+        auto const& other = iter->first;
+        auto position = iter->second.lru_position;
+        ++iter;
+
+        if (other.layer_id == key.layer_id && other.image_revision != key.image_revision)
+            remove(position);
+    }
+
+    const uint_fast64_t size = get_region_size(region);
+    if (!reserve(size))
+        return;
+
+    lru.push_front({entry_type::Region, template_key(), key});
+    regions[key] = {region, size, lru.begin()};
+    allocated_memory += size;
+}
+
+void TemplateMatchingCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    templates.clear();
+    regions.clear();
+    lru.clear();
+    allocated_memory = 0;
+}
+
+void TemplateMatchingCache::set_max_memory(uint_fast64_t max_memory)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    this->max_memory = max_memory;
+
+    while (allocated_memory > max_memory && !lru.empty())
+        remove(std::prev(lru.end()));
+}
+
+uint_fast64_t TemplateMatchingCache::get_max_memory() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return max_memory;
+}
+
+uint_fast64_t TemplateMatchingCache::get_allocated_memory() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return allocated_memory;
+}
@@ -0,0 +1,213 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __TEMPLATEMATCHINGCACHE_H__
+#define __TEMPLATEMATCHINGCACHE_H__
+
+#include "Core/Matching/TemplateMatching.h"
+#include "Core/Primitive/SingletonBase.h"
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace degate
+{
+    /**
+     * @class TemplateMatchingCache
+     * @brief Keep template matching data between matching runs.
+     *
+     * Prepared templates and greyscale/summation images of a search region are
+     * expensive to compute. They are kept here, so that re-running a template
+     * matching (e.g. with other thresholds) on the same region can reuse them.
+     *
+     * Entries are keyed with the image revisions of templates and layers, so data
+     * computed from an outdated image is never returned. Outdated entries are dropped
+     * when newer ones are added, the others are evicted (least recently used first)
+     * to stay within the memory budget.
+     *
+     * All the methods are thread safe.
+     *
+     * @warning This is a singleton, only one instance can exists.
+     */
+    class TemplateMatchingCache : public SingletonBase<TemplateMatchingCache>
+    {
+        friend class SingletonBase<TemplateMatchingCache>;
+
+    public:
+
+        typedef std::shared_ptr<const TemplateMatching::prepared_template> prepared_template_shptr;
+
+        struct template_key
+        {
+            object_id_t template_id;
+            uint_fast64_t image_revision;
+            Layer::LAYER_TYPE layer_type;
+            Gate::ORIENTATION orientation;
+            unsigned int scaling_factor;
+            bool fft_correlation;
+
+            bool operator<(template_key const& other) const
+            {
+                return std::tie(template_id, image_revision, layer_type, orientation, scaling_factor, fft_correlation) <
+                       std::tie(other.template_id, other.image_revision, other.layer_type, other.orientation,
+                                other.scaling_factor, other.fft_correlation);
+            }
+        };
+
+        struct region_key
+        {
+            layer_id_t layer_id;
+            uint_fast64_t image_revision;
+            int min_x, max_x, min_y, max_y; // on the unscaled background image
+            unsigned int scaling_factor;
+
+            bool operator<(region_key const& other) const
+            {
+                return std::tie(layer_id, image_revision, min_x, max_x, min_y, max_y, scaling_factor) <
+                       std::tie(other.layer_id, other.image_revision, other.min_x, other.max_x, other.min_y,
+                                other.max_y, other.scaling_factor);
+            }
+        };
+
+        /**
+         * Greyscale background images and summation tables of a region.
+         */
+        struct region_images
+        {
+            TileImage_GS_BYTE_shptr gs_img_normal;
+            TileImage_GS_BYTE_shptr gs_img_scaled;
+
+            TileImage_GS_DOUBLE_shptr sum_table_single_normal;
+            TileImage_GS_DOUBLE_shptr sum_table_squared_normal;
+            TileImage_GS_DOUBLE_shptr sum_table_single_scaled;
+            TileImage_GS_DOUBLE_shptr sum_table_squared_scaled;
+        };
+
+        typedef std::shared_ptr<const region_images> region_images_shptr;
+
+    private:
+
+        enum class entry_type
+        {
+            Template,
+            Region
+        };
+
+        struct lru_entry
+        {
+            entry_type type;
+            template_key tmpl;
+            region_key region;
+        };
+
+        // Entries ordered from the most recently to the least recently used one.
+        typedef std::list<lru_entry> lru_t;
+
+        template<typename Value>
+        struct cache_entry
+        {
+            Value value;
+            uint_fast64_t size;
+            lru_t::iterator lru_position;
+        };
+
+        std::map<template_key, cache_entry<prepared_template_shptr>> templates;
+        std::map<region_key, cache_entry<region_images_shptr>> regions;
+        lru_t lru;
+
+        uint_fast64_t max_memory;
+        uint_fast64_t allocated_memory;
+
+        mutable std::mutex mtx;
+
+    private:
+
+        /**
+         * Create the cache (singleton), with the budget from the configuration.
+         */
+        TemplateMatchingCache();
+
+        /**
+         * Remove an entry. The mutex must be held by the caller.
+         */
+        void remove(lru_t::iterator position);
+
+        /**
+         * Make room for a new entry, evicting the least recently used ones.
+         * The mutex must be held by the caller.
+         *
+         * @return Returns false if the entry is larger than the budget.
+         */
+        bool reserve(uint_fast64_t size);
+
+    public:
+
+        /**
+         * Get a prepared template.
+         * @return Returns the prepared template, or nullptr if it isn't cached.
+         */
+        prepared_template_shptr get_template(template_key const& key);
+
+        /**
+         * Add a prepared template. Entries for older images of the same
+         * template are removed.
+         */
+        void add_template(template_key const& key, prepared_template_shptr tmpl);
+
+        /**
+         * Get the images of a region.
+         * @return Returns the images, or nullptr if they aren't cached.
+         */
+        region_images_shptr get_region(region_key const& key);
+
+        /**
+         * Add the images of a region. Entries for older images of the same
+         * layer are removed.
+         */
+        void add_region(region_key const& key, region_images_shptr region);
+
+        /**
+         * Remove all the entries.
+         */
+        void clear();
+
+        /**
+         * Set the memory budget (in bytes), 0 disables the cache.
+         * Entries are evicted if needed.
+         */
+        void set_max_memory(uint_fast64_t max_memory);
+
+        /**
+         * Get the memory budget (in bytes).
+         */
+        uint_fast64_t get_max_memory() const;
+
+        /**
+         * Get the memory used by the entries (in bytes, estimated).
+         */
+        uint_fast64_t get_allocated_memory() const;
+    };
+}
+
+#endif
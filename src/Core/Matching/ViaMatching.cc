@@ -24,7 +24,20 @@
 #include "Core/Matching/EdgeDetection.h"
 #include "Core/Matching/ViaMatching.h"
 #include "Core/Primitive/BoundingBox.h"
+#include "Core/Utils/Instrumentation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/range/counting_range.hpp>
+
+#include <QtConcurrent/QtConcurrent>
 
 
 using namespace degate;
@@ -108,6 +121,9 @@ void ViaMatching::run()
     int max_count_up = merge_n_vias, max_count_down = merge_n_vias;
     max_r = (max_r + 1) / 2;
 
+    static Histogram& prepare_timer = Instrumentation::get_instance().get_timer("via_matching.prepare");
+    ScopedTimer prepare(prepare_timer);
+
     // iterate over all placed vias (current layer) and calculate a mean-image
     for (LogicModel::via_collection::iterator viter = lmodel->vias_begin();
          viter != lmodel->vias_end(); ++viter)
@@ -169,6 +185,8 @@ void ViaMatching::run()
     //if (via_up_gs) save_image(join_pathes("/tmp", "02_via_up_gs.tif"), via_up_gs);
     //if (via_down_gs) save_image(join_pathes("/tmp", "02_via_down_gs.tif"), via_down_gs);
 
+    prepare.stop();
+
     // set progress step size
     int substeps = 0;
     if (via_up_gs) substeps++;
@@ -180,29 +198,132 @@ void ViaMatching::run()
     if (via_down_gs) scan(bounding_box, img, via_down_gs, Via::DIRECTION_DOWN);
 }
 
-template <class BGImageType, class TemplateImageType>
-double calc_xcorr(unsigned int start_x, unsigned int start_y,
-                  std::shared_ptr<BGImageType> bg_img, double f_avg, double sigma_f,
-                  std::shared_ptr<TemplateImageType> tmpl_img, double t_avg, double sigma_t)
+namespace
 {
-    double sum = 0;
-    double n = tmpl_img->get_width() * tmpl_img->get_height();
-
-    for (unsigned int y = 0; y < tmpl_img->get_height(); y++)
+    /**
+     * A zero-mean via template.
+     */
+    struct via_template
+    {
+        unsigned int width, height;
+        std::vector<double> pixels; // t(x, y) - t_avg, row by row
+        double sum;                 // the sum over the zero-mean pixels (not exactly 0)
+        double stddev;
+    };
+
+    /**
+     * Scan the template positions of rows [min_y, max_y) of the search area.
+     *
+     * The band is converted to a greyscale crop once, with summed-area tables for
+     * the window sums, so the window mean and standard deviation cost O(1) per position.
+     *
+     * @param row_done Called after each row, returns false if the scan must stop.
+     */
+    void scan_rows(BackgroundImage_shptr bg_img,
+                   via_template const& tmpl,
+                   unsigned int min_x, unsigned int max_x,
+                   unsigned int min_y, unsigned int max_y,
+                   double threshold,
+                   std::vector<ViaMatching::match_found>& matches,
+                   std::function<bool()> const& row_done)
     {
-        for (unsigned int x = 0; x < tmpl_img->get_width(); x++)
+        const unsigned int
+            positions = max_x - min_x,
+            rows = max_y - min_y,
+            crop_width = positions + tmpl.width - 1,
+            crop_height = rows + tmpl.height - 1,
+            table_width = crop_width + 1;
+
+        // Greyscale crop, pixels outside of the image are 0
+        std::vector<std::uint8_t> crop(static_cast<std::size_t>(crop_width) * crop_height, 0);
+        std::shared_ptr<const BackgroundImage> view = bg_img;
+
+        for (unsigned int y = 0; y < crop_height && min_y + y < bg_img->get_height(); y++)
+        {
+            std::uint8_t* dst = &crop[static_cast<std::size_t>(y) * crop_width];
+
+            for_each_row_segment(view, min_x, min_y + y, crop_width,
+                                 [&](unsigned int x, const rgba_pixel_t* pixels, unsigned int length)
+                                 {
+                                     for (unsigned int i = 0; i < length; i++)
+                                         dst[x - min_x + i] = convert_pixel<gs_byte_pixel_t, rgba_pixel_t>(pixels[i]);
+                                 });
+        }
+
+        // Summed-area tables with a zero first row and column, exact with integers
+        std::vector<std::uint64_t>
+            sum_single(static_cast<std::size_t>(table_width) * (crop_height + 1), 0),
+            sum_squared(sum_single.size(), 0);
+
+        for (unsigned int y = 0; y < crop_height; y++)
         {
-            double f_xy = bg_img->template get_pixel_as<double>(start_x + x, start_y + y);
-            double t_xy = tmpl_img->template get_pixel_as<double>(x, y);
+            const std::uint8_t* src = &crop[static_cast<std::size_t>(y) * crop_width];
+            const std::size_t above = static_cast<std::size_t>(y) * table_width, row = above + table_width;
 
-            sum += (f_xy - f_avg) * (t_xy - t_avg) / (sigma_f * sigma_t); // extract commons
+            std::uint64_t row_single = 0, row_squared = 0;
+            for (unsigned int x = 0; x < crop_width; x++)
+            {
+                row_single += src[x];
+                row_squared += static_cast<std::uint64_t>(src[x]) * src[x];
+
+                sum_single[row + x + 1] = sum_single[above + x + 1] + row_single;
+                sum_squared[row + x + 1] = sum_squared[above + x + 1] + row_squared;
+            }
         }
-    }
 
-    sum *= 1 / (n - 1);
+        const std::uint64_t n = static_cast<std::uint64_t>(tmpl.width) * tmpl.height;
+        std::vector<double> nummerators(positions);
+
+        for (unsigned int y = 0; y < rows; y++)
+        {
+            // Template row after template row, so that the inner loop runs over contiguous positions
+            std::fill(nummerators.begin(), nummerators.end(), 0.0);
+
+            for (unsigned int ty = 0; ty < tmpl.height; ty++)
+            {
+                const std::uint8_t* src = &crop[static_cast<std::size_t>(y + ty) * crop_width];
+                const double* t = &tmpl.pixels[static_cast<std::size_t>(ty) * tmpl.width];
+
+                for (unsigned int tx = 0; tx < tmpl.width; tx++)
+                    for (unsigned int i = 0; i < positions; i++)
+                        nummerators[i] += src[tx + i] * t[tx];
+            }
+
+            const std::size_t
+                top = static_cast<std::size_t>(y) * table_width,
+                bottom = static_cast<std::size_t>(y + tmpl.height) * table_width;
+
+            for (unsigned int i = 0; i < positions; i++)
+            {
+                const std::size_t left = i, right = i + tmpl.width;
+
+                const std::uint64_t
+                    single = sum_single[bottom + right] - sum_single[bottom + left] -
+                             sum_single[top + right] + sum_single[top + left],
+                    squared = sum_squared[bottom + right] - sum_squared[bottom + left] -
+                              sum_squared[top + right] + sum_squared[top + left];
+
+                // n^2 times the variance, a flat window has no correlation
+                const std::uint64_t variance_n2 = n * squared - single * single;
+                if (variance_n2 == 0)
+                    continue;
+
+                const double
+                    f_avg = static_cast<double>(single) / static_cast<double>(n),
+                    sigma_f = std::sqrt(static_cast<double>(variance_n2)) / static_cast<double>(n);
 
+                // sum((f - f_avg) * (t - t_avg)) / (sigma_f * sigma_t) / (n - 1)
+                const double xcorr = (nummerators[i] - f_avg * tmpl.sum) / (sigma_f * tmpl.stddev) *
+                                     (1 / (static_cast<double>(n) - 1));
 
-    return sum;
+                if (xcorr > threshold)
+                    matches.push_back({min_x + i, min_y + y, xcorr});
+            }
+
+            if (!row_done())
+                return;
+        }
+    }
 }
 
 
@@ -215,10 +336,11 @@ bool compare_correlation(ViaMatching::match_found const& lhs,
 bool ViaMatching::add_via(unsigned int x, unsigned int y,
                           unsigned int diameter,
                           Via::DIRECTION direction,
-                          double corr_val, double threshold_hc)
+                          double corr_val, double threshold_hc,
+                          BulkInsert& vias)
 {
-    if (!layer->exists_type_in_region<Via>(x, x + diameter,
-                                           y, y + diameter))
+    if (!vias.exists_type_in_region<Via>(x, x + diameter,
+                                         y, y + diameter))
     {
         Via_shptr via(new Via(x + diameter / 2, y + diameter / 2, diameter, direction));
 
@@ -226,7 +348,7 @@ bool ViaMatching::add_via(unsigned int x, unsigned int y,
         snprintf(dsc, sizeof(dsc), "matched with corr=%.2f t_hc=%.2f", corr_val, threshold_hc);
         via->set_description(dsc);
 
-        lmodel->add_object(layer, via);
+        vias.add(via);
         return true;
     }
     return false;
@@ -235,63 +357,150 @@ bool ViaMatching::add_via(unsigned int x, unsigned int y,
 void ViaMatching::scan(BoundingBox const& bbox, BackgroundImage_shptr bg_img,
                        MemoryImage_GS_BYTE_shptr tmpl_img, Via::DIRECTION direction)
 {
-    std::list<match_found> matches;
-
     debug(TM, "run scanning");
-    double f_avg, sigma_f;
-    double t_avg, sigma_t;
+
+    via_template tmpl;
+    tmpl.width = tmpl_img->get_width();
+    tmpl.height = tmpl_img->get_height();
+
+    double t_avg;
     average_and_stddev(tmpl_img, 0, 0,
-                       tmpl_img->get_width(), tmpl_img->get_height(),
-                       &t_avg, &sigma_t);
+                       tmpl.width, tmpl.height,
+                       &t_avg, &tmpl.stddev);
+
+    // A flat template has no correlation
+    if (tmpl.stddev == 0)
+        return;
+
+    tmpl.pixels.resize(static_cast<std::size_t>(tmpl.width) * tmpl.height);
+    tmpl.sum = 0;
+
+    for (unsigned int y = 0; y < tmpl.height; y++)
+        for (unsigned int x = 0; x < tmpl.width; x++)
+        {
+            const double t = tmpl_img->template get_pixel_as<double>(x, y) - t_avg;
+            tmpl.pixels[y * tmpl.width + x] = t;
+            tmpl.sum += t;
+        }
 
     assert(bbox.get_max_x() >= 0);
     assert(bbox.get_max_y() >= 0);
 
-    int max_x = static_cast<unsigned int>(bbox.get_max_x()) > tmpl_img->get_width()
-                    ? bbox.get_max_x() - tmpl_img->get_width()
+    int min_x = bbox.get_min_x();
+    int min_y = bbox.get_min_y();
+    int max_x = static_cast<unsigned int>(bbox.get_max_x()) > tmpl.width
+                    ? bbox.get_max_x() - tmpl.width
                     : bbox.get_min_x();
-    int max_y = static_cast<unsigned int>(bbox.get_max_y()) > tmpl_img->get_height()
-                    ? bbox.get_max_y() - tmpl_img->get_height()
+    int max_y = static_cast<unsigned int>(bbox.get_max_y()) > tmpl.height
+                    ? bbox.get_max_y() - tmpl.height
                     : bbox.get_min_y();
 
-    for (int y = bbox.get_min_y(); y < max_y; y++)
+    if (min_x >= max_x || min_y >= max_y)
+        return;
+
+    // Row bands are scanned in parallel, each one on its own greyscale crop
+    const unsigned int
+        band_height = std::max(64u, 4 * tmpl.height),
+        bands = (static_cast<unsigned int>(max_y - min_y) + band_height - 1) / band_height;
+
+    std::vector<std::vector<match_found>> band_matches(bands);
+
+    std::function<void(const unsigned int&)> scan_band = [&](const unsigned int& band)
     {
-        for (int x = bbox.get_min_x(); x < max_x; x++)
-        {
-            average_and_stddev(bg_img, x, y,
-                               tmpl_img->get_width(), tmpl_img->get_height(),
-                               &f_avg, &sigma_f);
+        const unsigned int
+            band_min_y = static_cast<unsigned int>(min_y) + band * band_height,
+            band_max_y = std::min(band_min_y + band_height, static_cast<unsigned int>(max_y));
+
+        if (is_canceled())
+            return;
+
+        scan_rows(bg_img, tmpl,
+                  static_cast<unsigned int>(min_x), static_cast<unsigned int>(max_x),
+                  band_min_y, band_max_y,
+                  threshold_match, band_matches[band],
+                  [this]()
+                  {
+                      // update progress
+                      progress_step_done();
+
+                      // check if scanning was canceled
+                      return !is_canceled();
+                  });
+    };
+
+    static Histogram& scan_timer = Instrumentation::get_instance().get_timer("via_matching.scan");
+    ScopedTimer scanning(scan_timer);
+
+    const auto& it = boost::counting_range<unsigned int>(0, bands);
+    QtConcurrent::blockingMap(it, scan_band);
+
+    scanning.stop();
+
+    if (is_canceled())
+    {
+        reset_progress();
+        return;
+    }
 
-            double xcorr = calc_xcorr(x, y,
-                                      bg_img, f_avg, sigma_f,
-                                      tmpl_img, t_avg, sigma_t);
+    // Bands are in row order, so equal correlations keep the scanning order
+    std::vector<match_found> matches;
+    for (auto const& band : band_matches)
+        matches.insert(matches.end(), band.begin(), band.end());
 
-            if (xcorr > threshold_match)
+    std::stable_sort(matches.begin(), matches.end(), compare_correlation);
+
+    static Histogram& insert_timer = Instrumentation::get_instance().get_timer("via_matching.insert");
+    ScopedTimer inserting(insert_timer);
+
+    // Non-maximum suppression: a match is dropped if it overlaps a better match that
+    // was added, without querying the layer. A new via placed at (vx, vy) spans
+    // [vx, vx + 2 * (diameter / 2)], and add_via() looks for vias in [x, x + diameter].
+    const unsigned int
+        diameter = via_diameter,
+        extent = 2 * (via_diameter / 2),
+        cell_size = diameter + 1;
+
+    std::unordered_map<std::uint64_t, std::vector<std::pair<unsigned int, unsigned int>>> added;
+    auto get_cell = [cell_size](unsigned int cell_x, unsigned int cell_y)
+    {
+        return (static_cast<std::uint64_t>(cell_y / cell_size) << 32) | (cell_x / cell_size);
+    };
+
+    auto overlaps_added_via = [&](match_found const& m)
+    {
+        const unsigned int
+            min_cell_x = m.x > extent ? m.x - extent : 0,
+            min_cell_y = m.y > extent ? m.y - extent : 0;
+
+        for (unsigned int cy = min_cell_y / cell_size; cy <= (m.y + diameter) / cell_size; cy++)
+            for (unsigned int cx = min_cell_x / cell_size; cx <= (m.x + diameter) / cell_size; cx++)
             {
-                match_found m;
-                m.x = x;
-                m.y = y;
-                m.correlation = xcorr;
+                auto found = added.find(get_cell(cx * cell_size, cy * cell_size));
+                if (found == added.end())
+                    continue;
 
-                matches.push_back(m);
-                //debug(TM, "%d,%d -> %f sigma-f=%f sigma-t=%f f_avg=%f t_avg=%f", x, y, xcorr, sigma_f,sigma_t, f_avg, sigma_f);
+                for (auto const& via : found->second)
+                {
+                    if (via.first <= m.x + diameter && via.first + extent >= m.x &&
+                        via.second <= m.y + diameter && via.second + extent >= m.y)
+                        return true;
+                }
             }
-        }
 
-        // update progress
-        progress_step_done();
+        return false;
+    };
 
-        // check if scanning was canceled
-        if (is_canceled())
-        {
-            reset_progress();
-            return;
-        }
-    }
+    // The vias are added into the logic model at once.
+    BulkInsert vias(lmodel, layer);
 
-    matches.sort(compare_correlation);
     for (const auto& m : matches)
     {
-        add_via(m.x, m.y, via_diameter, direction, m.correlation, threshold_match);
+        if (overlaps_added_via(m))
+            continue;
+
+        if (add_via(m.x, m.y, via_diameter, direction, m.correlation, threshold_match, vias))
+            added[get_cell(m.x, m.y)].emplace_back(m.x, m.y);
     }
+
+    vias.commit();
 }
@@ -79,13 +79,23 @@ namespace degate
         void set_diameter(unsigned int diameter);
 
     private:
+
+        /**
+         * Scan an area for a via template, in parallel row bands, and add the
+         * best non-overlapping matches as vias.
+         */
         void scan(BoundingBox const& bbox, BackgroundImage_shptr bg_img,
                   MemoryImage_GS_BYTE_shptr tmpl_img, Via::DIRECTION direction);
 
+        /**
+         * Create a via, if there is no via in the layer or in \p vias at this place.
+         * The via is staged in \p vias, to be added into the logic model later.
+         */
         bool add_via(unsigned int x, unsigned int y,
                      unsigned int diameter,
                      Via::DIRECTION direction,
-                     double corr_val, double threshold_hc);
+                     double corr_val, double threshold_hc,
+                     BulkInsert& vias);
     };
 
     typedef std::shared_ptr<ViaMatching> ViaMatching_shptr;
@@ -21,12 +21,14 @@
 
 #define _CRT_SECURE_NO_WARNINGS 1
 #include "Core/Matching/WireMatching.h"
+#include "Core/LogicModel/BulkInsert.h"
 #include "Core/Matching/ZeroCrossingEdgeDetection.h"
 #include "Core/Matching/CannyEdgeDetection.h"
 #include "Core/Matching/BinaryLineDetection.h"
 #include "Core/Primitive/BoundingBox.h"
 #include "Core/Matching/LineSegmentExtraction.h"
 #include "Core/Image/Manipulation/MedianFilter.h"
+#include "Core/Utils/Instrumentation.h"
 
 using namespace degate;
 
@@ -96,27 +98,48 @@ void WireMatching::run()
                                  wire_diameter + (wire_diameter >> 1),
                                  min_edge_magnitude, 0.5);
 
+    Instrumentation& instrumentation = Instrumentation::get_instance();
+
+    static Histogram& edge_detection_timer = instrumentation.get_timer("wire_matching.edge_detection");
+    ScopedTimer edge_detection(edge_detection_timer);
+
     TileImage_GS_DOUBLE_shptr i = ed.run(img, TileImage_GS_DOUBLE_shptr(), directory);
     assert(i != nullptr);
 
+    edge_detection.stop();
+
+    static Histogram& line_extraction_timer = instrumentation.get_timer("wire_matching.line_extraction");
+    ScopedTimer line_extraction(line_extraction_timer);
+
     LineSegmentExtraction<TileImage_GS_DOUBLE> extraction(i, wire_diameter / 2, 2, ed.get_border());
     LineSegmentMap_shptr line_segments = extraction.run();
     assert(line_segments != nullptr);
 
+    line_extraction.stop();
+
     assert(lmodel != nullptr);
     assert(layer != nullptr);
 
-    for (auto ls : *line_segments)
+    static Histogram& insert_timer = instrumentation.get_timer("wire_matching.insert");
+    ScopedTimer inserting(insert_timer);
+
+    BulkInsert wires(lmodel, layer);
+
+    for (auto const& ls : *line_segments)
     {
         debug(TM, "found wire");
-        Wire_shptr w(new Wire(bounding_box.get_min_x() + ls->get_from_x(),
-                              bounding_box.get_min_y() + ls->get_from_y(),
-                              bounding_box.get_min_x() + ls->get_to_x(),
-                              bounding_box.get_min_y() + ls->get_to_y(),
+        Wire_shptr w(new Wire(bounding_box.get_min_x() + ls.get_from_x(),
+                              bounding_box.get_min_y() + ls.get_from_y(),
+                              bounding_box.get_min_x() + ls.get_to_x(),
+                              bounding_box.get_min_y() + ls.get_to_y(),
                               wire_diameter));
 
-        lmodel->add_object(layer->get_layer_pos(), w);
+        wires.add(w);
     }
 
+    wires.commit();
+
+    inserting.stop();
+
     remove_directory(directory);
 }
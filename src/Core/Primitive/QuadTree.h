@@ -25,13 +25,18 @@
 #define __QUADTREE_H__
 
 #include "BoundingBox.h"
+#include "Core/Utils/Instrumentation.h"
 #include "Core/Utils/TypeTraits.h"
 #include "Globals.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <list>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace degate
@@ -40,7 +45,7 @@ namespace degate
     struct get_bbox_trait_selector
     {
         template<typename T>
-        static BoundingBox const& get_bounding_box_for_object(T object)
+        static BoundingBox const& get_bounding_box_for_object(T const& object)
         {
             return object.get_bounding_box();
         }
@@ -50,7 +55,7 @@ namespace degate
     struct get_bbox_trait_selector<true>
     {
         template<typename T>
-        static BoundingBox const& get_bounding_box_for_object(T object)
+        static BoundingBox const& get_bounding_box_for_object(T const& object)
         {
             return object->get_bounding_box();
         }
@@ -97,6 +102,53 @@ namespace degate
 
         QuadTree<T>* traverse_downto_bounding_box(BoundingBox const& box);
 
+        /**
+         * Get the bounding box of a quadrant (NW, NE, SW or SE) of a node bounding box.
+         */
+        static BoundingBox get_quadrant_bounding_box(BoundingBox const& box, int quadrant);
+
+        /**
+         * Object and its position in the quadtree for a bulk insertion.
+         *
+         * The key is the sequence of quadrants that contain the object, from the node where the
+         * bulk insertion starts, 3 bits per level (0 when no quadrant contains the object,
+         * 1 + NW/NE/SW/SE otherwise), like a Morton order. The entries are sorted on the key
+         * level by level, as deep as the nodes are split.
+         *
+         * The entries refer to the objects by index, so that they are cheap to move.
+         */
+        struct bulk_entry
+        {
+            std::uint64_t key;
+            std::size_t index;
+        };
+
+        typedef typename std::vector<bulk_entry>::iterator bulk_iterator;
+
+        const static unsigned int bulk_key_levels = 21;
+
+        static unsigned int get_bulk_key_shift(unsigned int level)
+        {
+            return 3 * (bulk_key_levels - 1 - level);
+        }
+
+        /**
+         * Get the bulk insertion key of a bounding box, from a node bounding box at a level.
+         */
+        static std::uint64_t get_bulk_key(BoundingBox const& bounding_box, BoundingBox const& node_box,
+                                          unsigned int level);
+
+        ret_t bulk_insert(std::vector<T>& objects, std::vector<bulk_entry>& entries);
+
+        /**
+         * Insert the objects of the entries [first, last) in the node. The buffer is used
+         * to sort the entries, it must be as large as the range.
+         */
+        void bulk_insert_range(std::vector<T>& objects, bulk_iterator first, bulk_iterator last,
+                               bulk_iterator buffer, unsigned int level);
+        void bulk_dispatch_range(std::vector<T>& objects, bulk_iterator first, bulk_iterator last,
+                                 bulk_iterator buffer, unsigned int level);
+
         ret_t split();
         ret_t reinsert_objects();
 
@@ -155,6 +207,33 @@ namespace degate
          */
         ret_t insert(T object, const BoundingBox& bounding_box);
 
+        /**
+         * Insert many objects at once.
+         *
+         * The objects are sorted by their node in the quadtree while they are dispatched to
+         * the nodes, from the top down, one level at a time: a node is split at most once,
+         * and its objects are not reinserted one by one after the split. The objects end up
+         * in the nodes where insert() would place them.
+         *
+         * Whether a node is split depends on the number of objects that reach it, so the
+         * depth of a subtree is only known once its parent is dispatched. Building the tree
+         * bottom-up in one pass would need the keys sorted to the full depth first, which
+         * was slower than sorting only the levels that are split.
+         *
+         * @param objects : the objects with the bounding boxes to use.
+         */
+        ret_t bulk_insert(std::vector<std::pair<T, BoundingBox>> const& objects);
+
+        /**
+         * Insert many objects at once, with their own bounding boxes.
+         *
+         * @param first : the first object of the range.
+         * @param last : the end of the range.
+         * @see bulk_insert(std::vector<std::pair<T, BoundingBox>> const&)
+         */
+        template<typename Iterator>
+        ret_t bulk_insert(Iterator first, Iterator last);
+
         /**
          * Remove an object with the specified bounding box.
          *
@@ -163,10 +242,18 @@ namespace degate
          */
         ret_t remove(T object, const BoundingBox& bounding_box);
 
+        /**
+         * Remove many objects at once. The objects of a node are removed in one
+         * pass over the node, then the emptied nodes are merged like remove() does.
+         *
+         * @param objects : the objects with the bounding boxes they were inserted with.
+         */
+        ret_t bulk_remove(std::vector<std::pair<T, BoundingBox>> const& objects);
+
         /**
          * Get the bounding box of an object.
          */
-        BoundingBox get_object_bb(T object);
+        BoundingBox const& get_object_bb(T const& object);
 
         /**
          * Notify that the bounding box of an object changed.
@@ -304,27 +391,31 @@ namespace degate
         return box.get_width() > bbox_min_size && box.get_height() > bbox_min_size && is_leave();
     }
 
+    template<typename T>
+    BoundingBox QuadTree<T>::get_quadrant_bounding_box(BoundingBox const& box, int quadrant)
+    {
+        switch (quadrant)
+        {
+            case NW:
+                return BoundingBox(box.get_min_x(), box.get_center_x(), box.get_min_y(), box.get_center_y());
+            case NE:
+                return BoundingBox(box.get_center_x() + 1, box.get_max_x(), box.get_min_y(), box.get_center_y());
+            case SW:
+                return BoundingBox(box.get_min_x(), box.get_center_x(), box.get_center_y() + 1, box.get_max_y());
+            default:
+                return BoundingBox(box.get_center_x() + 1, box.get_max_x(), box.get_center_y() + 1, box.get_max_y());
+        }
+    }
+
     template<typename T>
     ret_t QuadTree<T>::split()
     {
         if (is_splitable())
         {
-            BoundingBox nw(box.get_min_x(), box.get_center_x(), box.get_min_y(), box.get_center_y());
-
-
-            BoundingBox sw(box.get_min_x(), box.get_center_x(), box.get_center_y() + 1, box.get_max_y());
-
-
-            BoundingBox ne(box.get_center_x() + 1, box.get_max_x(), box.get_min_y(), box.get_center_y());
-
-
-            BoundingBox se(box.get_center_x() + 1, box.get_max_x(), box.get_center_y() + 1, box.get_max_y());
-
-
-            QuadTree<T> node_nw(nw, this, "NW", max_entries);
-            QuadTree<T> node_ne(ne, this, "NE", max_entries);
-            QuadTree<T> node_sw(sw, this, "SW", max_entries);
-            QuadTree<T> node_se(se, this, "SE", max_entries);
+            QuadTree<T> node_nw(get_quadrant_bounding_box(box, NW), this, "NW", max_entries);
+            QuadTree<T> node_ne(get_quadrant_bounding_box(box, NE), this, "NE", max_entries);
+            QuadTree<T> node_sw(get_quadrant_bounding_box(box, SW), this, "SW", max_entries);
+            QuadTree<T> node_se(get_quadrant_bounding_box(box, SE), this, "SE", max_entries);
 
 
             subtree_nodes.push_back(node_nw);
@@ -386,7 +477,7 @@ namespace degate
     }
 
     template<typename T>
-    inline BoundingBox QuadTree<T>::get_object_bb(T object)
+    inline BoundingBox const& QuadTree<T>::get_object_bb(T const& object)
     {
         return get_bbox_trait_selector<is_pointer<T>::value>::get_bounding_box_for_object(object);
     }
@@ -439,6 +530,203 @@ namespace degate
         return RET_ERR;
     }
 
+    template<typename T>
+    std::uint64_t QuadTree<T>::get_bulk_key(BoundingBox const& bounding_box, BoundingBox const& node_box,
+                                            unsigned int level)
+    {
+        std::uint64_t key = 0;
+
+        const float
+            o_min_x = bounding_box.get_min_x(), o_max_x = bounding_box.get_max_x(),
+            o_min_y = bounding_box.get_min_y(), o_max_y = bounding_box.get_max_y();
+
+        float
+            min_x = node_box.get_min_x(), max_x = node_box.get_max_x(),
+            min_y = node_box.get_min_y(), max_y = node_box.get_max_y();
+
+        // Same descent as traverse_downto_bounding_box(), as deep as the nodes could be split.
+        // The quadrants are computed like get_quadrant_bounding_box() does, without
+        // creating bounding boxes, as this is done for each object and level. The nodes
+        // are larger than bbox_min_size, so the west (north) quadrant is [min, center] and
+        // the east (south) quadrant is [center + 1, max].
+        for (; level < bulk_key_levels; level++)
+        {
+            const float width = max_x - min_x, height = max_y - min_y;
+
+            if (!(width > bbox_min_size && height > bbox_min_size))
+                break;
+
+            const float center_x = min_x + width / 2, center_y = min_y + height / 2;
+
+            const bool
+                in_w = o_min_x >= min_x && o_max_x <= center_x,
+                in_e = o_min_x >= center_x + 1 && o_max_x <= max_x,
+                in_n = o_min_y >= min_y && o_max_y <= center_y,
+                in_s = o_min_y >= center_y + 1 && o_max_y <= max_y;
+
+            if (!((in_w || in_e) && (in_n || in_s)))
+                break;
+
+            // Selects rather than branches, the quadrants are not predictable.
+            min_x = in_w ? min_x : center_x + 1;
+            max_x = in_w ? center_x : max_x;
+            min_y = in_n ? min_y : center_y + 1;
+            max_y = in_n ? center_y : max_y;
+
+            const unsigned int quadrant = in_n ? (in_w ? NW : NE) : (in_w ? SW : SE);
+
+            key |= static_cast<std::uint64_t>(quadrant + 1) << get_bulk_key_shift(level);
+        }
+
+        return key;
+    }
+
+    template<typename T>
+    ret_t QuadTree<T>::bulk_insert(std::vector<std::pair<T, BoundingBox>> const& objects)
+    {
+        std::vector<T> bulk_objects;
+        std::vector<bulk_entry> entries;
+        bulk_objects.reserve(objects.size());
+        entries.reserve(objects.size());
+
+        for (auto const& o : objects)
+        {
+            entries.push_back(bulk_entry{get_bulk_key(o.second, box, 0), bulk_objects.size()});
+            bulk_objects.push_back(o.first);
+        }
+
+        return bulk_insert(bulk_objects, entries);
+    }
+
+    template<typename T>
+    template<typename Iterator>
+    ret_t QuadTree<T>::bulk_insert(Iterator first, Iterator last)
+    {
+        const std::size_t size = static_cast<std::size_t>(std::distance(first, last));
+
+        std::vector<T> objects;
+        std::vector<bulk_entry> entries;
+        objects.reserve(size);
+        entries.reserve(size);
+
+        for (; first != last; ++first)
+        {
+            entries.push_back(bulk_entry{get_bulk_key(get_object_bb(*first), box, 0), objects.size()});
+            objects.push_back(*first);
+        }
+
+        return bulk_insert(objects, entries);
+    }
+
+    template<typename T>
+    ret_t QuadTree<T>::bulk_insert(std::vector<T>& objects, std::vector<bulk_entry>& entries)
+    {
+        std::vector<bulk_entry> buffer(entries.size());
+
+        bulk_insert_range(objects, entries.begin(), entries.end(), buffer.begin(), 0);
+
+        return RET_OK;
+    }
+
+    template<typename T>
+    void QuadTree<T>::bulk_insert_range(std::vector<T>& objects,
+                                        bulk_iterator first,
+                                        bulk_iterator last,
+                                        bulk_iterator buffer,
+                                        unsigned int level)
+    {
+        if (first == last)
+            return;
+
+        if (is_leave())
+        {
+            const std::size_t count = children.size() + static_cast<std::size_t>(last - first);
+
+            // The leaf keeps all the objects, like insert() does until the node is full.
+            if (count <= max_entries || !is_splitable() || level >= bulk_key_levels)
+            {
+                for (bulk_iterator it = first; it != last; ++it)
+                    children.push_back(std::move(objects[it->index]));
+
+                return;
+            }
+
+            if (!children.empty())
+            {
+                // The objects already in the leaf are dispatched with the new ones, after the split.
+                std::vector<bulk_entry> entries;
+                entries.reserve(count);
+
+                for (auto& child : children)
+                {
+                    entries.push_back(bulk_entry{get_bulk_key(get_object_bb(child), box, level), objects.size()});
+                    objects.push_back(std::move(child));
+                }
+
+                entries.insert(entries.end(), first, last);
+                std::vector<bulk_entry> entries_buffer(entries.size());
+
+                children.clear();
+                split();
+                bulk_dispatch_range(objects, entries.begin(), entries.end(), entries_buffer.begin(), level);
+                return;
+            }
+
+            split();
+        }
+
+        bulk_dispatch_range(objects, first, last, buffer, level);
+    }
+
+    template<typename T>
+    void QuadTree<T>::bulk_dispatch_range(std::vector<T>& objects,
+                                          bulk_iterator first,
+                                          bulk_iterator last,
+                                          bulk_iterator buffer,
+                                          unsigned int level)
+    {
+        assert(!is_leave());
+
+        if (level >= bulk_key_levels)
+        {
+            for (bulk_iterator it = first; it != last; ++it)
+                children.push_back(std::move(objects[it->index]));
+
+            return;
+        }
+
+        const unsigned int shift = get_bulk_key_shift(level);
+
+        // Stable counting sort on the key digit of the level, so that the objects of a
+        // node keep their insertion order.
+        std::size_t offsets[6] = {0, 0, 0, 0, 0, 0};
+
+        for (bulk_iterator it = first; it != last; ++it)
+            offsets[((it->key >> shift) & 7) + 1]++;
+
+        for (unsigned int digit = 1; digit < 6; digit++)
+            offsets[digit] += offsets[digit - 1];
+
+        std::size_t positions[5] = {offsets[0], offsets[1], offsets[2], offsets[3], offsets[4]};
+
+        for (bulk_iterator it = first; it != last; ++it)
+            buffer[static_cast<std::ptrdiff_t>(positions[(it->key >> shift) & 7]++)] = *it;
+
+        std::copy(buffer, buffer + (last - first), first);
+
+        // Not within a quadrant, the objects stay in this node.
+        for (bulk_iterator it = first; it != first + static_cast<std::ptrdiff_t>(offsets[1]); ++it)
+            children.push_back(std::move(objects[it->index]));
+
+        for (unsigned int quadrant = 0; quadrant < 4; quadrant++)
+        {
+            const std::ptrdiff_t begin = static_cast<std::ptrdiff_t>(offsets[quadrant + 1]);
+            const std::ptrdiff_t end = static_cast<std::ptrdiff_t>(offsets[quadrant + 2]);
+
+            subtree_nodes[quadrant].bulk_insert_range(objects, first + begin, first + end, buffer + begin, level + 1);
+        }
+    }
+
     template<typename T>
     ret_t QuadTree<T>::remove(T object, const BoundingBox& bounding_box)
     {
@@ -446,10 +734,12 @@ namespace degate
         assert(found != nullptr);
         if (found != nullptr)
         {
-            if (std::find(found->children.begin(), found->children.end(), object) == found->children.end())
-                debug(TM, "Quadtree can't remove, object not found.");
+            const std::size_t size = found->children.size();
             found->children.remove(object);
 
+            if (found->children.size() == size)
+                debug(TM, "Quadtree can't remove, object not found.");
+
             if (!found->is_leave() && found->subtree_nodes[NW].children.size() == 0 &&
                 found->subtree_nodes[NE].children.size() == 0 && found->subtree_nodes[SW].children.size() == 0 &&
                 found->subtree_nodes[SE].children.size() == 0)
@@ -463,6 +753,64 @@ namespace degate
     }
 
 
+    template<typename T>
+    ret_t QuadTree<T>::bulk_remove(std::vector<std::pair<T, BoundingBox>> const& objects)
+    {
+        // The objects to remove, by node (in order of first use)
+        std::vector<std::pair<QuadTree<T>*, std::unordered_set<T>>> nodes;
+        std::unordered_map<QuadTree<T>*, std::size_t> node_indices;
+
+        for (auto const& object : objects)
+        {
+            QuadTree<T>* found = traverse_downto_bounding_box(object.second);
+            assert(found != nullptr);
+            if (found == nullptr)
+                return RET_ERR;
+
+            auto index = node_indices.insert(std::make_pair(found, nodes.size()));
+            if (index.second)
+                nodes.push_back(std::make_pair(found, std::unordered_set<T>()));
+
+            nodes[index.first->second].second.insert(object.first);
+        }
+
+        for (auto& node : nodes)
+        {
+            std::unordered_set<T> const& removed = node.second;
+
+            const std::size_t size = node.first->children.size();
+            node.first->children.remove_if([&removed](T const& child) { return removed.count(child) != 0; });
+
+            if (size - node.first->children.size() != removed.size())
+                debug(TM, "Quadtree can't remove, object not found.");
+        }
+
+        // Merging a node destroys its subtree nodes: the nodes are merged from the
+        // smallest ones, a subtree node being smaller than its parent.
+        std::stable_sort(nodes.begin(), nodes.end(), [](std::pair<QuadTree<T>*, std::unordered_set<T>> const& a,
+                                                         std::pair<QuadTree<T>*, std::unordered_set<T>> const& b)
+        {
+            return a.first->box.get_width() * a.first->box.get_height() <
+                   b.first->box.get_width() * b.first->box.get_height();
+        });
+
+        for (auto const& node : nodes)
+        {
+            QuadTree<T>* found = node.first;
+
+            if (!found->is_leave() && found->subtree_nodes[NW].children.size() == 0 &&
+                found->subtree_nodes[NE].children.size() == 0 && found->subtree_nodes[SW].children.size() == 0 &&
+                found->subtree_nodes[SE].children.size() == 0)
+            {
+                ret_t ret = reinsert_all_objects(found);
+                if (RET_IS_NOT_OK(ret))
+                    return ret;
+            }
+        }
+
+        return RET_OK;
+    }
+
     template<typename T>
     bool QuadTree<T>::is_leave() const
     {
@@ -550,6 +898,9 @@ namespace degate
     template<typename T>
     RegionIterator<T> QuadTree<T>::region_iter_begin(BoundingBox const& bbox)
     {
+        static Counter& region_queries = Instrumentation::get_instance().get_counter("quadtree.region_queries");
+        region_queries.add();
+
         return RegionIterator<T>(this, bbox);
     }
 
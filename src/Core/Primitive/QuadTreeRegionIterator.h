@@ -25,6 +25,7 @@
 // #define DEBUG_SHOW_ITER 1
 
 #include "Core/Primitive/BoundingBox.h"
+#include "Core/Utils/Instrumentation.h"
 #include "Core/Utils/Iterator.h"
 
 #include <list>
@@ -105,6 +106,8 @@ namespace degate
         }
         else
         {
+            static Counter& visited_nodes = Instrumentation::get_instance().get_counter("quadtree.visited_nodes");
+
             do
             {
 #ifdef DEBUG_SHOW_ITER
@@ -112,6 +115,7 @@ namespace degate
 #endif
                 node = open_list.front();
                 open_list.pop_front();
+                visited_nodes.add();
 
                 // add subtree nodes to open list
                 for (typename std::vector<QuadTree<T>>::iterator it = node->subtree_nodes.begin();
@@ -0,0 +1,154 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Project/ProjectAutoSaver.h"
+#include "Core/Project/ProjectExporter.h"
+#include "Core/Utils/FileSystem.h"
+#include "Globals.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <QtConcurrent/QtConcurrent>
+
+#include <stdexcept>
+
+using namespace degate;
+
+ProjectAutoSaver::ProjectAutoSaver()
+{
+    // One save at a time, without taking threads from the global pool.
+    pool.setMaxThreadCount(1);
+}
+
+ProjectAutoSaver::~ProjectAutoSaver()
+{
+    wait();
+}
+
+QFuture<void> ProjectAutoSaver::save(Project_shptr const& prj)
+{
+    if (prj == nullptr)
+        throw InvalidPointerException("Project pointer is nullptr.");
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+
+        if (saving)
+            return QFuture<void>();
+
+        saving = true;
+    }
+
+    Project_shptr snapshot;
+
+    try
+    {
+        snapshot = create_snapshot(prj);
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        saving = false;
+        throw;
+    }
+
+    future = QtConcurrent::run(&pool, [this, snapshot]()
+    {
+        std::string error;
+
+        try
+        {
+            save_snapshot(snapshot);
+        }
+        catch (const std::exception& ex)
+        {
+            error = ex.what();
+
+            if (error.empty())
+                error = "Unknown error.";
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        last_error = error;
+        saving = false;
+    });
+
+    return future;
+}
+
+bool ProjectAutoSaver::is_saving() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return saving;
+}
+
+void ProjectAutoSaver::wait()
+{
+    future.waitForFinished();
+}
+
+std::string ProjectAutoSaver::get_last_error() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return last_error;
+}
+
+Project_shptr ProjectAutoSaver::create_snapshot(Project_shptr const& prj)
+{
+    if (prj == nullptr)
+        throw InvalidPointerException("Project pointer is nullptr.");
+
+    DeepCopyable::oldnew_t oldnew;
+    return std::dynamic_pointer_cast<Project>(prj->clone_deep(&oldnew));
+}
+
+void ProjectAutoSaver::save_snapshot(Project_shptr const& snapshot)
+{
+    if (snapshot == nullptr)
+        throw InvalidPointerException("Project pointer is nullptr.");
+
+    const std::string directory = snapshot->get_project_directory();
+    if (!is_directory(directory))
+        throw InvalidPathException("The project directory doesn't exist.");
+
+    // In the project directory, so that the files can be renamed (and not copied) into place.
+    const std::string temp_directory =
+        join_pathes(directory, boost::filesystem::unique_path(".autosave.%%%%-%%%%-%%%%").string());
+    create_directory(temp_directory);
+
+    try
+    {
+        ProjectExporter exporter;
+        exporter.export_all(temp_directory, snapshot);
+
+        for (auto const& file : read_directory(temp_directory, true))
+        {
+            if (is_file(file))
+                move_file(file, join_pathes(directory, get_filename_from_path(file)));
+        }
+    }
+    catch (...)
+    {
+        remove_directory(temp_directory);
+        throw;
+    }
+
+    remove_directory(temp_directory);
+}
@@ -0,0 +1,114 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __PROJECTAUTOSAVER_H__
+#define __PROJECTAUTOSAVER_H__
+
+#include "Core/Project/Project.h"
+
+#include <QFuture>
+#include <QThreadPool>
+
+#include <mutex>
+#include <string>
+
+namespace degate
+{
+    /**
+     * @class ProjectAutoSaver
+     * @brief Save a project in the background.
+     *
+     * A save takes a snapshot of the project (a deep copy, see DeepCopyable) in the
+     * calling thread, then exports the snapshot from a worker thread. The project
+     * can be edited again as soon as save() returns.
+     *
+     * The project files are first exported to a temporary directory within the project
+     * directory, then renamed over the previous ones. A save that fails (or a crash
+     * during a save) doesn't leave partially written project files.
+     */
+    class ProjectAutoSaver
+    {
+    public:
+
+        /**
+         * Create an auto saver.
+         */
+        ProjectAutoSaver();
+
+        /**
+         * The dtor, waits for the running save (if any).
+         */
+        ~ProjectAutoSaver();
+
+        /**
+         * Take a snapshot of the project and save it in the background.
+         *
+         * @param prj The project to save.
+         * @return Returns the future of the save, or a finished future if another save
+         *   is still running (nothing is saved then).
+         * @exception InvalidPointerException This exception is thrown if \p prj is nullptr.
+         */
+        QFuture<void> save(Project_shptr const& prj);
+
+        /**
+         * Check if a save is running.
+         */
+        bool is_saving() const;
+
+        /**
+         * Wait for the running save (if any).
+         */
+        void wait();
+
+        /**
+         * Get the error of the last finished save.
+         *
+         * @return Returns an empty string if the last save succeeded.
+         */
+        std::string get_last_error() const;
+
+        /**
+         * Create a snapshot of a project: a deep copy that shares nothing
+         * with the project, except the background images.
+         */
+        static Project_shptr create_snapshot(Project_shptr const& prj);
+
+        /**
+         * Export a project to its project directory, through a temporary directory.
+         *
+         * @exception InvalidPathException This exception is thrown if the project
+         *   directory doesn't exist.
+         * @exception std::runtime_error This exception is thrown if the export fails.
+         */
+        static void save_snapshot(Project_shptr const& snapshot);
+
+    private:
+
+        QThreadPool pool;
+        QFuture<void> future;
+
+        mutable std::mutex mtx;
+        bool saving = false;
+        std::string last_error;
+    };
+}
+
+#endif
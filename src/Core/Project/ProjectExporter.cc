@@ -20,9 +20,11 @@
  */
 
 #include "Core/LogicModel/Gate/GateLibraryExporter.h"
+#include "Core/LogicModel/LogicModelBinaryExporter.h"
 #include "Core/LogicModel/LogicModelExporter.h"
 #include "Core/Project/ProjectExporter.h"
 #include "Core/RuleCheck/RCVBlacklistExporter.h"
+#include "Core/Utils/Instrumentation.h"
 #include "Core/Utils/ObjectIDRewriter.h"
 #include "Core/Version.h"
 #include "Globals.h"
@@ -41,7 +43,8 @@ void ProjectExporter::export_all(std::string const& project_directory,
                                  std::string const& project_file,
                                  std::string const& lmodel_file,
                                  std::string const& gatelib_file,
-                                 std::string const& rcbl_file)
+                                 std::string const& rcbl_file,
+                                 std::string const& binary_lmodel_file)
 {
     if (!is_directory(project_directory))
     {
@@ -49,25 +52,59 @@ void ProjectExporter::export_all(std::string const& project_directory,
     }
     else
     {
+        Instrumentation& instrumentation = Instrumentation::get_instance();
+
+        static Histogram& total_timer = instrumentation.get_timer("project_export.total");
+        ScopedTimer total(total_timer);
+
         ObjectIDRewriter_shptr oid_rewriter(new ObjectIDRewriter(enable_oid_rewrite));
 
+        static Histogram& project_timer = instrumentation.get_timer("project_export.project");
+        ScopedTimer project(project_timer);
+
         export_data(join_pathes(project_directory, project_file), prj);
 
+        project.stop();
+
         LogicModel_shptr lmodel = prj->get_logic_model();
 
         if (lmodel != nullptr)
         {
+            static Histogram& logic_model_timer = instrumentation.get_timer("project_export.logic_model");
+            ScopedTimer logic_model(logic_model_timer);
+
             LogicModelExporter lm_exporter(oid_rewriter);
             string lm_filename(join_pathes(project_directory, lmodel_file));
             lm_exporter.export_data(lm_filename, lmodel);
 
+            logic_model.stop();
+
+            // The binary logic model is optional, but once there it is loaded instead of lmodel.xml.
+            if (file_exists(join_pathes(project_directory, binary_lmodel_file)) ||
+                file_exists(join_pathes(prj->get_project_directory(), binary_lmodel_file)))
+            {
+                static Histogram& binary_logic_model_timer =
+                    instrumentation.get_timer("project_export.binary_logic_model");
+                ScopedTimer binary_logic_model(binary_logic_model_timer);
+
+                LogicModelBinaryExporter lm_binary_exporter(oid_rewriter);
+                lm_binary_exporter.export_data(join_pathes(project_directory, binary_lmodel_file), lmodel);
+            }
+
+            static Histogram& rcv_blacklist_timer = instrumentation.get_timer("project_export.rcv_blacklist");
+            ScopedTimer rcv_blacklist(rcv_blacklist_timer);
 
             RCVBlacklistExporter rcv_exporter(oid_rewriter);
             rcv_exporter.export_data(join_pathes(project_directory, rcbl_file), prj->get_rcv_blacklist());
 
+            rcv_blacklist.stop();
+
             GateLibrary_shptr glib = lmodel->get_gate_library();
             if (glib != nullptr)
             {
+                static Histogram& gate_library_timer = instrumentation.get_timer("project_export.gate_library");
+                ScopedTimer gate_library(gate_library_timer);
+
                 GateLibraryExporter gl_exporter(oid_rewriter);
                 gl_exporter.export_data(join_pathes(project_directory, gatelib_file), glib);
             }
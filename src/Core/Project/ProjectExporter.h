@@ -70,6 +70,8 @@ namespace degate
         void export_data(std::string const& filename, const Project_shptr& prj);
 
         /**
+         * Export the project files. If the project (or the target directory) has a binary
+         * logic model file, it is exported too, next to lmodel.xml, to be kept up to date.
          * @exception InvalidPathException
          * @exception InvalidPointerException
          * @exception std::runtime_error
@@ -79,7 +81,8 @@ namespace degate
                         std::string const& project_file = "project.xml",
                         std::string const& lmodel_file = "lmodel.xml",
                         std::string const& gatelib_file = "gate_library.xml",
-                        std::string const& rcbl_file = "rc_blacklist.xml");
+                        std::string const& rcbl_file = "rc_blacklist.xml",
+                        std::string const& binary_lmodel_file = "lmodel.bin");
     };
 }
 
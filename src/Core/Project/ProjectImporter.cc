@@ -21,9 +21,13 @@
 
 #include "Core/Project/ProjectImporter.h"
 #include "Core/LogicModel/Gate/GateLibraryImporter.h"
+#include "Core/LogicModel/LogicModelBinaryImporter.h"
 #include "Core/LogicModel/LogicModelImporter.h"
 #include "Core/RuleCheck/RCVBlacklistImporter.h"
 #include "Core/LogicModel/LogicModelHelper.h"
+#include "Core/Utils/Instrumentation.h"
+
+#include <boost/filesystem/operations.hpp>
 
 #include <QFileDialog>
 #include <QMessageBox>
@@ -46,10 +50,39 @@ std::string ProjectImporter::get_project_filename(std::string const& dir)
         return dir;
 }
 
+std::string ProjectImporter::get_logic_model_filename(std::string const& dir)
+{
+    const std::string xml_file = join_pathes(dir, "lmodel.xml");
+    const std::string binary_file = join_pathes(dir, "lmodel.bin");
+
+    if (!file_exists(binary_file))
+        return xml_file;
+
+    // A binary logic model older than lmodel.xml was not saved with it (e.g. by an older degate).
+    if (file_exists(xml_file) &&
+        boost::filesystem::last_write_time(xml_file) > boost::filesystem::last_write_time(binary_file))
+    {
+        debug(TM, "The binary logic model is older than lmodel.xml, it is ignored.");
+        return xml_file;
+    }
+
+    return binary_file;
+}
+
 Project_shptr ProjectImporter::import_all(std::string const& directory)
 {
+    Instrumentation& instrumentation = Instrumentation::get_instance();
+
+    static Histogram& total_timer = instrumentation.get_timer("project_import.total");
+    ScopedTimer total(total_timer);
+
+    static Histogram& project_timer = instrumentation.get_timer("project_import.project");
+    ScopedTimer project(project_timer);
+
     Project_shptr prj = import(directory);
 
+    project.stop();
+
     if (prj != nullptr)
     {
         GateLibraryImporter gl_importer;
@@ -59,24 +92,64 @@ Project_shptr ProjectImporter::import_all(std::string const& directory)
         std::string gate_lib_file(get_basedir(directory) + "/gate_library.xml");
         std::string rcbl_file(get_basedir(directory) + "/rc_blacklist.xml");
 
+        static Histogram& gate_library_timer = instrumentation.get_timer("project_import.gate_library");
+        ScopedTimer gate_library(gate_library_timer);
+
         if (file_exists(gate_lib_file))
             gate_lib = gl_importer.import(gate_lib_file);
         else gate_lib = std::make_shared<GateLibrary>();
 
-        LogicModelImporter lm_importer(prj->get_width(), prj->get_height(), gate_lib);
+        gate_library.stop();
+
+        static Histogram& logic_model_timer = instrumentation.get_timer("project_import.logic_model");
+        ScopedTimer logic_model(logic_model_timer);
+
+        // The format of the logic model file is detected from its content.
+        std::string lmodel_file = get_logic_model_filename(get_basedir(directory));
+        const std::string xml_lmodel_file = join_pathes(get_basedir(directory), "lmodel.xml");
 
-        lm_importer.import_into(prj->get_logic_model(),
-                                get_basedir(directory) + "/lmodel.xml");
+        bool binary_loaded = false;
+        if (LogicModelBinaryFile::is_binary_file(lmodel_file))
+        {
+            try
+            {
+                LogicModelBinaryImporter lm_importer(prj->get_width(), prj->get_height(), gate_lib);
+                lm_importer.import_into(prj->get_logic_model(), lmodel_file);
+                binary_loaded = true;
+            }
+            catch (InvalidPathException const&)
+            {
+                // The binary file can't be opened or mapped, the logic model is still empty.
+                if (lmodel_file == xml_lmodel_file || !file_exists(xml_lmodel_file))
+                    throw;
+
+                debug(TM, "Can't map the binary logic model, load lmodel.xml instead.");
+                lmodel_file = xml_lmodel_file;
+            }
+        }
+
+        if (!binary_loaded)
+        {
+            LogicModelImporter lm_importer(prj->get_width(), prj->get_height(), gate_lib);
+            lm_importer.import_into(prj->get_logic_model(), lmodel_file);
+        }
+
+        logic_model.stop();
 
         LogicModel_shptr lmodel = prj->get_logic_model();
         lmodel->set_default_gate_port_diameter(prj->get_default_port_diameter());
 
+        static Histogram& rcv_blacklist_timer = instrumentation.get_timer("project_import.rcv_blacklist");
+        ScopedTimer rcv_blacklist(rcv_blacklist_timer);
+
         if (file_exists(rcbl_file))
         {
             RCVBlacklistImporter rcvbl_importer(lmodel);
             rcvbl_importer.import_into(rcbl_file, prj->get_rcv_blacklist());
         }
 
+        rcv_blacklist.stop();
+
         /*
       For degate projects that were exported with degate 0.0.6 the gate templates
       were expressed in terms of an image region. This is bad. Here is a part of the fix:
@@ -86,6 +159,9 @@ Project_shptr ProjectImporter::import_all(std::string const& directory)
       transistor, the first logic and the first metal layer.
         */
 
+        static Histogram& template_images_timer = instrumentation.get_timer("project_import.template_images");
+        ScopedTimer template_images(template_images_timer);
+
         debug(TM, "Check if we have template images.");
         for (auto& iter : *gate_lib)
         {
@@ -102,6 +178,9 @@ Project_shptr ProjectImporter::import_all(std::string const& directory)
                 grab_template_images(lmodel, tmpl, bbox);
             }
         }
+
+        template_images.stop();
+
         debug(TM, "Project loaded.");
         //prj->print_all(cout);
     }
@@ -81,12 +81,19 @@ namespace degate
 
         /**
          * Import a complete degate project, including the default gate library and the logic model.
+         * The logic model is loaded from lmodel.xml if the binary logic model can't be mapped.
          * @param path The parameter path specifies the project directory
          *             or the path to the project.xml file. It is determined automatically.
          * @exception std::runtime_error If there are parsing problems.
          * @return Returns a pointer to a project object.
          */
         Project_shptr import_all(std::string const& path);
+
+        /**
+         * Get the logic model file of a project directory: the binary logic model
+         * (lmodel.bin) if there is one that is up to date, lmodel.xml otherwise.
+         */
+        static std::string get_logic_model_filename(std::string const& dir);
     };
 }
 
@@ -0,0 +1,117 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __BOUNDEDQUEUE_H__
+#define __BOUNDEDQUEUE_H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace degate
+{
+    /**
+     * @class BoundedQueue
+     * @brief Thread-safe FIFO queue with a maximum size, to chain pipeline stages.
+     *
+     * Producers block while the queue is full and consumers block while it is
+     * empty, so a fast stage can't buffer an unbounded amount of data.
+     *
+     * Once closed, push() fails and pop() returns the remaining values, then fails.
+     */
+    template<typename T>
+    class BoundedQueue
+    {
+    private:
+
+        std::deque<T> values;
+        std::size_t capacity;
+        bool closed = false;
+
+        std::mutex mtx;
+        std::condition_variable not_empty, not_full;
+
+    public:
+
+        /**
+         * Create a queue.
+         *
+         * @param capacity The maximum number of values in the queue (at least 1).
+         */
+        explicit BoundedQueue(std::size_t capacity) : capacity(capacity > 0 ? capacity : 1)
+        {
+        }
+
+        /**
+         * Add a value, waiting while the queue is full.
+         *
+         * @return Returns false if the queue was closed (the value is dropped).
+         */
+        bool push(T value)
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            not_full.wait(lock, [this] { return closed || values.size() < capacity; });
+
+            if (closed)
+                return false;
+
+            values.push_back(std::move(value));
+            not_empty.notify_one();
+
+            return true;
+        }
+
+        /**
+         * Take the oldest value, waiting while the queue is empty.
+         *
+         * @return Returns false if the queue is closed and empty.
+         */
+        bool pop(T& value)
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            not_empty.wait(lock, [this] { return closed || !values.empty(); });
+
+            if (values.empty())
+                return false;
+
+            value = std::move(values.front());
+            values.pop_front();
+            not_full.notify_one();
+
+            return true;
+        }
+
+        /**
+         * Close the queue and wake up all waiting producers and consumers.
+         */
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            closed = true;
+
+            not_empty.notify_all();
+            not_full.notify_all();
+        }
+    };
+}
+
+#endif
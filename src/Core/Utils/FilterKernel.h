@@ -86,6 +86,49 @@ namespace degate
             data[row * columns + column] = val;
         }
 
+        /**
+         * Check if the kernel is separable, i.e. the product of a row vector and a column
+         * vector: get(column, row) == horizontal[column] * vertical[row].
+         *
+         * @param horizontal The row vector, set if the kernel is separable.
+         * @param vertical The column vector, set if the kernel is separable.
+         * @return Returns true if the kernel is separable.
+         */
+        bool get_separable_factors(std::vector<double>& horizontal, std::vector<double>& vertical) const
+        {
+            // Factors taken from the row and the column of the largest coefficient
+            unsigned int pivot = 0;
+            for (unsigned int i = 1; i < data.size(); i++)
+                if (std::fabs(data[i]) > std::fabs(data[pivot]))
+                    pivot = i;
+
+            if (data.empty() || data[pivot] == 0)
+                return false;
+
+            const unsigned int pivot_column = pivot % columns;
+            const unsigned int pivot_row = pivot / columns;
+
+            std::vector<double> h(columns), v(rows);
+
+            for (unsigned int x = 0; x < columns; x++)
+                h[x] = get(x, pivot_row);
+
+            for (unsigned int y = 0; y < rows; y++)
+                v[y] = get(pivot_column, y) / data[pivot];
+
+            const double tolerance = 1e-12 * std::fabs(data[pivot]);
+
+            for (unsigned int y = 0; y < rows; y++)
+                for (unsigned int x = 0; x < columns; x++)
+                    if (std::fabs(get(x, y) - h[x] * v[y]) > tolerance)
+                        return false;
+
+            horizontal.swap(h);
+            vertical.swap(v);
+
+            return true;
+        }
+
         void print() const
         {
             unsigned int x, y;
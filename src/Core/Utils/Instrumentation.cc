@@ -0,0 +1,215 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Utils/Instrumentation.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <sstream>
+
+using namespace degate;
+
+std::atomic<bool> Instrumentation::enabled{false};
+
+namespace
+{
+    Histogram& get_or_create(std::map<std::string, std::unique_ptr<Histogram>>& histograms, std::string const& name)
+    {
+        std::unique_ptr<Histogram>& histogram = histograms[name];
+        if (histogram == nullptr)
+            histogram.reset(new Histogram());
+
+        return *histogram;
+    }
+
+    void write_string(std::ostream& os, std::string const& str)
+    {
+        os << '"';
+
+        for (char c : str)
+        {
+            if (c == '"' || c == '\\')
+                os << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned int>(c));
+                os << buffer;
+            }
+            else
+                os << c;
+        }
+
+        os << '"';
+    }
+
+    void write_histogram(std::ostream& os, Instrumentation::metric_values const& values, double unit)
+    {
+        os << "{\"count\": " << values.count
+           << ", \"sum\": " << values.sum * unit
+           << ", \"min\": " << values.min * unit
+           << ", \"max\": " << values.max * unit
+           << ", \"mean\": " << (values.count == 0 ? 0. : values.sum * unit / values.count)
+           << ", \"buckets\": [";
+
+        bool first = true;
+        for (unsigned int bucket = 0; bucket < values.buckets.size(); bucket++)
+        {
+            if (values.buckets[bucket] == 0)
+                continue;
+
+            os << (first ? "" : ", ") << "{\"max\": " << Histogram::get_bucket_max(bucket) * unit
+               << ", \"count\": " << values.buckets[bucket] << "}";
+            first = false;
+        }
+
+        os << "]}";
+    }
+}
+
+void Histogram::reset()
+{
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    min.store(std::numeric_limits<uint_fast64_t>::max(), std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+
+    for (auto& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+Instrumentation& Instrumentation::get_instance()
+{
+    // Never destroyed, see the class description.
+    static Instrumentation* instance = new Instrumentation();
+    return *instance;
+}
+
+void Instrumentation::set_enabled(bool state)
+{
+    enabled.store(state, std::memory_order_relaxed);
+}
+
+Counter& Instrumentation::get_counter(std::string const& name)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    std::unique_ptr<Counter>& counter = counters[name];
+    if (counter == nullptr)
+        counter.reset(new Counter());
+
+    return *counter;
+}
+
+Histogram& Instrumentation::get_histogram(std::string const& name)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return get_or_create(histograms, name);
+}
+
+Histogram& Instrumentation::get_timer(std::string const& name)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return get_or_create(timers, name);
+}
+
+std::vector<Instrumentation::metric_values> Instrumentation::get_values() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    std::vector<metric_values> values;
+
+    for (auto const& counter : counters)
+        values.push_back(metric_values{counter.first, COUNTER, counter.second->get_value(), 0, 0, 0, {}});
+
+    for (int type = HISTOGRAM; type <= TIMER; type++)
+    {
+        for (auto const& histogram : (type == HISTOGRAM ? histograms : timers))
+        {
+            Histogram const& h = *histogram.second;
+
+            metric_values value{histogram.first, static_cast<metric_type>(type),
+                                h.get_count(), h.get_sum(), h.get_min(), h.get_max(), {}};
+
+            value.buckets.resize(Histogram::bucket_count);
+            for (unsigned int bucket = 0; bucket < Histogram::bucket_count; bucket++)
+                value.buckets[bucket] = h.get_bucket_count(bucket);
+
+            values.push_back(value);
+        }
+    }
+
+    std::sort(values.begin(), values.end(), [](metric_values const& a, metric_values const& b) {
+        return a.name < b.name;
+    });
+
+    return values;
+}
+
+void Instrumentation::reset()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    for (auto& counter : counters)
+        counter.second->reset();
+
+    for (auto& histogram : histograms)
+        histogram.second->reset();
+
+    for (auto& timer : timers)
+        timer.second->reset();
+}
+
+void Instrumentation::write_json(std::ostream& os) const
+{
+    const std::vector<metric_values> values = get_values();
+
+    std::ostringstream counters_stm, histograms_stm, timers_stm;
+    counters_stm.precision(std::numeric_limits<double>::max_digits10);
+    histograms_stm.precision(std::numeric_limits<double>::max_digits10);
+    timers_stm.precision(std::numeric_limits<double>::max_digits10);
+
+    for (auto const& value : values)
+    {
+        std::ostringstream& stm = value.type == COUNTER ? counters_stm :
+                                  value.type == HISTOGRAM ? histograms_stm : timers_stm;
+
+        if (stm.tellp() > 0)
+            stm << ",\n";
+
+        stm << "    ";
+        write_string(stm, value.name);
+        stm << ": ";
+
+        if (value.type == COUNTER)
+            stm << value.count;
+        else
+            write_histogram(stm, value, value.type == TIMER ? 1e-9 : 1.);
+    }
+
+    os << "{\n"
+       << "  \"enabled\": " << (is_enabled() ? "true" : "false") << ",\n"
+       << "  \"counters\": {\n" << counters_stm.str() << "\n  },\n"
+       << "  \"histograms\": {\n" << histograms_stm.str() << "\n  },\n"
+       << "  \"timers\": {\n" << timers_stm.str() << "\n  }\n"
+       << "}\n";
+}
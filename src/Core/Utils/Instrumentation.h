@@ -0,0 +1,365 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __INSTRUMENTATION_H__
+#define __INSTRUMENTATION_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace degate
+{
+    /**
+     * @class Counter
+     * @brief Monotonic counter of the instrumentation.
+     *
+     * @see Instrumentation
+     */
+    class Counter
+    {
+    public:
+
+        Counter() = default;
+        Counter(Counter const&) = delete;
+        Counter& operator=(Counter const&) = delete;
+
+        /**
+         * Add to the counter, if the instrumentation is enabled.
+         */
+        inline void add(uint_fast64_t value = 1);
+
+        /**
+         * Get the value of the counter.
+         */
+        uint_fast64_t get_value() const
+        {
+            return value.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Set the counter back to 0.
+         */
+        void reset()
+        {
+            value.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<uint_fast64_t> value{0};
+    };
+
+    /**
+     * @class Histogram
+     * @brief Distribution of values of the instrumentation (e.g. durations).
+     *
+     * Values are counted in power of 2 buckets: bucket 0 holds 0 and bucket
+     * i > 0 holds the values in [2^(i-1), 2^i - 1].
+     *
+     * @see Instrumentation
+     */
+    class Histogram
+    {
+    public:
+
+        const static unsigned int bucket_count = 65;
+
+        Histogram()
+        {
+            reset();
+        }
+
+        Histogram(Histogram const&) = delete;
+        Histogram& operator=(Histogram const&) = delete;
+
+        /**
+         * Add a value, if the instrumentation is enabled.
+         */
+        inline void add(uint_fast64_t value);
+
+        /**
+         * Get the bucket of a value.
+         */
+        static unsigned int get_bucket(uint_fast64_t value)
+        {
+            // Bit width of the value.
+            unsigned int width = 0;
+            for (unsigned int shift = 32; shift > 0; shift /= 2)
+            {
+                if ((value >> shift) != 0)
+                {
+                    width += shift;
+                    value >>= shift;
+                }
+            }
+
+            return width + static_cast<unsigned int>(value);
+        }
+
+        /**
+         * Get the largest value of a bucket.
+         */
+        static uint_fast64_t get_bucket_max(unsigned int bucket)
+        {
+            return bucket >= 64 ? ~uint_fast64_t(0) : (uint_fast64_t(1) << bucket) - 1;
+        }
+
+        uint_fast64_t get_count() const
+        {
+            return count.load(std::memory_order_relaxed);
+        }
+
+        uint_fast64_t get_sum() const
+        {
+            return sum.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Get the smallest value, 0 if there is no value.
+         */
+        uint_fast64_t get_min() const
+        {
+            return get_count() == 0 ? 0 : min.load(std::memory_order_relaxed);
+        }
+
+        uint_fast64_t get_max() const
+        {
+            return max.load(std::memory_order_relaxed);
+        }
+
+        uint_fast64_t get_bucket_count(unsigned int bucket) const
+        {
+            return buckets[bucket].load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Remove all the values.
+         */
+        void reset();
+
+    private:
+        std::atomic<uint_fast64_t> count;
+        std::atomic<uint_fast64_t> sum;
+        std::atomic<uint_fast64_t> min;
+        std::atomic<uint_fast64_t> max;
+        std::atomic<uint_fast64_t> buckets[bucket_count];
+    };
+
+    /**
+     * @class Instrumentation
+     * @brief Registry of the counters, histograms and timers used to see where the time is spent.
+     *
+     * Metrics are created on the first request for their name (e.g. "tile_cache.misses")
+     * and live as long as the program, so a reference on a metric can be kept, typically
+     * in a function static variable:
+     *
+     *   static Counter& misses = Instrumentation::get_instance().get_counter("tile_cache.misses");
+     *   misses.add();
+     *
+     *   static Histogram& scan = Instrumentation::get_instance().get_timer("template_matching.scan");
+     *   ScopedTimer timer(scan);
+     *
+     * Recording is thread-safe and lock-free. The instrumentation is disabled by default:
+     * recording then only tests a flag.
+     *
+     * The registry is never destroyed, so metrics can still be recorded at exit
+     * (e.g. when the tile caches release their memory).
+     */
+    class Instrumentation
+    {
+    public:
+
+        /**
+         * Type of a metric.
+         */
+        enum metric_type
+        {
+            COUNTER,
+            HISTOGRAM,
+            TIMER
+        };
+
+        /**
+         * Values of a metric, at the time they were read.
+         * Timer values are in nanoseconds.
+         */
+        struct metric_values
+        {
+            std::string name;
+            metric_type type;
+
+            // The counter value, or the number of values of a histogram or a timer.
+            uint_fast64_t count;
+
+            uint_fast64_t sum;
+            uint_fast64_t min;
+            uint_fast64_t max;
+
+            // Histograms and timers, the number of values per bucket.
+            std::vector<uint_fast64_t> buckets;
+        };
+
+        /**
+         * Get the registry.
+         */
+        static Instrumentation& get_instance();
+
+        /**
+         * Check if metrics are recorded.
+         */
+        static inline bool is_enabled()
+        {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Enable or disable the recording of the metrics.
+         * The values are kept when the instrumentation is disabled.
+         */
+        static void set_enabled(bool state);
+
+        /**
+         * Get a counter, created if needed.
+         */
+        Counter& get_counter(std::string const& name);
+
+        /**
+         * Get a histogram, created if needed.
+         */
+        Histogram& get_histogram(std::string const& name);
+
+        /**
+         * Get a timer (a histogram of durations in nanoseconds), created if needed.
+         * @see ScopedTimer
+         */
+        Histogram& get_timer(std::string const& name);
+
+        /**
+         * Read the values of all the metrics, sorted by name.
+         */
+        std::vector<metric_values> get_values() const;
+
+        /**
+         * Set all the metrics back to 0.
+         */
+        void reset();
+
+        /**
+         * Write the values of all the metrics as a JSON object. Counters are written
+         * as numbers. Histograms and timers have their count, sum, min, max, mean and
+         * non-empty buckets (with the largest value of the bucket). Timers are in seconds.
+         */
+        void write_json(std::ostream& os) const;
+
+    private:
+
+        Instrumentation() = default;
+        Instrumentation(Instrumentation const&) = delete;
+        Instrumentation& operator=(Instrumentation const&) = delete;
+
+        static std::atomic<bool> enabled;
+
+        mutable std::mutex mtx;
+
+        std::map<std::string, std::unique_ptr<Counter>> counters;
+        std::map<std::string, std::unique_ptr<Histogram>> histograms;
+        std::map<std::string, std::unique_ptr<Histogram>> timers;
+    };
+
+    /**
+     * @class ScopedTimer
+     * @brief Add the duration of a scope to a timer, if the instrumentation is enabled.
+     *
+     * @see Instrumentation::get_timer()
+     */
+    class ScopedTimer
+    {
+    public:
+
+        explicit ScopedTimer(Histogram& timer) : timer(timer), running(Instrumentation::is_enabled())
+        {
+            if (running)
+                start = std::chrono::steady_clock::now();
+        }
+
+        ~ScopedTimer()
+        {
+            stop();
+        }
+
+        /**
+         * Add the duration since the construction to the timer, before the end of the scope.
+         * Further calls do nothing.
+         */
+        void stop()
+        {
+            if (!running)
+                return;
+
+            running = false;
+            timer.add(static_cast<uint_fast64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                    .count()));
+        }
+
+        ScopedTimer(ScopedTimer const&) = delete;
+        ScopedTimer& operator=(ScopedTimer const&) = delete;
+
+    private:
+        Histogram& timer;
+        bool running;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    inline void Counter::add(uint_fast64_t value)
+    {
+        if (Instrumentation::is_enabled())
+            this->value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    inline void Histogram::add(uint_fast64_t value)
+    {
+        if (!Instrumentation::is_enabled())
+            return;
+
+        count.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+        buckets[get_bucket(value)].fetch_add(1, std::memory_order_relaxed);
+
+        uint_fast64_t current = min.load(std::memory_order_relaxed);
+        while (value < current && !min.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+
+        current = max.load(std::memory_order_relaxed);
+        while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+}
+
+#endif
@@ -39,6 +39,7 @@ namespace degate
         MAP_STORAGE_TYPE_MEM = 0,
         MAP_STORAGE_TYPE_PERSISTENT_FILE = 1,
         MAP_STORAGE_TYPE_TEMP_FILE = 2,
+        MAP_STORAGE_TYPE_READ_ONLY_FILE = 3,
     };
 
 
@@ -77,6 +78,11 @@ namespace degate
             return storage_type == MAP_STORAGE_TYPE_PERSISTENT_FILE;
         }
 
+        bool is_read_only_file() const
+        {
+            return storage_type == MAP_STORAGE_TYPE_READ_ONLY_FILE;
+        }
+
         bool is_mem() const
         {
             return storage_type == MAP_STORAGE_TYPE_MEM;
@@ -93,9 +99,15 @@ namespace degate
         /**
          * Create a file based memory chunk.
          * The storage is filebases. The file is mapped into memory.
+         *
+         * With MAP_STORAGE_TYPE_READ_ONLY_FILE, the file must exist and hold at least
+         * width * height elements. It is mapped read-only and never resized, the memory
+         * map must not be written. If the file can't be opened or mapped, data() is null.
+         *
          * @param width The width of a 2D map.
          * @param height The height of a 2D map.
-         * @param mode Is either MAP_STORAGE_TYPE_PERSISTENT_FILE or MAP_STORAGE_TYPE_TEMP_FILE.
+         * @param mode Is either MAP_STORAGE_TYPE_PERSISTENT_FILE, MAP_STORAGE_TYPE_TEMP_FILE
+         *   or MAP_STORAGE_TYPE_READ_ONLY_FILE.
          * @param file_to_map The name of the file, which should be mmap().
          */
         MemoryMap(unsigned int width, unsigned int height, MAP_STORAGE_TYPE mode, std::string const& file_to_map);
@@ -162,6 +174,15 @@ namespace degate
         {
             return mem_view;
         };
+
+        /**
+         * Get data (can be null).
+         * @return Returns data.
+         */
+        const T* data() const
+        {
+            return mem_view;
+        };
     };
 
     template<typename T>
@@ -170,6 +191,7 @@ namespace degate
           height(height),
           storage_type(MAP_STORAGE_TYPE_MEM),
           mem_size(width * height * sizeof(T)),
+          backing_file(nullptr),
           mem_view(nullptr)
     {
         assert(width > 0 && height > 0);
@@ -186,10 +208,12 @@ namespace degate
         : width(width),
           height(height),
           storage_type(mode),
-          mem_size(width * height * sizeof(T)),
+          mem_size(static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * sizeof(T)),
+          backing_file(nullptr),
           mem_view(nullptr)
     {
-        assert(mode == MAP_STORAGE_TYPE_PERSISTENT_FILE || mode == MAP_STORAGE_TYPE_TEMP_FILE);
+        assert(mode == MAP_STORAGE_TYPE_PERSISTENT_FILE || mode == MAP_STORAGE_TYPE_TEMP_FILE ||
+               mode == MAP_STORAGE_TYPE_READ_ONLY_FILE);
 
         assert(width > 0 && height > 0);
 
@@ -207,8 +231,9 @@ namespace degate
         }
         else
         {
+            // A read-only file is not created if it doesn't exist
             auto persistent_file = std::make_unique<QFile>(QString::fromStdString(file_to_map));
-            if (persistent_file->open(QFile::ReadWrite))
+            if (persistent_file->open(mode == MAP_STORAGE_TYPE_READ_ONLY_FILE ? QFile::ReadOnly : QFile::ReadWrite))
             {
                 file = std::move(persistent_file);
             }
@@ -234,7 +259,8 @@ namespace degate
             backing_file = file.release();
         }
 
-        assert(RET_IS_OK(ret));
+        // An unreadable existing file is not a programming error, the caller checks data()
+        assert(RET_IS_OK(ret) || mode == MAP_STORAGE_TYPE_READ_ONLY_FILE);
     }
 
 
@@ -249,6 +275,7 @@ namespace degate
 
             case MAP_STORAGE_TYPE_PERSISTENT_FILE:
             case MAP_STORAGE_TYPE_TEMP_FILE:
+            case MAP_STORAGE_TYPE_READ_ONLY_FILE:
                 unmap();
                 break;
         }
@@ -324,15 +351,29 @@ namespace degate
     ret_t MemoryMap<T>::map_file(QFile* file)
     {
         assert(file);
-        assert(is_persistent_file() || is_temp_file());
+        assert(is_persistent_file() || is_temp_file() || is_read_only_file());
 
-        if (!file->resize(mem_size))
+        if (is_read_only_file())
         {
-            debug(TM, "cannot resize file %s", file->fileName().toLatin1().constData());
-            return RET_ERR;
+            if (static_cast<std::size_t>(file->size()) < mem_size)
+            {
+                debug(TM, "file %s is too small", file->fileName().toLatin1().constData());
+                return RET_ERR;
+            }
+
+            mem_view = reinterpret_cast<T*>(file->map(0, static_cast<qint64>(mem_size)));
+        }
+        else
+        {
+            if (!file->resize(mem_size))
+            {
+                debug(TM, "cannot resize file %s", file->fileName().toLatin1().constData());
+                return RET_ERR;
+            }
+
+            mem_view = reinterpret_cast<T*>(file->map(0, file->size()));
         }
 
-        mem_view = reinterpret_cast<T*>(file->map(0, file->size()));
         if (mem_view == nullptr)
         {
             debug(TM, "cannot create memory map");
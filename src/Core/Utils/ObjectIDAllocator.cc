@@ -0,0 +1,134 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Utils/ObjectIDAllocator.h"
+#include "Core/Utils/DegateExceptions.h"
+
+#include <cassert>
+#include <iterator>
+#include <limits>
+
+using namespace degate;
+
+ObjectIDAllocator::ObjectIDAllocator() : last_allocated(0)
+{
+    // 0 is the invalid object ID
+    free_ranges[std::numeric_limits<object_id_t>::max()] = 1;
+}
+
+object_id_t ObjectIDAllocator::allocate()
+{
+    if (free_ranges.empty())
+        throw DegateRuntimeException("There is no object ID left.");
+
+    auto range = free_ranges.begin();
+    object_id_t id = range->second;
+
+    if (range->second == range->first)
+        free_ranges.erase(range);
+    else
+        range->second++;
+
+    last_allocated = id;
+    return id;
+}
+
+object_id_t ObjectIDAllocator::allocate_block(object_id_t count)
+{
+    assert(count > 0);
+
+    // The last range is usually the largest one, so look for a block from the end
+    for (auto range = free_ranges.rbegin(); range != free_ranges.rend(); ++range)
+    {
+        if (range->first - range->second < count - 1)
+            continue;
+
+        object_id_t first = range->second;
+
+        if (range->first - range->second == count - 1)
+            free_ranges.erase(std::next(range).base());
+        else
+            range->second += count;
+
+        return first;
+    }
+
+    throw DegateRuntimeException("There is no block of object IDs left.");
+}
+
+void ObjectIDAllocator::reserve(object_id_t id)
+{
+    auto range = free_ranges.lower_bound(id);
+    if (range == free_ranges.end() || range->second > id)
+        return;
+
+    object_id_t first = range->second;
+    object_id_t last = range->first;
+
+    if (first == id)
+    {
+        if (first == last)
+            free_ranges.erase(range);
+        else
+            range->second++;
+        return;
+    }
+
+    // Keep [first, id - 1], the key of the range changes
+    auto hint = range;
+    if (last == id)
+        hint = free_ranges.erase(range);
+    else
+        range->second = id + 1;
+
+    free_ranges.insert(hint, std::make_pair(id - 1, first));
+}
+
+void ObjectIDAllocator::release(object_id_t id)
+{
+    if (id == 0 || id <= last_allocated)
+        return;
+
+    auto next = free_ranges.lower_bound(id);
+    if (next != free_ranges.end() && next->second <= id)
+        return;
+
+    // Merge with the range ending at id - 1
+    object_id_t first = id;
+    auto previous = free_ranges.find(id - 1);
+    if (previous != free_ranges.end())
+    {
+        first = previous->second;
+        free_ranges.erase(previous);
+    }
+
+    // Merge with the range starting at id + 1
+    if (next != free_ranges.end() && next->second == id + 1)
+        next->second = first;
+    else
+        free_ranges.insert(next, std::make_pair(id, first));
+}
+
+bool ObjectIDAllocator::is_free(object_id_t id) const
+{
+    auto range = free_ranges.lower_bound(id);
+    return id != 0 && range != free_ranges.end() && range->second <= id;
+}
@@ -0,0 +1,96 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __OBJECTIDALLOCATOR_H__
+#define __OBJECTIDALLOCATOR_H__
+
+#include "Globals.h"
+
+#include <map>
+
+namespace degate
+{
+    /**
+     * @class ObjectIDAllocator
+     * @brief Keep track of the free object IDs of a logic model.
+     *
+     * A new ID is the smallest free ID above the last new ID, like a counter that
+     * skips the IDs in use. IDs below the last new ID are not tracked: an ID released
+     * there is never given again. An ID released above the last new ID (e.g. the ID of
+     * a loaded object that is removed) is free again, and can be given again.
+     *
+     * The free IDs are stored as ranges, so getting a new ID is done in constant time
+     * and marking an ID as used or free is logarithmic in the number of ranges.
+     */
+    class ObjectIDAllocator
+    {
+    public:
+
+        /**
+         * Create an allocator with all the IDs free.
+         */
+        ObjectIDAllocator();
+
+        /**
+         * Get a new ID, the ID is marked as used.
+         * @exception DegateRuntimeException Is thrown if there is no ID left.
+         */
+        object_id_t allocate();
+
+        /**
+         * Reserve a block of consecutive IDs, e.g. to assign IDs to objects created
+         * in parallel without going through the allocator for each object.
+         * @param count : the number of IDs, must be greater than 0.
+         * @return Returns the first ID of the block [first, first + count - 1].
+         * @exception DegateRuntimeException Is thrown if there is no such block left.
+         */
+        object_id_t allocate_block(object_id_t count);
+
+        /**
+         * Mark an ID as used, e.g. the ID of an object loaded from a file.
+         * Marking an ID already in use does nothing.
+         */
+        void reserve(object_id_t id);
+
+        /**
+         * Mark an ID as free again. An ID above the last new ID can be given again,
+         * an ID at or below the last new ID is never given again.
+         */
+        void release(object_id_t id);
+
+        /**
+         * Check if an ID would still be given.
+         */
+        bool is_free(object_id_t id) const;
+
+    private:
+
+        /**
+         * The free ranges above the last new ID, as [first, last] ranges by last ID.
+         * Keying by the last ID lets allocate() move the first ID of a range in place.
+         */
+        std::map<object_id_t, object_id_t> free_ranges;
+
+        object_id_t last_allocated;
+    };
+}
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "InstrumentationDialog.h"
+
+#include <QFileDialog>
+#include <QMessageBox>
+
+#include <fstream>
+
+namespace degate
+{
+    InstrumentationDialog::InstrumentationDialog(QWidget* parent)
+            : QDialog(parent)
+    {
+        setWindowTitle(tr("Instrumentation"));
+        setWindowIcon(QIcon(":/degate_logo.png"));
+
+        // Enable
+        enable_checkbox.setText(tr("Record counters and timers"));
+        enable_checkbox.setChecked(Instrumentation::is_enabled());
+        QObject::connect(&enable_checkbox, SIGNAL(stateChanged(int)), this, SLOT(enable_changed(int)));
+
+        // Table
+        table.setColumnCount(7);
+        table.setSelectionBehavior(QAbstractItemView::SelectionBehavior::SelectRows);
+
+        QStringList list;
+        list.append(tr("Name"));
+        list.append(tr("Count"));
+        list.append(tr("Sum"));
+        list.append(tr("Min"));
+        list.append(tr("Max"));
+        list.append(tr("Mean"));
+        list.append(tr("Unit"));
+        table.setHorizontalHeaderLabels(list);
+
+        // Buttons
+        refresh_button.setText(tr("Refresh"));
+        refresh_button.setFocusPolicy(Qt::NoFocus);
+        QObject::connect(&refresh_button, SIGNAL(clicked()), this, SLOT(refresh()));
+        control_layout.addWidget(&refresh_button, 0, 0);
+
+        reset_button.setText(tr("Reset"));
+        reset_button.setFocusPolicy(Qt::NoFocus);
+        QObject::connect(&reset_button, SIGNAL(clicked()), this, SLOT(reset()));
+        control_layout.addWidget(&reset_button, 0, 1);
+
+        export_button.setText(tr("Export as JSON"));
+        export_button.setFocusPolicy(Qt::NoFocus);
+        QObject::connect(&export_button, SIGNAL(clicked()), this, SLOT(export_json()));
+        control_layout.addWidget(&export_button, 0, 2);
+
+        close_button.setText(tr("Close"));
+        QObject::connect(&close_button, SIGNAL(clicked()), this, SLOT(accept()));
+        control_layout.addWidget(&close_button, 0, 3);
+
+        layout.addWidget(&enable_checkbox, 0, 0);
+        layout.addWidget(&table, 1, 0);
+        layout.addLayout(&control_layout, 2, 0);
+        layout.setRowStretch(1, 1);
+
+        setLayout(&layout);
+
+        if (parent != nullptr)
+            resize(parent->size() * 0.6);
+
+        refresh();
+    }
+
+    void InstrumentationDialog::refresh()
+    {
+        table.clearContents();
+        table.setRowCount(0);
+
+        for (auto const& metric : Instrumentation::get_instance().get_values())
+        {
+            const int row = table.rowCount();
+            table.insertRow(row);
+
+            QStringList values;
+            values.append(QString::fromStdString(metric.name));
+            values.append(QString::number(metric.count));
+
+            if (metric.type == Instrumentation::COUNTER)
+            {
+                values.append("");
+                values.append("");
+                values.append("");
+                values.append("");
+                values.append("");
+            }
+            else
+            {
+                // Timers are recorded in nanoseconds
+                const double unit = metric.type == Instrumentation::TIMER ? 1e-6 : 1.;
+
+                values.append(QString::number(metric.sum * unit));
+                values.append(QString::number(metric.min * unit));
+                values.append(QString::number(metric.max * unit));
+                values.append(QString::number(metric.count == 0 ? 0. : metric.sum * unit / metric.count));
+                values.append(metric.type == Instrumentation::TIMER ? tr("ms") : "");
+            }
+
+            for (int column = 0; column < values.size(); column++)
+            {
+                auto item = new QTableWidgetItem(values[column]);
+                item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+                table.setItem(row, column, item);
+            }
+        }
+
+        table.resizeColumnsToContents();
+        table.resizeRowsToContents();
+    }
+
+    void InstrumentationDialog::reset()
+    {
+        Instrumentation::get_instance().reset();
+        refresh();
+    }
+
+    void InstrumentationDialog::export_json()
+    {
+        QString filename = QFileDialog::getSaveFileName(this, tr("Export instrumentation"), "", tr("JSON (*.json)"));
+
+        if (filename.isNull())
+            return;
+
+        std::ofstream file(filename.toStdString());
+        Instrumentation::get_instance().write_json(file);
+
+        if (!file)
+            QMessageBox::warning(this, tr("Export instrumentation"), tr("Can't write the file."));
+    }
+
+    void InstrumentationDialog::enable_changed(int state)
+    {
+        Instrumentation::set_enabled(state == Qt::Checked);
+    }
+}
@@ -0,0 +1,91 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __INSTRUMENTATIONDIALOG_H__
+#define __INSTRUMENTATIONDIALOG_H__
+
+#include "Core/Utils/Instrumentation.h"
+
+#include <QDialog>
+#include <QTableWidget>
+#include <QGridLayout>
+#include <QCheckBox>
+#include <QPushButton>
+
+namespace degate
+{
+    /**
+     * @class InstrumentationDialog
+     * @brief Dialog that lists the instrumentation counters and timers (see Instrumentation).
+     *
+     * Timers are shown in milliseconds. The values can be exported as JSON.
+     */
+    class InstrumentationDialog : public QDialog
+    {
+    Q_OBJECT
+
+    public:
+        /**
+         * Create a new instrumentation dialog.
+         *
+         * @param parent : the parent of the dialog.
+         */
+        explicit InstrumentationDialog(QWidget* parent);
+        ~InstrumentationDialog() override = default;
+
+    public slots:
+        /**
+         * Read the current values of the metrics.
+         */
+        void refresh();
+
+        /**
+         * Set all the metrics back to 0.
+         */
+        void reset();
+
+        /**
+         * Export the values of the metrics as a JSON file.
+         */
+        void export_json();
+
+        /**
+         * Enable or disable the instrumentation.
+         *
+         * @param state : the state of the checkbox.
+         */
+        void enable_changed(int state);
+
+    private:
+        QGridLayout layout;
+        QCheckBox enable_checkbox;
+        QTableWidget table;
+
+        // Control layout
+        QGridLayout control_layout;
+        QPushButton refresh_button;
+        QPushButton reset_button;
+        QPushButton export_button;
+        QPushButton close_button;
+    };
+}
+
+#endif //__INSTRUMENTATIONDIALOG_H__
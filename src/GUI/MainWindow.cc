@@ -19,6 +19,8 @@
  *
  */
 
+#include "Core/LogicModel/Gate/GateLibraryImporter.h"
+#include "Core/LogicModel/LogicModelConverter.h"
 #include "Core/Utils/CrashReport.h"
 #include "Core/Version.h"
 #include "GUI/Dialog/AboutDialog.h"
@@ -93,6 +95,11 @@ namespace degate
                          SIGNAL(triggered()),
                          this,
                          SLOT(on_menu_project_create_subproject()));
+        project_create_binary_logic_model_action = project_menu->addAction("");
+        QObject::connect(project_create_binary_logic_model_action,
+                         SIGNAL(triggered()),
+                         this,
+                         SLOT(on_menu_project_create_binary_logic_model()));
 
         project_menu->addSeparator();
         project_settings_action = project_menu->addAction("");
@@ -351,6 +358,9 @@ namespace degate
         bug_report_action = help_menu->addAction("");
         QObject::connect(bug_report_action, SIGNAL(triggered()), this, SLOT(on_menu_help_bug_report()));
 
+        instrumentation_action = help_menu->addAction("");
+        QObject::connect(instrumentation_action, SIGNAL(triggered()), this, SLOT(on_menu_help_instrumentation()));
+
         help_menu->addSeparator();
 
         degate_website_action = help_menu->addAction("");
@@ -445,6 +455,7 @@ namespace degate
         auto_save_timer.start();
 
         QObject::connect(&auto_save_timer, SIGNAL(timeout()), this, SLOT(auto_save()));
+        QObject::connect(&auto_save_watcher, SIGNAL(finished()), this, SLOT(auto_save_finished()));
 
         QThreadPool::globalInstance()->setMaxThreadCount(Configuration::get_max_concurrent_thread_count());
 
@@ -528,6 +539,7 @@ namespace degate
         project_recent_projects_submenu->setTitle(tr("Recent projects"));
         project_close_action->setText(tr("Close"));
         project_create_subproject_action->setText(tr("Create subproject from selection"));
+        project_create_binary_logic_model_action->setText(tr("Create binary logic model"));
         project_settings_action->setText(tr("Project settings"));
         project_quit_action->setText(tr("Quit"));
 
@@ -605,6 +617,7 @@ namespace degate
         if (open_error_file_action != nullptr)
             open_error_file_action->setText(tr("Open error file location"));
         bug_report_action->setText(tr("Bug report"));
+        instrumentation_action->setText(tr("Instrumentation"));
         degate_website_action->setText(tr("Degate's website"));
         about_action->setText(tr("About"));
 
@@ -664,6 +677,9 @@ namespace degate
 
         status_bar.showMessage(tr("Saving project..."));
 
+        // Don't write the project files while an auto save writes them.
+        auto_saver.wait();
+
         ProjectExporter exporter;
         exporter.export_all(project->get_project_directory(), project);
 
@@ -707,6 +723,8 @@ namespace degate
             }
         }
 
+        auto_saver.wait();
+
         project.reset();
         project = nullptr;
 
@@ -789,6 +807,47 @@ namespace degate
             new_annotation.reset();
     }
 
+    void MainWindow::on_menu_project_create_binary_logic_model()
+    {
+        if (project == nullptr)
+            return;
+
+        // Convert the saved logic model, so that lmodel.bin has the object IDs of the other project files.
+        on_menu_project_save();
+
+        status_bar.showMessage(tr("Creating binary logic model..."));
+
+        const std::string project_directory = project->get_project_directory();
+        const std::string gate_library_file = join_pathes(project_directory, "gate_library.xml");
+
+        try
+        {
+            GateLibraryImporter gate_library_importer;
+            GateLibrary_shptr gate_library = file_exists(gate_library_file)
+                                                 ? gate_library_importer.import(gate_library_file)
+                                                 : std::make_shared<GateLibrary>();
+
+            convert_logic_model_to_binary(join_pathes(project_directory, "lmodel.xml"),
+                                          join_pathes(project_directory, "lmodel.bin"),
+                                          project->get_width(),
+                                          project->get_height(),
+                                          gate_library);
+        }
+        catch (const std::exception& e)
+        {
+            QMessageBox::warning(this,
+                                 tr("Create binary logic model"),
+                                 tr("The binary logic model cannot be created.") + "\n\n" +
+                                         tr("Error") + ": " + QString::fromStdString(e.what()));
+            status_bar.showMessage(tr("Binary logic model creation failed."), SECOND(DEFAULT_STATUS_MESSAGE_DURATION));
+
+            return;
+        }
+
+        // The binary logic model is then saved with the project and loaded instead of lmodel.xml.
+        status_bar.showMessage(tr("Binary logic model created."), SECOND(DEFAULT_STATUS_MESSAGE_DURATION));
+    }
+
     void MainWindow::on_menu_edit_preferences()
     {
         PreferencesEditor dialog(this);
@@ -1423,6 +1482,12 @@ namespace degate
         QDesktopServices::openUrl(QUrl("https://github.com/DegateCommunity/Degate/issues/new?template=bug_report.md"));
     }
 
+    void MainWindow::on_menu_help_instrumentation()
+    {
+        InstrumentationDialog dialog(this);
+        dialog.exec();
+    }
+
     void MainWindow::on_menu_help_degate_website()
     {
         QDesktopServices::openUrl(QUrl("https://degatecommunity.github.io"));
@@ -1871,8 +1936,51 @@ namespace degate
         {
             auto_save_timer.setInterval(PREFERENCES_HANDLER.get_preferences().auto_save_interval * 60000);
 
-            on_menu_project_save();
+            // Skip this auto save if the previous one is still running, or if there is nothing to save.
+            if (auto_saver.is_saving() || !project->is_changed())
+                return;
+
+            status_bar.showMessage(tr("Auto saving project..."));
+
+            // Only the snapshot of the project is taken here, the export runs in the background.
+            try
+            {
+                auto_save_watcher.setFuture(auto_saver.save(project));
+            }
+            catch (const std::exception& e)
+            {
+                status_bar.showMessage(tr("Auto save failed: ") + QString::fromStdString(e.what()),
+                                       SECOND(DEFAULT_STATUS_MESSAGE_DURATION));
+                return;
+            }
+
+            auto_saved_project = project;
+
+            // Edits made from now on will mark the project as changed again.
+            project->set_changed(false);
+            update_window_title();
+        }
+    }
+
+    void MainWindow::auto_save_finished()
+    {
+        const std::string error = auto_saver.get_last_error();
+
+        if (error.empty())
+        {
+            status_bar.showMessage(tr("Project auto saved."), SECOND(DEFAULT_STATUS_MESSAGE_DURATION));
+            return;
+        }
+
+        // The snapshot wasn't saved, the project still has unsaved changes.
+        if (project != nullptr && project == auto_saved_project.lock())
+        {
+            project->set_changed();
+            update_window_title();
         }
+
+        status_bar.showMessage(tr("Auto save failed: ") + QString::fromStdString(error),
+                               SECOND(DEFAULT_STATUS_MESSAGE_DURATION));
     }
 
     void MainWindow::goto_object(PlacedLogicModelObject_shptr& object)
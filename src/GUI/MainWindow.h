@@ -25,6 +25,7 @@
 #include "Core/Project/ProjectImporter.h"
 #include "GUI/Workspace/WorkspaceRenderer.h"
 #include "Core/Project/ProjectExporter.h"
+#include "Core/Project/ProjectAutoSaver.h"
 #include "GUI/Dialog/NewProjectDialog.h"
 #include "GUI/Dialog/GateEditDialog.h"
 #include "GUI/Dialog/LayersEditDialog.h"
@@ -46,6 +47,7 @@
 #include "Core/LogicModel/Gate/AutoNameGates.h"
 #include "GUI/Dialog/AnnotationListDialog.h"
 #include "GUI/Dialog/GateListDialog.h"
+#include "GUI/Dialog/InstrumentationDialog.h"
 #include "GUI/Utils/Updater.h"
 
 #include <QMainWindow>
@@ -53,6 +55,7 @@
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QToolBar>
+#include <QFutureWatcher>
 
 /**
  * This define the default status message duration for the status bar.
@@ -126,6 +129,12 @@ namespace degate
          */
         void on_menu_project_create_subproject();
 
+        /**
+         * Save the project and convert its logic model to a binary logic model (lmodel.bin),
+         * faster to load. Once created, it is kept up to date by the next saves.
+         */
+        void on_menu_project_create_binary_logic_model();
+
         /**
          * Open the project settings dialog.
          */
@@ -322,6 +331,11 @@ namespace degate
          */
         void on_menu_help_bug_report();
 
+        /**
+         * Create and open the instrumentation window (counters and timers).
+         */
+        void on_menu_help_instrumentation();
+
         /**
          * Redirect to the Degate's website.
          */
@@ -404,6 +418,11 @@ namespace degate
          */
         void auto_save();
 
+        /**
+         * Called when a background auto save is finished (linked to the auto_save_watcher).
+         */
+        void auto_save_finished();
+
         /**
          * Center view on a specific object.
          *
@@ -465,6 +484,7 @@ namespace degate
         QMenu* project_recent_projects_submenu;
         QAction* project_close_action;
         QAction* project_create_subproject_action;
+        QAction* project_create_binary_logic_model_action;
         QAction* project_settings_action;
         QAction* project_quit_action;
 
@@ -540,6 +560,7 @@ namespace degate
         QAction* check_updates_action;
         QAction* open_error_file_action;
         QAction* bug_report_action;
+        QAction* instrumentation_action;
         QAction* degate_website_action;
         QAction* about_action;
 
@@ -558,6 +579,11 @@ namespace degate
         // QTimer for auto save
         QTimer auto_save_timer;
 
+        // Background auto save
+        ProjectAutoSaver auto_saver;
+        QFutureWatcher<void> auto_save_watcher;
+        std::weak_ptr<Project> auto_saved_project;
+
         /* Dialogs */
         RuleViolationsDialog* rcv_dialog = nullptr;
         ModulesDialog* modules_dialog = nullptr;
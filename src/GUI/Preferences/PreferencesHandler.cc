@@ -20,6 +20,7 @@
  */
 
 #include "PreferencesHandler.h"
+#include "Core/Matching/TemplateMatchingCache.h"
 
 #include <QStyleHints>
 #include <fstream>
@@ -100,6 +101,9 @@ namespace degate
         // Image importer cache size
         preferences.image_importer_cache_size = settings.value("image_importer_cache_size", 256).toUInt();
 
+        // Matching cache size
+        preferences.matching_cache_size = settings.value("matching_cache_size", 256).toUInt();
+
         // Max concurrent thread count
         preferences.max_concurrent_thread_count = settings.value("max_concurrent_thread_count", 0).toUInt();
 
@@ -150,6 +154,7 @@ namespace degate
 
         settings.setValue("cache_size", preferences.cache_size);
         settings.setValue("image_importer_cache_size", preferences.image_importer_cache_size);
+        settings.setValue("matching_cache_size", preferences.matching_cache_size);
         settings.setValue("max_concurrent_thread_count", preferences.max_concurrent_thread_count);
     }
 
@@ -182,6 +187,9 @@ namespace degate
 
         // Update max thread count on preference update
         QThreadPool::globalInstance()->setMaxThreadCount(Configuration::get_max_concurrent_thread_count());
+
+        // Update matching cache size on preference update
+        TemplateMatchingCache::get_instance().set_max_memory(Configuration::get_max_matching_cache_size() * uint_fast64_t(1024) * uint_fast64_t(1024));
     }
 
     void PreferencesHandler::update_language()
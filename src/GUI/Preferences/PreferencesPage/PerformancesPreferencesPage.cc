@@ -65,6 +65,14 @@ namespace degate
         image_importer_cache_size_edit.setMinimum(MINIMUM_CACHE_SIZE);
         image_importer_cache_size_edit.setMaximum(std::numeric_limits<int>::max());
         image_importer_cache_size_edit.setValue(PREFERENCES_HANDLER.get_preferences().image_importer_cache_size);
+
+        // Matching cache size spinbox (0 disables the cache)
+        PreferencesPage::add_widget(cache_layout,
+                                    tr("Template matching cache size (in Mb):"),
+                                    &matching_cache_size_edit);
+        matching_cache_size_edit.setMinimum(0);
+        matching_cache_size_edit.setMaximum(std::numeric_limits<int>::max());
+        matching_cache_size_edit.setValue(PREFERENCES_HANDLER.get_preferences().matching_cache_size);
     }
 
     void PerformancesPreferencesPage::apply(Preferences& preferences)
@@ -79,6 +87,7 @@ namespace degate
 
         preferences.cache_size = static_cast<unsigned int>(cache_size_edit.value());
         preferences.image_importer_cache_size = static_cast<unsigned int>(image_importer_cache_size_edit.value());
+        preferences.matching_cache_size = static_cast<unsigned int>(matching_cache_size_edit.value());
         preferences.max_concurrent_thread_count = static_cast<unsigned int>(max_concurrent_thread_count_edit.value());
     }
 } // namespace degate
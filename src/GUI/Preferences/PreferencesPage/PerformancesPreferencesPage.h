@@ -59,6 +59,7 @@ namespace degate
         QLabel introduction_label;
         QSpinBox cache_size_edit;
         QSpinBox image_importer_cache_size_edit;
+        QSpinBox matching_cache_size_edit;
         QSpinBox max_concurrent_thread_count_edit;
 
     };
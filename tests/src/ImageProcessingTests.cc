@@ -22,9 +22,16 @@
 #include "Core/Image/Image.h"
 #include "Core/Image/Processor/IPPipe.h"
 #include "Core/Image/Processor/IPCopy.h"
+#include "Core/Image/Processor/IPMedianFilter.h"
+#include "Core/Image/Processor/IPNormalize.h"
+#include "Core/Image/Processor/IPConvolve.h"
+#include "Core/Image/Processor/IPThresholding.h"
 
 #include "catch.hpp"
 
+#include <cmath>
+#include <vector>
+
 using namespace degate;
 
 TEST_CASE("Test pipe", "[ImageProcessingTests]")
@@ -62,4 +69,266 @@ TEST_CASE("Test pipe", "[ImageProcessingTests]")
     REQUIRE(pipe.size() == 2);
 
     REQUIRE_NOTHROW(pipe.run(in));
-}
\ No newline at end of file
+}
+
+namespace
+{
+    /**
+     * Pseudo random single channel image.
+     */
+    TileImage_GS_DOUBLE_shptr create_noise_image(unsigned int width, unsigned int height)
+    {
+        TileImage_GS_DOUBLE_shptr img = std::make_shared<TileImage_GS_DOUBLE>(width, height);
+
+        unsigned int seed = 1;
+        for (unsigned int y = 0; y < height; y++)
+            for (unsigned int x = 0; x < width; x++)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                img->set_pixel(x, y, static_cast<double>((seed >> 8) % 256));
+            }
+
+        return img;
+    }
+
+    /**
+     * The convolution as implemented before separable kernels: the dense kernel for every pixel.
+     */
+    TileImage_GS_DOUBLE_shptr reference_convolve(TileImage_GS_DOUBLE_shptr src, FilterKernel_shptr kernel)
+    {
+        TileImage_GS_DOUBLE_shptr dst = std::make_shared<TileImage_GS_DOUBLE>(src->get_width(), src->get_height());
+
+        for (unsigned int y = kernel->get_center_row(); y < src->get_height() - kernel->get_center_row(); y++)
+            for (unsigned int x = kernel->get_center_column(); x < src->get_width() - kernel->get_center_column(); x++)
+            {
+                double accu = 0;
+
+                for (unsigned int i = 0; i < kernel->get_columns(); i++)
+                    for (unsigned int j = 0; j < kernel->get_rows(); j++)
+                        accu += kernel->get(kernel->get_columns() - 1 - i, kernel->get_rows() - 1 - j) *
+                                src->get_pixel(x - kernel->get_center_column() + i, y - kernel->get_center_row() + j);
+
+                dst->set_pixel(x, y, accu);
+            }
+
+        return dst;
+    }
+
+    /**
+     * Create a line detection pipe (like BinaryLineDetection).
+     */
+    void setup_line_detection_pipe(IPPipe& pipe,
+                                   unsigned int min_x, unsigned int max_x,
+                                   unsigned int min_y, unsigned int max_y)
+    {
+        pipe.add(std::make_shared<IPCopy<TileImage_RGBA, TileImage_GS_DOUBLE>>(min_x, max_x, min_y, max_y));
+        pipe.add(std::make_shared<IPMedianFilter<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>>(3));
+        pipe.add(std::make_shared<IPNormalize<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>>(0, 255));
+        pipe.add(std::make_shared<IPConvolve<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>>(
+            std::make_shared<GaussianBlur>(10, 10, 0.5)));
+        pipe.add(std::make_shared<IPConvolve<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>>(
+            std::make_shared<SobelXOperator>()));
+        pipe.add(std::make_shared<IPThresholding<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>>(0.5));
+    }
+}
+
+TEST_CASE("Test tiled pipe", "[ImageProcessingTests]")
+{
+    const unsigned int width = 300, height = 250;
+
+    TileImage_RGBA_shptr in = std::make_shared<TileImage_RGBA>(width, height);
+
+    for (unsigned int y = 0; y < height; y++)
+        for (unsigned int x = 0; x < width; x++)
+        {
+            unsigned int v = ((x / 7 + y / 5) % 3 == 0 ? 180 : 60) + (x * 31 + y * 17) % 40;
+            in->set_pixel(x, y, MERGE_CHANNELS(v, v, v, 255));
+        }
+
+    IPPipe pipe;
+    setup_line_detection_pipe(pipe, 10, 290, 20, 240);
+
+    auto expected = std::dynamic_pointer_cast<TileImage_GS_DOUBLE>(pipe.run(in));
+    REQUIRE(expected != nullptr);
+
+    // Tiles smaller than the halo, not aligned to the image tiles, and bigger than the image
+    for (unsigned int tile_size : {7u, 64u, 100u, 1000u})
+    {
+        auto tiled = std::dynamic_pointer_cast<TileImage_GS_DOUBLE>(pipe.run_tiled(in, tile_size));
+        REQUIRE(tiled != nullptr);
+        REQUIRE(tiled->get_width() == expected->get_width());
+        REQUIRE(tiled->get_height() == expected->get_height());
+
+        unsigned int differences = 0;
+        for (unsigned int y = 0; y < expected->get_height(); y++)
+            for (unsigned int x = 0; x < expected->get_width(); x++)
+                if (tiled->get_pixel(x, y) != expected->get_pixel(x, y))
+                    differences++;
+
+        REQUIRE(differences == 0);
+        REQUIRE(pipe.get_progress() == Approx(1.0));
+    }
+
+    // A region partly outside of the image
+    IPPipe outside_pipe;
+    outside_pipe.add(std::make_shared<IPCopy<TileImage_RGBA, TileImage_GS_DOUBLE>>(200, 400, 100, 300));
+
+    expected = std::dynamic_pointer_cast<TileImage_GS_DOUBLE>(outside_pipe.run(in));
+    auto tiled = std::dynamic_pointer_cast<TileImage_GS_DOUBLE>(outside_pipe.run_tiled(in, 64));
+
+    for (unsigned int y = 0; y < expected->get_height(); y++)
+        for (unsigned int x = 0; x < expected->get_width(); x++)
+            REQUIRE(tiled->get_pixel(x, y) == expected->get_pixel(x, y));
+}
+
+TEST_CASE("Test tiled pipe with a too small image", "[ImageProcessingTests]")
+{
+    TileImage_GS_DOUBLE_shptr in = std::make_shared<TileImage_GS_DOUBLE>(2, 50);
+
+    IPPipe pipe;
+    pipe.add(std::make_shared<IPMedianFilter<TileImage_GS_DOUBLE, TileImage_GS_DOUBLE>>(3));
+
+    REQUIRE_THROWS_AS(pipe.run(in), DegateRuntimeException);
+    REQUIRE_THROWS_AS(pipe.run_tiled(in), DegateRuntimeException);
+}
+
+TEST_CASE("Test separable filter kernels", "[ImageProcessingTests]")
+{
+    std::vector<FilterKernel_shptr> separable = {std::make_shared<GaussianBlur>(10, 10, 0.5),
+                                                 std::make_shared<GaussianBlur>(7, 5, 2.0),
+                                                 std::make_shared<SobelXOperator>(),
+                                                 std::make_shared<SobelYOperator>()};
+
+    for (auto const& kernel : separable)
+    {
+        std::vector<double> horizontal, vertical;
+        REQUIRE(kernel->get_separable_factors(horizontal, vertical));
+        REQUIRE(horizontal.size() == kernel->get_columns());
+        REQUIRE(vertical.size() == kernel->get_rows());
+
+        for (unsigned int y = 0; y < kernel->get_rows(); y++)
+            for (unsigned int x = 0; x < kernel->get_columns(); x++)
+                REQUIRE(horizontal[x] * vertical[y] == Approx(kernel->get(x, y)).margin(1e-15));
+    }
+
+    std::vector<double> horizontal, vertical;
+    REQUIRE_FALSE(std::make_shared<LoG>(9, 9, 1.4)->get_separable_factors(horizontal, vertical));
+    REQUIRE_FALSE(std::make_shared<SobelOperator>()->get_separable_factors(horizontal, vertical));
+    REQUIRE_FALSE(std::make_shared<FilterKernel>(3, 3)->get_separable_factors(horizontal, vertical));
+}
+
+TEST_CASE("Test convolution kernels", "[ImageProcessingTests]")
+{
+    const unsigned int length = 37;
+
+    std::vector<double> in(length), expected(length);
+    for (unsigned int i = 0; i < length; i++)
+    {
+        in[i] = std::sin(i * 0.7) * 100;
+        expected[i] = i * 0.25;
+    }
+
+    std::vector<double> start = expected;
+    convolution_accumulate_row(expected.data(), in.data(), 0.3, length, ConvolutionInstructionSet::Scalar);
+
+    for (auto instruction_set : {ConvolutionInstructionSet::Scalar, ConvolutionInstructionSet::SSE2, ConvolutionInstructionSet::AVX})
+    {
+        if (!is_convolution_instruction_set_supported(instruction_set))
+            continue;
+
+        // All lengths, to test the remainders
+        for (unsigned int n = 0; n <= length; n++)
+        {
+            std::vector<double> out = start;
+            convolution_accumulate_row(out.data(), in.data(), 0.3, n, instruction_set);
+
+            for (unsigned int i = 0; i < length; i++)
+                REQUIRE(out[i] == Approx(i < n ? expected[i] : start[i]).epsilon(1e-14));
+        }
+    }
+}
+
+TEST_CASE("Test separable convolution against dense convolution", "[ImageProcessingTests]")
+{
+    TileImage_GS_DOUBLE_shptr src = create_noise_image(150, 120);
+
+    std::vector<FilterKernel_shptr> kernels = {std::make_shared<GaussianBlur>(10, 10, 0.5),
+                                               std::make_shared<GaussianBlur>(13, 13, 2.0),
+                                               std::make_shared<GaussianBlur>(7, 5, 1.0),
+                                               std::make_shared<SobelXOperator>(),
+                                               std::make_shared<SobelYOperator>(),
+                                               std::make_shared<LoG>(9, 9, 1.4)};
+
+    for (auto const& kernel : kernels)
+    {
+        TileImage_GS_DOUBLE_shptr expected = reference_convolve(src, kernel);
+
+        TileImage_GS_DOUBLE_shptr dst = std::make_shared<TileImage_GS_DOUBLE>(src->get_width(), src->get_height());
+        convolve(dst, src, kernel);
+
+        for (unsigned int y = 0; y < src->get_height(); y++)
+            for (unsigned int x = 0; x < src->get_width(); x++)
+                REQUIRE(dst->get_pixel(x, y) == Approx(expected->get_pixel(x, y)).margin(1e-9));
+    }
+}
+
+namespace
+{
+    /**
+     * Compare the median filter with the pixel by pixel median filter.
+     */
+    template <typename ImageType>
+    void check_median_filter(std::shared_ptr<ImageType> src, unsigned int kernel_width)
+    {
+        auto expected = std::make_shared<ImageType>(src->get_width(), src->get_height());
+        filter_image<ImageType, ImageType,
+                     CalculateImageMedianPolicy<ImageType, typename ImageType::pixel_type>>(expected, src, kernel_width);
+
+        auto dst = std::make_shared<ImageType>(src->get_width(), src->get_height());
+        median_filter<ImageType, ImageType>(dst, src, kernel_width);
+
+        unsigned int differences = 0;
+        for (unsigned int y = 0; y < src->get_height(); y++)
+            for (unsigned int x = 0; x < src->get_width(); x++)
+                if (dst->get_pixel(x, y) != expected->get_pixel(x, y))
+                    differences++;
+
+        INFO("kernel width " << kernel_width);
+        REQUIRE(differences == 0);
+    }
+}
+
+TEST_CASE("Test histogram median filter against median filter", "[ImageProcessingTests]")
+{
+    const unsigned int width = 150, height = 170;
+
+    auto gs_byte = std::make_shared<TileImage_GS_BYTE>(width, height);
+    auto gs_double = std::make_shared<TileImage_GS_DOUBLE>(width, height);
+    auto fractional = std::make_shared<TileImage_GS_DOUBLE>(width, height);
+    auto rgba = std::make_shared<TileImage_RGBA>(width, height);
+
+    unsigned int seed = 7;
+    for (unsigned int y = 0; y < height; y++)
+        for (unsigned int x = 0; x < width; x++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            const unsigned int v = (x / 9 + y / 13) % 2 == 0 ? (seed >> 8) % 256 : 40 + (seed >> 8) % 20;
+
+            gs_byte->set_pixel(x, y, static_cast<gs_byte_pixel_t>(v));
+            gs_double->set_pixel(x, y, v);
+            fractional->set_pixel(x, y, v + 0.5);
+            rgba->set_pixel(x, y, MERGE_CHANNELS(v, (seed >> 16) % 256, 255 - v, 255));
+        }
+
+    REQUIRE(is_histogram_median_supported(gs_double, 0, 0, width, height));
+    REQUIRE_FALSE(is_histogram_median_supported(fractional, 0, 0, width, height));
+
+    for (unsigned int kernel_width : {2u, 3u, 4u, 5u, 8u, 15u})
+    {
+        check_median_filter(gs_byte, kernel_width);
+        check_median_filter(gs_double, kernel_width);
+        check_median_filter(rgba, kernel_width);
+    }
+
+    check_median_filter(fractional, 3);
+}
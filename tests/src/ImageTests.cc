@@ -23,11 +23,80 @@
 #include "Core/Image/TileImage.h"
 #include "Core/Image/TIFFWriter.h"
 #include "Core/Image/ImageReader.h"
+#include "Core/Image/BackgroundImageImporter.h"
+#include "Core/Image/Manipulation/ImageManipulation.h"
 
 #include "catch.hpp"
 
+#include <atomic>
+
+#include <QThreadPool>
+
 using namespace degate;
 
+namespace
+{
+    /**
+     * Pixel policy of a global tile cache used only by the tests.
+     */
+    struct TestPixelPolicy
+    {
+    };
+
+    typedef GlobalTileCache<TestPixelPolicy> TestGlobalTileCache;
+
+    /**
+     * A tile cache whose tiles are all in use by another thread: it can't release anything.
+     */
+    class BusyTileCache : public TileCacheBase
+    {
+    public:
+        void cleanup_cache() override
+        {
+        }
+
+        void print() const override
+        {
+        }
+    };
+
+    /**
+     * A tile cache that releases a tile each time it is asked to.
+     */
+    class IdleTileCache : public TileCacheBase
+    {
+    public:
+        uint_fast64_t tile_size;
+        unsigned int tiles = 0;
+
+        explicit IdleTileCache(uint_fast64_t tile_size) : tile_size(tile_size)
+        {
+        }
+
+        bool load_tile()
+        {
+            if (!TestGlobalTileCache::get_instance().request_cache_memory(this, tile_size))
+                return false;
+
+            tiles++;
+            return true;
+        }
+
+        void cleanup_cache() override
+        {
+            if (tiles == 0)
+                return;
+
+            tiles--;
+            TestGlobalTileCache::get_instance().release_cache_memory(this, tile_size);
+        }
+
+        void print() const override
+        {
+        }
+    };
+}
+
 TEST_CASE("Test rgba in memory", "[ImageTests]")
 {
     Image<PixelPolicy_RGBA, StoragePolicy_Memory> img(100, 100);
@@ -151,4 +220,304 @@ TEST_CASE("Test pixel conversion", "[ImageTests]")
 
     rgba_pixel_t rd = convert_pixel<rgba_pixel_t, gs_double_pixel_t>(4.0);
     REQUIRE((unsigned)MERGE_CHANNELS(4, 4, 4, 255) == rd);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Test tile image access across tiles", "[ImageTests]")
+{
+    // Tiles of size 16x16, so the image spans 64 tiles
+    TileImage_GS_BYTE img(128, 128, 1, 4);
+
+    for (unsigned int y = 0; y < img.get_height(); y++)
+        for (unsigned int x = 0; x < img.get_width(); x++)
+            img.set_pixel(x, y, static_cast<gs_byte_pixel_t>((x * 7 + y * 13) & 0xff));
+
+    // Read back in a different order (column major), to jump between tiles
+    bool all_equal = true;
+    for (unsigned int x = 0; x < img.get_width(); x++)
+        for (unsigned int y = 0; y < img.get_height(); y++)
+            all_equal &= img.get_pixel(x, y) == static_cast<gs_byte_pixel_t>((x * 7 + y * 13) & 0xff);
+
+    REQUIRE(all_equal);
+}
+
+TEST_CASE("Test tile cache LRU eviction", "[ImageTests]")
+{
+    std::string cache_path = create_temp_directory();
+    TileCache<PixelPolicy_GS_BYTE> cache(cache_path, 4, 1, TileLoadingType::Sync, {});
+
+    // Least recently used first
+    for (unsigned int x = 0; x < 4; x++)
+        cache.load_tile(x, 0);
+
+    // A hit makes the first tile the most recently used one
+    cache.load_tile(0, 0);
+
+    // When the global tile cache is full, it asks the cache to release its least recently used tile
+    cache.cleanup_cache();
+    REQUIRE_FALSE(cache.contains_tile(1, 0));
+    REQUIRE(cache.contains_tile(0, 0));
+    REQUIRE(cache.contains_tile(2, 0));
+    REQUIRE(cache.contains_tile(3, 0));
+
+    cache.cleanup_cache();
+    REQUIRE_FALSE(cache.contains_tile(2, 0));
+    REQUIRE(cache.contains_tile(0, 0));
+    REQUIRE(cache.contains_tile(3, 0));
+
+    // A loaded tile is the most recently used one
+    cache.load_tile(1, 0);
+    cache.cleanup_cache();
+    REQUIRE_FALSE(cache.contains_tile(3, 0));
+    REQUIRE(cache.contains_tile(0, 0));
+    REQUIRE(cache.contains_tile(1, 0));
+
+    cache.cleanup_cache();
+    REQUIRE_FALSE(cache.contains_tile(0, 0));
+    REQUIRE(cache.contains_tile(1, 0));
+
+    cache.release_memory();
+    remove_directory(cache_path);
+}
+
+TEST_CASE("Test tile cache eviction of a tile held by a thread", "[ImageTests]")
+{
+    std::string cache_path = create_temp_directory();
+    TileCache<PixelPolicy_GS_BYTE> cache(cache_path, 4, 1, TileLoadingType::Sync, {});
+
+    // The thread tile handle now holds the first tile, which is the least recently used one
+    std::weak_ptr<MemoryMap<gs_byte_pixel_t>> held_tile = cache.get_tile_shared(0, 0);
+    cache.load_tile(1, 0);
+    cache.load_tile(2, 0);
+
+    // Evicting it would not free it, the next one is evicted
+    cache.cleanup_cache();
+    REQUIRE(cache.contains_tile(0, 0));
+    REQUIRE_FALSE(cache.contains_tile(1, 0));
+    REQUIRE_FALSE(held_tile.expired());
+
+    // Once the handle moved to another tile, the tile is evicted and freed
+    cache.get_tile_fast(32, 0);
+    cache.cleanup_cache();
+    REQUIRE_FALSE(cache.contains_tile(0, 0));
+    REQUIRE(cache.contains_tile(2, 0));
+    REQUIRE(held_tile.expired());
+
+    cache.release_memory();
+    remove_directory(cache_path);
+}
+
+TEST_CASE("Test global tile cache limit", "[ImageTests]")
+{
+    TestGlobalTileCache& gtc = TestGlobalTileCache::get_instance();
+    const uint_fast64_t tile_size = 16 * 1024 * 1024;
+    const unsigned int tiles = static_cast<unsigned int>(gtc.get_max_cache_memory() / tile_size);
+
+    REQUIRE(gtc.get_allocated_memory() == 0);
+
+    // Past the limit, the least recently used tiles are released
+    IdleTileCache idle(tile_size);
+    for (unsigned int i = 0; i < 2 * tiles; i++)
+    {
+        REQUIRE(idle.load_tile());
+        REQUIRE(gtc.get_allocated_memory() <= gtc.get_max_cache_memory());
+    }
+
+    REQUIRE(idle.tiles == tiles);
+
+    // When nothing can be released, the limit is only exceeded by one tile per worker thread
+    BusyTileCache busy;
+    unsigned int busy_tiles = 0;
+    while (busy_tiles <= 2 * tiles && gtc.request_cache_memory(&busy, tile_size))
+        busy_tiles++;
+
+    REQUIRE(idle.tiles == 0);
+    REQUIRE(gtc.get_allocated_memory() > gtc.get_max_cache_memory());
+    REQUIRE(gtc.get_allocated_memory() <= gtc.get_max_cache_memory() + gtc.get_over_commit_limit(tile_size));
+    REQUIRE(busy_tiles - tiles ==
+            static_cast<unsigned int>(std::max(1, QThreadPool::globalInstance()->maxThreadCount())));
+
+    gtc.release_cache_memory(&busy, busy_tiles * tile_size);
+    REQUIRE(gtc.get_allocated_memory() == 0);
+}
+
+TEST_CASE("Test image blocks", "[ImageTests]")
+{
+    // Tiles of size 16x16
+    auto img = std::make_shared<TileImage_GS_BYTE>(100, 70, 1, 4);
+
+    for (unsigned int y = 0; y < img->get_height(); y++)
+        for (unsigned int x = 0; x < img->get_width(); x++)
+            img->set_pixel(x, y, static_cast<gs_byte_pixel_t>((x + 3 * y) & 0xff));
+
+    // A block never crosses a tile border
+    auto block = img->get_block(10, 20, 100, 100);
+    REQUIRE(block.get_min_x() == 10);
+    REQUIRE(block.get_min_y() == 20);
+    REQUIRE(block.get_width() == 6);
+    REQUIRE(block.get_height() == 12);
+    REQUIRE(block.at(2, 3) == img->get_pixel(12, 23));
+
+    // Out of the image
+    REQUIRE(img->get_block(100, 0, 10, 10).is_empty());
+
+    // The blocks of a region cover it exactly once
+    unsigned int covered = 0;
+    bool all_equal = true;
+    for (auto const& b : ImageRegionBlocks<const TileImage_GS_BYTE>(img, 5, 7, 90, 200))
+    {
+        covered += b.get_width() * b.get_height();
+
+        for (unsigned int y = 0; y < b.get_height(); y++)
+            for (unsigned int x = 0; x < b.get_width(); x++)
+                all_equal &= b.get_row(y)[x] == img->get_pixel(b.get_min_x() + x, b.get_min_y() + y);
+    }
+
+    REQUIRE(covered == 90 * 63);
+    REQUIRE(all_equal);
+
+    // Blocks of a memory image
+    auto mem = std::make_shared<Image<PixelPolicy_GS_BYTE, StoragePolicy_Memory>>(100, 70);
+    auto mem_block = mem->get_block(10, 20, 1000, 1000);
+    REQUIRE(mem_block.get_width() == 90);
+    REQUIRE(mem_block.get_height() == 50);
+    REQUIRE(mem_block.get_stride() == 100);
+}
+
+TEST_CASE("Test copy and extract with different tilings", "[ImageTests]")
+{
+    auto src = std::make_shared<TileImage_RGBA>(200, 150, 1, 5);
+    for (unsigned int y = 0; y < src->get_height(); y++)
+        for (unsigned int x = 0; x < src->get_width(); x++)
+            src->set_pixel(x, y, MERGE_CHANNELS(x & 0xff, y & 0xff, (x + y) & 0xff, 255));
+
+    // Copy with pixel conversion into another tiling
+    auto copy = std::make_shared<TileImage_GS_BYTE>(200, 150, 1, 4);
+    copy_image(copy, src);
+
+    bool copy_equal = true;
+    for (unsigned int y = 0; y < copy->get_height(); y++)
+        for (unsigned int x = 0; x < copy->get_width(); x++)
+            copy_equal &= copy->get_pixel(x, y) == src->get_pixel_as<gs_byte_pixel_t>(x, y);
+
+    REQUIRE(copy_equal);
+
+    // Extract a region not aligned on tiles
+    auto part = std::make_shared<TileImage_RGBA>(60, 40, 1, 4);
+    extract_partial_image(part, src, 37, 97, 21, 61);
+
+    bool part_equal = true;
+    for (unsigned int y = 0; y < part->get_height(); y++)
+        for (unsigned int x = 0; x < part->get_width(); x++)
+            part_equal &= part->get_pixel(x, y) == src->get_pixel(37 + x, 21 + y);
+
+    REQUIRE(part_equal);
+
+    // In place greyscale conversion
+    convert_to_greyscale(part);
+    REQUIRE(part->get_pixel(3, 4) == convert_pixel<rgba_pixel_t, gs_byte_pixel_t>(
+                                             src->get_pixel_as<gs_byte_pixel_t>(40, 25)));
+
+    // Statistics
+    double avg = 0, stddev = 0;
+    average_and_stddev(copy, 10, 10, 100, 100, &avg, &stddev);
+
+    double sum = 0;
+    for (unsigned int y = 10; y < 110; y++)
+        for (unsigned int x = 10; x < 110; x++)
+            sum += copy->get_pixel(x, y);
+
+    REQUIRE(avg == Approx(sum / 10000.0));
+    REQUIRE(stddev > 0);
+}
+
+TEST_CASE("Test background image importer", "[ImageTests]")
+{
+    const unsigned int width = 300, height = 200;
+    const unsigned int tile_width_exp = 5, tile_size = 1 << tile_width_exp;
+
+    auto pixel = [](unsigned int x, unsigned int y) {
+        return static_cast<rgba_pixel_t>(MERGE_CHANNELS(x & 0xff, y & 0xff, (x * 3 + y) & 0xff, 255u));
+    };
+
+    std::atomic<unsigned int> decoded_rows(0);
+    auto decoder = [&](unsigned int min_y, unsigned int rows, std::vector<rgba_pixel_t>& pixels) {
+        pixels.resize(width * rows);
+        for (unsigned int y = 0; y < rows; y++)
+            for (unsigned int x = 0; x < width; x++)
+                pixels[y * width + x] = pixel(x, min_y + y);
+
+        decoded_rows += rows;
+        return true;
+    };
+
+    std::string dir = create_temp_directory();
+
+    BackgroundImageImporter importer(dir, width, height, tile_size, decoder);
+
+    // 4 strips of 64 rows, decoded by 2 threads
+    importer.set_decode_threads(2);
+    importer.set_memory_budget(4 * 64 * width * sizeof(rgba_pixel_t));
+    REQUIRE(importer.get_strip_height() == 64);
+
+    BackgroundImageImporter::statistics stats = importer.run();
+
+    // The source is decoded once
+    REQUIRE(decoded_rows == height);
+    REQUIRE(stats.strips == 4);
+    REQUIRE(stats.decoded_bytes == width * height * sizeof(rgba_pixel_t));
+    REQUIRE(stats.levels == 5);
+
+    // Compare every level with the source scaled down with scale_down_by_2()
+    auto reference = std::make_shared<MemoryImage_RGBA>(width, height);
+    for (unsigned int y = 0; y < height; y++)
+        for (unsigned int x = 0; x < width; x++)
+            reference->set_pixel(x, y, pixel(x, y));
+
+    unsigned int tiles = 0;
+    for (unsigned int scale = 1; scale <= 16; scale *= 2)
+    {
+        if (scale > 1)
+        {
+            auto scaled = std::make_shared<MemoryImage_RGBA>(reference->get_width() / 2, reference->get_height() / 2);
+            scale_down_by_2<MemoryImage_RGBA, MemoryImage_RGBA>(scaled, reference);
+            reference = scaled;
+        }
+
+        std::string path = scale == 1 ? dir : join_pathes(dir, "scaling_" + std::to_string(scale) + ".dimg");
+        BackgroundImage img(reference->get_width(), reference->get_height(), path, true, scale, tile_width_exp);
+
+        bool all_equal = true;
+        for (unsigned int y = 0; y < img.get_height(); y++)
+            for (unsigned int x = 0; x < img.get_width(); x++)
+                all_equal &= img.get_pixel(x, y) == reference->get_pixel(x, y);
+
+        REQUIRE(all_equal);
+
+        tiles += ((img.get_width() + tile_size - 1) / tile_size) * ((img.get_height() + tile_size - 1) / tile_size);
+    }
+
+    REQUIRE(stats.tiles == tiles);
+    REQUIRE(stats.written_bytes == tiles * tile_size * tile_size * sizeof(rgba_pixel_t));
+
+    remove_directory(dir);
+}
+
+TEST_CASE("Test background image importer with a decoding error", "[ImageTests]")
+{
+    const unsigned int width = 100, height = 300;
+
+    auto decoder = [&](unsigned int min_y, unsigned int rows, std::vector<rgba_pixel_t>& pixels) {
+        pixels.assign(width * rows, 0);
+        return min_y < 128;
+    };
+
+    std::string dir = create_temp_directory();
+
+    BackgroundImageImporter importer(dir, width, height, 32, decoder);
+    importer.set_memory_budget(3 * 64 * width * sizeof(rgba_pixel_t));
+    REQUIRE(importer.get_strip_height() == 64);
+
+    REQUIRE_THROWS_AS(importer.run(), DegateRuntimeException);
+
+    remove_directory(dir);
+}
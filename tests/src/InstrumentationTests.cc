@@ -0,0 +1,158 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Utils/Instrumentation.h"
+
+#include "catch.hpp"
+
+#include <sstream>
+
+using namespace degate;
+
+TEST_CASE("Counter", "[Instrumentation]")
+{
+    Instrumentation& instrumentation = Instrumentation::get_instance();
+    Instrumentation::set_enabled(true);
+
+    Counter& counter = instrumentation.get_counter("tests.counter");
+    counter.reset();
+
+    counter.add();
+    counter.add(41);
+    REQUIRE(counter.get_value() == 42);
+
+    // Same name, same counter
+    REQUIRE(&instrumentation.get_counter("tests.counter") == &counter);
+
+    SECTION("Disabled instrumentation records nothing")
+    {
+        Instrumentation::set_enabled(false);
+        counter.add(10);
+        REQUIRE(counter.get_value() == 42);
+    }
+
+    SECTION("Reset")
+    {
+        instrumentation.reset();
+        REQUIRE(counter.get_value() == 0);
+    }
+
+    Instrumentation::set_enabled(false);
+}
+
+TEST_CASE("Histogram buckets", "[Instrumentation]")
+{
+    REQUIRE(Histogram::get_bucket(0) == 0);
+    REQUIRE(Histogram::get_bucket(1) == 1);
+    REQUIRE(Histogram::get_bucket(2) == 2);
+    REQUIRE(Histogram::get_bucket(3) == 2);
+    REQUIRE(Histogram::get_bucket(4) == 3);
+    REQUIRE(Histogram::get_bucket(1023) == 10);
+    REQUIRE(Histogram::get_bucket(1024) == 11);
+    REQUIRE(Histogram::get_bucket(~uint_fast64_t(0)) == 64);
+
+    REQUIRE(Histogram::get_bucket_max(0) == 0);
+    REQUIRE(Histogram::get_bucket_max(2) == 3);
+    REQUIRE(Histogram::get_bucket_max(64) == ~uint_fast64_t(0));
+
+    for (unsigned int bucket = 0; bucket < Histogram::bucket_count; bucket++)
+        REQUIRE(Histogram::get_bucket(Histogram::get_bucket_max(bucket)) == bucket);
+}
+
+TEST_CASE("Histogram", "[Instrumentation]")
+{
+    Instrumentation::set_enabled(true);
+
+    Histogram& histogram = Instrumentation::get_instance().get_histogram("tests.histogram");
+    histogram.reset();
+
+    REQUIRE(histogram.get_count() == 0);
+    REQUIRE(histogram.get_min() == 0);
+    REQUIRE(histogram.get_max() == 0);
+
+    histogram.add(5);
+    histogram.add(3);
+    histogram.add(100);
+
+    REQUIRE(histogram.get_count() == 3);
+    REQUIRE(histogram.get_sum() == 108);
+    REQUIRE(histogram.get_min() == 3);
+    REQUIRE(histogram.get_max() == 100);
+    REQUIRE(histogram.get_bucket_count(Histogram::get_bucket(3)) == 1);
+    REQUIRE(histogram.get_bucket_count(Histogram::get_bucket(5)) == 1);
+    REQUIRE(histogram.get_bucket_count(Histogram::get_bucket(100)) == 1);
+
+    Instrumentation::set_enabled(false);
+    histogram.add(1);
+    REQUIRE(histogram.get_count() == 3);
+    REQUIRE(histogram.get_min() == 3);
+}
+
+TEST_CASE("Scoped timer", "[Instrumentation]")
+{
+    Histogram& timer = Instrumentation::get_instance().get_timer("tests.timer");
+    timer.reset();
+
+    {
+        ScopedTimer disabled(timer);
+    }
+    REQUIRE(timer.get_count() == 0);
+
+    Instrumentation::set_enabled(true);
+
+    {
+        ScopedTimer enabled(timer);
+        enabled.stop();
+        enabled.stop();
+    }
+    REQUIRE(timer.get_count() == 1);
+
+    Instrumentation::set_enabled(false);
+}
+
+TEST_CASE("Instrumentation JSON", "[Instrumentation]")
+{
+    Instrumentation& instrumentation = Instrumentation::get_instance();
+    Instrumentation::set_enabled(true);
+
+    instrumentation.get_counter("tests.json.counter").add(7);
+    instrumentation.get_histogram("tests.json.histogram").add(2);
+    instrumentation.get_timer("tests.json.timer").add(2000000000);
+
+    auto values = instrumentation.get_values();
+    for (std::size_t i = 1; i < values.size(); i++)
+        REQUIRE(values[i - 1].name < values[i].name);
+
+    std::ostringstream stm;
+    instrumentation.write_json(stm);
+    const std::string json = stm.str();
+
+    REQUIRE(json.find("\"enabled\": true") != std::string::npos);
+    REQUIRE(json.find("\"tests.json.counter\": 7") != std::string::npos);
+    REQUIRE(json.find("\"tests.json.histogram\": {\"count\": 1, \"sum\": 2, \"min\": 2, \"max\": 2, \"mean\": 2, "
+                      "\"buckets\": [{\"max\": 3, \"count\": 1}]}") != std::string::npos);
+
+    // Timers are written in seconds
+    REQUIRE(json.find("\"tests.json.timer\": {\"count\": 1, \"sum\": 2, ") != std::string::npos);
+
+    instrumentation.reset();
+    Instrumentation::set_enabled(false);
+}
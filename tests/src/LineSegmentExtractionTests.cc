@@ -0,0 +1,179 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Matching/LineSegmentExtraction.h"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <tuple>
+#include <vector>
+
+using namespace degate;
+
+namespace
+{
+    /**
+     * Synthetic wires, broken into pieces with small gaps and jitter across the wire.
+     */
+    std::vector<LineSegment> create_wire_pieces(unsigned int wires, unsigned int size, std::uint32_t seed)
+    {
+        std::vector<LineSegment> pieces;
+
+        auto random = [&seed](unsigned int max) {
+            seed = seed * 1664525u + 1013904223u;
+            return (seed >> 8) % max;
+        };
+
+        for (unsigned int i = 0; i < wires; i++)
+        {
+            const bool horizontal = random(2) == 0;
+            const int across = static_cast<int>(random(size));
+            int along = static_cast<int>(random(size));
+            const int end = along + 20 + static_cast<int>(random(200));
+
+            while (along < end)
+            {
+                const int length = 2 + static_cast<int>(random(12));
+                const int jitter = static_cast<int>(random(3)) - 1;
+
+                if (horizontal)
+                    pieces.emplace_back(along, across + jitter, along + length, across + jitter);
+                else
+                    pieces.emplace_back(across + jitter, along, across + jitter, along + length);
+
+                along += length + static_cast<int>(random(4));
+            }
+        }
+
+        return pieces;
+    }
+
+    typedef std::vector<std::tuple<float, float, float, float>> segment_list;
+
+    template<typename Container>
+    segment_list get_segments(Container const& container)
+    {
+        segment_list segments;
+        for (auto const& ls : container)
+            segments.emplace_back(ls.get_from_x(), ls.get_from_y(), ls.get_to_x(), ls.get_to_y());
+        return segments;
+    }
+
+    /**
+     * The segment merging as implemented before the endpoint grid: a linear search
+     * of the first adjacent segment in a list.
+     */
+    segment_list reference_merge(std::vector<LineSegment> const& pieces,
+                                 unsigned int search_radius_along,
+                                 unsigned int search_radius_across)
+    {
+        std::list<LineSegment> lines(pieces.begin(), pieces.end());
+
+        unsigned int counter = 0;
+        unsigned int max_rounds = static_cast<unsigned int>(lines.size());
+        int distance = 1;
+        int max_distance = search_radius_along;
+        bool running = lines.size() > 0;
+
+        while (running)
+        {
+            running = false;
+
+            LineSegment ls = lines.front();
+            lines.pop_front();
+
+            auto found = std::find_if(lines.begin(), lines.end(), [&](LineSegment const& ls2) {
+                return ls.is_adjacent(ls2, distance, search_radius_across);
+            });
+
+            if (found != lines.end())
+            {
+                running = true;
+                ls.merge(*found);
+                lines.erase(found);
+            }
+            else
+            {
+                if (counter++ < max_rounds)
+                    running = true;
+                else
+                {
+                    if (distance <= max_distance)
+                    {
+                        distance++;
+                        counter = 0;
+                        running = true;
+                    }
+                    else running = false;
+                }
+            }
+
+            lines.push_back(ls);
+        }
+
+        return get_segments(lines);
+    }
+}
+
+TEST_CASE("Test line segment merge", "[LineSegmentExtractionTests]")
+{
+    LineSegmentMap map;
+    map.add(LineSegment(0, 10, 5, 10));
+    map.add(LineSegment(40, 20, 40, 30)); // vertical, far away
+    map.add(LineSegment(7, 11, 12, 11));  // 2 pixels away, 1 pixel across
+    map.add(LineSegment(13, 10, 20, 10)); // 1 pixel away
+    map.add(LineSegment(25, 30, 30, 30)); // not in the same band
+
+    map.merge(2, 2);
+
+    auto segments = get_segments(map);
+    REQUIRE(segments.size() == 3);
+
+    unsigned int merged = 0;
+    for (auto const& s : segments)
+    {
+        if (std::min(std::get<0>(s), std::get<2>(s)) == 0 && std::max(std::get<0>(s), std::get<2>(s)) == 20)
+            merged++;
+    }
+
+    REQUIRE(merged == 1);
+}
+
+TEST_CASE("Test line segment merge against reference merge", "[LineSegmentExtractionTests]")
+{
+    for (std::uint32_t seed : {1u, 2u, 3u})
+    {
+        auto pieces = create_wire_pieces(150, 400, seed);
+
+        LineSegmentMap map;
+        for (auto const& piece : pieces)
+            map.add(piece);
+
+        map.merge(3, 2);
+
+        auto segments = get_segments(map);
+        REQUIRE(segments.size() < pieces.size());
+        REQUIRE(segments == reference_merge(pieces, 3, 2));
+    }
+}
@@ -0,0 +1,237 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Globals.h"
+#include "Core/LogicModel/Annotation/Annotation.h"
+#include "Core/LogicModel/EMarker/EMarker.h"
+#include "Core/LogicModel/Gate/GateLibraryImporter.h"
+#include "Core/LogicModel/LogicModelBinaryExporter.h"
+#include "Core/LogicModel/LogicModelBinaryImporter.h"
+#include "Core/LogicModel/LogicModelConverter.h"
+#include "Core/LogicModel/LogicModelImporter.h"
+#include "Core/LogicModel/Via/Via.h"
+#include "Core/LogicModel/Wire/Wire.h"
+#include "Core/Utils/FileSystem.h"
+
+#include "catch.hpp"
+
+#include <boost/filesystem/operations.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace degate;
+
+namespace
+{
+    typedef std::tuple<object_id_t, std::string, std::string, layer_position_t, float, float, float, float,
+                       color_t, color_t> object_entry;
+
+    /**
+     * Get the placed objects of a logic model, ordered by object ID.
+     */
+    std::vector<object_entry> get_objects(LogicModel_shptr lmodel)
+    {
+        std::vector<object_entry> objects;
+
+        for (auto iter = lmodel->objects_begin(); iter != lmodel->objects_end(); ++iter)
+        {
+            PlacedLogicModelObject_shptr o = iter->second;
+            BoundingBox const& bb = o->get_bounding_box();
+
+            objects.emplace_back(o->get_object_id(), o->get_name(), o->get_description(),
+                                 o->get_layer()->get_layer_pos(),
+                                 bb.get_min_x(), bb.get_min_y(), bb.get_max_x(), bb.get_max_y(),
+                                 o->get_fill_color(), o->get_frame_color());
+        }
+
+        return objects;
+    }
+
+    /**
+     * Get the nets of a logic model, as the IDs of the connected objects.
+     */
+    std::vector<std::vector<object_id_t>> get_nets(LogicModel_shptr lmodel)
+    {
+        std::vector<std::vector<object_id_t>> nets;
+
+        for (auto iter = lmodel->nets_begin(); iter != lmodel->nets_end(); ++iter)
+        {
+            nets.emplace_back(iter->second->begin(), iter->second->end());
+            std::sort(nets.back().begin(), nets.back().end());
+        }
+
+        return nets;
+    }
+}
+
+TEST_CASE("Test binary logic model export and import", "[LogicModelBinary]")
+{
+    LogicModel_shptr lmodel(new LogicModel(1000, 1000, ProjectType::Normal, 3));
+
+    Wire_shptr wire = std::make_shared<Wire>(10, 20, 110, 20, 5);
+    wire->set_name("wire");
+    wire->set_description("a wire");
+    wire->set_fill_color(0x11223344);
+    wire->set_remote_object_id(42);
+    lmodel->add_object(0, wire);
+
+    Via_shptr via = std::make_shared<Via>(110, 20, 7, Via::DIRECTION_DOWN);
+    via->set_name("via");
+    lmodel->add_object(0, via);
+
+    Via_shptr via2 = std::make_shared<Via>(110, 20, 7, Via::DIRECTION_UP);
+    lmodel->add_object(1, via2);
+
+    EMarker_shptr emarker = std::make_shared<EMarker>(200, 300, 3, true);
+    emarker->set_name("wire");
+    emarker->set_frame_color(0x55667788);
+    lmodel->add_object(2, emarker);
+
+    Annotation_shptr annotation = std::make_shared<Annotation>(5, 50, 5, 50);
+    annotation->set_description("an annotation");
+    lmodel->add_object(2, annotation);
+
+    Net_shptr net = std::make_shared<Net>();
+    lmodel->add_net(net);
+    wire->set_net(net);
+    via->set_net(net);
+
+    std::string directory = create_temp_directory();
+    std::string filename = join_pathes(directory, "lmodel.bin");
+
+    LogicModelBinaryExporter exporter(std::make_shared<ObjectIDRewriter>(false));
+    REQUIRE_NOTHROW(exporter.export_data(filename, lmodel));
+
+    REQUIRE(LogicModelBinaryFile::is_binary_file(filename));
+
+    SECTION("The records can be inspected without importing the logic model")
+    {
+        LogicModelBinaryFile file(filename);
+
+        REQUIRE(file.get_layers().size() == 3);
+        REQUIRE(file.get_wires(file.get_layers()[0]).size() == 1);
+        REQUIRE(file.get_wires(file.get_layers()[0])[0].from_x == 10);
+        REQUIRE(file.get_string(file.get_wires(file.get_layers()[0])[0].object.description) == "a wire");
+        REQUIRE(file.get_vias(file.get_layers()[1]).size() == 1);
+        REQUIRE(file.get_emarkers(file.get_layers()[2])[0].is_module_port == 1);
+        REQUIRE(file.get_nets().size() == 1);
+        REQUIRE(file.get_nets()[0].connection_count == 2);
+    }
+
+    SECTION("The imported logic model is the exported one")
+    {
+        LogicModelBinaryImporter importer(1000, 1000);
+        LogicModel_shptr imported(importer.import(filename, ProjectType::Normal));
+        REQUIRE(imported != nullptr);
+
+        REQUIRE(get_objects(imported) == get_objects(lmodel));
+        REQUIRE(get_nets(imported) == get_nets(lmodel));
+
+        Wire_shptr imported_wire = std::dynamic_pointer_cast<Wire>(imported->get_object(wire->get_object_id()));
+        REQUIRE(imported_wire != nullptr);
+        REQUIRE(imported_wire->get_diameter() == 5);
+        REQUIRE(imported_wire->get_remote_object_id() == 42);
+
+        Via_shptr imported_via = std::dynamic_pointer_cast<Via>(imported->get_object(via->get_object_id()));
+        REQUIRE(imported_via != nullptr);
+        REQUIRE(imported_via->get_direction() == Via::DIRECTION_DOWN);
+
+        EMarker_shptr imported_emarker =
+            std::dynamic_pointer_cast<EMarker>(imported->get_object(emarker->get_object_id()));
+        REQUIRE(imported_emarker != nullptr);
+        REQUIRE(imported_emarker->is_module_port());
+
+        REQUIRE(imported->get_main_module() != nullptr);
+    }
+
+    SECTION("A read-only file can be imported and is not modified")
+    {
+        const boost::uintmax_t size = boost::filesystem::file_size(filename);
+        boost::filesystem::permissions(filename, boost::filesystem::owner_read);
+
+        LogicModelBinaryImporter importer(1000, 1000);
+        LogicModel_shptr imported(importer.import(filename, ProjectType::Normal));
+        REQUIRE(imported != nullptr);
+        REQUIRE(get_objects(imported) == get_objects(lmodel));
+
+        REQUIRE(boost::filesystem::file_size(filename) == size);
+
+        boost::filesystem::permissions(filename, boost::filesystem::owner_read | boost::filesystem::owner_write);
+    }
+
+    remove_directory(directory);
+}
+
+TEST_CASE("Test binary logic model with an invalid file", "[LogicModelBinary]")
+{
+    std::string directory = create_temp_directory();
+    std::string filename = join_pathes(directory, "lmodel.bin");
+
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << "DGTLMODL, but truncated";
+    }
+
+    REQUIRE(LogicModelBinaryFile::is_binary_file(filename));
+
+    LogicModelBinaryImporter importer(1000, 1000);
+    REQUIRE_THROWS_AS(importer.import(filename, ProjectType::Normal), InvalidFileFormatException);
+
+    REQUIRE_FALSE(LogicModelBinaryFile::is_binary_file("tests_files/test_project/lmodel.xml"));
+
+    remove_directory(directory);
+}
+
+TEST_CASE("Test logic model conversion", "[LogicModelBinary]")
+{
+    GateLibraryImporter gate_library_importer;
+    GateLibrary_shptr glib(gate_library_importer.import("tests_files/test_project/gate_library.xml"));
+    REQUIRE(glib != nullptr);
+
+    std::string directory = create_temp_directory();
+    std::string binary_filename = join_pathes(directory, "lmodel.bin");
+    std::string xml_filename = join_pathes(directory, "lmodel.xml");
+
+    REQUIRE_FALSE(convert_logic_model("tests_files/test_project/lmodel.xml", binary_filename, 500, 500, glib));
+    REQUIRE(convert_logic_model(binary_filename, xml_filename, 500, 500, glib));
+
+    LogicModelImporter lm_importer(500, 500, glib);
+    LogicModel_shptr lmodel(lm_importer.import("tests_files/test_project/lmodel.xml", ProjectType::Normal));
+    LogicModel_shptr converted(lm_importer.import(xml_filename, ProjectType::Normal));
+
+    REQUIRE(get_objects(converted) == get_objects(lmodel));
+    REQUIRE(get_nets(converted) == get_nets(lmodel));
+
+    LogicModelBinaryImporter binary_importer(500, 500, glib);
+    LogicModel_shptr binary(binary_importer.import(binary_filename, ProjectType::Normal));
+
+    REQUIRE(get_objects(binary) == get_objects(lmodel));
+    REQUIRE(std::distance(binary->gates_begin(), binary->gates_end()) ==
+            std::distance(lmodel->gates_begin(), lmodel->gates_end()));
+
+    remove_directory(directory);
+}
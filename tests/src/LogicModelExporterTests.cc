@@ -0,0 +1,86 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Globals.h"
+#include "Core/LogicModel/Gate/GateLibraryImporter.h"
+#include "Core/LogicModel/LogicModelExporter.h"
+#include "Core/LogicModel/LogicModelImporter.h"
+#include "Core/Utils/FileSystem.h"
+
+#include "catch.hpp"
+
+#include <iterator>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace degate;
+
+namespace
+{
+    typedef std::tuple<object_id_t, std::string, std::string, layer_position_t, float, float, float, float> object_entry;
+
+    /**
+     * Get the placed objects of a logic model, ordered by object ID.
+     */
+    std::vector<object_entry> get_objects(LogicModel_shptr lmodel)
+    {
+        std::vector<object_entry> objects;
+
+        for (auto iter = lmodel->objects_begin(); iter != lmodel->objects_end(); ++iter)
+        {
+            PlacedLogicModelObject_shptr o = iter->second;
+            BoundingBox const& bb = o->get_bounding_box();
+
+            objects.emplace_back(o->get_object_id(), o->get_name(), o->get_description(),
+                                 o->get_layer()->get_layer_pos(),
+                                 bb.get_min_x(), bb.get_min_y(), bb.get_max_x(), bb.get_max_y());
+        }
+
+        return objects;
+    }
+}
+
+TEST_CASE("Test logic model export and import", "[LogicModelExporter]")
+{
+    GateLibraryImporter gate_library_importer;
+    GateLibrary_shptr glib(gate_library_importer.import("tests_files/test_project/gate_library.xml"));
+    REQUIRE(glib != nullptr);
+
+    LogicModelImporter lm_importer(500, 500, glib);
+    LogicModel_shptr lmodel(lm_importer.import("tests_files/test_project/lmodel.xml", ProjectType::Normal));
+    REQUIRE(lmodel != nullptr);
+
+    std::string filename = join_pathes(create_temp_directory(), "lmodel.xml");
+
+    // Without ID rewriting, the imported objects must be the exported ones.
+    LogicModelExporter exporter(std::make_shared<ObjectIDRewriter>(false));
+    REQUIRE_NOTHROW(exporter.export_data(filename, lmodel));
+
+    LogicModel_shptr imported(lm_importer.import(filename, ProjectType::Normal));
+    REQUIRE(imported != nullptr);
+
+    REQUIRE(get_objects(imported) == get_objects(lmodel));
+    REQUIRE(std::distance(imported->nets_begin(), imported->nets_end()) ==
+            std::distance(lmodel->nets_begin(), lmodel->nets_end()));
+
+    remove_directory(get_basedir(filename));
+}
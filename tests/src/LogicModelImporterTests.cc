@@ -57,3 +57,30 @@ TEST_CASE("Test import", "[LogicModelImporter]")
     LogicModel_shptr lmodel2(lm_importer.import(filename, ProjectType::Normal));
     REQUIRE(lmodel2 != nullptr);
 }
+
+TEST_CASE("Test import of gates", "[LogicModelImporter]")
+{
+    GateLibraryImporter gate_library_importer;
+    GateLibrary_shptr glib(gate_library_importer.import("tests_files/test_project/gate_library.xml"));
+    REQUIRE(glib != nullptr);
+
+    LogicModelImporter lm_importer(500, 500, glib);
+    LogicModel_shptr lmodel(lm_importer.import("tests_files/test_project/lmodel.xml", ProjectType::Normal));
+    REQUIRE(lmodel != nullptr);
+
+    for (auto iter = lmodel->gates_begin(); iter != lmodel->gates_end(); ++iter)
+    {
+        Gate_shptr gate = (*iter).second;
+
+        REQUIRE(gate->get_layer() != nullptr);
+
+        // Ports are placed objects of their own, on the gate layer.
+        for (auto port_iter = gate->ports_begin(); port_iter != gate->ports_end(); ++port_iter)
+        {
+            REQUIRE(lmodel->get_object((*port_iter)->get_object_id()) == *port_iter);
+            REQUIRE((*port_iter)->get_layer() == gate->get_layer());
+        }
+    }
+
+    REQUIRE(lmodel->get_main_module() != nullptr);
+}
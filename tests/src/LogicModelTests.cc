@@ -21,6 +21,7 @@
 
 #include "Core/LogicModel/Wire/Wire.h"
 #include "Core/LogicModel/LogicModel.h"
+#include "Core/LogicModel/BulkInsert.h"
 
 #include "catch.hpp"
 
@@ -125,4 +126,309 @@ TEST_CASE("Test add and retrieve wire", "[LogicModel]")
     }
 
     REQUIRE(i > 0);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Test add many objects", "[LogicModel]")
+{
+    LogicModel_shptr lmodel(new LogicModel(100, 100, ProjectType::Normal));
+
+    std::vector<PlacedLogicModelObject_shptr> objects;
+    for (int j = 0; j < 500; j++)
+        objects.push_back(std::make_shared<Wire>(j % 90, j / 10, j % 90 + 10, j / 10, 5));
+
+    lmodel->add_objects(0, objects);
+
+    Layer_shptr layer = lmodel->get_layer(0);
+    REQUIRE(layer != nullptr);
+
+    for (auto const& o : objects)
+    {
+        REQUIRE(o->has_valid_object_id() == true);
+        REQUIRE(lmodel->get_object(o->get_object_id()) == o);
+        REQUIRE(o->get_layer() == layer);
+    }
+
+    unsigned int count = 0;
+    for (auto iter = layer->region_begin(0, 100, 0, 100); iter != layer->region_end(); ++iter)
+        count++;
+
+    REQUIRE(count == objects.size());
+
+    // An object with an ID already in the logic model.
+    Wire_shptr duplicate(new Wire(20, 21, 30, 31, 5));
+    duplicate->set_object_id(objects.front()->get_object_id());
+
+    REQUIRE_THROWS_AS(lmodel->add_objects(0, {duplicate}), DegateLogicException);
+}
+
+TEST_CASE("Test template port updates", "[LogicModel]")
+{
+    LogicModel_shptr lmodel(new LogicModel(1000, 1000, ProjectType::Normal, 1));
+
+    GateTemplate_shptr tmpl(new GateTemplate(20, 20));
+    GateTemplatePort_shptr port_a(new GateTemplatePort(5, 5, GateTemplatePort::PORT_TYPE_IN));
+    port_a->set_object_id(lmodel->get_new_object_id());
+    tmpl->add_template_port(port_a);
+    lmodel->add_gate_template(tmpl);
+
+    GateTemplate_shptr other_tmpl(new GateTemplate(20, 20));
+    lmodel->add_gate_template(other_tmpl);
+
+    std::vector<Gate_shptr> gates;
+    std::vector<PlacedLogicModelObject_shptr> objects;
+    for (int i = 0; i < 10; i++)
+    {
+        Gate_shptr gate(new Gate(i * 50, i * 50 + 19, 100, 119, Gate::ORIENTATION_NORMAL));
+        gate->set_gate_template(i % 2 == 0 ? tmpl : other_tmpl);
+        gates.push_back(gate);
+        objects.push_back(gate);
+    }
+
+    lmodel->add_objects(0, objects);
+    for (auto const& gate : gates)
+        lmodel->update_ports(gate);
+
+    std::vector<Gate_shptr> instances = lmodel->get_template_instances(tmpl);
+    REQUIRE(instances.size() == 5);
+    for (std::size_t i = 1; i < instances.size(); i++)
+        REQUIRE(instances[i - 1]->get_object_id() < instances[i]->get_object_id());
+
+    Layer_shptr layer = lmodel->get_layer(0);
+
+    auto count_ports_at = [&](int x, int y)
+    {
+        unsigned int count = 0;
+        for (auto iter = layer->region_begin(x, x, y, y); iter != layer->region_end(); ++iter)
+            if (std::dynamic_pointer_cast<GatePort>(*iter) != nullptr)
+                count++;
+        return count;
+    };
+
+    REQUIRE(count_ports_at(5, 105) == 1);
+
+    // Move a template port and add another one, the ports of all instances are updated.
+    port_a->set_point(Point(10, 5));
+    GateTemplatePort_shptr port_b(new GateTemplatePort(15, 15, GateTemplatePort::PORT_TYPE_OUT));
+    port_b->set_object_id(lmodel->get_new_object_id());
+    lmodel->add_template_port_to_gate_template(tmpl, port_b);
+
+    for (auto const& gate : instances)
+    {
+        REQUIRE(gate->get_ports_number() == 2);
+        REQUIRE(gate->get_port_by_template_port(port_a)->get_x() == gate->get_min_x() + 10);
+        REQUIRE(gate->get_port_by_template_port(port_b)->get_x() == gate->get_min_x() + 15);
+    }
+
+    REQUIRE(count_ports_at(5, 105) == 0);
+    REQUIRE(count_ports_at(10, 105) == 1);
+    REQUIRE(count_ports_at(15, 115) == 1);
+    REQUIRE(count_ports_at(215, 115) == 1);
+
+    // Remove a template port.
+    lmodel->remove_template_port_from_gate_template(tmpl, port_a);
+    for (auto const& gate : instances)
+        REQUIRE(gate->get_ports_number() == 1);
+    REQUIRE(count_ports_at(10, 105) == 0);
+
+    // Remove the instances.
+    lmodel->remove_gates_by_template_type(tmpl);
+    REQUIRE(lmodel->get_template_instances(tmpl).empty());
+    REQUIRE(lmodel->get_template_instances(other_tmpl).size() == 5);
+    REQUIRE(lmodel->get_gates_count() == 5);
+    REQUIRE(count_ports_at(15, 115) == 0);
+}
+
+TEST_CASE("Test object ID allocator", "[LogicModel]")
+{
+    ObjectIDAllocator ids;
+
+    REQUIRE(!ids.is_free(0));
+    REQUIRE(ids.allocate() == 1);
+    REQUIRE(ids.allocate() == 2);
+
+    // Loaded IDs are skipped
+    ids.reserve(3);
+    ids.reserve(5);
+    ids.reserve(5);
+    REQUIRE(ids.allocate() == 4);
+    REQUIRE(ids.allocate() == 6);
+
+    // Released IDs above the last new ID are given again, not the ones below
+    ids.reserve(8);
+    ids.release(8);
+    ids.release(2);
+    REQUIRE(!ids.is_free(2));
+    REQUIRE(ids.is_free(8));
+    REQUIRE(ids.allocate() == 7);
+    REQUIRE(ids.allocate() == 8);
+
+    const object_id_t first = ids.allocate_block(1000);
+    for (object_id_t id = first; id < first + 1000; id++)
+        REQUIRE(!ids.is_free(id));
+
+    for (int i = 0; i < 100; i++)
+    {
+        object_id_t id = ids.allocate();
+        REQUIRE((id < first || id >= first + 1000));
+    }
+}
+
+TEST_CASE("Test logic model object IDs", "[LogicModel]")
+{
+    LogicModel_shptr lmodel(new LogicModel(100, 100, ProjectType::Normal, 1));
+
+    // IDs set from outside, e.g. by an importer
+    GateTemplate_shptr tmpl(new GateTemplate(10, 10));
+    tmpl->set_object_id(lmodel->get_new_object_id() + 1);
+
+    GateTemplatePort_shptr tmpl_port(new GateTemplatePort());
+    tmpl_port->set_object_id(tmpl->get_object_id() + 1);
+    tmpl->add_template_port(tmpl_port);
+    lmodel->add_gate_template(tmpl);
+
+    Wire_shptr wire(new Wire(20, 21, 30, 31, 5));
+    wire->set_object_id(tmpl_port->get_object_id() + 1);
+    lmodel->add_object(0, wire);
+
+    std::set<object_id_t> used = {tmpl->get_object_id(), tmpl_port->get_object_id(), wire->get_object_id()};
+    for (int i = 0; i < 10; i++)
+        REQUIRE(used.insert(lmodel->get_new_object_id()).second);
+
+    // A block for a bulk insert
+    const object_id_t first = lmodel->reserve_object_ids(100);
+    std::vector<PlacedLogicModelObject_shptr> wires;
+    for (object_id_t id = first; id < first + 100; id++)
+    {
+        Wire_shptr w(new Wire(0, 10, 0, 10, 5));
+        w->set_object_id(id);
+        wires.push_back(w);
+    }
+    lmodel->add_objects(0, wires);
+
+    for (int i = 0; i < 10; i++)
+    {
+        object_id_t id = lmodel->get_new_object_id();
+        REQUIRE((id < first || id >= first + 100));
+        REQUIRE(used.insert(id).second);
+    }
+
+    Gate_shptr gate(new Gate(0, 10, 0, 10));
+    lmodel->add_object(0, gate);
+    REQUIRE(used.insert(gate->get_object_id()).second);
+    REQUIRE(lmodel->get_object(gate->get_object_id()) == gate);
+}
+
+TEST_CASE("Test bulk insert", "[LogicModel]")
+{
+    LogicModel_shptr lmodel(new LogicModel(1000, 1000, ProjectType::Normal, 1));
+    Layer_shptr layer = lmodel->get_layer(0);
+
+    GateTemplate_shptr tmpl(new GateTemplate(20, 20));
+    for (int i = 0; i < 3; i++)
+    {
+        GateTemplatePort_shptr port(new GateTemplatePort(5 + i * 5, 5, GateTemplatePort::PORT_TYPE_IN));
+        port->set_object_id(lmodel->get_new_object_id());
+        tmpl->add_template_port(port);
+    }
+    lmodel->add_gate_template(tmpl);
+
+    Gate_shptr placed(new Gate(0, 20, 0, 20, Gate::ORIENTATION_NORMAL));
+    lmodel->add_object(0, placed);
+
+    BulkInsert gates(lmodel, layer);
+
+    for (int i = 0; i < 20; i++)
+    {
+        // Two gates out of three overlap a placed or a staged gate
+        const unsigned int x = i * 10;
+        if (gates.exists_type_in_region<Gate>(x, x + 20, 0, 20))
+            continue;
+
+        Gate_shptr gate(new Gate(x, x + 20, 0, 20, Gate::ORIENTATION_NORMAL));
+        gate->set_gate_template(tmpl);
+        gates.add(gate);
+    }
+
+    REQUIRE(gates.size() == 6);
+    REQUIRE(!gates.exists_type_in_region<Via>(0, 1000, 0, 1000));
+    REQUIRE(lmodel->get_gates_count() == 1);
+
+    SECTION("Commit")
+    {
+        std::vector<PlacedLogicModelObject_shptr> added = gates.commit();
+        REQUIRE(added.size() == 6);
+        REQUIRE(gates.size() == 0);
+        REQUIRE(lmodel->get_gates_count() == 7);
+        REQUIRE(lmodel->get_template_instances(tmpl).size() == 6);
+
+        for (auto const& o : added)
+        {
+            Gate_shptr gate = std::dynamic_pointer_cast<Gate>(o);
+            REQUIRE(gate != nullptr);
+            REQUIRE(lmodel->get_object(gate->get_object_id()) == gate);
+            REQUIRE(gate->get_layer() == layer);
+            REQUIRE(gate->get_ports_number() == 3);
+
+            for (Gate::port_iterator iter = gate->ports_begin(); iter != gate->ports_end(); ++iter)
+            {
+                REQUIRE(lmodel->get_object((*iter)->get_object_id()) == *iter);
+                REQUIRE(layer->exists_type_in_region<GatePort>((*iter)->get_x(), (*iter)->get_x(),
+                                                               (*iter)->get_y(), (*iter)->get_y()));
+            }
+        }
+
+        // The new gates have consecutive IDs, followed by the IDs of their new ports
+        for (std::size_t i = 1; i < added.size(); i++)
+            REQUIRE(added[i]->get_object_id() == added[i - 1]->get_object_id() + 1);
+
+        std::set<object_id_t> port_ids;
+        for (auto const& o : added)
+        {
+            Gate_shptr gate = std::dynamic_pointer_cast<Gate>(o);
+            for (Gate::port_iterator iter = gate->ports_begin(); iter != gate->ports_end(); ++iter)
+                port_ids.insert((*iter)->get_object_id());
+        }
+
+        REQUIRE(port_ids.size() == 18);
+        REQUIRE(*port_ids.begin() == added.back()->get_object_id() + 1);
+        REQUIRE(*port_ids.rbegin() == added.back()->get_object_id() + 18);
+    }
+
+    SECTION("Rejected commit")
+    {
+        SECTION("Duplicate object ID")
+        {
+            Gate_shptr gate(new Gate(500, 520, 500, 520, Gate::ORIENTATION_NORMAL));
+            gate->set_gate_template(tmpl);
+            gate->set_object_id(placed->get_object_id());
+            gates.add(gate);
+        }
+
+        SECTION("Undefined bounding box")
+        {
+            gates.add(std::make_shared<Gate>(0, 0, 0, 0));
+        }
+
+        const object_id_t next_id = lmodel->get_new_object_id();
+
+        REQUIRE_THROWS_AS(gates.commit(), DegateLogicException);
+
+        // Nothing is added and the objects are still staged
+        REQUIRE(gates.size() == 7);
+        REQUIRE(lmodel->get_gates_count() == 1);
+        REQUIRE(lmodel->get_template_instances(tmpl).empty());
+        REQUIRE(!layer->exists_type_in_region<Gate>(30, 1000, 0, 1000));
+        REQUIRE(!layer->exists_type_in_region<GatePort>(30, 1000, 0, 1000));
+        REQUIRE(lmodel->get_object(placed->get_object_id()) == placed);
+        REQUIRE(lmodel->get_new_object_id() == next_id + 1);
+    }
+
+    SECTION("Rollback")
+    {
+        gates.rollback();
+        REQUIRE(gates.size() == 0);
+        REQUIRE(gates.commit().empty());
+        REQUIRE(lmodel->get_gates_count() == 1);
+        REQUIRE(!layer->exists_type_in_region<Gate>(30, 1000, 0, 20));
+    }
+}
@@ -24,6 +24,8 @@
 
 #include "catch.hpp"
 
+#include <fstream>
+
 using namespace degate;
 
 TEST_CASE("Memory", "[MemoryMap]")
@@ -80,4 +82,40 @@ TEST_CASE("Persistent MemoryMap", "[MemoryMap]")
 
     REQUIRE(file_exists(filename) == true);
     REQUIRE(remove_file(filename) == true);
-}
\ No newline at end of file
+}
+TEST_CASE("Read-only MemoryMap", "[MemoryMap]")
+{
+    std::string filename(get_temp_file_path());
+
+    {
+        MemoryMap<int> mm(100, 100, MAP_STORAGE_TYPE_PERSISTENT_FILE, filename);
+        mm.set(10, 10, 99);
+    }
+
+    {
+        MemoryMap<int> mm(100, 50, MAP_STORAGE_TYPE_READ_ONLY_FILE, filename);
+        REQUIRE(mm.data() != nullptr);
+        REQUIRE(mm.get(10, 10) == 99);
+    }
+
+    SECTION("File is not resized")
+    {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        REQUIRE(static_cast<std::size_t>(file.tellg()) == 100 * 100 * sizeof(int));
+    }
+
+    SECTION("File too small")
+    {
+        MemoryMap<int> mm(100, 101, MAP_STORAGE_TYPE_READ_ONLY_FILE, filename);
+        REQUIRE(mm.data() == nullptr);
+    }
+
+    REQUIRE(remove_file(filename) == true);
+
+    SECTION("Missing file is not created")
+    {
+        MemoryMap<int> mm(100, 100, MAP_STORAGE_TYPE_READ_ONLY_FILE, filename);
+        REQUIRE(mm.data() == nullptr);
+        REQUIRE(file_exists(filename) == false);
+    }
+}
@@ -22,9 +22,17 @@
 #include "Core/Project/ProjectImporter.h"
 #include "Core/Project/ProjectExporter.h"
 #include "Core/Project/Project.h"
+#include "Core/Project/ProjectAutoSaver.h"
+#include "Core/LogicModel/Gate/GateLibraryImporter.h"
+#include "Core/LogicModel/LogicModelHelper.h"
+#include "Core/LogicModel/LogicModelImporter.h"
+#include "Core/LogicModel/Via/Via.h"
+#include "Core/Utils/FileSystem.h"
 
 #include "catch.hpp"
 
+#include <iterator>
+
 using namespace degate;
 
 TEST_CASE("Test project export", "[ProjectExporter]")
@@ -44,4 +52,50 @@ TEST_CASE("Test project export", "[ProjectExporter]")
      */
     ProjectExporter exporter;
     REQUIRE_NOTHROW(exporter.export_all("tests_files/test_project", prj));
-}
\ No newline at end of file
+}
+
+TEST_CASE("Test project auto save", "[ProjectExporter]")
+{
+    ProjectImporter importer;
+
+    std::string filename("tests_files/test_project/project.xml");
+    Project_shptr prj(importer.import_all(filename));
+
+    REQUIRE(prj != nullptr);
+
+    std::string directory = create_temp_directory();
+    prj->set_project_directory(directory);
+
+    LogicModel_shptr lmodel = prj->get_logic_model();
+    const auto objects = std::distance(lmodel->objects_begin(), lmodel->objects_end());
+
+    ProjectAutoSaver saver;
+    QFuture<void> future = saver.save(prj);
+
+    // Edits made after the snapshot are not saved
+    lmodel->add_object(get_first_logic_layer(lmodel), std::make_shared<Via>(10, 10, 5, Via::DIRECTION_UP));
+
+    future.waitForFinished();
+
+    REQUIRE_FALSE(saver.is_saving());
+    REQUIRE(saver.get_last_error().empty());
+
+    REQUIRE(file_exists(join_pathes(directory, "project.xml")));
+    REQUIRE(file_exists(join_pathes(directory, "rc_blacklist.xml")));
+
+    // The temporary directory is removed
+    for (auto const& entry : read_directory(directory, true))
+        REQUIRE_FALSE(is_directory(entry));
+
+    GateLibraryImporter gate_library_importer;
+    GateLibrary_shptr glib(gate_library_importer.import(join_pathes(directory, "gate_library.xml")));
+    REQUIRE(glib != nullptr);
+
+    LogicModelImporter lm_importer(prj->get_width(), prj->get_height(), glib);
+    LogicModel_shptr saved(lm_importer.import(join_pathes(directory, "lmodel.xml"), ProjectType::Normal));
+    REQUIRE(saved != nullptr);
+
+    REQUIRE(std::distance(saved->objects_begin(), saved->objects_end()) == objects);
+
+    remove_directory(directory);
+}
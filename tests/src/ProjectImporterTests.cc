@@ -23,9 +23,14 @@
 #include "Core/Project/ProjectExporter.h"
 #include "Core/Project/Project.h"
 #include "Core/LogicModel/LogicModelHelper.h"
+#include "Core/Utils/FileSystem.h"
 
 #include "catch.hpp"
 
+#include <boost/filesystem/operations.hpp>
+
+#include <fstream>
+
 using namespace degate;
 
 TEST_CASE("Test project import", "[ProjectImporter]")
@@ -110,4 +115,36 @@ TEST_CASE("Test get object at", "[ProjectImporter]")
 
     REQUIRE(plo != nullptr);
     REQUIRE(plo->get_name() == "test_gate_1");
-}
\ No newline at end of file
+}
+
+TEST_CASE("Test get logic model filename", "[ProjectImporter]")
+{
+    std::string directory = create_temp_directory();
+    std::string xml_file = join_pathes(directory, "lmodel.xml");
+    std::string binary_file = join_pathes(directory, "lmodel.bin");
+
+    std::ofstream(xml_file) << "<logic-model/>";
+
+    SECTION("Without binary logic model, lmodel.xml is used")
+    {
+        REQUIRE(ProjectImporter::get_logic_model_filename(directory) == xml_file);
+    }
+
+    SECTION("An up to date binary logic model is detected")
+    {
+        std::ofstream(binary_file, std::ios::binary) << "DGTLMODL";
+        boost::filesystem::last_write_time(binary_file, boost::filesystem::last_write_time(xml_file) + 10);
+
+        REQUIRE(ProjectImporter::get_logic_model_filename(directory) == binary_file);
+    }
+
+    SECTION("A binary logic model older than lmodel.xml is skipped")
+    {
+        std::ofstream(binary_file, std::ios::binary) << "DGTLMODL";
+        boost::filesystem::last_write_time(binary_file, boost::filesystem::last_write_time(xml_file) - 10);
+
+        REQUIRE(ProjectImporter::get_logic_model_filename(directory) == xml_file);
+    }
+
+    remove_directory(directory);
+}
@@ -29,8 +29,51 @@
 
 #include "catch.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 using namespace degate;
 
+namespace
+{
+    /**
+     * Synthetic wires, with some of them outside of the quadtree.
+     */
+    std::vector<PlacedLogicModelObject_shptr> create_wires(unsigned int count, unsigned int size, std::uint32_t seed)
+    {
+        std::vector<PlacedLogicModelObject_shptr> wires;
+
+        auto random = [&seed](unsigned int max) {
+            seed = seed * 1664525u + 1013904223u;
+            return (seed >> 8) % max;
+        };
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            const float x = static_cast<float>(random(size + 50));
+            const float y = static_cast<float>(random(size + 50));
+            const float length = static_cast<float>(random(i % 10 == 0 ? size / 2 : 40));
+
+            if (random(2) == 0)
+                wires.push_back(std::make_shared<Wire>(x, y, x + length, y, 5));
+            else
+                wires.push_back(std::make_shared<Wire>(x, y, x, y + length, 5));
+        }
+
+        return wires;
+    }
+
+    std::vector<PlacedLogicModelObject_shptr> get_region(QuadTree<PlacedLogicModelObject_shptr>& qt,
+                                                         int min_x, int max_x, int min_y, int max_y)
+    {
+        std::vector<PlacedLogicModelObject_shptr> objects(qt.region_iter_begin(min_x, max_x, min_y, max_y),
+                                                          qt.region_iter_end());
+        std::sort(objects.begin(), objects.end());
+        return objects;
+    }
+}
+
 TEST_CASE("Test quad tree insert", "[QuadTree]")
 {
     const BoundingBox bbox(0, 1000, 0, 1000);
@@ -177,4 +220,91 @@ TEST_CASE("Test overlapping objects", "[QuadTree]")
     delete g;
     delete v;
     delete qtree;
-}
\ No newline at end of file
+}
+
+TEST_CASE("Test quad tree bulk insert", "[QuadTree]")
+{
+    const unsigned int size = 2000;
+    const BoundingBox bbox(0, size, 0, size);
+
+    auto wires = create_wires(5000, size, 7);
+
+    QuadTree<PlacedLogicModelObject_shptr> inserted(bbox, 20);
+    for (auto const& w : wires)
+        REQUIRE(RET_IS_OK(inserted.insert(w)));
+
+    SECTION("Into an empty quadtree")
+    {
+        QuadTree<PlacedLogicModelObject_shptr> bulk(bbox, 20);
+        REQUIRE(RET_IS_OK(bulk.bulk_insert(wires.begin(), wires.end())));
+
+        REQUIRE(bulk.total_size() == wires.size());
+        REQUIRE(bulk.depth() > 1);
+
+        for (int y = -100; y < static_cast<int>(size) + 100; y += 150)
+            for (int x = -100; x < static_cast<int>(size) + 100; x += 150)
+                REQUIRE(get_region(bulk, x, x + 120, y, y + 120) == get_region(inserted, x, x + 120, y, y + 120));
+    }
+
+    SECTION("Into a quadtree with objects, with explicit bounding boxes")
+    {
+        QuadTree<PlacedLogicModelObject_shptr> bulk(bbox, 20);
+
+        for (std::size_t i = 0; i < wires.size() / 3; i++)
+            REQUIRE(RET_IS_OK(bulk.insert(wires[i])));
+
+        std::vector<std::pair<PlacedLogicModelObject_shptr, BoundingBox>> objects;
+        for (std::size_t i = wires.size() / 3; i < wires.size(); i++)
+            objects.emplace_back(wires[i], wires[i]->get_bounding_box());
+
+        REQUIRE(RET_IS_OK(bulk.bulk_insert(objects)));
+        REQUIRE(bulk.total_size() == wires.size());
+
+        for (int y = -100; y < static_cast<int>(size) + 100; y += 150)
+            for (int x = -100; x < static_cast<int>(size) + 100; x += 150)
+                REQUIRE(get_region(bulk, x, x + 120, y, y + 120) == get_region(inserted, x, x + 120, y, y + 120));
+
+        // The quadtree is still usable object by object.
+        for (std::size_t i = 0; i < wires.size(); i += 2)
+            REQUIRE(RET_IS_OK(bulk.remove(wires[i])));
+
+        REQUIRE(bulk.total_size() == wires.size() / 2);
+    }
+}
+
+TEST_CASE("Test quad tree bulk remove", "[QuadTree]")
+{
+    const unsigned int size = 2000;
+    const BoundingBox bbox(0, size, 0, size);
+
+    auto wires = create_wires(5000, size, 11);
+
+    QuadTree<PlacedLogicModelObject_shptr> removed(bbox, 20);
+    QuadTree<PlacedLogicModelObject_shptr> bulk(bbox, 20);
+    REQUIRE(RET_IS_OK(removed.bulk_insert(wires.begin(), wires.end())));
+    REQUIRE(RET_IS_OK(bulk.bulk_insert(wires.begin(), wires.end())));
+
+    std::vector<std::pair<PlacedLogicModelObject_shptr, BoundingBox>> objects;
+    for (std::size_t i = 0; i < wires.size(); i += 3)
+    {
+        REQUIRE(RET_IS_OK(removed.remove(wires[i])));
+        objects.emplace_back(wires[i], wires[i]->get_bounding_box());
+    }
+
+    REQUIRE(RET_IS_OK(bulk.bulk_remove(objects)));
+    REQUIRE(bulk.total_size() == removed.total_size());
+
+    for (int y = -100; y < static_cast<int>(size) + 100; y += 150)
+        for (int x = -100; x < static_cast<int>(size) + 100; x += 150)
+            REQUIRE(get_region(bulk, x, x + 120, y, y + 120) == get_region(removed, x, x + 120, y, y + 120));
+
+    // Remove the remaining objects, emptying the whole quadtree.
+    objects.clear();
+    for (std::size_t i = 0; i < wires.size(); i++)
+        if (i % 3 != 0)
+            objects.emplace_back(wires[i], wires[i]->get_bounding_box());
+
+    REQUIRE(RET_IS_OK(bulk.bulk_remove(objects)));
+    REQUIRE(bulk.total_size() == 0);
+    REQUIRE(get_region(bulk, 0, size, 0, size).empty());
+}
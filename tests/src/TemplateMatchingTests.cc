@@ -0,0 +1,677 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Matching/TemplateMatching.h"
+#include "Core/Matching/NCCKernel.h"
+#include "Core/Matching/TemplateMatchingCache.h"
+#include "Core/LogicModel/LogicModel.h"
+#include "Core/LogicModel/Gate/Gate.h"
+#include "Core/LogicModel/Gate/GateTemplate.h"
+#include "Core/Project/Project.h"
+#include "Core/Image/Image.h"
+#include "Core/Utils/FileSystem.h"
+
+#include "TestNoise.h"
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <tuple>
+#include <vector>
+
+#include <QThreadPool>
+
+using namespace degate;
+
+namespace
+{
+    /**
+     * A smooth (8x8 pixel blocks) pseudo random cell pattern.
+     */
+    unsigned int cell_pattern(unsigned int seed, unsigned int x, unsigned int y)
+    {
+        return 64 + noise(seed, x / 8, y / 8) % 160;
+    }
+
+    struct placed_cell
+    {
+        GateTemplate_shptr tmpl;
+        unsigned int seed;
+        unsigned int x, y;
+        Gate::ORIENTATION orientation;
+    };
+
+    // Template index (0 or 1), position and orientation of a cell.
+    typedef std::tuple<unsigned int, unsigned int, unsigned int, Gate::ORIENTATION> cell_placement;
+
+    const std::vector<cell_placement> default_placements = {{0, 20, 30, Gate::ORIENTATION_NORMAL},
+                                                            {0, 120, 40, Gate::ORIENTATION_FLIPPED_LEFT_RIGHT},
+                                                            {1, 60, 130, Gate::ORIENTATION_NORMAL},
+                                                            {1, 170, 150, Gate::ORIENTATION_FLIPPED_UP_DOWN}};
+
+    /**
+     * A project with a single transistor layer, whose background contains
+     * two gate templates placed with different orientations.
+     */
+    struct MatchingProject
+    {
+        Project_shptr project;
+        Layer_shptr layer;
+        std::list<GateTemplate_shptr> templates;
+        std::vector<placed_cell> cells;
+
+        MatchingProject(unsigned int width = 256,
+                        unsigned int height = 256,
+                        std::vector<cell_placement> const& placements = default_placements)
+        {
+            project = std::make_shared<Project>(width, height, create_temp_directory(), ProjectType::Normal, 1);
+
+            LogicModel_shptr lmodel = project->get_logic_model();
+            layer = lmodel->get_layer(0);
+            layer->set_layer_type(Layer::TRANSISTOR);
+
+            std::vector<GateTemplate_shptr> tmpls = {create_template("A", 24, 20, 1),
+                                                     create_template("B", 20, 24, 2)};
+            templates.assign(tmpls.begin(), tmpls.end());
+
+            for (auto const& placement : placements)
+            {
+                const unsigned int i = std::get<0>(placement);
+                cells.push_back({tmpls[i], i + 1, std::get<1>(placement), std::get<2>(placement), std::get<3>(placement)});
+            }
+
+            BackgroundImage_shptr img = std::make_shared<BackgroundImage>(width, height, create_temp_directory());
+
+            for (unsigned int y = 0; y < height; y++)
+                for (unsigned int x = 0; x < width; x++)
+                {
+                    unsigned int v = 30 + noise(3, x, y) % 8;
+                    img->set_pixel(x, y, MERGE_CHANNELS(v, v, v, 255));
+                }
+
+            for (auto const& cell : cells)
+            {
+                unsigned int w = cell.tmpl->get_width(), h = cell.tmpl->get_height();
+
+                for (unsigned int y = 0; y < h; y++)
+                    for (unsigned int x = 0; x < w; x++)
+                    {
+                        bool flip_x = cell.orientation == Gate::ORIENTATION_FLIPPED_LEFT_RIGHT ||
+                                      cell.orientation == Gate::ORIENTATION_FLIPPED_BOTH;
+                        bool flip_y = cell.orientation == Gate::ORIENTATION_FLIPPED_UP_DOWN ||
+                                      cell.orientation == Gate::ORIENTATION_FLIPPED_BOTH;
+                        unsigned int px = flip_x ? w - 1 - x : x;
+                        unsigned int py = flip_y ? h - 1 - y : y;
+                        unsigned int v = cell_pattern(cell.seed, px, py);
+                        img->set_pixel(cell.x + x, cell.y + y, MERGE_CHANNELS(v, v, v, 255));
+                    }
+            }
+
+            layer->set_image(img);
+        }
+
+        GateTemplate_shptr create_template(std::string const& name, unsigned int w, unsigned int h, unsigned int seed)
+        {
+            GateTemplate_shptr tmpl = std::make_shared<GateTemplate>(w, h);
+            tmpl->set_name(name);
+
+            GateTemplateImage_shptr tmpl_img = std::make_shared<GateTemplateImage>(w, h);
+            for (unsigned int y = 0; y < h; y++)
+                for (unsigned int x = 0; x < w; x++)
+                {
+                    unsigned int v = cell_pattern(seed, x, y);
+                    tmpl_img->set_pixel(x, y, MERGE_CHANNELS(v, v, v, 255));
+                }
+
+            tmpl->set_image(Layer::TRANSISTOR, tmpl_img);
+            project->get_logic_model()->add_gate_template(tmpl);
+
+            return tmpl;
+        }
+
+        void run(TemplateMatching& matching)
+        {
+            matching.set_templates(templates);
+            matching.set_orientations({Gate::ORIENTATION_NORMAL,
+                                       Gate::ORIENTATION_FLIPPED_UP_DOWN,
+                                       Gate::ORIENTATION_FLIPPED_LEFT_RIGHT,
+                                       Gate::ORIENTATION_FLIPPED_BOTH});
+            matching.set_layers(layer, layer);
+            matching.init(project->get_bounding_box(), project);
+            matching.run();
+        }
+
+        /**
+         * Get the inserted gates, in insertion order.
+         */
+        std::vector<std::tuple<int, int, std::string, Gate::ORIENTATION>> get_gates()
+        {
+            std::vector<std::tuple<int, int, std::string, Gate::ORIENTATION>> gates;
+
+            LogicModel_shptr lmodel = project->get_logic_model();
+            for (auto iter = lmodel->gates_begin(); iter != lmodel->gates_end(); ++iter)
+            {
+                Gate_shptr gate = iter->second;
+                gates.emplace_back(gate->get_min_x(), gate->get_min_y(),
+                                   gate->get_gate_template()->get_name(), gate->get_orientation());
+            }
+
+            return gates;
+        }
+    };
+
+    /**
+     * Check that every placed cell was found exactly once.
+     */
+    void check_matched_cells(MatchingProject& prj, TemplateMatching const& matching)
+    {
+        REQUIRE(matching.get_number_of_hits() == prj.cells.size());
+
+        auto gates = prj.get_gates();
+        REQUIRE(gates.size() == prj.cells.size());
+
+        // Hill climbing may stop a pixel away from the exact placement
+        for (auto const& cell : prj.cells)
+        {
+            auto found = std::find_if(gates.begin(), gates.end(), [&cell](std::tuple<int, int, std::string, Gate::ORIENTATION> const& gate)
+            {
+                return std::abs(std::get<0>(gate) - static_cast<int>(cell.x)) <= 1 &&
+                       std::abs(std::get<1>(gate) - static_cast<int>(cell.y)) <= 1 &&
+                       std::get<2>(gate) == cell.tmpl->get_name() &&
+                       std::get<3>(gate) == cell.orientation;
+            });
+            CHECK(found != gates.end());
+        }
+    }
+
+    /**
+     * Gives access to the cross correlation functions.
+     */
+    class XCorrTemplateMatching : public TemplateMatchingNormal
+    {
+    public:
+        using TemplateMatching::precalc_sum_tables;
+        using TemplateMatching::subtract_mean;
+        using TemplateMatching::calc_single_xcorr;
+        using TemplateMatching::calc_xcorr;
+        using TemplateMatching::calc_xcorr_row;
+        using TemplateMatching::calc_xcorr_surface;
+    };
+}
+
+TEST_CASE("Test template matching", "[TemplateMatchingTests]")
+{
+    MatchingProject prj;
+
+    TemplateMatchingNormal matching;
+    prj.run(matching);
+
+    check_matched_cells(prj, matching);
+}
+
+TEST_CASE("Test template matching across background tiles", "[TemplateMatchingTests]")
+{
+    // Background tiles are 1024 pixels wide, cells are placed on the tile border
+    MatchingProject prj(1100, 200, {{0, 1010, 30, Gate::ORIENTATION_NORMAL},
+                                    {1, 1015, 120, Gate::ORIENTATION_FLIPPED_BOTH},
+                                    {0, 400, 100, Gate::ORIENTATION_FLIPPED_UP_DOWN}});
+
+    TemplateMatchingNormal matching;
+    prj.run(matching);
+
+    check_matched_cells(prj, matching);
+}
+
+TEST_CASE("Test template matching split in search areas", "[TemplateMatchingTests]")
+{
+    // The step size restarts in each search area, positions visited with and
+    // without the split differ, but both have to find every placed cell.
+    const std::vector<cell_placement> placements = {{0, 1010, 30, Gate::ORIENTATION_NORMAL},
+                                                    {1, 1015, 120, Gate::ORIENTATION_FLIPPED_BOTH},
+                                                    {0, 400, 100, Gate::ORIENTATION_FLIPPED_UP_DOWN}};
+
+    MatchingProject split_prj(1100, 200, placements);
+    TemplateMatchingNormal split_matching;
+    REQUIRE(split_matching.get_split_search_areas());
+    split_prj.run(split_matching);
+
+    MatchingProject whole_prj(1100, 200, placements);
+    TemplateMatchingNormal whole_matching;
+    whole_matching.set_split_search_areas(false);
+    whole_prj.run(whole_matching);
+
+    check_matched_cells(split_prj, split_matching);
+    check_matched_cells(whole_prj, whole_matching);
+
+    REQUIRE(split_prj.get_gates() == whole_prj.get_gates());
+}
+
+TEST_CASE("Test parallel template matching is deterministic", "[TemplateMatchingTests]")
+{
+    QThreadPool* pool = QThreadPool::globalInstance();
+    const int max_thread_count = pool->maxThreadCount();
+
+    // Reference run, on one thread
+    MatchingProject serial_prj;
+    TemplateMatchingNormal serial_matching;
+
+    pool->setMaxThreadCount(1);
+    serial_prj.run(serial_matching);
+    pool->setMaxThreadCount(std::max(max_thread_count, 4));
+
+    MatchingProject parallel_prj;
+    TemplateMatchingNormal parallel_matching;
+    parallel_prj.run(parallel_matching);
+
+    pool->setMaxThreadCount(max_thread_count);
+
+    REQUIRE(serial_matching.get_number_of_hits() == parallel_matching.get_number_of_hits());
+    REQUIRE(serial_prj.get_gates() == parallel_prj.get_gates());
+}
+
+TEST_CASE("Test canceled template matching", "[TemplateMatchingTests]")
+{
+    MatchingProject prj;
+
+    TemplateMatchingNormal matching;
+    matching.cancel();
+    prj.run(matching);
+
+    REQUIRE(matching.get_number_of_hits() == 0);
+    REQUIRE(prj.get_gates().empty());
+}
+
+TEST_CASE("Test template matching in rows across background tiles", "[TemplateMatchingTests]")
+{
+    MatchingProject prj(1100, 200, {{0, 1010, 30, Gate::ORIENTATION_NORMAL},
+                                    {1, 1015, 120, Gate::ORIENTATION_FLIPPED_BOTH},
+                                    {0, 400, 120, Gate::ORIENTATION_FLIPPED_UP_DOWN}});
+
+    // Rows start at y = 30 and y = 120
+    RegularGrid_shptr grid = prj.project->get_regular_vertical_grid();
+    grid->set_range(30, 200);
+    grid->set_distance(90);
+    grid->set_enabled(true);
+
+    TemplateMatchingInRows matching;
+    prj.run(matching);
+
+    check_matched_cells(prj, matching);
+}
+
+TEST_CASE("Test template matching in columns across background tiles", "[TemplateMatchingTests]")
+{
+    MatchingProject prj(200, 1100, {{0, 30, 1010, Gate::ORIENTATION_NORMAL},
+                                    {1, 120, 1015, Gate::ORIENTATION_FLIPPED_BOTH},
+                                    {0, 120, 400, Gate::ORIENTATION_FLIPPED_UP_DOWN}});
+
+    // Columns start at x = 30 and x = 120
+    RegularGrid_shptr grid = prj.project->get_regular_horizontal_grid();
+    grid->set_range(30, 200);
+    grid->set_distance(90);
+    grid->set_enabled(true);
+
+    TemplateMatchingInCols matching;
+    prj.run(matching);
+
+    check_matched_cells(prj, matching);
+}
+
+TEST_CASE("Test NCC kernels", "[TemplateMatchingTests]")
+{
+    const unsigned int length = 37, count = 29;
+
+    std::vector<std::uint8_t> master(length + count - 1);
+    std::vector<float> tmpl(length);
+
+    for (unsigned int i = 0; i < master.size(); i++)
+        master[i] = static_cast<std::uint8_t>(noise(4, i, 0));
+    for (unsigned int i = 0; i < length; i++)
+        tmpl[i] = static_cast<float>(noise(5, i, 0) % 1000) / 7.f - 70.f;
+
+    std::vector<double> expected(count, 0.5);
+    ncc_dot_product_row(master.data(), tmpl.data(), length, count, expected.data(), NCCInstructionSet::Scalar);
+
+    for (auto instruction_set : {NCCInstructionSet::Scalar, NCCInstructionSet::SSE4_1, NCCInstructionSet::AVX2})
+    {
+        if (!is_ncc_instruction_set_supported(instruction_set))
+            continue;
+
+        std::vector<double> results(count, 0.5);
+        ncc_dot_product_row(master.data(), tmpl.data(), length, count, results.data(), instruction_set);
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            double reference = ncc_dot_product(master.data() + i, tmpl.data(), length, NCCInstructionSet::Scalar);
+
+            CHECK(ncc_dot_product(master.data() + i, tmpl.data(), length, instruction_set) == Approx(reference).epsilon(1e-12));
+            CHECK(results[i] == Approx(expected[i]).epsilon(1e-12));
+            CHECK(expected[i] == Approx(reference + 0.5).epsilon(1e-12));
+        }
+    }
+}
+
+TEST_CASE("Test NCC kernels against reference cross correlation", "[TemplateMatchingTests]")
+{
+    const unsigned int width = 300, height = 200, tmpl_width = 24, tmpl_height = 20;
+
+    // Small (64 pixels) tiles, so that template windows cross tile borders
+    TileImage_GS_BYTE_shptr master = std::make_shared<TileImage_GS_BYTE>(width, height, 1, 6);
+    for (unsigned int y = 0; y < height; y++)
+        for (unsigned int x = 0; x < width; x++)
+        {
+            // Low contrast and a high mean in the lower right part, this is where precision matters
+            unsigned int v = x >= 200 && y >= 100 ? 240 + noise(6, x, y) % 4 : cell_pattern(7, x, y) + noise(6, x, y) % 24;
+            master->set_pixel(x, y, v);
+        }
+
+    // The template is cut out of the master, with some noise
+    TempImage_GS_BYTE_shptr tmpl_img = std::make_shared<TempImage_GS_BYTE>(tmpl_width, tmpl_height);
+    for (unsigned int y = 0; y < tmpl_height; y++)
+        for (unsigned int x = 0; x < tmpl_width; x++)
+            tmpl_img->set_pixel(x, y, master->get_pixel(50 + x, 40 + y) + noise(8, x, y) % 9);
+
+    XCorrTemplateMatching matching;
+
+    TempImage_GS_DOUBLE_shptr zero_mean_template = std::make_shared<TempImage_GS_DOUBLE>(tmpl_width, tmpl_height);
+    double sum_over_zero_mean_template = matching.subtract_mean(tmpl_img, zero_mean_template);
+    NCCTemplate ncc_template(zero_mean_template);
+
+    TileImage_GS_DOUBLE_shptr sum_table_single = std::make_shared<TileImage_GS_DOUBLE>(width, height, 1, 6);
+    TileImage_GS_DOUBLE_shptr sum_table_squared = std::make_shared<TileImage_GS_DOUBLE>(width, height, 1, 6);
+    matching.precalc_sum_tables(master, sum_table_single, sum_table_squared);
+
+    const unsigned int max_x = width - tmpl_width;
+    std::vector<double> row(width);
+
+    for (unsigned int y : {0u, 40u, 57u, 110u, 150u, height - tmpl_height})
+    {
+        matching.calc_xcorr_row(master, sum_table_single, sum_table_squared, ncc_template,
+                                sum_over_zero_mean_template, 0, y, width, row.data());
+
+        for (unsigned int x = 0; x <= max_x; x++)
+        {
+            double reference = matching.calc_single_xcorr(master, sum_table_single, sum_table_squared,
+                                                          zero_mean_template, sum_over_zero_mean_template, x, y);
+
+            REQUIRE(std::abs(matching.calc_xcorr(master, sum_table_single, sum_table_squared, ncc_template,
+                                                 sum_over_zero_mean_template, x, y) - reference) < 1e-6);
+            REQUIRE(std::abs(row[x] - reference) < 1e-6);
+        }
+
+        // Positions where the template doesn't fit
+        for (unsigned int x = max_x + 1; x < width; x++)
+            REQUIRE(row[x] == -1.0);
+    }
+
+    REQUIRE(matching.calc_xcorr(master, sum_table_single, sum_table_squared, ncc_template,
+                                sum_over_zero_mean_template, 50, 40) > 0.9);
+    REQUIRE(matching.calc_xcorr(master, sum_table_single, sum_table_squared, ncc_template,
+                                sum_over_zero_mean_template, max_x + 1, 0) == -1.0);
+}
+
+TEST_CASE("Test FFT cross correlation against reference cross correlation", "[TemplateMatchingTests]")
+{
+    const unsigned int width = 300, height = 200;
+
+    // Small (64 pixels) tiles, so that FFT blocks cross tile borders
+    TileImage_GS_BYTE_shptr master = std::make_shared<TileImage_GS_BYTE>(width, height, 1, 6);
+    for (unsigned int y = 0; y < height; y++)
+        for (unsigned int x = 0; x < width; x++)
+        {
+            unsigned int v = x >= 200 && y >= 100 ? 240 + noise(6, x, y) % 4 : cell_pattern(7, x, y) + noise(6, x, y) % 24;
+            master->set_pixel(x, y, v);
+        }
+
+    XCorrTemplateMatching matching;
+
+    TileImage_GS_DOUBLE_shptr sum_table_single = std::make_shared<TileImage_GS_DOUBLE>(width, height, 1, 6);
+    TileImage_GS_DOUBLE_shptr sum_table_squared = std::make_shared<TileImage_GS_DOUBLE>(width, height, 1, 6);
+    matching.precalc_sum_tables(master, sum_table_single, sum_table_squared);
+
+    // A small template and a large one (larger than a tile)
+    for (auto const& size : {std::make_pair(24u, 20u), std::make_pair(70u, 66u)})
+    {
+        const unsigned int tmpl_width = size.first, tmpl_height = size.second;
+
+        TempImage_GS_BYTE_shptr tmpl_img = std::make_shared<TempImage_GS_BYTE>(tmpl_width, tmpl_height);
+        for (unsigned int y = 0; y < tmpl_height; y++)
+            for (unsigned int x = 0; x < tmpl_width; x++)
+                tmpl_img->set_pixel(x, y, master->get_pixel(50 + x, 40 + y) + noise(8, x, y) % 9);
+
+        TempImage_GS_DOUBLE_shptr zero_mean_template = std::make_shared<TempImage_GS_DOUBLE>(tmpl_width, tmpl_height);
+        double sum_over_zero_mean_template = matching.subtract_mean(tmpl_img, zero_mean_template);
+        FFTCorrelation fft_template(zero_mean_template);
+
+        // The surface is clipped to the positions where the template fits
+        auto surface = matching.calc_xcorr_surface(master, sum_table_single, sum_table_squared, fft_template,
+                                                   sum_over_zero_mean_template, 0, 0, width, height);
+
+        REQUIRE(surface.width == width - tmpl_width + 1);
+        REQUIRE(surface.height == height - tmpl_height + 1);
+
+        for (unsigned int y : {0u, 40u, 63u, 110u, surface.height - 1})
+            for (unsigned int x = 0; x < surface.width; x++)
+            {
+                double reference = matching.calc_single_xcorr(master, sum_table_single, sum_table_squared,
+                                                              zero_mean_template, sum_over_zero_mean_template, x, y);
+
+                REQUIRE(std::abs(surface.get(x, y) - reference) < 1e-6);
+            }
+
+        REQUIRE(surface.get(50, 40) > 0.9);
+
+        // Partial surfaces give the same values
+        auto partial = matching.calc_xcorr_surface(master, sum_table_single, sum_table_squared, fft_template,
+                                                   sum_over_zero_mean_template, 17, 9, 100, 50);
+
+        REQUIRE(partial.width == 100);
+        REQUIRE(partial.height == 50);
+
+        for (unsigned int y = 9; y < 59; y++)
+            for (unsigned int x = 17; x < 117; x++)
+                REQUIRE(std::abs(partial.get(x, y) - surface.get(x, y)) < 1e-9);
+    }
+}
+
+TEST_CASE("Test FFT template matching finds the same gates", "[TemplateMatchingTests]")
+{
+    const std::vector<cell_placement> across_tiles = {{0, 1010, 30, Gate::ORIENTATION_NORMAL},
+                                                      {1, 1015, 120, Gate::ORIENTATION_FLIPPED_BOTH},
+                                                      {0, 400, 100, Gate::ORIENTATION_FLIPPED_UP_DOWN}};
+
+    for (auto const& size : {std::make_pair(256u, 256u), std::make_pair(1100u, 200u)})
+    {
+        auto const& placements = size.first == 256 ? default_placements : across_tiles;
+
+        MatchingProject direct_prj(size.first, size.second, placements);
+        TemplateMatchingNormal direct_matching;
+        direct_matching.set_correlation_mode(TemplateMatching::CorrelationMode::Direct);
+        direct_prj.run(direct_matching);
+
+        MatchingProject fft_prj(size.first, size.second, placements);
+        TemplateMatchingNormal fft_matching;
+        fft_matching.set_correlation_mode(TemplateMatching::CorrelationMode::FFT);
+        fft_prj.run(fft_matching);
+
+        check_matched_cells(fft_prj, fft_matching);
+
+        REQUIRE(direct_matching.get_number_of_hits() == fft_matching.get_number_of_hits());
+        REQUIRE(direct_prj.get_gates() == fft_prj.get_gates());
+    }
+}
+
+TEST_CASE("Test summation tables", "[TemplateMatchingTests]")
+{
+    const unsigned int width = 150, height = 130;
+
+    // Tiles of the image and of the tables have different sizes
+    TileImage_GS_BYTE_shptr img = std::make_shared<TileImage_GS_BYTE>(width, height, 1, 4);
+    for (unsigned int y = 0; y < height; y++)
+        for (unsigned int x = 0; x < width; x++)
+            img->set_pixel(x, y, noise(9, x, y) % 256);
+
+    TileImage_GS_DOUBLE_shptr sum_table_single = std::make_shared<TileImage_GS_DOUBLE>(width, height, 1, 5);
+    TileImage_GS_DOUBLE_shptr sum_table_squared = std::make_shared<TileImage_GS_DOUBLE>(width, height, 1, 5);
+
+    XCorrTemplateMatching matching;
+    matching.precalc_sum_tables(img, sum_table_single, sum_table_squared);
+
+    std::vector<double> column_single(width, 0), column_squared(width, 0);
+
+    for (unsigned int y = 0; y < height; y++)
+    {
+        double row_single = 0, row_squared = 0;
+
+        for (unsigned int x = 0; x < width; x++)
+        {
+            double f = img->get_pixel(x, y);
+            row_single += f;
+            row_squared += f * f;
+            column_single[x] += row_single;
+            column_squared[x] += row_squared;
+
+            REQUIRE(sum_table_single->get_pixel(x, y) == column_single[x]);
+            REQUIRE(sum_table_squared->get_pixel(x, y) == column_squared[x]);
+        }
+    }
+}
+
+TEST_CASE("Test template matching cache", "[TemplateMatchingTests]")
+{
+    TemplateMatchingCache& cache = TemplateMatchingCache::get_instance();
+    const uint_fast64_t max_memory = cache.get_max_memory();
+
+    cache.clear();
+    cache.set_max_memory(64 * 1024 * 1024);
+
+    MatchingProject prj;
+    LogicModel_shptr lmodel = prj.project->get_logic_model();
+    BoundingBox const& bounding_box = prj.project->get_bounding_box();
+
+    auto get_region_key = [&]()
+    {
+        return TemplateMatchingCache::region_key{prj.layer->get_layer_id(), prj.layer->get_image_revision(),
+                                                 static_cast<int>(bounding_box.get_min_x()),
+                                                 static_cast<int>(bounding_box.get_max_x()),
+                                                 static_cast<int>(bounding_box.get_min_y()),
+                                                 static_cast<int>(bounding_box.get_max_y()), 1};
+    };
+
+    auto get_template_key = [](GateTemplate_shptr tmpl)
+    {
+        return TemplateMatchingCache::template_key{tmpl->get_object_id(), tmpl->get_image_revision(),
+                                                   Layer::TRANSISTOR, Gate::ORIENTATION_NORMAL, 1, false};
+    };
+
+    auto remove_gates = [&]()
+    {
+        std::vector<Gate_shptr> gates;
+        for (auto iter = lmodel->gates_begin(); iter != lmodel->gates_end(); ++iter)
+            gates.push_back(iter->second);
+
+        for (auto const& gate : gates)
+            lmodel->remove_object(gate);
+    };
+
+    GateTemplate_shptr tmpl_a = prj.templates.front();
+    GateTemplate_shptr tmpl_b = prj.templates.back();
+
+    TemplateMatchingNormal first_matching;
+    prj.run(first_matching);
+    check_matched_cells(prj, first_matching);
+    auto first_gates = prj.get_gates();
+
+    auto region = cache.get_region(get_region_key());
+    auto prepared_a = cache.get_template(get_template_key(tmpl_a));
+    auto prepared_b = cache.get_template(get_template_key(tmpl_b));
+
+    REQUIRE(region != nullptr);
+    REQUIRE(prepared_a != nullptr);
+    REQUIRE(prepared_b != nullptr);
+
+    const uint_fast64_t allocated_memory = cache.get_allocated_memory();
+    REQUIRE(allocated_memory > 0);
+
+    // Re-run with other thresholds, everything is reused
+    remove_gates();
+
+    TemplateMatchingNormal second_matching;
+    second_matching.set_threshold_detection(0.65);
+    prj.run(second_matching);
+    check_matched_cells(prj, second_matching);
+
+    REQUIRE(cache.get_region(get_region_key()) == region);
+    REQUIRE(cache.get_template(get_template_key(tmpl_a)) == prepared_a);
+    REQUIRE(cache.get_allocated_memory() == allocated_memory);
+
+    // A new template image replaces the outdated entries of this template only
+    auto old_template_key = get_template_key(tmpl_a);
+    GateTemplateImage_shptr tmpl_img = std::make_shared<GateTemplateImage>(tmpl_a->get_width(), tmpl_a->get_height());
+    copy_image(tmpl_img, tmpl_a->get_image(Layer::TRANSISTOR));
+    tmpl_a->set_image(Layer::TRANSISTOR, tmpl_img);
+
+    remove_gates();
+
+    TemplateMatchingNormal third_matching;
+    prj.run(third_matching);
+    check_matched_cells(prj, third_matching);
+
+    REQUIRE(cache.get_template(old_template_key) == nullptr);
+    REQUIRE(cache.get_template(get_template_key(tmpl_a)) != nullptr);
+    REQUIRE(cache.get_template(get_template_key(tmpl_a)) != prepared_a);
+    REQUIRE(cache.get_template(get_template_key(tmpl_b)) == prepared_b);
+    REQUIRE(cache.get_region(get_region_key()) == region);
+    REQUIRE(cache.get_allocated_memory() == allocated_memory);
+
+    // A new background image replaces the outdated region
+    auto old_region_key = get_region_key();
+    BackgroundImage_shptr img = std::make_shared<BackgroundImage>(256, 256, create_temp_directory());
+    copy_image(img, prj.layer->get_image());
+    prj.layer->set_image(img);
+
+    remove_gates();
+
+    TemplateMatchingNormal fourth_matching;
+    prj.run(fourth_matching);
+    check_matched_cells(prj, fourth_matching);
+    REQUIRE(prj.get_gates() == first_gates);
+
+    REQUIRE(cache.get_region(old_region_key) == nullptr);
+    REQUIRE(cache.get_region(get_region_key()) != nullptr);
+    REQUIRE(cache.get_region(get_region_key()) != region);
+
+    // Without budget, nothing is cached
+    cache.set_max_memory(0);
+    REQUIRE(cache.get_allocated_memory() == 0);
+
+    remove_gates();
+
+    TemplateMatchingNormal fifth_matching;
+    prj.run(fifth_matching);
+    check_matched_cells(prj, fifth_matching);
+
+    REQUIRE(cache.get_region(get_region_key()) == nullptr);
+    REQUIRE(cache.get_allocated_memory() == 0);
+
+    cache.set_max_memory(max_memory);
+}
@@ -0,0 +1,46 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __TESTNOISE_H__
+#define __TESTNOISE_H__
+
+namespace degate
+{
+    /**
+     * Pseudo random noise, for synthetic test images.
+     *
+     * @param seed : the seed, to get different noises.
+     * @param x : the x coordinate.
+     * @param y : the y coordinate.
+     *
+     * @return Returns the noise value at (x, y).
+     */
+    inline unsigned int noise(unsigned int seed, unsigned int x, unsigned int y)
+    {
+        unsigned int h = seed * 2654435761u ^ x * 40503u ^ y * 2246822519u;
+        h ^= h >> 13;
+        h *= 0x5bd1e995;
+        h ^= h >> 15;
+        return h;
+    }
+}
+
+#endif //__TESTNOISE_H__
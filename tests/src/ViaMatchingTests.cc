@@ -0,0 +1,268 @@
+/**
+ * This file is part of the IC reverse engineering tool Degate.
+ *
+ * Copyright 2008, 2009, 2010 by Martin Schobert
+ * Copyright 2019-2020 Dorian Bachelot
+ *
+ * Degate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Degate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with degate. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Core/Matching/ViaMatching.h"
+#include "Core/LogicModel/LogicModel.h"
+#include "Core/LogicModel/LogicModelHelper.h"
+#include "Core/LogicModel/Via/Via.h"
+#include "Core/Project/Project.h"
+#include "Core/Image/Image.h"
+#include "Core/Utils/FileSystem.h"
+
+#include "TestNoise.h"
+#include "catch.hpp"
+
+#include <list>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace degate;
+
+namespace
+{
+    typedef std::tuple<unsigned int, unsigned int, Via::DIRECTION> via_placement;
+
+    // Vias centers, some of them close enough to compete for the same matches
+    const std::vector<via_placement> placements = {{30, 30, Via::DIRECTION_UP},
+                                                   {80, 40, Via::DIRECTION_UP},
+                                                   {92, 44, Via::DIRECTION_UP},
+                                                   {150, 70, Via::DIRECTION_UP},
+                                                   {200, 200, Via::DIRECTION_UP},
+                                                   {40, 180, Via::DIRECTION_UP},
+                                                   {60, 100, Via::DIRECTION_DOWN},
+                                                   {120, 140, Via::DIRECTION_DOWN},
+                                                   {134, 152, Via::DIRECTION_DOWN},
+                                                   {220, 60, Via::DIRECTION_DOWN},
+                                                   {180, 230, Via::DIRECTION_DOWN}};
+
+    const unsigned int via_diameter = 11;
+
+    /**
+     * A project with a metal layer showing vias. The first via of each direction
+     * is placed in the logic model.
+     */
+    struct ViaProject
+    {
+        Project_shptr project;
+        Layer_shptr layer;
+
+        ViaProject(unsigned int width = 256, unsigned int height = 256)
+        {
+            project = std::make_shared<Project>(width, height, create_temp_directory(), ProjectType::Normal, 1);
+
+            LogicModel_shptr lmodel = project->get_logic_model();
+            layer = lmodel->get_layer(0);
+            layer->set_layer_type(Layer::METAL);
+
+            BackgroundImage_shptr img = std::make_shared<BackgroundImage>(width, height, create_temp_directory());
+
+            for (unsigned int y = 0; y < height; y++)
+                for (unsigned int x = 0; x < width; x++)
+                {
+                    unsigned int v = 60 + noise(1, x, y) % 40;
+
+                    for (auto const& placement : placements)
+                    {
+                        const int dx = static_cast<int>(x) - static_cast<int>(std::get<0>(placement));
+                        const int dy = static_cast<int>(y) - static_cast<int>(std::get<1>(placement));
+                        const int d2 = dx * dx + dy * dy;
+
+                        if (std::get<2>(placement) == Via::DIRECTION_UP && d2 <= 16)
+                            v = 200 + noise(1, x, y) % 30;
+                        else if (std::get<2>(placement) == Via::DIRECTION_DOWN && d2 <= 25)
+                            v = d2 <= 6 ? 20 + noise(1, x, y) % 10 : 170 + noise(1, x, y) % 20;
+                    }
+
+                    img->set_pixel(x, y, MERGE_CHANNELS(v, v, v, 255));
+                }
+
+            layer->set_image(img);
+
+            bool up = false, down = false;
+            for (auto const& placement : placements)
+            {
+                bool& placed = std::get<2>(placement) == Via::DIRECTION_UP ? up : down;
+                if (placed)
+                    continue;
+
+                lmodel->add_object(layer, std::make_shared<Via>(std::get<0>(placement), std::get<1>(placement),
+                                                                via_diameter, std::get<2>(placement)));
+                placed = true;
+            }
+        }
+
+        /**
+         * Get the vias, in insertion order.
+         */
+        std::vector<std::tuple<float, float, unsigned int, Via::DIRECTION, std::string>> get_vias()
+        {
+            std::vector<std::tuple<float, float, unsigned int, Via::DIRECTION, std::string>> vias;
+
+            LogicModel_shptr lmodel = project->get_logic_model();
+            for (auto iter = lmodel->vias_begin(); iter != lmodel->vias_end(); ++iter)
+            {
+                Via_shptr via = iter->second;
+                vias.emplace_back(via->get_x(), via->get_y(), via->get_diameter(), via->get_direction(),
+                                  via->get_description());
+            }
+
+            return vias;
+        }
+    };
+
+    /**
+     * The via matching as implemented before summed-area tables: window statistics and
+     * correlation for every position, then vias added by decreasing correlation.
+     */
+    void reference_via_matching(ViaProject& prj, double threshold)
+    {
+        LogicModel_shptr lmodel = prj.project->get_logic_model();
+        Layer_shptr layer = prj.layer;
+        BackgroundImage_shptr bg_img = layer->get_scaling_manager()->get_image(1).second;
+        BoundingBox bbox = prj.project->get_bounding_box();
+
+        unsigned int max_r = 0;
+        for (auto iter = lmodel->vias_begin(); iter != lmodel->vias_end(); ++iter)
+            max_r = std::max(max_r, iter->second->get_diameter());
+        max_r = (max_r + 1) / 2;
+
+        std::list<MemoryImage_shptr> vias_up, vias_down;
+        for (auto iter = lmodel->vias_begin(); iter != lmodel->vias_end(); ++iter)
+        {
+            Via_shptr via = iter->second;
+            BoundingBox bb(via->get_x() - max_r, via->get_x() + max_r,
+                           via->get_y() - max_r, via->get_y() + max_r);
+
+            MemoryImage_shptr img = grab_image<MemoryImage>(lmodel, layer, bb);
+            (via->get_direction() == Via::DIRECTION_UP ? vias_up : vias_down).push_back(img);
+        }
+
+        for (auto direction : {Via::DIRECTION_UP, Via::DIRECTION_DOWN})
+        {
+            MemoryImage_shptr merged = merge_images(direction == Via::DIRECTION_UP ? vias_up : vias_down);
+            auto tmpl_img = std::make_shared<MemoryImage_GS_BYTE>(merged->get_width(), merged->get_height());
+            copy_image(tmpl_img, merged);
+
+            const unsigned int w = tmpl_img->get_width(), h = tmpl_img->get_height();
+            const double n = w * h;
+
+            double t_avg, sigma_t;
+            average_and_stddev(tmpl_img, 0, 0, w, h, &t_avg, &sigma_t);
+
+            int max_x = static_cast<unsigned int>(bbox.get_max_x()) > w ? bbox.get_max_x() - w : bbox.get_min_x();
+            int max_y = static_cast<unsigned int>(bbox.get_max_y()) > h ? bbox.get_max_y() - h : bbox.get_min_y();
+
+            std::list<ViaMatching::match_found> matches;
+            for (int y = bbox.get_min_y(); y < max_y; y++)
+                for (int x = bbox.get_min_x(); x < max_x; x++)
+                {
+                    double f_avg, sigma_f;
+                    average_and_stddev(bg_img, x, y, w, h, &f_avg, &sigma_f);
+
+                    double sum = 0;
+                    for (unsigned int ty = 0; ty < h; ty++)
+                        for (unsigned int tx = 0; tx < w; tx++)
+                        {
+                            double f_xy = bg_img->get_pixel_as<double>(x + tx, y + ty);
+                            double t_xy = tmpl_img->get_pixel_as<double>(tx, ty);
+                            sum += (f_xy - f_avg) * (t_xy - t_avg) / (sigma_f * sigma_t);
+                        }
+                    sum *= 1 / (n - 1);
+
+                    if (sum > threshold)
+                        matches.push_back({static_cast<unsigned int>(x), static_cast<unsigned int>(y), sum});
+                }
+
+            matches.sort([](ViaMatching::match_found const& lhs, ViaMatching::match_found const& rhs)
+            {
+                return lhs.correlation > rhs.correlation;
+            });
+
+            for (auto const& m : matches)
+            {
+                if (layer->exists_type_in_region<Via>(m.x, m.x + via_diameter, m.y, m.y + via_diameter))
+                    continue;
+
+                Via_shptr via(new Via(m.x + via_diameter / 2, m.y + via_diameter / 2, via_diameter, direction));
+
+                char dsc[100];
+                snprintf(dsc, sizeof(dsc), "matched with corr=%.2f t_hc=%.2f", m.correlation, threshold);
+                via->set_description(dsc);
+
+                lmodel->add_object(layer, via);
+            }
+        }
+    }
+}
+
+TEST_CASE("Test via matching finds the vias", "[ViaMatchingTests]")
+{
+    ViaProject prj;
+
+    ViaMatching matching;
+    matching.set_diameter(via_diameter);
+    matching.set_threshold_match(0.7);
+    matching.set_merge_n_vias(0);
+    matching.init(prj.project->get_bounding_box(), prj.project);
+    matching.run();
+
+    auto vias = prj.get_vias();
+
+    // Every via is found once
+    for (auto const& placement : placements)
+    {
+        unsigned int found = 0;
+        for (auto const& via : vias)
+        {
+            if (std::abs(std::get<0>(via) - static_cast<float>(std::get<0>(placement))) <= 2 &&
+                std::abs(std::get<1>(via) - static_cast<float>(std::get<1>(placement))) <= 2 &&
+                std::get<3>(via) == std::get<2>(placement))
+                found++;
+        }
+
+        INFO("via at " << std::get<0>(placement) << "," << std::get<1>(placement));
+        CHECK(found == 1);
+    }
+}
+
+TEST_CASE("Test via matching against reference via matching", "[ViaMatchingTests]")
+{
+    for (double threshold : {0.5, 0.7, 0.9})
+    {
+        ViaProject prj, reference_prj;
+
+        ViaMatching matching;
+        matching.set_diameter(via_diameter);
+        matching.set_threshold_match(threshold);
+        matching.set_merge_n_vias(0);
+        matching.init(prj.project->get_bounding_box(), prj.project);
+        matching.run();
+
+        reference_via_matching(reference_prj, threshold);
+
+        auto vias = prj.get_vias();
+        auto reference_vias = reference_prj.get_vias();
+
+        REQUIRE(vias.size() > placements.size() / 2);
+        REQUIRE(vias == reference_vias);
+    }
+}